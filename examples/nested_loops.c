@@ -0,0 +1,12 @@
+int main() {
+    int count = 0;
+    for (int i = 0; i < 300; i = i + 1) {
+        for (int j = 0; j < 300; j = j + 1) {
+            if (i < j) {
+                count = count + 1;
+            }
+        }
+    }
+    printf("pairs = %d\n", count);
+    return 0;
+}
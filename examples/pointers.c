@@ -0,0 +1,12 @@
+int main() {
+    int a = 1;
+    int b = 2;
+    int c = 3;
+    int* ptrP = &a;
+    int* ptrQ = &b;
+    c = *ptrP;
+    ptrP = ptrQ;
+    ptrP = &c;
+    printf("a=%d b=%d c=%d *ptrP=%d\n", a, b, c, *ptrP);
+    return 0;
+}
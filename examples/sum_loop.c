@@ -0,0 +1,13 @@
+int sumTo(int n) {
+    int total = 0;
+    for (int i = 0; i < n; i = i + 1) {
+        total = total + i;
+    }
+    return total;
+}
+
+int main() {
+    int result = sumTo(20000);
+    printf("sum = %d\n", result);
+    return 0;
+}
@@ -0,0 +1,92 @@
+#!/usr/bin/env bash
+# Compara el tiempo de ejecución del programa traducido en modo nativo (--emit=native)
+# con el de la simulación instrumentada (por sentencia y por bloque básico).
+#
+# Uso: scripts/benchmark.sh [programa.c ...]
+#   Sin argumentos usa examples/*.c.
+# Variables de entorno:
+#   COMPILER  ruta al compilador (por defecto build/src/C_SFML_Compiler)
+#   RUNS      ejecuciones por medición; se reporta la mejor (por defecto 5)
+#   CXX       compilador de C++ (por defecto g++)
+#   CXXFLAGS  opciones adicionales para compilar el código generado
+#   RUNTIME_LIB_DIR directorio de libsim_runtime.a (por defecto build/src/runtime)
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+COMPILER="${COMPILER:-$ROOT/build/src/C_SFML_Compiler}"
+RUNS="${RUNS:-5}"
+CXX="${CXX:-g++}"
+CXXFLAGS="${CXXFLAGS:-}"
+RUNTIME_LIB_DIR="${RUNTIME_LIB_DIR:-$ROOT/build/src/runtime}"
+
+if [ ! -x "$COMPILER" ]; then
+    echo "No se encontró el compilador en $COMPILER (define COMPILER=...)" >&2
+    exit 1
+fi
+
+if [ "$#" -gt 0 ]; then
+    PROGRAMS=("$@")
+else
+    PROGRAMS=("$ROOT"/examples/*.c)
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+# Mejor tiempo (en ms) de RUNS ejecuciones del binario dado
+best_time_ms() {
+    local binary="$1" best="" start end elapsed
+    for _ in $(seq "$RUNS"); do
+        start=$(date +%s%N)
+        "$binary" > /dev/null 2>&1
+        end=$(date +%s%N)
+        elapsed=$(( (end - start) / 1000 ))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+    done
+    printf "%d.%03d" $((best / 1000)) $((best % 1000))
+}
+
+# Traduce el programa con las opciones dadas y lo compila con -O2
+build_variant() {
+    local source="$1" name="$2"; shift 2
+    local dir="$WORK/$name"
+    mkdir -p "$dir"
+    (cd "$dir" && "$COMPILER" "$@" "$source" > /dev/null)
+    if [ -f "$dir/output_native.cpp" ]; then
+        # shellcheck disable=SC2086
+        "$CXX" -std=c++17 -O2 $CXXFLAGS "$dir/output_native.cpp" -o "$dir/program"
+    else
+        # Con SIMULATION_BENCHMARK el main no abre el visor: basta sim_runtime, sin SFML
+        # shellcheck disable=SC2086
+        "$CXX" -std=c++17 -O2 $CXXFLAGS -DSIMULATION_BENCHMARK -I"$ROOT/src/runtime" "$dir/output_sfml.cpp" \
+            -o "$dir/program" -L"$RUNTIME_LIB_DIR" -lsim_runtime
+    fi
+    echo "$dir/program"
+}
+
+printf "%-24s %12s %14s %12s %10s\n" "programa" "nativo (ms)" "sentencia (ms)" "bloque (ms)" "factor"
+for program in "${PROGRAMS[@]}"; do
+    source="$(cd "$(dirname "$program")" && pwd)/$(basename "$program")"
+    base="$(basename "$program" .c)"
+
+    native=$(build_variant "$source" "$base-native" --emit=native)
+    statement=$(build_variant "$source" "$base-statement" --instrument=statement)
+    block=$(build_variant "$source" "$base-block" --instrument=block)
+
+    # Las tres variantes deben producir la misma salida
+    expected="$("$native")"
+    for binary in "$statement" "$block"; do
+        if [ "$("$binary" 2> /dev/null)" != "$expected" ]; then
+            echo "La salida de $binary difiere de la versión nativa" >&2
+            exit 1
+        fi
+    done
+
+    native_ms=$(best_time_ms "$native")
+    statement_ms=$(best_time_ms "$statement")
+    block_ms=$(best_time_ms "$block")
+    factor=$(awk -v a="$statement_ms" -v b="$native_ms" 'BEGIN { if (b > 0) printf "%.1fx", a / b; else print "-" }')
+    printf "%-24s %12s %14s %12s %10s\n" "$base" "$native_ms" "$statement_ms" "$block_ms" "$factor"
+done
@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+# Compara el tiempo desde el fuente C hasta la traza lista para el visor por los dos caminos:
+#   g++: C_SFML_Compiler --backend=html --run (genera C++, lo compila con g++ y lo ejecuta)
+#   vm:  C_SFML_Compiler --backend=html --vm  (bytecode interpretado dentro del compilador)
+# Ambos escriben trace.json; se comprueba que las trazas coinciden (salvo las direcciones).
+#
+# Uso: scripts/benchmark_vm.sh [programa.c ...]
+#   Sin argumentos usa examples/*.c.
+# Variables de entorno:
+#   COMPILER  ruta al compilador (por defecto build/src/C_SFML_Compiler)
+#   RUNS      ejecuciones por medición; se reporta la mejor (por defecto 3)
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+COMPILER="${COMPILER:-$ROOT/build/src/C_SFML_Compiler}"
+RUNS="${RUNS:-3}"
+
+if [ ! -x "$COMPILER" ]; then
+    echo "No se encontró el compilador en $COMPILER (define COMPILER=...)" >&2
+    exit 1
+fi
+
+if [ "$#" -gt 0 ]; then
+    PROGRAMS=("$@")
+else
+    PROGRAMS=("$ROOT"/examples/*.c)
+fi
+
+WORK="$(mktemp -d)"
+trap 'rm -rf "$WORK"' EXIT
+
+# Mejor tiempo (en ms) de RUNS ejecuciones del compilador con las opciones dadas, dentro de dir
+best_time_ms() {
+    local dir="$1" best="" start end elapsed; shift
+    mkdir -p "$dir"
+    for _ in $(seq "$RUNS"); do
+        start=$(date +%s%N)
+        (cd "$dir" && "$COMPILER" "$@" > /dev/null 2>&1)
+        end=$(date +%s%N)
+        elapsed=$(( (end - start) / 1000 ))
+        if [ -z "$best" ] || [ "$elapsed" -lt "$best" ]; then
+            best=$elapsed
+        fi
+    done
+    printf "%d.%03d" $((best / 1000)) $((best % 1000))
+}
+
+# Traza sin direcciones de memoria, que cambian entre ejecuciones
+normalized_trace() {
+    sed -E 's/0x[0-9a-f]+/<ptr>/g' "$1/trace.json"
+}
+
+printf "%-24s %8s %12s %10s %10s\n" "programa" "pasos" "g++ (ms)" "vm (ms)" "factor"
+for program in "${PROGRAMS[@]}"; do
+    source="$(cd "$(dirname "$program")" && pwd)/$(basename "$program")"
+    base="$(basename "$program" .c)"
+
+    gpp_ms=$(best_time_ms "$WORK/$base-gpp" --backend=html --run "$source")
+    vm_ms=$(best_time_ms "$WORK/$base-vm" --backend=html --vm "$source")
+
+    if ! cmp -s <(normalized_trace "$WORK/$base-gpp") <(normalized_trace "$WORK/$base-vm"); then
+        echo "La traza de la VM difiere de la del programa compilado con g++ ($base)" >&2
+        exit 1
+    fi
+    steps=$(grep -c '"text"' "$WORK/$base-vm/trace.json")
+    factor=$(awk -v a="$gpp_ms" -v b="$vm_ms" 'BEGIN { if (b > 0) printf "%.1fx", a / b; else print "-" }')
+    printf "%-24s %8s %12s %10s %10s\n" "$base" "$steps" "$gpp_ms" "$vm_ms" "$factor"
+done
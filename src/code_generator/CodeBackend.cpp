@@ -0,0 +1,14 @@
+// src/code_generator/CodeBackend.cpp
+#include "CodeBackend.h"
+#include "SFMLTranslator.h"
+#include "TraceTranslator.h"
+
+std::unique_ptr<CodeBackend> createBackend(BackendKind kind) {
+    switch (kind) {
+        case BackendKind::HTML:
+            return std::make_unique<TraceTranslator>();
+        case BackendKind::SFML:
+        default:
+            return std::make_unique<SFMLTranslator>();
+    }
+}
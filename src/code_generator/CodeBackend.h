@@ -0,0 +1,115 @@
+// src/code_generator/CodeBackend.h
+#ifndef CODEBACKEND_H
+#define CODEBACKEND_H
+
+#include <memory>
+#include <string>
+#include <utility> // Para std::pair
+#include <vector>
+#include "../parser/FormatString.h" // Segmentos de formato de printf
+#include "../runtime/SimulationLimits.h" // SimTraceOverflow, SimStopReason
+
+// 0 si se construyó sin SFML (ver src/CMakeLists.txt): no hay sim_viewer y el backend SFML compila los
+// programas con -DSIMULATION_HEADLESS contra sim_runtime
+#ifndef SIM_VIEWER_AVAILABLE
+#define SIM_VIEWER_AVAILABLE 1
+#endif
+
+// Destino del código generado
+enum class EmitMode {
+    Visualization, // Programa instrumentado que registra la simulación
+    Native,        // Programa C++ plano: sin recordStep, marcos de pila ni runtime
+    Profile        // --profile: el programa nativo con contadores por sentencia y por función
+};
+
+// Backends de visualización disponibles (--backend=...)
+enum class BackendKind {
+    SFML, // Visor SFML enlazado con sim_viewer
+    HTML  // Programa que exporta la traza + visor HTML/JS autónomo
+};
+
+// Archivo adicional que acompaña al programa generado (p. ej. el visor HTML)
+struct GeneratedFile {
+    std::string fileName;
+    std::string contents;
+};
+
+// Interfaz que usa el CodeGenerator para emitir el programa traducido. Cada backend decide
+// cómo se instrumentan las sentencias y qué envuelve al programa (includes, main, archivos extra).
+class CodeBackend {
+public:
+    virtual ~CodeBackend() = default;
+
+    virtual void increaseIndent() = 0;
+    virtual void decreaseIndent() = 0;
+    virtual std::string getCurrentIndent() const = 0;
+
+    virtual void setEmitMode(EmitMode mode) = 0;
+    virtual EmitMode getEmitMode() const = 0;
+    virtual void setStepRecordingEnabled(bool enabled) = 0;
+    virtual bool isStepRecordingEnabled() const = 0;
+    // Variable booleana del código generado que condiciona cada recordStep (muestreo de bucles; vacía: ninguna)
+    virtual void setStepGuard(const std::string& guard) = 0;
+    virtual std::string getStepGuard() const = 0;
+    // Línea del fuente C de la sentencia en generación: se guarda en los descriptores de sus pasos
+    virtual void setSourceLine(int line) = 0;
+    virtual int getSourceLine() const = 0;
+    // Presupuesto de memoria de la traza que fija el main generado (--trace-budget; 0: sin límite)
+    virtual void setTraceBudget(size_t maxBytes, SimTraceOverflow overflow) = 0;
+    // Límites de ejecución que comprueba el programa generado (--max-steps, --max-seconds, --detect-loops; 0: sin límite)
+    virtual void setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops) = 0;
+    // --lazy: las funciones traducidas son corrutinas que se suspenden tras cada paso y el visor conserva
+    // los últimos 'window' pasos (0: se registra la ejecución entera antes de abrir el visor)
+    virtual void setLazyStepping(size_t window) = 0;
+    virtual bool isLazyStepping() const = 0;
+    // Fuente C del programa: el informe de --profile lo anota
+    virtual void setSourceFileName(const std::string& fileName) = 0;
+    // --profile: cuenta cada ejecución de la sentencia en generación (la línea de setSourceLine) y la
+    // marca como sitio en curso para el muestreo del tiempo; en los demás modos no genera nada. El
+    // sitio se restaura al terminar la sentencia (los de sus hijos no son los suyos).
+    virtual std::string generateProfileSite() = 0;
+    virtual int getProfileSite() const = 0;
+    virtual void setProfileSite(int site) = 0;
+
+    // Envoltorio del programa (se generan después del cuerpo)
+    virtual std::string getHeader() = 0;
+    virtual std::string getStepDescriptorTable() = 0;
+    virtual std::string getFrameLayoutTable() = 0;
+    virtual std::string getFooter() = 0;
+    virtual std::string getNativeHeader() const = 0;
+    virtual std::string getNativeFooter() const = 0;
+
+    // Nombre del archivo C++ generado, bibliotecas con las que se enlaza (--run) y archivos extra
+    virtual std::string getOutputFileName() const = 0;
+    virtual std::string getRuntimeLibraries() const = 0;
+    virtual std::string getCxxStandard() const = 0; // Para -std= al compilar el programa generado
+    virtual std::vector<GeneratedFile> getAuxiliaryFiles() const = 0;
+
+    // Sentencias
+    virtual std::string generateProgramStart() = 0;
+    virtual std::string generateProgramEnd() = 0;
+    virtual std::string generateVariableDeclaration(const std::string& typeName, const std::string& variableName, int slot, const std::string& initialValue) = 0;
+    virtual std::string generateAssignment(const std::string& identifierName, const std::string& typeName, int slot, const std::string& expressionCode) = 0;
+    virtual std::string generateReturnStatement(const std::string& expressionCode, const std::string& functionName) = 0;
+    virtual std::string generateIfStatement(const std::string& conditionCode, const std::string& thenBlockCode, const std::string& elseBlockCode) = 0;
+    // Con 'sampleGuard', el cuerpo y el incremento registran pasos en una de cada 'sampleEvery' iteraciones
+    virtual std::string generateForLoop(const std::string& initCode, const std::string& conditionCode, const std::string& updateCode, const std::string& bodyCode,
+                                        const std::string& sampleGuard, unsigned sampleEvery) = 0;
+    virtual std::string generatePrintStatement(const std::vector<FormatSegment>& segments, const std::vector<std::string>& argumentCodes) = 0;
+    virtual std::string generateFunctionEntry(const std::string& functionName, int layoutId, const std::vector<std::pair<int, std::string>>& paramSlots) = 0;
+    // Heap: malloc es una expresión (un int*, el único tipo puntero del lenguaje); free y '*p = v' son sentencias
+    virtual std::string generateMallocExpression(const std::string& sizeCode) = 0;
+    virtual std::string generateFreeStatement(const std::string& pointerCode) = 0;
+    virtual std::string generatePointerAssignment(const std::string& targetCode, const std::string& expressionCode) = 0;
+    // Variable local cuya dirección toma la función (&x), tras declararla: '*p = v' sobre ella actualiza su slot
+    virtual std::string generateStackAddressBinding(const std::string& variableName, const std::string& typeName, int slot) = 0;
+
+    // Diseño estático de los marcos de pila
+    virtual int addFrameLayout(const std::string& functionName) = 0;
+    virtual int addFrameSlot(int layoutId, const std::string& name, const std::string& typeName) = 0;
+};
+
+// Crea el backend indicado por --backend
+std::unique_ptr<CodeBackend> createBackend(BackendKind kind);
+
+#endif // CODEBACKEND_H
@@ -1,28 +1,239 @@
 // src/code_generator/CodeGenerator.cpp
-#include "CodeGenerator.h" // Incluye CodeGenerator.h, que a su vez incluye SFMLTranslator.h
+#include "CodeGenerator.h" // Incluye CodeGenerator.h, que a su vez incluye CodeBackend.h
 #include <iostream>
 #include <vector>
 #include <utility> // Para std::move
 
 // Incluir los encabezados de los nodos AST específicos para dynamic_cast
 #include "../parser/AST.h"
+#include "../runtime/SimulationLimits.h"
+#include "PrecomputedTraceEmitter.h"
+
+namespace {
+
+// Nombres de las variables cuya dirección se toma (&x) en la sentencia o expresión, incluidos sus bloques
+void collectAddressTakenNames(const ASTNode* node, std::unordered_set<std::string>& names) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case ASTNodeType::UnaryExpression: {
+            auto unary = static_cast<const UnaryExpressionNode*>(node);
+            if (unary->op == "&" && unary->operand && unary->operand->type == ASTNodeType::Identifier) {
+                names.insert(static_cast<const IdentifierNode*>(unary->operand.get())->name);
+            }
+            collectAddressTakenNames(unary->operand.get(), names);
+            break;
+        }
+        case ASTNodeType::BinaryExpression: {
+            auto binary = static_cast<const BinaryExpressionNode*>(node);
+            collectAddressTakenNames(binary->left.get(), names);
+            collectAddressTakenNames(binary->right.get(), names);
+            break;
+        }
+        case ASTNodeType::FunctionCall:
+            for (const auto& arg : static_cast<const FunctionCallNode*>(node)->arguments) {
+                collectAddressTakenNames(arg.get(), names);
+            }
+            break;
+        case ASTNodeType::MallocExpression:
+            collectAddressTakenNames(static_cast<const MallocExpressionNode*>(node)->size.get(), names);
+            break;
+        case ASTNodeType::VariableDeclaration:
+            collectAddressTakenNames(static_cast<const VariableDeclarationNode*>(node)->initializer.get(), names);
+            break;
+        case ASTNodeType::AssignmentStatement:
+            collectAddressTakenNames(static_cast<const AssignmentStatementNode*>(node)->expression.get(), names);
+            break;
+        case ASTNodeType::IfStatement: {
+            auto ifNode = static_cast<const IfStatementNode*>(node);
+            collectAddressTakenNames(ifNode->condition.get(), names);
+            collectAddressTakenNames(ifNode->thenBlock.get(), names);
+            collectAddressTakenNames(ifNode->elseBlock.get(), names);
+            break;
+        }
+        case ASTNodeType::ForStatement: {
+            auto forNode = static_cast<const ForStatementNode*>(node);
+            collectAddressTakenNames(forNode->initialization.get(), names);
+            collectAddressTakenNames(forNode->condition.get(), names);
+            collectAddressTakenNames(forNode->increment.get(), names);
+            collectAddressTakenNames(forNode->body.get(), names);
+            break;
+        }
+        case ASTNodeType::ReturnStatement:
+            collectAddressTakenNames(static_cast<const ReturnStatementNode*>(node)->expression.get(), names);
+            break;
+        case ASTNodeType::PrintStatement:
+            for (const auto& arg : static_cast<const PrintStatementNode*>(node)->arguments) {
+                collectAddressTakenNames(arg.get(), names);
+            }
+            break;
+        case ASTNodeType::FreeStatement:
+            collectAddressTakenNames(static_cast<const FreeStatementNode*>(node)->pointer.get(), names);
+            break;
+        case ASTNodeType::PointerAssignmentStatement: {
+            auto store = static_cast<const PointerAssignmentStatementNode*>(node);
+            collectAddressTakenNames(store->target.get(), names);
+            collectAddressTakenNames(store->expression.get(), names);
+            break;
+        }
+        case ASTNodeType::BlockStatement:
+            for (const auto& stmt : static_cast<const BlockStatementNode*>(node)->statements) {
+                collectAddressTakenNames(stmt.get(), names);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
 
 
 // Constructor: Ahora recibe ErrorHandler
 CodeGenerator::CodeGenerator(ErrorHandler& errorHandler)
-    : currentFunctionName(""), errorHandler(errorHandler) {
+    : translator(createBackend(BackendKind::SFML)), currentFunctionName(""), instrumentationPlan(nullptr), currentFrameLayout(-1), errorHandler(errorHandler) {
     // Constructor
 }
 
+CodeGenerator::CodeGenerator(ErrorHandler& errorHandler, std::unique_ptr<CodeBackend> backend)
+    : translator(std::move(backend)), currentFunctionName(""), instrumentationPlan(nullptr), currentFrameLayout(-1), errorHandler(errorHandler) {
+}
+
+std::string CodeGenerator::getOutputFileName() const {
+    return translator->getOutputFileName();
+}
+
+std::string CodeGenerator::getRuntimeLibraries() const {
+    return translator->getRuntimeLibraries();
+}
+
+std::string CodeGenerator::getCxxStandard() const {
+    return translator->getCxxStandard();
+}
+
+std::vector<GeneratedFile> CodeGenerator::getAuxiliaryFiles() const {
+    return translator->getAuxiliaryFiles();
+}
+
 std::string CodeGenerator::generate(ProgramNode* program) {
     return visitProgramNode(program);
 }
 
+std::string CodeGenerator::generatePrecomputed(const BytecodeProgram& program, const std::string& output) {
+    std::stringstream ss;
+    ss << translator->getHeader();
+    ss << PrecomputedTraceEmitter(program).emit(output);
+    ss << translator->getFooter();
+    return ss.str();
+}
+
+void CodeGenerator::setEmitMode(EmitMode mode) {
+    translator->setEmitMode(mode);
+}
+
+void CodeGenerator::setTraceBudget(size_t maxBytes, SimTraceOverflow overflow) {
+    translator->setTraceBudget(maxBytes, overflow);
+}
+
+void CodeGenerator::setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops) {
+    translator->setExecutionLimits(maxSteps, maxMillis, detectLoops);
+}
+
+void CodeGenerator::setLazyStepping(size_t window) {
+    translator->setLazyStepping(window);
+}
+
+void CodeGenerator::setInstrumentationPlan(const InstrumentationPlan* plan) {
+    instrumentationPlan = plan;
+}
+
+void CodeGenerator::setSourceFileName(const std::string& fileName) {
+    sourceFileName = fileName;
+    translator->setSourceFileName(fileName);
+}
+
+// --- Directivas #line ---
+
+// Marca que resolveGeneratedLineDirectives() sustituye por la línea real del archivo generado,
+// que solo se conoce cuando el programa está completo
+static const char* const GENERATED_LINE_MARKER = "#line __generated__";
+
+static std::string quotedFileName(const std::string& fileName) {
+    std::string quoted = "\"";
+    for (char c : fileName) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::string CodeGenerator::sourceLineDirective(const ASTNode* node) const {
+    if (sourceFileName.empty() || node->line <= 0) {
+        return "";
+    }
+    return "#line " + std::to_string(node->line) + " " + quotedFileName(sourceFileName) + "\n";
+}
+
+std::string CodeGenerator::generatedLineDirective() const {
+    return sourceFileName.empty() ? "" : std::string(GENERATED_LINE_MARKER) + "\n";
+}
+
+std::string CodeGenerator::resolveGeneratedLineDirectives(const std::string& code) const {
+    if (sourceFileName.empty()) {
+        return code;
+    }
+    const std::string marker = GENERATED_LINE_MARKER;
+    const std::string outputFileName = quotedFileName(translator->getOutputFileName());
+    std::string resolved;
+    resolved.reserve(code.size());
+    int lineNumber = 1;
+    size_t lineStart = 0;
+    while (lineStart < code.size()) {
+        size_t lineEnd = code.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? code.size() : lineEnd + 1;
+        if (code.compare(lineStart, lineEnd - lineStart, marker + "\n") == 0) {
+            // La línea siguiente a la directiva es la lineNumber + 1 del archivo generado
+            resolved += "#line " + std::to_string(lineNumber + 1) + " " + outputFileName + "\n";
+        } else {
+            resolved.append(code, lineStart, lineEnd - lineStart);
+        }
+        lineStart = lineEnd;
+        ++lineNumber;
+    }
+    return resolved;
+}
+
 std::string CodeGenerator::visit(ASTNode* node) {
     if (!node) {
         return "";
     }
 
+    // Cada sentencia decide si registra paso; al volver se restaura el estado del padre
+    // (if y for generan su propio paso después de visitar sus hijos).
+    bool previousRecording = translator->isStepRecordingEnabled();
+    if (instrumentationPlan && node->type != ASTNodeType::BlockStatement && node->type != ASTNodeType::FunctionDeclaration) {
+        translator->setStepRecordingEnabled(instrumentationPlan->recordsStep(node));
+    }
+    const bool isStatement = node->type != ASTNodeType::BlockStatement && node->type != ASTNodeType::FunctionDeclaration;
+    const int previousLine = translator->getSourceLine();
+    const int previousSite = translator->getProfileSite();
+    std::string code;
+    if (isStatement && node->line > 0) {
+        translator->setSourceLine(node->line);
+        code = sourceLineDirective(node);
+        code += translator->generateProfileSite();
+    }
+    code += visitStatement(node);
+    translator->setStepRecordingEnabled(previousRecording);
+    translator->setSourceLine(previousLine);
+    translator->setProfileSite(previousSite);
+    return code;
+}
+
+std::string CodeGenerator::visitStatement(ASTNode* node) {
     switch(node->type) {
         case ASTNodeType::Program:
             return ""; // La lógica se maneja en visitProgramNode
@@ -40,6 +251,10 @@ std::string CodeGenerator::visit(ASTNode* node) {
             return visitForStatementNode(static_cast<ForStatementNode*>(node));
         case ASTNodeType::PrintStatement:
             return visitPrintStatementNode(static_cast<PrintStatementNode*>(node));
+        case ASTNodeType::FreeStatement:
+            return visitFreeStatementNode(static_cast<FreeStatementNode*>(node));
+        case ASTNodeType::PointerAssignmentStatement:
+            return visitPointerAssignmentStatementNode(static_cast<PointerAssignmentStatementNode*>(node));
         case ASTNodeType::BlockStatement:
             return visitBlockStatementNode(static_cast<BlockStatementNode*>(node));
         case ASTNodeType::FunctionCall:
@@ -59,185 +274,187 @@ std::string CodeGenerator::visit(ASTNode* node) {
 std::string CodeGenerator::visitProgramNode(ProgramNode* node) {
     std::stringstream ss;
 
-    // Generar el encabezado SFML (includes, variables globales, prototipos)
-    ss << translator.getSFMLHeader();
-
-    // Generar las declaraciones de funciones C (excepto main)
-    for (const auto& func : node->functionDeclarations) {
-        if (static_cast<FunctionDeclarationNode*>(func.get())->name != "main") {
-            ss << visitFunctionDeclarationNode(static_cast<FunctionDeclarationNode*>(func.get()));
-            ss << std::endl;
-        }
+    // El cuerpo se genera primero: el encabezado y la tabla de descriptores de pasos
+    // dependen de los sitios instrumentados que registre el traductor.
+    std::stringstream body;
+    generateProgramBody(node, body);
+
+    // Modo nativo (y de perfil): mismo recorrido, sin instrumentación ni bucle de ventana SFML
+    if (translator->getEmitMode() != EmitMode::Visualization) {
+        ss << translator->getNativeHeader();
+        ss << std::endl;
+        ss << body.str();
+        ss << translator->getNativeFooter();
+        return resolveGeneratedLineDirectives(ss.str());
     }
 
-    // Generar la función run_c_program_simulation que contiene la lógica del programa C
-    ss << "void run_c_program_simulation() {" << std::endl;
-    translator.increaseIndent(); // Indentación para el cuerpo de run_c_program_simulation
+    // Generar el encabezado (include del runtime)
+    ss << translator->getHeader();
+    ss << translator->getStepDescriptorTable();
+    ss << translator->getFrameLayoutTable();
+    ss << std::endl;
+    ss << body.str();
 
-    ss << translator.generateProgramStart(); // Llama a recordStep("Program Started")
+    // Generar el main (el visor y el registro de pasos están en el runtime precompilado)
+    ss << translator->getFooter();
+    return resolveGeneratedLineDirectives(ss.str());
+}
 
+// Genera las funciones C traducidas y run_c_program_simulation()
+void CodeGenerator::generateProgramBody(ProgramNode* node, std::stringstream& out) {
+    // Generar las funciones C (main se renombra para no chocar con el main de SFML)
     bool main_found = false;
     for (const auto& func : node->functionDeclarations) {
         auto funcDecl = static_cast<FunctionDeclarationNode*>(func.get());
-        if (funcDecl->name == "main") {
-            main_found = true;
-            std::string previousFunctionName = currentFunctionName;
-            currentFunctionName = "main";
-
-            ss << translator.generateFunctionEntry("main", {}); // Registra la entrada a main
-
-            if (funcDecl->body) {
-                ss << visit(funcDecl->body.get()); // Visita el cuerpo de main
-            }
+        main_found = main_found || funcDecl->name == "main";
+        out << visitFunctionDeclarationNode(funcDecl);
+        out << std::endl;
+    }
 
-            ss << translator.generateFunctionExit("main", ""); // Registra la salida de main
+    // Generar la función run_c_program_simulation que contiene la lógica del programa C
+    out << (translator->isLazyStepping() ? "SimulationTask<void>" : "void") << " run_c_program_simulation() {" << std::endl;
+    translator->increaseIndent(); // Indentación para el cuerpo de run_c_program_simulation
 
-            currentFunctionName = previousFunctionName;
-            break;
-        }
-    }
+    out << translator->generateProgramStart(); // Llama a recordStep("Program Started")
 
-    if (!main_found) {
+    if (main_found) {
+        out << translator->getCurrentIndent() << (translator->isLazyStepping() ? "co_await " : "") << translatedFunctionName("main") << "();" << std::endl;
+    } else {
         errorHandler.reportWarning("No se encontró la función 'main()' en el código C. Ejecutando sentencias globales si las hay.", -1, -1);
-        ss << translator.generateFunctionEntry("global_scope", {});
+        out << translator->getCurrentIndent() << "{" << std::endl;
+        translator->increaseIndent();
+        beginFrame("global_scope");
+        for (const auto& stmt : node->statements) {
+            collectAddressTakenNames(stmt.get(), addressTakenLocals);
+        }
+        out << generateFunctionEntry("global_scope", {}, {});
         for (const auto& stmt : node->statements) {
-            ss << visit(stmt.get());
+            out << visit(stmt.get());
         }
-        ss << translator.generateFunctionExit("global_scope", "");
+        out << generatedLineDirective();
+        endFrame();
+        translator->decreaseIndent();
+        out << translator->getCurrentIndent() << "}" << std::endl;
     }
 
-    ss << translator.generateProgramEnd(); // Llama a recordStep("Program Ended")
-    translator.decreaseIndent(); // Cierra la indentación de run_c_program_simulation
-    ss << "}" << std::endl; // Cierra la función run_c_program_simulation
-
-    // Generar el pie de página SFML (implementaciones de funciones auxiliares)
-    ss << translator.getSFMLFooter();
-
-    // Generar la función main de SFML
-    ss << std::endl;
-    ss << "int main() {" << std::endl;
-    translator.increaseIndent(); // Indentación para el cuerpo de main SFML
-
-    // Configuración inicial de la ventana SFML
-    ss << translator.getCurrentIndent() << "sf::RenderWindow window(sf::VideoMode(1000, 500), \"C to SFML Compiler Visualization\");" << std::endl;
-    ss << translator.getCurrentIndent() << "setupSFML(window);" << std::endl;
-    ss << translator.getCurrentIndent() << "window.setFramerateLimit(60);" << std::endl;
-
-    ss << std::endl;
-    ss << translator.getCurrentIndent() << "// --- Primera pasada: Ejecutar la simulación C para registrar todos los pasos ---" << std::endl;
-    ss << translator.getCurrentIndent() << "run_c_program_simulation();" << std::endl; // Llama a la lógica del programa C simulado
-    ss << translator.getCurrentIndent() << "currentStepIndex = 0; // Comienza en el primer paso registrado" << std::endl;
-    ss << std::endl;
-
-    ss << translator.getCurrentIndent() << "// --- Bucle principal de eventos SFML para la navegación ---" << std::endl;
-    ss << translator.getCurrentIndent() << "while (window.isOpen()) {" << std::endl;
-    translator.increaseIndent(); // Indentación para el bucle while(window.isOpen())
-
-    ss << translator.getCurrentIndent() << "sf::Event event;" << std::endl;
-    ss << translator.getCurrentIndent() << "while (window.pollEvent(event)) {" << std::endl;
-    translator.increaseIndent(); // Indentación para el bucle while(window.pollEvent(event))
-
-    ss << translator.getCurrentIndent() << "if (event.type == sf::Event::Closed) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "window.close();" << std::endl;
-    translator.decreaseIndent();
-    ss << translator.getCurrentIndent() << "}" << std::endl;
-
-    ss << translator.getCurrentIndent() << "if (event.type == sf::Event::MouseButtonPressed) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "if (event.mouseButton.button == sf::Mouse::Left) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "sf::Vector2i mousePos = sf::Mouse::getPosition(window);" << std::endl;
-    ss << translator.getCurrentIndent() << "const float BUTTON_WIDTH = 100.f;" << std::endl;
-    ss << translator.getCurrentIndent() << "const float BUTTON_HEIGHT = 40.f;" << std::endl; // Definir BUTTON_HEIGHT
-    ss << translator.getCurrentIndent() << "const float BUTTON_Y = window.getSize().y - BUTTON_HEIGHT - 20;" << std::endl; // Usar BUTTON_HEIGHT
-
-    ss << std::endl;
-    ss << translator.getCurrentIndent() << "// Botón Siguiente" << std::endl;
-    ss << translator.getCurrentIndent() << "const float NEXT_BUTTON_X = window.getSize().x / 2 + 10;" << std::endl;
-    ss << translator.getCurrentIndent() << "sf::FloatRect nextButtonBounds(NEXT_BUTTON_X, BUTTON_Y, BUTTON_WIDTH, BUTTON_HEIGHT);" << std::endl; // Usar BUTTON_HEIGHT
-    ss << translator.getCurrentIndent() << "if (nextButtonBounds.contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "if (currentStepIndex < simulationHistory.size() - 1) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "currentStepIndex++;" << std::endl;
-    ss << translator.getCurrentIndent() << "}" << std::endl; // Cierra if (currentStepIndex < simulationHistory.size() - 1)
-    translator.decreaseIndent();
-    ss << translator.getCurrentIndent() << "}" << std::endl; // Cierra if (nextButtonBounds.contains)
-
-    ss << std::endl;
-    ss << translator.getCurrentIndent() << "// Botón Anterior" << std::endl;
-    ss << translator.getCurrentIndent() << "const float PREV_BUTTON_X = window.getSize().x / 2 - BUTTON_WIDTH - 10;" << std::endl;
-    ss << translator.getCurrentIndent() << "sf::FloatRect prevButtonBounds(PREV_BUTTON_X, BUTTON_Y, BUTTON_WIDTH, BUTTON_HEIGHT);" << std::endl; // Usar BUTTON_HEIGHT
-    ss << translator.getCurrentIndent() << "if (prevButtonBounds.contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "if (currentStepIndex > 0) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "currentStepIndex--;" << std::endl;
-    ss << translator.getCurrentIndent() << "}" << std::endl; // Cierra if (currentStepIndex > 0)
-    translator.decreaseIndent();
-    ss << translator.getCurrentIndent() << "}" << std::endl; // Cierra if (prevButtonBounds.contains)
-
-    translator.decreaseIndent(); // Cierra if (event.mouseButton.button == sf::Mouse::Left)
-    ss << translator.getCurrentIndent() << "}" << std::endl;
-
-    translator.decreaseIndent(); // Cierra if (event.type == sf::Event::MouseButtonPressed)
-    ss << translator.getCurrentIndent() << "}" << std::endl;
-
-    translator.decreaseIndent(); // Cierra while (window.pollEvent(event))
-    ss << translator.getCurrentIndent() << "}" << std::endl;
+    out << translator->generateProgramEnd(); // Llama a recordStep("Program Ended")
+    translator->decreaseIndent(); // Cierra la indentación de run_c_program_simulation
+    out << "}" << std::endl; // Cierra la función run_c_program_simulation
+}
 
-    // Después de procesar los eventos, actualiza y dibuja el paso actual
-    ss << translator.getCurrentIndent() << "if (!simulationHistory.empty()) {" << std::endl;
-    translator.increaseIndent();
-    ss << translator.getCurrentIndent() << "displaySpecificStep(simulationHistory[currentStepIndex]);" << std::endl;
-    translator.decreaseIndent();
-    ss << translator.getCurrentIndent() << "}" << std::endl;
+// Nombre de la función en el código generado: el main del programa C no puede llamarse main
+std::string CodeGenerator::translatedFunctionName(const std::string& name) {
+    return name == "main" ? "c_program_main" : name;
+}
 
-    ss << translator.getCurrentIndent() << "sf::sleep(sf::milliseconds(10)); // Pequeño sleep para reducir el uso de CPU" << std::endl;
+// --- Asignación de slots de pila en tiempo de compilación ---
 
-    translator.decreaseIndent(); // Cierra while (window.isOpen())
-    ss << translator.getCurrentIndent() << "}" << std::endl;
+void CodeGenerator::beginFrame(const std::string& functionName) {
+    currentFrameLayout = translator->addFrameLayout(functionName);
+    localScopes.clear();
+    localScopes.emplace_back();
+}
 
-    ss << translator.getCurrentIndent() << "return 0;" << std::endl;
+void CodeGenerator::endFrame() {
+    localScopes.clear();
+    addressTakenLocals.clear();
+    currentFrameLayout = -1;
+}
 
-    translator.decreaseIndent(); // Cierra la indentación de main SFML
-    ss << "}" << std::endl; // Cierra la función main SFML
+// Cada declaración recibe un slot propio en el marco de la función, incluso si oculta a otra. El runtime
+// precompilado tiene una capacidad fija por marco: el error se sitúa en la declaración que la supera
+int CodeGenerator::declareLocal(const std::string& name, const std::string& typeName, const ASTNode* declaration) {
+    if (currentFrameLayout < 0 || localScopes.empty()) {
+        return -1;
+    }
+    int slot = translator->addFrameSlot(currentFrameLayout, name, typeName);
+    if (slot == SIM_MAX_FRAME_SLOTS && translator->getEmitMode() == EmitMode::Visualization) {
+        errorHandler.reportError("La variable '" + name + "' supera el máximo de " + std::to_string(SIM_MAX_FRAME_SLOTS) +
+                                 " variables locales por función que admite el runtime.", declaration->line, declaration->column);
+    }
+    localScopes.back()[name] = {typeName, slot};
+    return slot;
+}
 
-    return ss.str();
+const CodeGenerator::LocalVariable* CodeGenerator::lookupLocal(const std::string& name) const {
+    for (auto it = localScopes.rbegin(); it != localScopes.rend(); ++it) {
+        auto found = it->find(name);
+        if (found != it->end()) {
+            return &found->second;
+        }
+    }
+    return nullptr;
 }
 
 std::string CodeGenerator::visitFunctionDeclarationNode(FunctionDeclarationNode* node) {
     std::stringstream ss;
     std::string paramsCode;
-    std::vector<std::pair<std::string, std::string>> paramsForSFML;
 
     for (size_t i = 0; i < node->parameters.size(); ++i) {
         paramsCode += node->parameters[i].first + " " + node->parameters[i].second;
-        paramsForSFML.push_back({node->parameters[i].first, node->parameters[i].second});
         if (i < node->parameters.size() - 1) {
             paramsCode += ", ";
         }
     }
 
-    ss << translator.getCurrentIndent() << node->returnType << " " << node->name << "(" << paramsCode << ") {" << std::endl;
-    translator.increaseIndent();
+    // --lazy: cada función es una corrutina que devuelve su valor al co_await de quien la llama
+    const std::string returnType = translator->isLazyStepping() ? "SimulationTask<" + node->returnType + ">" : node->returnType;
+    ss << sourceLineDirective(node);
+    ss << translator->getCurrentIndent() << returnType << " " << translatedFunctionName(node->name) << "(" << paramsCode << ") {" << std::endl;
+    translator->increaseIndent();
 
     std::string previousFunctionName = currentFunctionName;
     currentFunctionName = node->name;
 
+    // El paso de entrada a la función lleva la línea de su cabecera
+    const int previousLine = translator->getSourceLine();
+    translator->setSourceLine(node->line);
+
+    // Los parámetros ocupan los primeros slots del marco
+    beginFrame(node->name);
+    collectAddressTakenNames(node->body.get(), addressTakenLocals);
+    std::vector<std::pair<int, std::string>> paramSlots;
+    for (const auto& param : node->parameters) {
+        paramSlots.push_back({declareLocal(param.second, param.first, node), param.second});
+    }
+    ss << generateFunctionEntry(node->name, node->parameters, paramSlots);
+    for (size_t i = 0; i < node->parameters.size(); ++i) {
+        if (addressTakenLocals.count(node->parameters[i].second) > 0) {
+            ss << translator->generateStackAddressBinding(node->parameters[i].second, node->parameters[i].first, paramSlots[i].first);
+        }
+    }
+
     if (node->body) {
         ss << visit(node->body.get());
     } else {
         errorHandler.reportWarning("Cuerpo de función nulo para: " + node->name, -1, -1);
     }
+    if (translator->isLazyStepping() && node->returnType == "void") {
+        // Una función void sin return ni pasos registrados no sería una corrutina
+        ss << translator->getCurrentIndent() << "co_return;" << std::endl;
+    }
 
+    endFrame();
     currentFunctionName = previousFunctionName;
-    translator.decreaseIndent();
-    ss << translator.getCurrentIndent() << "}" << std::endl;
+    translator->setSourceLine(previousLine);
+    translator->decreaseIndent();
+    ss << translator->getCurrentIndent() << "}" << std::endl;
+    ss << generatedLineDirective();
     return ss.str();
 }
 
+// El plan puede descartar el paso de entrada (--trace-functions, --trace-vars); el marco se empuja siempre
+std::string CodeGenerator::generateFunctionEntry(const std::string& functionName, const std::vector<std::pair<std::string, std::string>>& parameters,
+                                                 const std::vector<std::pair<int, std::string>>& paramSlots) {
+    const bool previousRecording = translator->isStepRecordingEnabled();
+    if (instrumentationPlan) {
+        translator->setStepRecordingEnabled(instrumentationPlan->recordsFunctionEntry(functionName, parameters));
+    }
+    std::string code = translator->generateFunctionEntry(functionName, currentFrameLayout, paramSlots);
+    translator->setStepRecordingEnabled(previousRecording);
+    return code;
+}
+
 std::string CodeGenerator::visitVariableDeclarationNode(VariableDeclarationNode* node) {
     std::stringstream ss;
     std::string initialValueStr;
@@ -246,14 +463,10 @@ std::string CodeGenerator::visitVariableDeclarationNode(VariableDeclarationNode*
         initialValueStr = generateExpression(node->initializer.get());
     }
 
-    ss << translator.generateVariableDeclaration(node->typeName, node->variableName, initialValueStr);
-
-    if (!initialValueStr.empty()) {
-        ss << translator.generateVariableUpdate(node->variableName, initialValueStr);
-    } else {
-        if (node->typeName == "int") {
-            ss << translator.generateVariableUpdate(node->variableName, "0");
-        }
+    int slot = declareLocal(node->variableName, node->typeName, node);
+    ss << translator->generateVariableDeclaration(node->typeName, node->variableName, slot, initialValueStr);
+    if (addressTakenLocals.count(node->variableName) > 0) {
+        ss << translator->generateStackAddressBinding(node->variableName, node->typeName, slot);
     }
     return ss.str();
 }
@@ -262,26 +475,15 @@ std::string CodeGenerator::visitAssignmentStatementNode(AssignmentStatementNode*
     std::stringstream ss;
     std::string exprCode = generateExpression(node->expression.get());
 
-    ss << translator.generateAssignment(node->identifierName, exprCode);
-    ss << translator.generateVariableUpdate(node->identifierName, exprCode);
+    const LocalVariable* local = lookupLocal(node->identifierName);
+    ss << translator->generateAssignment(node->identifierName, local ? local->typeName : "int", local ? local->slot : -1, exprCode);
     return ss.str();
 }
 
 std::string CodeGenerator::visitFunctionCallNode(FunctionCallNode* node) {
+    // El marco y el paso de entrada los registra la propia función llamada
     std::stringstream ss;
-    std::string argsCode;
-    std::vector<std::pair<std::string, std::string>> argsForSFML;
-
-    for (size_t i = 0; i < node->arguments.size(); ++i) {
-        std::string argExpr = generateExpression(node->arguments[i].get());
-        argsCode += argExpr;
-        argsForSFML.push_back({"param_type", argExpr}); // Tipo genérico, el valor es lo importante para la visualización
-        if (i < node->arguments.size() - 1) {
-            argsCode += ", ";
-        }
-    }
-    ss << translator.generateFunctionEntry(node->functionName, argsForSFML);
-    ss << translator.getCurrentIndent() << node->functionName << "(" << argsCode << ");" << std::endl;
+    ss << translator->getCurrentIndent() << generateExpression(node) << ";" << std::endl;
     return ss.str();
 }
 
@@ -291,54 +493,97 @@ std::string CodeGenerator::visitReturnStatementNode(ReturnStatementNode* node) {
     if (node->expression) {
         exprCode = generateExpression(node->expression.get());
     }
-    ss << translator.generateReturnStatement(exprCode, currentFunctionName);
-    ss << translator.generateFunctionExit(currentFunctionName, exprCode);
+    // StackFrameScope saca el marco al ejecutar el return
+    ss << translator->generateReturnStatement(exprCode, currentFunctionName);
     return ss.str();
 }
 
 std::string CodeGenerator::visitIfStatementNode(IfStatementNode* node) {
     std::stringstream ss;
     std::string conditionCode = generateExpression(node->condition.get());
+    // Las ramas quedan dentro del bloque de la condición y del if que emite el traductor: dos niveles más
+    translator->increaseIndent();
+    translator->increaseIndent();
     std::string thenBlockCode = visit(node->thenBlock.get());
     std::string elseBlockCode = node->elseBlock ? visit(node->elseBlock.get()) : "";
+    translator->decreaseIndent();
+    translator->decreaseIndent();
 
-    ss << translator.generateIfStatement(conditionCode, thenBlockCode, elseBlockCode);
+    ss << translator->generateIfStatement(conditionCode, thenBlockCode, elseBlockCode);
     return ss.str();
 }
 
 std::string CodeGenerator::visitForStatementNode(ForStatementNode* node) {
     std::stringstream ss;
+    // El for se envuelve en un bloque: la variable de inicialización pertenece a su ámbito
+    ss << translator->getCurrentIndent() << "{" << std::endl;
+    translator->increaseIndent();
+    localScopes.emplace_back();
+
     std::string initCode = visit(node->initialization.get());
     std::string conditionCode = generateExpression(node->condition.get());
-    std::string updateCode = generateExpression(node->increment.get());
-    std::string bodyCode = visit(node->body.get());
 
-    ss << translator.generateForLoop(initCode, conditionCode, updateCode, bodyCode);
+    // --trace-every: los pasos del cuerpo y del incremento quedan condicionados por la muestra del bucle
+    const unsigned sampleEvery = instrumentationPlan ? instrumentationPlan->loopSampling() : 1;
+    std::string sampleGuard;
+    if (sampleEvery > 1 && translator->getEmitMode() == EmitMode::Visualization) {
+        sampleGuard = "traceSample" + std::to_string(sampledLoopCount++);
+    }
+    const std::string previousGuard = translator->getStepGuard();
+    if (!sampleGuard.empty()) {
+        translator->setStepGuard(sampleGuard);
+    }
+    translator->increaseIndent();
+    std::string bodyCode = visit(node->body.get());
+    std::string updateCode = visit(node->increment.get());
+    translator->decreaseIndent();
+    translator->setStepGuard(previousGuard);
+
+    ss << translator->generateForLoop(initCode, conditionCode, updateCode, bodyCode, sampleGuard, sampleEvery);
+    localScopes.pop_back();
+    translator->decreaseIndent();
+    ss << translator->getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
 std::string CodeGenerator::visitPrintStatementNode(PrintStatementNode* node) {
     std::stringstream ss;
-    std::string printArgs = "\"" + node->formatString + "\"";
+    // El paso de printf lleva un valor por argumento y el runtime precompilado tiene una capacidad fija
+    if (translator->getEmitMode() == EmitMode::Visualization && translator->isStepRecordingEnabled() &&
+        node->arguments.size() > static_cast<size_t>(SIM_MAX_STEP_ARGS)) {
+        errorHandler.reportError("printf registra " + std::to_string(node->arguments.size()) + " valores en su paso; el runtime admite como máximo " +
+                                 std::to_string(SIM_MAX_STEP_ARGS) + ".", node->line, node->column);
+    }
+    std::vector<std::string> argumentCodes;
 
     for (const auto& arg : node->arguments) {
-        printArgs += ", " + generateExpression(arg.get());
+        argumentCodes.push_back(generateExpression(arg.get()));
     }
-    ss << translator.generatePrintStatement(printArgs);
+    ss << translator->generatePrintStatement(node->segments, argumentCodes);
     return ss.str();
 }
 
+std::string CodeGenerator::visitFreeStatementNode(FreeStatementNode* node) {
+    return translator->generateFreeStatement(generateExpression(node->pointer.get()));
+}
+
+std::string CodeGenerator::visitPointerAssignmentStatementNode(PointerAssignmentStatementNode* node) {
+    return translator->generatePointerAssignment(generateExpression(node->target.get()), generateExpression(node->expression.get()));
+}
+
 std::string CodeGenerator::visitBlockStatementNode(BlockStatementNode* node) {
     std::stringstream ss;
-    ss << translator.getCurrentIndent() << "{" << std::endl;
-    translator.increaseIndent();
+    ss << translator->getCurrentIndent() << "{" << std::endl;
+    translator->increaseIndent();
+    localScopes.emplace_back();
 
     for (const auto& stmt : node->statements) {
         ss << visit(stmt.get());
     }
 
-    translator.decreaseIndent();
-    ss << translator.getCurrentIndent() << "}" << std::endl;
+    localScopes.pop_back();
+    translator->decreaseIndent();
+    ss << translator->getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
@@ -366,8 +611,11 @@ std::string CodeGenerator::generateExpression(ASTNode* node) {
                         ss_args << ", ";
                     }
                 }
-                return funcCall->functionName + "(" + ss_args.str() + ")";
+                const std::string call = translatedFunctionName(funcCall->functionName) + "(" + ss_args.str() + ")";
+                return translator->isLazyStepping() ? "(co_await " + call + ")" : call;
             }
+        case ASTNodeType::MallocExpression:
+            return translator->generateMallocExpression(generateExpression(static_cast<MallocExpressionNode*>(node)->size.get()));
         default:
             errorHandler.reportError("Tipo de nodo desconocido o no esperado como expresión: " + std::to_string(static_cast<int>(node->type)), -1, -1);
             return "";
@@ -379,6 +627,9 @@ std::string CodeGenerator::visitIdentifierNode(IdentifierNode* node) {
 }
 
 std::string CodeGenerator::visitLiteralNode(LiteralNode* node) {
+    if (node->isString) {
+        return "\"" + node->value + "\""; // El lexer elimina las comillas
+    }
     return node->value;
 }
 
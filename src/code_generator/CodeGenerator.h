@@ -2,13 +2,17 @@
 #ifndef CODEGENERATOR_H
 #define CODEGENERATOR_H
 
-#include "SFMLTranslator.h"
+#include "CodeBackend.h"
+#include "../vm/Bytecode.h"
 #include "../parser/AST.h" // Incluye el AST.h para todas las definiciones
 #include "../utils/ErrorHandler.h" // <--- ¡NUEVO: Incluir ErrorHandler!
+#include "../ir/InstrumentationPlan.h"
 #include <string>
 #include <memory>   // Para std::unique_ptr
 #include <sstream>  // Para std::stringstream
 #include <vector>   // Para std::vector en parámetros de funciones
+#include <map>
+#include <unordered_set>
 
 // Forward declarations para los nodos del AST (generalmente no necesarias si AST.h se incluye completamente)
 class ProgramNode;
@@ -30,8 +34,31 @@ class CodeGenerator {
 public:
     // Constructor: Ahora toma una referencia a ErrorHandler
     explicit CodeGenerator(ErrorHandler& errorHandler); // <--- ¡CONSTRUCTOR MODIFICADO!
+    // Usa el backend indicado en lugar del visor SFML por defecto
+    CodeGenerator(ErrorHandler& errorHandler, std::unique_ptr<CodeBackend> backend);
 
     std::string generate(ProgramNode* program);
+    // --precompute: el programa generado solo carga la traza que ya calculó la VM
+    std::string generatePrecomputed(const BytecodeProgram& program, const std::string& output);
+
+    // Datos del backend para escribir y compilar la salida
+    std::string getOutputFileName() const;
+    std::string getRuntimeLibraries() const;
+    std::string getCxxStandard() const;
+    std::vector<GeneratedFile> getAuxiliaryFiles() const;
+
+    // Visualización SFML (por defecto) o C++ nativo sin instrumentación
+    void setEmitMode(EmitMode mode);
+    void setTraceBudget(size_t maxBytes, SimTraceOverflow overflow);
+    void setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops);
+    void setLazyStepping(size_t window); // --lazy (0: desactivado)
+
+    // Plan que decide qué sentencias registran paso (nullptr: todas)
+    void setInstrumentationPlan(const InstrumentationPlan* plan);
+
+    // Con un nombre de archivo, cada sentencia va precedida de '#line N "archivo.c"', de modo que
+    // perf, gdb y los sanitizers atribuyen el código generado a las líneas del fuente C
+    void setSourceFileName(const std::string& fileName);
 
     std::string visit(ASTNode* node);
     std::string visitProgramNode(ProgramNode* node);
@@ -43,6 +70,8 @@ public:
     std::string visitIfStatementNode(IfStatementNode* node);
     std::string visitForStatementNode(ForStatementNode* node);
     std::string visitPrintStatementNode(PrintStatementNode* node);
+    std::string visitFreeStatementNode(FreeStatementNode* node);
+    std::string visitPointerAssignmentStatementNode(PointerAssignmentStatementNode* node);
     std::string visitBlockStatementNode(BlockStatementNode* node);
 
     std::string generateExpression(ASTNode* node);
@@ -52,8 +81,36 @@ public:
     std::string visitUnaryExpressionNode(UnaryExpressionNode* node);
 
 private:
-    SFMLTranslator translator;
+    // Variable local con su slot en el marco de la función actual
+    struct LocalVariable {
+        std::string typeName;
+        int slot;
+    };
+
+    void generateProgramBody(ProgramNode* node, std::stringstream& out);
+    static std::string translatedFunctionName(const std::string& name);
+    std::string visitStatement(ASTNode* node);
+
+    // Directivas #line: hacia el fuente C y, tras el código del usuario, de vuelta al archivo generado
+    std::string sourceLineDirective(const ASTNode* node) const;
+    std::string generatedLineDirective() const;
+    std::string resolveGeneratedLineDirectives(const std::string& code) const;
+
+    void beginFrame(const std::string& functionName);
+    void endFrame();
+    int declareLocal(const std::string& name, const std::string& typeName, const ASTNode* declaration);
+    const LocalVariable* lookupLocal(const std::string& name) const;
+    std::string generateFunctionEntry(const std::string& functionName, const std::vector<std::pair<std::string, std::string>>& parameters,
+                                      const std::vector<std::pair<int, std::string>>& paramSlots);
+
+    std::unique_ptr<CodeBackend> translator;
     std::string currentFunctionName;
+    const InstrumentationPlan* instrumentationPlan;
+    std::string sourceFileName; // Vacío: sin directivas #line
+    int currentFrameLayout; // Layout de la función en generación (-1 fuera de funciones)
+    unsigned sampledLoopCount = 0; // Bucles muestreados (--trace-every), para nombrar sus variables de muestra
+    std::vector<std::map<std::string, LocalVariable>> localScopes; // Ámbitos de bloque de la función actual
+    std::unordered_set<std::string> addressTakenLocals; // Nombres con '&nombre' en la función actual
     ErrorHandler& errorHandler; // <--- ¡NUEVO: Miembro para el manejador de errores!
 };
 
@@ -0,0 +1,224 @@
+// src/code_generator/PrecomputedTraceEmitter.cpp
+#include "PrecomputedTraceEmitter.h"
+
+#include <cstdint>
+#include <sstream>
+
+PrecomputedTraceEmitter::PrecomputedTraceEmitter(const BytecodeProgram& program)
+    : program(program) {
+    for (const StepDescriptor& descriptor : program.stepDescriptors) {
+        descriptors.push_back({descriptor.kind, descriptor.line, descriptor.format, descriptor.color});
+    }
+}
+
+std::string PrecomputedTraceEmitter::emit(const std::string& output) {
+    std::stringstream steps;
+    std::stringstream args;
+    size_t argCount = 0;
+
+    for (const SimulationStep& step : simulationHistory) {
+        std::vector<long long> stepArgs;
+        const int descriptor = resolveStringArgs(step, stepArgs);
+        if (!stepArgs.empty()) {
+            args << "   ";
+            for (long long value : stepArgs) {
+                args << " " << value << ",";
+            }
+            args << std::endl;
+        }
+        steps << "    {" << descriptor << ", " << stepArgs.size() << ", " << argCount << ", " << step.deltaEnd << "}," << std::endl;
+        argCount += stepArgs.size();
+    }
+
+    // Los keyframes no se emiten: loadPrecomputedTrace() los reconstruye reproduciendo los deltas
+    std::stringstream deltas;
+    for (const TraceDelta& delta : simulationDeltas) {
+        deltas << "    {" << deltaKindName(delta.kind) << ", " << static_cast<int>(delta.slot) << ", " << delta.layout << ", "
+               << delta.frame << ", " << delta.value << "}," << std::endl;
+    }
+    std::stringstream heapWrites;
+    for (const auto& write : simulationHeapWrites) {
+        heapWrites << "    {\"" << escape(write.first) << "\", \"" << escape(write.second.value) << "\"}," << std::endl;
+    }
+
+    std::stringstream ss;
+    ss << "// Traza precalculada por el compilador (--precompute): " << simulationHistory.size() << " pasos, "
+       << simulationDeltas.size() << " deltas" << std::endl;
+    ss << getStepDescriptorTable();
+    ss << getFrameLayoutTable();
+    ss << std::endl;
+
+    // Las tablas vacías llevan una entrada de relleno: C++ no admite arrays de tamaño cero
+    ss << "constexpr SimulationStep precomputedSteps[] = {" << std::endl;
+    ss << (simulationHistory.empty() ? "    {0, 0, 0, 0},\n" : steps.str());
+    ss << "};" << std::endl;
+    ss << "constexpr long long precomputedArgs[] = {" << std::endl;
+    ss << (argCount == 0 ? "    0,\n" : args.str());
+    ss << "};" << std::endl;
+    ss << "constexpr TraceDelta precomputedDeltas[] = {" << std::endl;
+    ss << (simulationDeltas.empty() ? "    {DELTA_PUSH_FRAME, 0, 0, 0, 0},\n" : deltas.str());
+    ss << "};" << std::endl;
+    ss << "constexpr PrecomputedHeapWrite precomputedHeapWrites[] = {" << std::endl;
+    ss << (simulationHeapWrites.empty() ? "    {\"\", \"\"},\n" : heapWrites.str());
+    ss << "};" << std::endl;
+
+    // La salida se parte por líneas para que el literal siga siendo legible
+    ss << "constexpr char precomputedOutput[] =" << std::endl;
+    size_t lineStart = 0;
+    do {
+        size_t lineEnd = output.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? output.size() : lineEnd + 1;
+        ss << "    \"" << escape(output.substr(lineStart, lineEnd - lineStart)) << "\"" << std::endl;
+        lineStart = lineEnd;
+    } while (lineStart < output.size());
+    ss << "    ;" << std::endl;
+    ss << std::endl;
+
+    ss << "void run_c_program_simulation() {" << std::endl;
+    ss << "    const PrecomputedTrace trace = {" << std::endl;
+    ss << "        precomputedSteps, " << simulationHistory.size() << "," << std::endl;
+    ss << "        precomputedArgs, " << argCount << "," << std::endl;
+    ss << "        precomputedDeltas, " << simulationDeltas.size() << "," << std::endl;
+    ss << "        precomputedHeapWrites, " << simulationHeapWrites.size() << "," << std::endl;
+    ss << "        precomputedOutput, sizeof(precomputedOutput) - 1" << std::endl;
+    ss << "    };" << std::endl;
+    ss << "    loadPrecomputedTrace(trace);" << std::endl;
+    ss << "}" << std::endl;
+    return ss.str();
+}
+
+int PrecomputedTraceEmitter::resolveStringArgs(const SimulationStep& step, std::vector<long long>& args) {
+    const std::string& format = descriptors[step.descriptor].format;
+    if (format.find("%s") == std::string::npos) {
+        args.assign(simulationArgs.begin() + step.argOffset, simulationArgs.begin() + step.argOffset + step.argCount);
+        return step.descriptor;
+    }
+
+    // Mismo recorrido de la plantilla que formatStepDescription()
+    std::string resolved;
+    int argIndex = 0;
+    for (size_t i = 0; i < format.size(); ++i) {
+        if (format[i] != '%' || i + 1 == format.size()) {
+            resolved += format[i];
+            continue;
+        }
+        const char directive = format[++i];
+        if (directive == '%') {
+            resolved += "%%";
+            continue;
+        }
+        const long long value = argIndex < step.argCount ? simulationArgs[step.argOffset + argIndex] : 0;
+        argIndex++;
+        if (directive != 's') {
+            resolved += '%';
+            resolved += directive;
+            args.push_back(value);
+            continue;
+        }
+        const char* str = reinterpret_cast<const char*>(static_cast<std::intptr_t>(value));
+        for (const char* c = str ? str : "(null)"; *c; ++c) {
+            resolved += *c;
+            if (*c == '%') {
+                resolved += '%';
+            }
+        }
+    }
+
+    auto key = std::make_pair(static_cast<int>(step.descriptor), resolved);
+    auto found = derivedDescriptors.find(key);
+    if (found != derivedDescriptors.end()) {
+        return found->second;
+    }
+    const EmittedDescriptor& original = descriptors[step.descriptor];
+    descriptors.push_back({original.kind, original.line, resolved, original.color});
+    const int id = static_cast<int>(descriptors.size() - 1);
+    derivedDescriptors.emplace(key, id);
+    return id;
+}
+
+std::string PrecomputedTraceEmitter::getStepDescriptorTable() const {
+    std::stringstream ss;
+    ss << std::endl;
+    ss << "constexpr StepDescriptor stepDescriptors[] = {" << std::endl;
+    for (size_t i = 0; i < descriptors.size(); ++i) {
+        const auto& descriptor = descriptors[i];
+        ss << "    {" << kindName(descriptor.kind) << ", " << descriptor.line << ", \"" << escape(descriptor.format) << "\", "
+           << colorName(descriptor.color) << "}, // " << i << std::endl;
+    }
+    if (descriptors.empty()) {
+        ss << "    {STEP_PROGRAM, 0, \"\", STEP_COLOR_DEFAULT}," << std::endl;
+    }
+    ss << "};" << std::endl;
+    return ss.str();
+}
+
+std::string PrecomputedTraceEmitter::getFrameLayoutTable() const {
+    std::stringstream ss;
+    ss << std::endl;
+    for (size_t i = 0; i < program.frameLayouts.size(); ++i) {
+        const FrameLayout& layout = program.frameLayouts[i];
+        if (layout.slotCount == 0) {
+            continue;
+        }
+        ss << "constexpr FrameSlotInfo frameSlots_" << i << "[] = { // " << layout.functionName << std::endl;
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            ss << "    {\"" << layout.slots[slot].name << "\", " << (layout.slots[slot].type == SLOT_POINTER ? "SLOT_POINTER" : "SLOT_INT") << "}," << std::endl;
+        }
+        ss << "};" << std::endl;
+    }
+    ss << "constexpr FrameLayout frameLayouts[] = {" << std::endl;
+    for (size_t i = 0; i < program.frameLayouts.size(); ++i) {
+        const FrameLayout& layout = program.frameLayouts[i];
+        ss << "    {\"" << layout.functionName << "\", " << (layout.slotCount == 0 ? "nullptr" : "frameSlots_" + std::to_string(i))
+           << ", " << layout.slotCount << "}, // " << i << std::endl;
+    }
+    if (program.frameLayouts.empty()) {
+        ss << "    {\"\", nullptr, 0}," << std::endl;
+    }
+    ss << "};" << std::endl;
+    return ss.str();
+}
+
+// Convierte texto ya interpretado en el contenido de un literal de cadena de C++
+std::string PrecomputedTraceEmitter::escape(const std::string& text) {
+    std::string escaped;
+    for (unsigned char c : text) {
+        switch (c) {
+            case '\\': escaped += "\\\\"; break;
+            case '"': escaped += "\\\""; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            case '\r': escaped += "\\r"; break;
+            default:
+                if (c < 0x20 || c == 0x7f) {
+                    // Octal de tres dígitos: no se mezcla con los caracteres que le siguen
+                    const char octal[] = {'\\', static_cast<char>('0' + (c >> 6)), static_cast<char>('0' + ((c >> 3) & 7)), static_cast<char>('0' + (c & 7)), '\0'};
+                    escaped += octal;
+                } else {
+                    escaped += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+const char* PrecomputedTraceEmitter::kindName(StepKind kind) {
+    static const char* const names[] = {
+        "STEP_PROGRAM", "STEP_DECLARATION", "STEP_ASSIGNMENT", "STEP_CONDITION", "STEP_LOOP", "STEP_CALL", "STEP_RETURN", "STEP_PRINT"
+    };
+    return names[kind];
+}
+
+const char* PrecomputedTraceEmitter::deltaKindName(TraceDeltaKind kind) {
+    static const char* const names[] = {"DELTA_PUSH_FRAME", "DELTA_POP_FRAME", "DELTA_SLOT_WRITE", "DELTA_HEAP_WRITE"};
+    return names[kind];
+}
+
+const char* PrecomputedTraceEmitter::colorName(StepColor color) {
+    static const char* const names[] = {
+        "STEP_COLOR_DEFAULT", "STEP_COLOR_HIGHLIGHT", "STEP_COLOR_VARIABLE_DECL", "STEP_COLOR_ASSIGNMENT",
+        "STEP_COLOR_FUNCTION_CALL", "STEP_COLOR_RETURN", "STEP_COLOR_PRINT"
+    };
+    return names[color];
+}
@@ -0,0 +1,47 @@
+// src/code_generator/PrecomputedTraceEmitter.h
+#ifndef PRECOMPUTEDTRACEEMITTER_H
+#define PRECOMPUTEDTRACEEMITTER_H
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../vm/Bytecode.h"
+
+// Emite la traza ya calculada por la VM (opción --precompute) como tablas constexpr: descriptores,
+// layouts, pasos, argumentos, deltas de pila y heap, y la salida de printf. El
+// run_c_program_simulation() resultante solo carga esas tablas en el runtime.
+class PrecomputedTraceEmitter {
+public:
+    explicit PrecomputedTraceEmitter(const BytecodeProgram& program);
+
+    // Tablas de la traza registrada en el runtime (simulationHistory, simulationDeltas...) y
+    // run_c_program_simulation(); el encabezado y el main los pone el backend
+    std::string emit(const std::string& output);
+
+private:
+    // Los argumentos %s apuntan a cadenas de la VM: se sustituyen en una copia del descriptor
+    int resolveStringArgs(const SimulationStep& step, std::vector<long long>& args);
+
+    std::string getStepDescriptorTable() const;
+    std::string getFrameLayoutTable() const;
+
+    static std::string escape(const std::string& text);
+    static const char* kindName(StepKind kind);
+    static const char* deltaKindName(TraceDeltaKind kind);
+    static const char* colorName(StepColor color);
+
+    struct EmittedDescriptor {
+        StepKind kind;
+        int line;
+        std::string format; // Sin secuencias de escape
+        StepColor color;
+    };
+
+    const BytecodeProgram& program;
+    std::vector<EmittedDescriptor> descriptors; // Los del programa seguidos de los derivados
+    std::map<std::pair<int, std::string>, int> derivedDescriptors;
+};
+
+#endif // PRECOMPUTEDTRACEEMITTER_H
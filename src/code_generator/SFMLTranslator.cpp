@@ -3,10 +3,11 @@
 #include <iostream>
 #include <utility> // Para std::move en algunos lugares si fuera necesario
 #include <algorithm> // Para std::max
-#include <iostream>
-using namespace std;
+#include <filesystem>
 
-SFMLTranslator::SFMLTranslator() : indentLevel(0) {
+SFMLTranslator::SFMLTranslator() : indentLevel(0), emitMode(EmitMode::Visualization), stepRecordingEnabled(true), sourceLine(0), traceBudgetBytes(0), traceOverflow(SIM_TRACE_SPILL),
+      maxSteps(0), maxMillis(0), detectLoops(false), lazyWindow(0), stopDescriptors{-1, -1, -1}, usesHeap(false), loopGuardCount(0),
+      profileSiteLines{0}, profileSite(0) {
     // Constructor
 }
 
@@ -26,287 +27,458 @@ std::string SFMLTranslator::getCurrentIndent() const {
 
 // --- Métodos de generación de código SFML ---
 
-// Este método genera los includes, las variables globales y los prototipos de funciones.
-std::string SFMLTranslator::getSFMLHeader() {
+// El runtime (registro de pasos, marcos de pila, salida de printf y visor) vive en las
+// bibliotecas sim_runtime y sim_viewer; el programa generado solo incluye su cabecera.
+std::string SFMLTranslator::getHeader() {
     std::stringstream ss;
-    ss << "#include <SFML/Graphics.hpp>" << std::endl;
-    ss << "#include <SFML/Window.hpp>" << std::endl;
-    ss << "#include <iostream>" << std::endl;
-    ss << "#include <string>" << std::endl;
-    ss << "#include <thread>" << std::endl;
-    ss << "#include <chrono>" << std::endl;
-    ss << "#include <vector>" << std::endl;
-    ss << "#include <map>" << std::endl;
-    ss << "#include <algorithm>" << std::endl; // Para std::max
-    ss << "#include <sstream>" << std::endl;
+    ss << "// Generado por C_SFML_Compiler: enlazar con sim_viewer, sim_runtime y SFML" << std::endl;
+    ss << "#include \"SimulationRuntime.h\"" << std::endl;
+    if (isLazyStepping()) {
+        ss << "#include \"SimulationCoroutine.h\" // --lazy: compilar con -std=c++20" << std::endl;
+    }
+    return ss.str();
+}
 
-    ss << std::endl;
-    ss << "// Objetos y constantes globales de SFML" << std::endl;
-    ss << "sf::RenderWindow* globalWindow = nullptr;" << std::endl;
-    ss << "sf::Font globalFont;" << std::endl;
-    ss << "const float LINE_HEIGHT = 25.f;" << std::endl;
-    ss << "const sf::Color COLOR_DEFAULT_TEXT = sf::Color::Black;" << std::endl; // CORREGIDO: sf::Color::Black
-    ss << "const sf::Color COLOR_HIGHLIGHT = sf::Color::Yellow;" << std::endl;
-    ss << "const sf::Color COLOR_VARIABLE_DECL = sf::Color::Cyan;" << std::endl;
-    ss << "const sf::Color COLOR_ASSIGNMENT = sf::Color::Magenta;" << std::endl;
-    ss << "const sf::Color COLOR_FUNCTION_CALL = sf::Color::Green;" << std::endl;
-    ss << "const sf::Color COLOR_RETURN = sf::Color::Red;" << std::endl;
-    ss << "const sf::Color COLOR_PRINT = sf::Color::Blue;" << std::endl;
+// Genera el main del programa: registra las tablas estáticas y entrega el control al runtime.
+// Los tamaños se toman de las propias tablas, que también puede emitir PrecomputedTraceEmitter.
+std::string SFMLTranslator::getSimulationProgramDefinition() const {
+    std::stringstream ss;
+    ss << "    const SimulationProgram program = {" << std::endl;
+    ss << "        stepDescriptors, static_cast<int>(std::size(stepDescriptors))," << std::endl;
+    ss << "        frameLayouts, static_cast<int>(std::size(frameLayouts))," << std::endl;
+    // Con --lazy, run_c_program_simulation es una corrutina: sin visor se ejecuta entera sin pausas
+    ss << "        " << (isLazyStepping() ? "runSimulationCoroutine" : "run_c_program_simulation") << std::endl;
+    ss << "    };" << std::endl;
+    if (traceBudgetBytes != 0) {
+        ss << "    setSimulationTraceBudget(" << traceBudgetBytes << ", " << (traceOverflow == SIM_TRACE_DROP ? "SIM_TRACE_DROP" : "SIM_TRACE_SPILL") << ");" << std::endl;
+    }
+    if (checksExecutionLimits()) {
+        ss << "    setSimulationExecutionLimits({" << maxSteps << ", " << maxMillis << ", " << (detectLoops ? "true" : "false") << ", {"
+           << stopDescriptors[SIM_STOP_STEPS] << ", " << stopDescriptors[SIM_STOP_TIME] << ", " << stopDescriptors[SIM_STOP_LOOP] << "}});" << std::endl;
+    }
+    return ss.str();
+}
 
+std::string SFMLTranslator::getFooter() {
+    std::stringstream ss;
     ss << std::endl;
-    ss << "// Global state for current memory snapshot (used during recording)" << std::endl;
-    ss << "std::vector<std::map<std::string, std::string>> currentStackFrames;" << std::endl;
-    ss << "std::map<std::string, std::string> currentHeapObjects;" << std::endl;
+    ss << "int main(int argc, char** argv) {" << std::endl;
+    ss << getSimulationProgramDefinition();
+    // Para medir solo la simulación instrumentada (scripts/benchmark.sh), sin abrir la ventana
+    ss << "#ifdef SIMULATION_BENCHMARK" << std::endl;
+    ss << "    return runSimulationBenchmark(program);" << std::endl;
+    // Sin SFML (agentes de CI sin pantalla): se enlaza solo con sim_runtime y escribe la traza en NDJSON
+    ss << "#elif defined(SIMULATION_HEADLESS)" << std::endl;
+    ss << "    if (argc > 1) {" << std::endl;
+    ss << "        return runSimulationCommand(program, argc, argv);" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "    return runSimulationHeadless(program, SIM_HEADLESS_NDJSON, \"-\");" << std::endl;
+    ss << "#else" << std::endl;
+    // Con argumentos no abre la ventana: graba la traza en un archivo (.simtrace), la publica en un
+    // anillo de memoria compartida (--stream=NOMBRE) para sim_stream_viewer o la escribe (--headless)
+    ss << "    if (argc > 1) {" << std::endl;
+    ss << "        return runSimulationCommand(program, argc, argv);" << std::endl;
+    ss << "    }" << std::endl;
+    if (isLazyStepping()) {
+        ss << "    return runLazySimulationViewer(program, simulationStepper, " << lazyWindow << ");" << std::endl;
+    } else {
+        ss << "    return runSimulationViewer(program);" << std::endl;
+    }
+    ss << "#endif" << std::endl;
+    ss << "}" << std::endl;
+    return ss.str();
+}
 
-    ss << std::endl;
-    ss << "// --- Variables globales del historial de simulación ---" << std::endl;
-    ss << "struct SimulationStep {" << std::endl;
-    ss << getCurrentIndent() << "std::string description;" << std::endl;
-    ss << getCurrentIndent() << "sf::Color color;" << std::endl;
-    ss << getCurrentIndent() << "std::vector<std::map<std::string, std::string>> stackSnapshot;" << std::endl;
-    ss << getCurrentIndent() << "std::map<std::string, std::string> heapSnapshot;" << std::endl;
-    ss << "};" << std::endl;
-    ss << "std::vector<SimulationStep> simulationHistory;" << std::endl;
-    ss << "extern int currentStepIndex; // Declarado como externo para que CodeGenerator pueda usarlo" << std::endl;
+std::string SFMLTranslator::getOutputFileName() const {
+    switch (emitMode) {
+        case EmitMode::Native:
+            return "output_native.cpp";
+        case EmitMode::Profile:
+            return "output_profile.cpp";
+        default:
+            return "output_sfml.cpp";
+    }
+}
 
-    ss << std::endl;
-    ss << "// Posiciones y tamaños ajustados para el diseño basado en la imagen" << std::endl;
-    ss << "const float PADDING = 20.f;" << std::endl;
-    ss << "const float BAR_HEIGHT = 100.f;" << std::endl; // Altura de las barras de Heap y Stack (ajustado)
-    ss << "const float HEAP_BAR_Y = 50.f;" << std::endl; // Posición Y del Heap (ajustado para dejar espacio arriba)
-    ss << "const float STACK_BAR_Y = HEAP_BAR_Y + BAR_HEIGHT + PADDING;" << std::endl;
-    ss << "const float MEMORY_BAR_WIDTH = 1000.f - (2 * PADDING);" << std::endl; // Ancho total de la ventana - padding
+std::string SFMLTranslator::getRuntimeLibraries() const {
+    if (emitMode == EmitMode::Profile) {
+        return "-lsim_runtime"; // Solo el informe (ProfileReport.cpp)
+    }
+#if SIM_VIEWER_AVAILABLE
+    return "-lsim_viewer -lsim_runtime -lsfml-graphics -lsfml-window -lsfml-system -pthread";
+#else
+    return "-DSIMULATION_HEADLESS -lsim_runtime -pthread"; // Sin visor: el main generado escribe la traza en NDJSON
+#endif
+}
 
-    ss << std::endl;
-    ss << "const float BOX_HEIGHT = 50.f;" << std::endl; // Altura de las cajas de variables/punteros
-    ss << "const float BOX_PADDING = 10.f;" << std::endl; // Espacio entre cajas
+std::string SFMLTranslator::getCxxStandard() const {
+    return isLazyStepping() ? "c++20" : "c++17";
+}
 
-    ss << std::endl;
-    ss << "// Prototipos de funciones auxiliares (implementadas en getSFMLFooter)" << std::endl;
-    ss << "void setupSFML(sf::RenderWindow& window);" << std::endl;
-    ss << "void displayText(const std::string& text_str, float x, float y, sf::Color color, unsigned int characterSize = 18);" << std::endl;
-    ss << "void drawRectangle(float x, float y, float width, float height, sf::Color color, bool filled, float outlineThickness, sf::Color outlineColor);" << std::endl;
-    ss << "void recordStep(const std::string& description, sf::Color color);" << std::endl;
-    ss << "void displaySpecificStep(const SimulationStep& step);" << std::endl;
-    ss << "void updateStackFrame(const std::string& varName, const std::string& value);" << std::endl;
-    ss << "void pushStackFrame();" << std::endl;
-    ss << "void popStackFrame();" << std::endl;
-    ss << "void updateHeapObject(const std::string& address, const std::string& value);" << std::endl;
-    ss << "void run_c_program_simulation(); // Prototipo de la función que contiene el código C simulado" << std::endl;
+std::vector<GeneratedFile> SFMLTranslator::getAuxiliaryFiles() const {
+    return {};
+}
 
+// --- Salida bufferizada de printf para el modo nativo (autocontenido, sin sim_runtime) ---
 
+std::string SFMLTranslator::getOutputRuntimeDeclarations() const {
+    std::stringstream ss;
+    ss << "// --- Salida bufferizada de printf (se vacía al llenarse y al final del programa) ---" << std::endl;
+    ss << "const size_t OUTPUT_BUFFER_SIZE = 1 << 16;" << std::endl;
+    ss << "char outputBuffer[OUTPUT_BUFFER_SIZE];" << std::endl;
+    ss << "size_t outputLength = 0;" << std::endl;
+    ss << "void flushOutput();" << std::endl;
+    ss << "void writeOutput(const char* data, size_t length);" << std::endl;
+    ss << "template <size_t N> inline void writeOutputLiteral(const char (&text)[N]) { writeOutput(text, N - 1); }" << std::endl;
+    ss << "void writeOutputInt(long long value);" << std::endl;
+    ss << "void writeOutputString(const char* value);" << std::endl;
+    ss << "void writeOutputPointer(const void* value);" << std::endl;
     return ss.str();
 }
 
-// Este método solo genera las implementaciones de las funciones auxiliares.
-// NO CONTIENE la función main() de SFML.
-std::string SFMLTranslator::getSFMLFooter() {
+std::string SFMLTranslator::getOutputRuntime() const {
     std::stringstream ss;
+    ss << "void flushOutput() {" << std::endl;
+    ss << "    if (outputLength > 0) {" << std::endl;
+    ss << "        std::fwrite(outputBuffer, 1, outputLength, stdout);" << std::endl;
+    ss << "        std::fflush(stdout);" << std::endl;
+    ss << "        outputLength = 0;" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "}" << std::endl;
     ss << std::endl;
-    ss << "// Implementaciones de funciones auxiliares" << std::endl;
 
-    // Definición de currentStepIndex
-    ss << "int currentStepIndex = 0;" << std::endl;
-
-    ss << "void setupSFML(sf::RenderWindow& window) {" << std::endl;
-    ss << getCurrentIndent() << "globalWindow = &window;" << std::endl;
-    ss << getCurrentIndent() << "if (!globalFont.loadFromFile(\"../../resources/arial.ttf\")) {" << std::endl;
-    ss << getCurrentIndent() << "    std::cerr << \"Error loading font: ../../resources/arial.ttf\" << std::endl;" << std::endl;
-    ss << getCurrentIndent() << "}" << std::endl;
+    ss << "void writeOutput(const char* data, size_t length) {" << std::endl;
+    ss << "    if (outputLength + length > OUTPUT_BUFFER_SIZE) {" << std::endl;
+    ss << "        flushOutput();" << std::endl;
+    ss << "        if (length > OUTPUT_BUFFER_SIZE) { // Demasiado grande para el buffer: escribir directamente" << std::endl;
+    ss << "            std::fwrite(data, 1, length, stdout);" << std::endl;
+    ss << "            return;" << std::endl;
+    ss << "        }" << std::endl;
+    ss << "    }" << std::endl;
+    ss << "    std::copy(data, data + length, outputBuffer + outputLength);" << std::endl;
+    ss << "    outputLength += length;" << std::endl;
     ss << "}" << std::endl;
     ss << std::endl;
 
-    ss << "void displayText(const std::string& text_str, float x, float y, sf::Color color, unsigned int characterSize) {" << std::endl;
-    ss << getCurrentIndent() << "if (!globalWindow) return;" << std::endl;
-    ss << getCurrentIndent() << "sf::Text text(text_str, globalFont, characterSize);" << std::endl;
-    ss << getCurrentIndent() << "text.setPosition(x, y);" << std::endl;
-    ss << getCurrentIndent() << "text.setFillColor(color);" << std::endl;
-    ss << getCurrentIndent() << "globalWindow->draw(text);" << std::endl;
+    ss << "void writeOutputInt(long long value) {" << std::endl;
+    ss << "    char digits[24];" << std::endl;
+    ss << "    auto result = std::to_chars(digits, digits + sizeof(digits), value);" << std::endl;
+    ss << "    writeOutput(digits, result.ptr - digits);" << std::endl;
     ss << "}" << std::endl;
     ss << std::endl;
 
-    ss << "void drawRectangle(float x, float y, float width, float height, sf::Color color, bool filled, float outlineThickness, sf::Color outlineColor) {" << std::endl;
-    ss << getCurrentIndent() << "if (!globalWindow) return;" << std::endl;
-    ss << getCurrentIndent() << "sf::RectangleShape rectangle(sf::Vector2f(width, height));" << std::endl;
-    ss << getCurrentIndent() << "rectangle.setPosition(x, y);" << std::endl;
-    ss << getCurrentIndent() << "if (filled) {" << std::endl;
-    ss << getCurrentIndent() << "    rectangle.setFillColor(color);" << std::endl;
-    ss << getCurrentIndent() << "} else {" << std::endl;
-    ss << getCurrentIndent() << "    rectangle.setFillColor(sf::Color::Transparent);" << std::endl;
-    ss << getCurrentIndent() << "    rectangle.setOutlineThickness(outlineThickness);" << std::endl;
-    ss << getCurrentIndent() << "    rectangle.setOutlineColor(outlineColor);" << std::endl;
-    ss << getCurrentIndent() << "}" << std::endl;
-    ss << getCurrentIndent() << "globalWindow->draw(rectangle);" << std::endl;
+    ss << "void writeOutputString(const char* value) {" << std::endl;
+    ss << "    writeOutput(value, std::char_traits<char>::length(value));" << std::endl;
     ss << "}" << std::endl;
     ss << std::endl;
 
-    ss << "void recordStep(const std::string& description, sf::Color color) {" << std::endl;
-    ss << getCurrentIndent() << "SimulationStep step;" << std::endl;
-    ss << getCurrentIndent() << "step.description = description;" << std::endl;
-    ss << getCurrentIndent() << "step.color = color;" << std::endl;
-    ss << getCurrentIndent() << "step.stackSnapshot = currentStackFrames; // Copia profunda" << std::endl;
-    ss << getCurrentIndent() << "step.heapSnapshot = currentHeapObjects;   // Copia profunda" << std::endl;
-    ss << getCurrentIndent() << "simulationHistory.push_back(step);" << std::endl;
+    ss << "void writeOutputPointer(const void* value) {" << std::endl;
+    ss << "    char digits[2 + 2 * sizeof(void*)] = {'0', 'x'};" << std::endl;
+    ss << "    auto result = std::to_chars(digits + 2, digits + sizeof(digits), reinterpret_cast<std::uintptr_t>(value), 16);" << std::endl;
+    ss << "    writeOutput(digits, result.ptr - digits);" << std::endl;
     ss << "}" << std::endl;
-    ss << std::endl;
 
+    return ss.str();
+}
 
-    ss << "void displaySpecificStep(const SimulationStep& step) {" << std::endl;
-    ss << getCurrentIndent() << "if (!globalWindow || !globalWindow->isOpen()) return;" << std::endl;
-    ss << getCurrentIndent() << "globalWindow->clear(sf::Color(240, 240, 240)); // Fondo gris muy claro para el nuevo diseño" << std::endl; // Fondo gris muy claro
+// --- Modo nativo: el programa traducido sin instrumentación ni SFML ---
 
-    // Mostrar la descripción del paso actual
-    ss << getCurrentIndent() << "displayText(step.description, PADDING, PADDING / 2, sf::Color::Black, 18);" << std::endl;
+std::string SFMLTranslator::getNativeHeader() const {
+    std::stringstream ss;
+    if (emitMode == EmitMode::Profile) {
+        ss << "// Generado con --profile: compilar con g++ -O2 y enlazar con sim_runtime (solo el informe del perfil)" << std::endl;
+        ss << "#include \"SimulationProfile.h\"" << std::endl;
+    } else {
+        ss << "// Generado con --emit=native: compilar con g++ -O2 (sin dependencias de SFML)" << std::endl;
+    }
+    ss << "#include <cstdio>" << std::endl;
+    ss << "#include <cstdlib>" << std::endl;
+    ss << "#include <cstdint>" << std::endl;
+    ss << "#include <algorithm>" << std::endl;
+    ss << "#include <string>" << std::endl;
+    ss << "#include <charconv>" << std::endl;
+    ss << std::endl;
+    ss << getOutputRuntimeDeclarations();
+    ss << "void run_c_program_simulation();" << std::endl;
+    if (emitMode == EmitMode::Profile) {
+        ss << getProfileTables();
+    }
+    return ss.str();
+}
 
+std::string SFMLTranslator::getNativeFooter() const {
+    std::stringstream ss;
     ss << std::endl;
-    ss << getCurrentIndent() << "// --- Dibujar Área del Heap ---" << std::endl;
-    ss << getCurrentIndent() << "displayText(\"Heap\", PADDING, HEAP_BAR_Y - 25, sf::Color::Black, 20);" << std::endl;
-    ss << getCurrentIndent() << "drawRectangle(PADDING, HEAP_BAR_Y, MEMORY_BAR_WIDTH, BAR_HEIGHT, sf::Color(210, 210, 210), true, 2.f, sf::Color::Black);" << std::endl; // Fondo gris claro, borde negro
-
-    ss << getCurrentIndent() << "float currentHeapX = PADDING + BOX_PADDING;" << std::endl;
-    ss << getCurrentIndent() << "for (const auto& objPair : step.heapSnapshot) {" << std::endl;
-    ss << getCurrentIndent() << "    std::string text = objPair.first + \": \" + objPair.second;" << std::endl;
-    ss << getCurrentIndent() << "    sf::Text tempText(text, globalFont, 16);" << std::endl;
-    ss << getCurrentIndent() << "    float boxWidth = std::max(80.f, tempText.getLocalBounds().width + (BOX_PADDING * 2));" << std::endl; // Ancho mínimo de 80
-
-    ss << getCurrentIndent() << "    // Verificar si la caja se sale del área del heap" << std::endl;
-    ss << getCurrentIndent() << "    if (currentHeapX + boxWidth > PADDING + MEMORY_BAR_WIDTH - BOX_PADDING) {" << std::endl;
-    ss << getCurrentIndent() << "        break;" << std::endl; // Salir si no hay espacio
-    ss << getCurrentIndent() << "    }" << std::endl;
-
-    ss << getCurrentIndent() << "    sf::Color boxColor = sf::Color(255, 255, 150); // Amarillo claro para punteros en heap" << std::endl;
-    ss << getCurrentIndent() << "    drawRectangle(currentHeapX, HEAP_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2, boxWidth, BOX_HEIGHT, boxColor, true, 1.f, sf::Color::Black);" << std::endl;
-    ss << getCurrentIndent() << "    displayText(text, currentHeapX + BOX_PADDING, HEAP_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);" << std::endl;
-    ss << getCurrentIndent() << "    currentHeapX += boxWidth + BOX_PADDING;" << std::endl;
-    ss << getCurrentIndent() << "}" << std::endl;
+    ss << getOutputRuntime();
+    ss << std::endl;
+    if (emitMode == EmitMode::Profile) {
+        ss << getProfileMain();
+        return ss.str();
+    }
+    ss << "int main() {" << std::endl;
+    ss << "    run_c_program_simulation();" << std::endl;
+    ss << "    flushOutput();" << std::endl;
+    ss << "    return 0;" << std::endl;
+    ss << "}" << std::endl;
+    return ss.str();
+}
+
+// --- Modo perfil (--profile): contadores en tablas estáticas, sin registro de pasos ---
 
+// Las tablas se emiten después del cuerpo, cuando ya se conocen todos los sitios y funciones
+std::string SFMLTranslator::getProfileTables() const {
+    std::stringstream ss;
     ss << std::endl;
-    ss << getCurrentIndent() << "// --- Dibujar Área de la Pila ---" << std::endl;
-    ss << getCurrentIndent() << "displayText(\"Stack\", PADDING, STACK_BAR_Y - 25, sf::Color::Black, 20);" << std::endl;
-    ss << getCurrentIndent() << "drawRectangle(PADDING, STACK_BAR_Y, MEMORY_BAR_WIDTH, BAR_HEIGHT, sf::Color(210, 210, 210), true, 2.f, sf::Color::Black);" << std::endl; // Fondo gris claro, borde negro
+    ss << "// --- Contadores de --profile: por sitio (sentencia del fuente C) y por función ---" << std::endl;
+    ss << "constexpr int profileSiteLines[] = {";
+    for (size_t i = 0; i < profileSiteLines.size(); ++i) {
+        ss << (i == 0 ? "" : ", ") << profileSiteLines[i];
+    }
+    ss << "};" << std::endl;
+    ss << "unsigned long long profileSiteHits[std::size(profileSiteLines)];" << std::endl;
+    ss << "unsigned long long profileSiteSamples[std::size(profileSiteLines)];" << std::endl;
+    ss << "constexpr SimProfileFunction profileFunctions[] = {" << std::endl;
+    for (size_t i = 0; i < frameLayouts.size(); ++i) {
+        ss << "    {\"" << frameLayouts[i].functionName << "\", " << frameLayouts[i].line << "}, // " << i << std::endl;
+    }
+    if (frameLayouts.empty()) {
+        ss << "    {\"\", 0}," << std::endl;
+    }
+    ss << "};" << std::endl;
+    ss << "SimProfileCounters profileCounters[std::size(profileFunctions)];" << std::endl;
+    return ss.str();
+}
 
-    ss << getCurrentIndent() << "float currentStackX = PADDING + BOX_PADDING;" << std::endl;
+std::string SFMLTranslator::getProfileMain() const {
+    std::string sourcePath;
+    for (char c : sourceFileName) {
+        if (c == '"' || c == '\\') {
+            sourcePath += '\\';
+        }
+        sourcePath += c;
+    }
+    std::stringstream ss;
+    ss << "int main(int argc, char** argv) {" << std::endl;
+    ss << "    const SimulationProfile profile = {" << std::endl;
+    ss << "        \"" << sourcePath << "\"," << std::endl;
+    ss << "        profileSiteLines, profileSiteHits, profileSiteSamples, std::size(profileSiteLines)," << std::endl;
+    ss << "        profileFunctions, profileCounters, std::size(profileFunctions)" << std::endl;
+    ss << "    };" << std::endl;
+    ss << "    startSimulationProfile(profile);" << std::endl;
+    ss << "    run_c_program_simulation();" << std::endl;
+    ss << "    flushOutput();" << std::endl;
+    // argv[1]: ruta del informe ("-": salida de errores)
+    ss << "    return writeSimulationProfile(profile, argc > 1 ? argv[1] : \"profile.txt\");" << std::endl;
+    ss << "}" << std::endl;
+    return ss.str();
+}
 
-    ss << getCurrentIndent() << "// Dibujar los marcos de la pila de izquierda a derecha (orden de llamada)" << std::endl;
-    ss << getCurrentIndent() << "for (size_t i = 0; i < step.stackSnapshot.size(); ++i) {" << std::endl;
-    ss << getCurrentIndent() << "    std::string frameLabel = (i == 0) ? \"main\" : \"Func\" + std::to_string(i + 1);" << std::endl;
+void SFMLTranslator::setSourceFileName(const std::string& fileName) {
+    std::error_code ec;
+    const std::filesystem::path absolute = std::filesystem::absolute(fileName, ec);
+    sourceFileName = ec ? fileName : absolute.string();
+}
 
-    ss << getCurrentIndent() << "    // Dibujar el label del marco (main, Func1, etc.)" << std::endl;
-    ss << getCurrentIndent() << "    sf::Color frameLabelColor = sf::Color(150, 255, 150); // Verde claro para 'main' y otros labels" << std::endl;
-    ss << getCurrentIndent() << "    sf::Text tempFrameText(frameLabel, globalFont, 16);" << std::endl;
-    ss << getCurrentIndent() << "    float frameLabelWidth = std::max(80.f, tempFrameText.getLocalBounds().width + (BOX_PADDING * 2));" << std::endl;
+std::string SFMLTranslator::generateProfileSite() {
+    if (emitMode != EmitMode::Profile) {
+        return "";
+    }
+    profileSite = static_cast<int>(profileSiteLines.size());
+    profileSiteLines.push_back(sourceLine);
+    return getCurrentIndent() + "++profileSiteHits[" + std::to_string(profileSite) + "]; simProfileAt(" + std::to_string(profileSite) + ");\n";
+}
 
-    ss << getCurrentIndent() << "    if (currentStackX + frameLabelWidth > PADDING + MEMORY_BAR_WIDTH - BOX_PADDING) break;" << std::endl; // Salir si no hay espacio
+int SFMLTranslator::getProfileSite() const {
+    return profileSite;
+}
 
-    ss << getCurrentIndent() << "    drawRectangle(currentStackX, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2, frameLabelWidth, BOX_HEIGHT, frameLabelColor, true, 1.f, sf::Color::Black);" << std::endl;
-    ss << getCurrentIndent() << "    displayText(frameLabel, currentStackX + BOX_PADDING, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);" << std::endl;
-    ss << getCurrentIndent() << "    currentStackX += frameLabelWidth + BOX_PADDING;" << std::endl;
+void SFMLTranslator::setProfileSite(int site) {
+    profileSite = site;
+}
 
+// --- Tabla de descriptores de pasos ---
+
+// Escapa texto del programa fuente para insertarlo en una plantilla de descriptor.
+std::string SFMLTranslator::escapeTemplateText(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        } else if (c == '%') {
+            escaped += '%'; // '%%' es un '%' literal en la plantilla
+        }
+        escaped += c;
+    }
+    return escaped;
+}
 
-    ss << getCurrentIndent() << "    // Dibujar las variables dentro del marco de la pila" << std::endl;
-    ss << getCurrentIndent() << "    for (const auto& varPair : step.stackSnapshot[i]) {" << std::endl;
-    ss << getCurrentIndent() << "        std::string varName = varPair.first;" << std::endl;
-    ss << getCurrentIndent() << "        std::string varValue = varPair.second;" << std::endl;
-    ss << getCurrentIndent() << "        std::string varText = varName;" << std::endl; // Solo el nombre para la caja, el valor se dibuja aparte
+int SFMLTranslator::addStepDescriptor(const std::string& kind, const std::string& format, const std::string& color) {
+    stepDescriptors.push_back({kind, sourceLine, format, color});
+    return static_cast<int>(stepDescriptors.size() - 1);
+}
 
-    ss << getCurrentIndent() << "        sf::Text tempVarNameText(varName, globalFont, 16);" << std::endl;
-    ss << getCurrentIndent() << "        sf::Text tempVarValueText(varValue, globalFont, 16);" << std::endl;
-    ss << getCurrentIndent() << "        float nameWidth = tempVarNameText.getLocalBounds().width;" << std::endl;
-    ss << getCurrentIndent() << "        float valueWidth = tempVarValueText.getLocalBounds().width;" << std::endl;
+void SFMLTranslator::setEmitMode(EmitMode mode) {
+    emitMode = mode;
+}
 
-    ss << getCurrentIndent() << "        float boxWidth = std::max(80.f, nameWidth + valueWidth + (BOX_PADDING * 3));" << std::endl; // Ancho para nombre + valor
+EmitMode SFMLTranslator::getEmitMode() const {
+    return emitMode;
+}
 
-    ss << getCurrentIndent() << "        if (currentStackX + boxWidth > PADDING + MEMORY_BAR_WIDTH - BOX_PADDING) {" << std::endl;
-    ss << getCurrentIndent() << "            break;" << std::endl;
-    ss << getCurrentIndent() << "        }" << std::endl;
+void SFMLTranslator::setStepRecordingEnabled(bool enabled) {
+    stepRecordingEnabled = enabled;
+}
 
-    ss << getCurrentIndent() << "        sf::Color varCellColor;" << std::endl;
-    ss << getCurrentIndent() << "        if (varValue.rfind(\"0x\", 0) == 0) {" << std::endl; // Es un puntero
-    ss << getCurrentIndent() << "            varCellColor = sf::Color(255, 255, 150); // Amarillo claro para punteros" << std::endl;
-    ss << getCurrentIndent() << "        } else {" << std::endl; // Es un valor numérico/normal
-    ss << getCurrentIndent() << "            varCellColor = sf::Color(150, 255, 150); // Verde claro para valores" << std::endl;
-    ss << getCurrentIndent() << "        }" << std::endl;
+bool SFMLTranslator::isStepRecordingEnabled() const {
+    return stepRecordingEnabled;
+}
 
-    ss << getCurrentIndent() << "        drawRectangle(currentStackX, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2, boxWidth, BOX_HEIGHT, varCellColor, true, 1.f, sf::Color::Black);" << std::endl;
-    ss << getCurrentIndent() << "        displayText(varName, currentStackX + BOX_PADDING, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);" << std::endl;
-    ss << getCurrentIndent() << "        displayText(varValue, currentStackX + BOX_PADDING + nameWidth + BOX_PADDING, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);" << std::endl;
-    ss << getCurrentIndent() << "        currentStackX += boxWidth + BOX_PADDING;" << std::endl;
-    ss << getCurrentIndent() << "    }" << std::endl;
-    ss << getCurrentIndent() << "}" << std::endl;
+void SFMLTranslator::setStepGuard(const std::string& guard) {
+    stepGuard = guard;
+}
 
+std::string SFMLTranslator::getStepGuard() const {
+    return stepGuard;
+}
 
-    ss << std::endl;
-    ss << getCurrentIndent() << "// --- Dibujar botones \"Previous\" y \"Next\" ---" << std::endl;
-    ss << getCurrentIndent() << "const float BUTTON_WIDTH = 100.f;" << std::endl;
-    ss << getCurrentIndent() << "const float BUTTON_HEIGHT = 40.f;" << std::endl;
-    ss << getCurrentIndent() << "const float BUTTON_Y = globalWindow->getSize().y - BUTTON_HEIGHT - PADDING;" << std::endl; // Posición de los botones
+void SFMLTranslator::setSourceLine(int line) {
+    sourceLine = line;
+}
 
-    ss << std::endl;
-    ss << getCurrentIndent() << "// Botón Anterior" << std::endl;
-    ss << getCurrentIndent() << "const float PREV_BUTTON_X = (globalWindow->getSize().x / 2) - BUTTON_WIDTH - (BOX_PADDING * 2);" << std::endl;
-    ss << getCurrentIndent() << "sf::RectangleShape prevButton(sf::Vector2f(BUTTON_WIDTH, BUTTON_HEIGHT));" << std::endl;
-    ss << getCurrentIndent() << "prevButton.setPosition(PREV_BUTTON_X, BUTTON_Y);" << std::endl;
-    ss << getCurrentIndent() << "prevButton.setFillColor(currentStepIndex > 0 ? sf::Color(70, 70, 70) : sf::Color(30, 30, 30));" << std::endl;
-    ss << getCurrentIndent() << "prevButton.setOutlineThickness(2);" << std::endl;
-    ss << getCurrentIndent() << "prevButton.setOutlineColor(sf::Color::Black);" << std::endl; // CORREGIDO: sf::Color::Black
-    ss << getCurrentIndent() << "globalWindow->draw(prevButton);" << std::endl;
-    ss << getCurrentIndent() << "displayText(\"Previous\", PREV_BUTTON_X + (BUTTON_WIDTH - sf::Text(\"Previous\", globalFont, 18).getLocalBounds().width) / 2, BUTTON_Y + (BUTTON_HEIGHT - 18) / 2, sf::Color::White);" << std::endl; // CORREGIDO: sf::Color::White
+int SFMLTranslator::getSourceLine() const {
+    return sourceLine;
+}
 
-    ss << std::endl;
-    ss << getCurrentIndent() << "// Botón Siguiente" << std::endl;
-    ss << getCurrentIndent() << "const float NEXT_BUTTON_X = (globalWindow->getSize().x / 2) + (BOX_PADDING * 2);" << std::endl;
-    ss << getCurrentIndent() << "sf::RectangleShape nextButton(sf::Vector2f(BUTTON_WIDTH, BUTTON_HEIGHT));" << std::endl;
-    ss << getCurrentIndent() << "nextButton.setPosition(NEXT_BUTTON_X, BUTTON_Y);" << std::endl;
-    ss << getCurrentIndent() << "nextButton.setFillColor(currentStepIndex < simulationHistory.size() - 1 ? sf::Color(70, 70, 70) : sf::Color(30, 30, 30));" << std::endl;
-    ss << getCurrentIndent() << "nextButton.setOutlineThickness(2);" << std::endl;
-    ss << getCurrentIndent() << "nextButton.setOutlineColor(sf::Color::Black);" << std::endl; // CORREGIDO: sf::Color::Black
-    ss << getCurrentIndent() << "globalWindow->draw(nextButton);" << std::endl;
-    ss << getCurrentIndent() << "displayText(\"Next\", NEXT_BUTTON_X + (BUTTON_WIDTH - sf::Text(\"Next\", globalFont, 18).getLocalBounds().width) / 2, BUTTON_Y + (BUTTON_HEIGHT - 18) / 2, sf::Color::White);" << std::endl; // CORREGIDO: sf::Color::White
-
-    ss << getCurrentIndent() << "globalWindow->display();" << std::endl;
-    ss << "}" << std::endl;
+void SFMLTranslator::setTraceBudget(size_t maxBytes, SimTraceOverflow overflow) {
+    traceBudgetBytes = maxBytes;
+    traceOverflow = overflow;
+}
 
-    ss << std::endl;
-    ss << "void updateStackFrame(const std::string& varName, const std::string& value) {" << std::endl;
-    ss << getCurrentIndent() << "if (!currentStackFrames.empty()) {" << std::endl;
-    ss << getCurrentIndent() << "    currentStackFrames.back()[varName] = value;" << std::endl;
-    ss << getCurrentIndent() << "}" << std::endl;
-    ss << "}" << std::endl;
-    ss << std::endl;
+void SFMLTranslator::setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops) {
+    this->maxSteps = maxSteps;
+    this->maxMillis = maxMillis;
+    this->detectLoops = detectLoops;
+}
 
-    ss << "void pushStackFrame() {" << std::endl;
-    ss << getCurrentIndent() << "currentStackFrames.emplace_back();" << std::endl;
-    ss << "}" << std::endl;
-    ss << std::endl;
+void SFMLTranslator::setLazyStepping(size_t window) {
+    lazyWindow = window;
+}
 
-    ss << "void popStackFrame() {" << std::endl;
-    ss << getCurrentIndent() << "if (!currentStackFrames.empty()) {" << std::endl;
-    ss << getCurrentIndent() << "    currentStackFrames.pop_back();" << std::endl;
-    ss << getCurrentIndent() << "}" << std::endl;
-    ss << "}" << std::endl;
+bool SFMLTranslator::isLazyStepping() const {
+    return lazyWindow != 0 && emitMode == EmitMode::Visualization;
+}
+
+bool SFMLTranslator::checksExecutionLimits() const {
+    return emitMode == EmitMode::Visualization && (maxSteps != 0 || maxMillis != 0 || detectLoops);
+}
+
+std::string SFMLTranslator::generateRecordStep(const std::string& kind, const std::string& format, const std::string& color, const std::vector<std::string>& args) {
+    if (!stepRecordingEnabled || emitMode != EmitMode::Visualization) {
+        return ""; // Sentencia sin paso propio según el plan de instrumentación (o modo nativo o de perfil)
+    }
+    return generateRecordStepCall(std::to_string(addStepDescriptor(kind, format, color)), args, stepGuard);
+}
+
+std::string SFMLTranslator::generateRecordStepCall(const std::string& descriptor, const std::vector<std::string>& args, const std::string& guard) {
+    std::stringstream ss;
+    ss << getCurrentIndent();
+    if (!guard.empty()) {
+        ss << "if (" << guard << ") ";
+    }
+    // --lazy: el paso suspende la corrutina hasta que el visor pida el siguiente
+    ss << (isLazyStepping() ? "co_await recordLazyStep(" : "recordStep(") << descriptor;
+    for (const auto& arg : args) {
+        ss << ", " << arg;
+    }
+    ss << ");" << std::endl;
+    return ss.str();
+}
+
+std::string SFMLTranslator::getStepDescriptorTable() {
+    std::stringstream ss;
     ss << std::endl;
+    ss << "constexpr StepDescriptor stepDescriptors[] = {" << std::endl;
+    for (size_t i = 0; i < stepDescriptors.size(); ++i) {
+        const auto& descriptor = stepDescriptors[i];
+        ss << "    {" << descriptor.kind << ", " << descriptor.line << ", \"" << descriptor.format << "\", " << descriptor.color << "}, // " << i << std::endl;
+    }
+    if (stepDescriptors.empty()) {
+        ss << "    {STEP_PROGRAM, 0, \"\", STEP_COLOR_DEFAULT}," << std::endl;
+    }
+    ss << "};" << std::endl;
+    return ss.str();
+}
 
-    ss << "void updateHeapObject(const std::string& address, const std::string& value) {" << std::endl;
-    ss << getCurrentIndent() << "currentHeapObjects[address] = value;" << std::endl;
-    ss << "}" << std::endl;
+// --- Diseño de los marcos de pila ---
+
+int SFMLTranslator::addFrameLayout(const std::string& functionName) {
+    frameLayouts.push_back({functionName, sourceLine, {}});
+    return static_cast<int>(frameLayouts.size() - 1);
+}
 
+int SFMLTranslator::addFrameSlot(int layoutId, const std::string& name, const std::string& typeName) {
+    auto& slots = frameLayouts[layoutId].slots;
+    slots.push_back({name, typeName});
+    return static_cast<int>(slots.size() - 1);
+}
+
+std::string SFMLTranslator::getFrameLayoutTable() {
+    std::stringstream ss;
+    ss << std::endl;
+    for (size_t i = 0; i < frameLayouts.size(); ++i) {
+        const auto& layout = frameLayouts[i];
+        if (layout.slots.empty()) {
+            continue;
+        }
+        ss << "constexpr FrameSlotInfo frameSlots_" << i << "[] = { // " << layout.functionName << std::endl;
+        for (const auto& slot : layout.slots) {
+            ss << "    {\"" << slot.first << "\", " << (isPointerType(slot.second) ? "SLOT_POINTER" : "SLOT_INT") << "}," << std::endl;
+        }
+        ss << "};" << std::endl;
+    }
+    ss << "constexpr FrameLayout frameLayouts[] = {" << std::endl;
+    for (size_t i = 0; i < frameLayouts.size(); ++i) {
+        const auto& layout = frameLayouts[i];
+        ss << "    {\"" << layout.functionName << "\", " << (layout.slots.empty() ? "nullptr" : "frameSlots_" + std::to_string(i))
+           << ", " << layout.slots.size() << "}, // " << i << std::endl;
+    }
+    if (frameLayouts.empty()) {
+        ss << "    {\"\", nullptr, 0}," << std::endl;
+    }
+    ss << "};" << std::endl;
     return ss.str();
 }
 
+bool SFMLTranslator::isPointerType(const std::string& typeName) {
+    return !typeName.empty() && typeName.back() == '*';
+}
+
 // A continuación, las implementaciones de las funciones declaradas en SFMLTranslator.h
 // Estas deben coincidir exactamente con sus prototipos.
 
 std::string SFMLTranslator::generateProgramStart() {
     std::stringstream ss;
     ss << getCurrentIndent() << "// Inicio del programa" << std::endl;
-    ss << getCurrentIndent() << "recordStep(\"Program Started\", sf::Color::Black);" << std::endl; // CORREGIDO: sf::Color::Black
+    ss << generateRecordStep("STEP_PROGRAM", "Program Started", "STEP_COLOR_DEFAULT");
+    if (checksExecutionLimits()) {
+        // Los registra el runtime al detener el programa, con la línea del bucle o la función como argumento
+        stopDescriptors[SIM_STOP_STEPS] = addStepDescriptor("STEP_PROGRAM", "Execution stopped: step budget exceeded at line %d", "STEP_COLOR_HIGHLIGHT");
+        stopDescriptors[SIM_STOP_TIME] = addStepDescriptor("STEP_PROGRAM", "Execution stopped: time budget exceeded at line %d", "STEP_COLOR_HIGHLIGHT");
+        stopDescriptors[SIM_STOP_LOOP] = addStepDescriptor("STEP_PROGRAM", "Execution stopped: infinite loop detected at line %d", "STEP_COLOR_HIGHLIGHT");
+    }
     return ss.str();
 }
 
 std::string SFMLTranslator::generateProgramEnd() {
     std::stringstream ss;
     ss << getCurrentIndent() << "// Fin del programa" << std::endl;
-    ss << getCurrentIndent() << "recordStep(\"Program Ended\", sf::Color::Black);" << std::endl; // CORREGIDO: sf::Color::Black
+    if (usesHeap && emitMode == EmitMode::Visualization) {
+        // Un paso por cada bloque sin liberar (bytes, dirección y línea del malloc), aunque el plan omita los demás
+        const int leakDescriptor = addStepDescriptor("STEP_PROGRAM", "Memory leak: %d bytes at %p allocated at line %d", "STEP_COLOR_HIGHLIGHT");
+        ss << getCurrentIndent() << "reportSimulationHeapLeaks(" << leakDescriptor << ");" << std::endl;
+    }
+    ss << generateRecordStep("STEP_PROGRAM", "Program Ended", "STEP_COLOR_DEFAULT");
+    ss << getCurrentIndent() << "flushOutput(); // Vaciar la salida bufferizada de printf" << std::endl;
     return ss.str();
 }
 
@@ -319,90 +491,65 @@ std::string SFMLTranslator::generateFunctionDeclaration(const std::string& retur
 
 std::string SFMLTranslator::generateFunctionCall(const std::string& functionName, const std::string& argsCode) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Calling function: " << functionName << "(" << argsCode << ")\", COLOR_FUNCTION_CALL);" << std::endl;
+    ss << generateRecordStep("STEP_CALL", "Calling function: " + functionName + "(" + escapeTemplateText(argsCode) + ")", "STEP_COLOR_FUNCTION_CALL");
     // La llamada a la función real en la salida C++ es manejada directamente por CodeGenerator.
     return ss.str();
 }
 
-std::string SFMLTranslator::generateVariableDeclaration(const std::string& typeName, const std::string& variableName, const std::string& initialValue) {
+std::string SFMLTranslator::generateVariableDeclaration(const std::string& typeName, const std::string& variableName, int slot, const std::string& initialValue) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Declaring: " << typeName << " " << variableName << (initialValue.empty() ? "" : " = " + initialValue) << "\", COLOR_VARIABLE_DECL);" << std::endl;
-    ss << getCurrentIndent() << typeName << " " << variableName << " = " << initialValue << ";" << std::endl;
-    //cout << "-----------------valor <<<<<<<<<" << typeName << " " << variableName<< " " <<initialValue << endl;
-    // Si es puntero y el valor inicial contiene '&'
-    if (typeName == "int*" && initialValue.find("&") != std::string::npos) {
-        ss << getCurrentIndent() << "std::ostringstream oss_" << variableName << ";" << std::endl;
-        ss << getCurrentIndent() << "oss_" << variableName << " << " << variableName << ";" << std::endl;
-        //ss << getCurrentIndent() << "updateStackFrame(\"" << variableName << "\", oss_" << variableName << ".str());" << std::endl;
-    } 
-    /*
-    else if(variableName.find("ptr") != std::string::npos && initialValue.find("ptr") != std::string::npos){
-        cout << "**entra**"<< endl;
-        ss << getCurrentIndent() << "std::ostringstream oss_" << variableName << ";" << std::endl;
-        ss << getCurrentIndent() << "oss_" << initialValue<<"<< static_cast<const void*>("<<initialValue<<")" << ";" << std::endl;
-    }*/
-    else {
-        cout << "tipo: " << typeName << " y nombre: " << variableName << " initialvalue " << initialValue << endl;
-        //ss << getCurrentIndent() << "updateStackFrame(\"" << variableName << "\", std::to_string(" << variableName << "));" << std::endl;
+    if (initialValue.empty()) {
+        ss << getCurrentIndent() << typeName << " " << variableName << "{};" << std::endl;
+    } else {
+        ss << getCurrentIndent() << typeName << " " << variableName << " = " << initialValue << ";" << std::endl;
     }
-
+    ss << generateVariableUpdate(variableName, slot);
+    // El paso se registra después de actualizar la pila para que la instantánea incluya la variable
+    ss << generateRecordStep("STEP_DECLARATION", "Declaring: " + typeName + " " + variableName + " = " + valueFormat(typeName),
+                             "STEP_COLOR_VARIABLE_DECL", {variableName});
     return ss.str();
 }
 
-std::string SFMLTranslator::generateAssignment(const std::string& identifierName, const std::string& expressionCode) {
+std::string SFMLTranslator::generateAssignment(const std::string& identifierName, const std::string& typeName, int slot, const std::string& expressionCode) {
     std::stringstream ss;
-    // Detecta si la expresión es una desreferenciación de puntero
-
-    //cout <<"generateAsss.. " << expressionCode << endl;
-    if (expressionCode.find("*") == 1) {
-        //cout << "-----entro -----" << endl;
-        // Ejemplo: expressionCode = (*p)
-        cout << "la ------expresion co....." <<expressionCode << endl;
-        ss << getCurrentIndent()
-           << "recordStep(\"Assigning to " << identifierName << " = *"
-           << expressionCode.substr(2, expressionCode.length() - 3) // Extrae el nombre del puntero (p)
-           << " (valor: \" + std::to_string" << expressionCode << " + \")\", COLOR_ASSIGNMENT);" << std::endl;
-    } 
-    
-    else if(identifierName.find("ptr") != std::string::npos && expressionCode.find("ptr") != std::string::npos){
-      //  cout << "ambos son punteros" << endl;
-       // cout << "**entra**"<< endl;
-        ss << getCurrentIndent() << "std::ostringstream _oss_" << expressionCode << ";" << std::endl;
-        ss << getCurrentIndent() << "_oss_" << expressionCode<<"<< static_cast<const void*>("<<expressionCode<<")" << ";" << std::endl;
-        ss << getCurrentIndent()
-           << "recordStep(\"Assigning to " << identifierName << " = "
-           << expressionCode // Extrae el nombre del puntero (p)
-           << " (valor: \" +"<< "_oss_"<<expressionCode <<".str()" << "+ \")\", COLOR_ASSIGNMENT);" << std::endl;
-    }
-
-    else if(identifierName.find("ptr") != std::string::npos && expressionCode.find("&") != std::string::npos){
-       // cout << "ambos son punteros" << endl;
-       // cout << "**entra**"<< endl;
-        ss << getCurrentIndent()
-           << "recordStep(\"Assigning to " << identifierName << " = "
-           << expressionCode // Extrae el nombre del puntero (p)
-           << "\", COLOR_VARIABLE_DECL);" << std::endl;
-    }
-    else {
-        ss << getCurrentIndent()
-           << "recordStep(\"Assigning to " << identifierName << " = \" + std::to_string(" << expressionCode << "), COLOR_ASSIGNMENT);" << std::endl;
-    }
     ss << getCurrentIndent() << identifierName << " = " << expressionCode << ";" << std::endl;
+    ss << generateVariableUpdate(identifierName, slot);
+    ss << generateRecordStep("STEP_ASSIGNMENT", "Assigning to " + identifierName + " = " + valueFormat(typeName),
+                             "STEP_COLOR_ASSIGNMENT", {identifierName});
     return ss.str();
 }
 
+// Conversión de plantilla para un valor del tipo dado
+std::string SFMLTranslator::valueFormat(const std::string& typeName) {
+    return isPointerType(typeName) ? "%p" : "%d";
+}
+
 std::string SFMLTranslator::generateReturnStatement(const std::string& expressionCode, const std::string& functionName) {
     std::stringstream ss;
-    std::string returnMsg = "Returning from " + functionName + (expressionCode.empty() ? "" : " (Returns: " + expressionCode + ")");
-    ss << getCurrentIndent() << "recordStep(\"" << returnMsg << "\", COLOR_RETURN);" << std::endl;
-    ss << getCurrentIndent() << "return " << expressionCode << ";" << std::endl;
+    if (expressionCode.empty()) {
+        ss << generateRecordStep("STEP_RETURN", "Returning from " + functionName, "STEP_COLOR_RETURN");
+        ss << getCurrentIndent() << (isLazyStepping() ? "co_return;" : "return;") << std::endl;
+        return ss.str();
+    }
+    // El valor de retorno se evalúa una sola vez
+    ss << getCurrentIndent() << "{" << std::endl;
+    increaseIndent();
+    ss << getCurrentIndent() << "const auto returnValue = " << expressionCode << ";" << std::endl;
+    ss << generateRecordStep("STEP_RETURN", "Returning from " + functionName + " (Returns: %d)", "STEP_COLOR_RETURN", {"returnValue"});
+    ss << getCurrentIndent() << (isLazyStepping() ? "co_return" : "return") << " returnValue;" << std::endl;
+    decreaseIndent();
+    ss << getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
 std::string SFMLTranslator::generateIfStatement(const std::string& conditionCode, const std::string& thenBlockCode, const std::string& elseBlockCode) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Evaluating if (\" + std::to_string(" << conditionCode << ") + \")\", COLOR_HIGHLIGHT);" << std::endl;
-    ss << getCurrentIndent() << "if (" << conditionCode << ") {" << std::endl;
+    // La condición se evalúa una sola vez: la usan el paso y el if
+    ss << getCurrentIndent() << "{" << std::endl;
+    increaseIndent();
+    ss << getCurrentIndent() << "const long long stepCondition = " << conditionCode << ";" << std::endl;
+    ss << generateRecordStep("STEP_CONDITION", "Evaluating if (%d)", "STEP_COLOR_HIGHLIGHT", {"stepCondition"});
+    ss << getCurrentIndent() << "if (stepCondition) {" << std::endl;
     increaseIndent();
     ss << thenBlockCode;
     decreaseIndent();
@@ -414,92 +561,233 @@ std::string SFMLTranslator::generateIfStatement(const std::string& conditionCode
         decreaseIndent();
         ss << getCurrentIndent() << "}" << std::endl;
     }
+    decreaseIndent();
+    ss << getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
-std::string SFMLTranslator::generateForLoop(const std::string& initCode, const std::string& conditionCode, const std::string& updateCode, const std::string& bodyCode) {
+std::string SFMLTranslator::generateForLoop(const std::string& initCode, const std::string& conditionCode, const std::string& updateCode, const std::string& bodyCode,
+                                            const std::string& sampleGuard, unsigned sampleEvery) {
     std::stringstream ss;
-    // Nota: initCode, conditionCode, updateCode aquí son el código C/C++ sin formato, no formateado con llamadas SFML.
-    // CodeGenerator se encarga de generar sus correspondientes llamadas de visualización SFML.
-    ss << getCurrentIndent() << "recordStep(\"Entering for loop\", COLOR_HIGHLIGHT);" << std::endl;
-    ss << getCurrentIndent() << "for (" << initCode << "; " << conditionCode << "; " << updateCode << ") {" << std::endl;
-    increaseIndent();
+    // Muestreo: una cuenta atrás por bucle decide qué iteraciones registran pasos. Solo se
+    // emite si algún recordStep del cuerpo o del incremento quedó condicionado por ella.
+    const std::string guardTest = "if (" + sampleGuard + ")";
+    const bool sampled = !sampleGuard.empty() &&
+                         (bodyCode.find(guardTest) != std::string::npos || updateCode.find(guardTest) != std::string::npos);
+    const std::string countdown = sampleGuard + "Countdown";
+    // La inicialización y el incremento son sentencias instrumentadas como cualquier otra,
+    // así que se emiten fuera de la cabecera del for.
+    ss << initCode;
+    ss << generateRecordStep("STEP_LOOP", "Entering for loop", "STEP_COLOR_HIGHLIGHT");
+    if (sampled) {
+        ss << getCurrentIndent() << "unsigned " << countdown << " = 1;" << std::endl;
+    }
+    const std::string loopGuard = "loopGuard" + std::to_string(loopGuardCount);
+    if (checksExecutionLimits()) {
+        ++loopGuardCount;
+        ss << getCurrentIndent() << "SimulationLoopGuard " << loopGuard << "(" << sourceLine << ");" << std::endl;
+    }
+    // --profile: el tiempo de la condición es del for, no de la última sentencia del cuerpo. Antes de la
+    // condición se ejecuta la inicialización o el incremento, cuyos sitios son los primeros y el último del
+    // for: si están en la línea del for (lo habitual), la condición no necesita anotar su sitio en cada vuelta.
+    const bool conditionSiteKnown = emitMode == EmitMode::Profile && !updateCode.empty() && profileSiteLines.back() == sourceLine &&
+                                    (initCode.empty() || profileSiteLines[profileSite + 1] == sourceLine);
+    const std::string loopCondition = emitMode == EmitMode::Profile && !conditionSiteKnown
+        ? "(simProfileAt(" + std::to_string(profileSite) + "), " + conditionCode + ")"
+        : conditionCode;
+    ss << getCurrentIndent() << "for (; " << loopCondition << "; ) {" << std::endl;
+    if (sampled) {
+        increaseIndent();
+        ss << getCurrentIndent() << "const bool " << sampleGuard << " = --" << countdown << " == 0;" << std::endl;
+        ss << getCurrentIndent() << "if (" << sampleGuard << ") " << countdown << " = " << sampleEvery << ";" << std::endl;
+        decreaseIndent();
+    }
     ss << bodyCode;
-    decreaseIndent();
+    ss << updateCode;
+    if (checksExecutionLimits()) {
+        increaseIndent();
+        ss << getCurrentIndent() << loopGuard << ".backEdge();" << std::endl;
+        decreaseIndent();
+    }
     ss << getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
-std::string SFMLTranslator::generatePrintStatement(const std::string& expressionCode) {
+// printf se compila segmento a segmento: cada literal y cada conversión se convierte en una
+// escritura directa en el buffer de salida, sin interpretar el formato en tiempo de ejecución.
+std::string SFMLTranslator::generatePrintStatement(const std::vector<FormatSegment>& segments, const std::vector<std::string>& argumentCodes) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Printing: \" + std::to_string(" << expressionCode << "), COLOR_PRINT);" << std::endl;
-    ss << getCurrentIndent() << "std::cout << " << expressionCode << " << std::endl;" << std::endl;
+    ss << getCurrentIndent() << "{" << std::endl;
+    increaseIndent();
+
+    // Evaluar cada argumento una sola vez (el paso y la salida lo usan)
+    std::string stepFormat = "Printing: ";
+    std::vector<std::string> stepArgs;
+    std::vector<std::string> writes;
+    size_t argIndex = 0;
+    for (const auto& segment : segments) {
+        if (segment.kind == FormatSegmentKind::Literal) {
+            for (char c : segment.text) {
+                stepFormat += (c == '%') ? "%%" : std::string(1, c);
+            }
+            writes.push_back("writeOutputLiteral(\"" + segment.text + "\");");
+            continue;
+        }
+        if (argIndex >= argumentCodes.size()) {
+            break; // El SemanticAnalyzer ya reportó la falta de argumentos
+        }
+
+        std::string argName = "printArg" + std::to_string(argIndex);
+        const std::string& argCode = argumentCodes[argIndex++];
+        stepArgs.push_back(argName);
+        switch (segment.kind) {
+            case FormatSegmentKind::Int:
+                ss << getCurrentIndent() << "const long long " << argName << " = " << argCode << ";" << std::endl;
+                stepFormat += "%d";
+                writes.push_back("writeOutputInt(" + argName + ");");
+                break;
+            case FormatSegmentKind::String:
+                ss << getCurrentIndent() << "const char* " << argName << " = " << argCode << ";" << std::endl;
+                stepFormat += "%s";
+                writes.push_back("writeOutputString(" + argName + ");");
+                break;
+            case FormatSegmentKind::Pointer:
+                ss << getCurrentIndent() << "const void* " << argName << " = " << argCode << ";" << std::endl;
+                stepFormat += "%p";
+                writes.push_back("writeOutputPointer(" + argName + ");");
+                break;
+            default:
+                break;
+        }
+    }
+
+    ss << generateRecordStep("STEP_PRINT", stepFormat, "STEP_COLOR_PRINT", stepArgs);
+    for (const auto& write : writes) {
+        ss << getCurrentIndent() << write << std::endl;
+    }
+
+    decreaseIndent();
+    ss << getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
 std::string SFMLTranslator::generateBreakStatement() {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Break statement encountered\", COLOR_HIGHLIGHT);" << std::endl;
+    ss << generateRecordStep("STEP_LOOP", "Break statement encountered", "STEP_COLOR_HIGHLIGHT");
     ss << getCurrentIndent() << "break;" << std::endl;
     return ss.str();
 }
 
 std::string SFMLTranslator::generateContinueStatement() {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Continue statement encountered\", COLOR_HIGHLIGHT);" << std::endl;
+    ss << generateRecordStep("STEP_LOOP", "Continue statement encountered", "STEP_COLOR_HIGHLIGHT");
     ss << getCurrentIndent() << "continue;" << std::endl;
     return ss.str();
 }
 
-std::string SFMLTranslator::generateFunctionEntry(const std::string& functionName, const std::vector<std::pair<std::string, std::string>>& params) {
+// Prólogo de una función traducida: empuja su marco (se saca automáticamente al salir)
+// y copia los parámetros a sus slots.
+std::string SFMLTranslator::generateFunctionEntry(const std::string& functionName, int layoutId, const std::vector<std::pair<int, std::string>>& paramSlots) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Entering function: " << functionName << "\", COLOR_FUNCTION_CALL);" << std::endl;
-    ss << getCurrentIndent() << "pushStackFrame();" << std::endl;
-    for (const auto& param : params) {
-        // Asegurarse de que el valor se convierte a string si es necesario
-        ss << getCurrentIndent() << "updateStackFrame(\"" << param.second << "\", std::to_string(" << param.second << "));" << std::endl;
+    if (emitMode == EmitMode::Native) {
+        return "";
+    }
+    if (emitMode == EmitMode::Profile) {
+        ss << getCurrentIndent() << "SimProfileScope profileScope(profileCounters[" << layoutId << "], " << layoutId << ");" << std::endl;
+        return ss.str();
+    }
+    ss << getCurrentIndent() << "StackFrameScope stackFrameScope(" << layoutId << ");" << std::endl;
+    if (checksExecutionLimits()) {
+        ss << getCurrentIndent() << "checkSimulationLimits(" << sourceLine << ");" << std::endl;
     }
+    for (const auto& param : paramSlots) {
+        ss << generateVariableUpdate(param.second, param.first);
+    }
+    ss << generateRecordStep("STEP_CALL", "Entering function: " + functionName, "STEP_COLOR_FUNCTION_CALL");
     return ss.str();
 }
 
-std::string SFMLTranslator::generateFunctionExit(const std::string& functionName, const std::string& returnValueCode) {
+// --- Heap ---
+
+// El paso de malloc es el de la declaración o asignación que recibe el puntero
+std::string SFMLTranslator::generateMallocExpression(const std::string& sizeCode) {
+    if (emitMode != EmitMode::Visualization) {
+        return "static_cast<int*>(std::malloc(" + sizeCode + "))";
+    }
+    usesHeap = true;
+    return "static_cast<int*>(simMalloc(" + sizeCode + ", " + std::to_string(sourceLine) + "))";
+}
+
+std::string SFMLTranslator::generateFreeStatement(const std::string& pointerCode) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "recordStep(\"Exiting function: " << functionName << (returnValueCode.empty() ? "" : " (Returns: " + returnValueCode + ")") << "\", COLOR_RETURN);" << std::endl;
-    ss << getCurrentIndent() << "popStackFrame();" << std::endl;
+    if (emitMode != EmitMode::Visualization) {
+        ss << getCurrentIndent() << "std::free(" << pointerCode << ");" << std::endl;
+        return ss.str();
+    }
+    ss << getCurrentIndent() << "{" << std::endl;
+    increaseIndent();
+    ss << getCurrentIndent() << "const void* freedPointer = " << pointerCode << ";" << std::endl;
+    ss << getCurrentIndent() << "const SimFreeResult freeResult = simFree(freedPointer, " << sourceLine << ");" << std::endl;
+    const std::string errorDescriptor = "freeResult == SIM_FREE_DOUBLE ? " +
+        std::to_string(addStepDescriptor("STEP_CALL", "Error: double free of %p", "STEP_COLOR_HIGHLIGHT")) + " : " +
+        std::to_string(addStepDescriptor("STEP_CALL", "Error: free of %p, which is not a block returned by malloc", "STEP_COLOR_HIGHLIGHT"));
+    if (stepRecordingEnabled) {
+        const std::string freeDescriptor = std::to_string(addStepDescriptor("STEP_CALL", "Freeing %p", "STEP_COLOR_FUNCTION_CALL"));
+        ss << generateRecordStepCall("freeResult == SIM_FREE_OK ? " + freeDescriptor + " : " + errorDescriptor, {"freedPointer"}, stepGuard);
+    } else {
+        // Los errores se registran aunque el plan de instrumentación omita el paso de la sentencia
+        ss << generateRecordStepCall(errorDescriptor, {"freedPointer"}, "freeResult != SIM_FREE_OK");
+    }
+    decreaseIndent();
+    ss << getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
-std::string SFMLTranslator::generateVariableUpdate(const std::string& variableName, const std::string& valueCode) {
+std::string SFMLTranslator::generatePointerAssignment(const std::string& targetCode, const std::string& expressionCode) {
     std::stringstream ss;
-    if (valueCode.find("&") != std::string::npos) {
-        ss << getCurrentIndent() << "updateStackFrame(\"" << variableName << "\", oss_" << variableName << ".str());" << std::endl;
-    } 
-    else if(variableName.find("ptr") != std::string::npos && valueCode.find("ptr") != std::string::npos){
-        cout << "ambos son punteros" << endl;
-        cout << variableName << " ----" << valueCode << endl;
-        cout << "**entra**"<< endl;
-        ss << getCurrentIndent()
-           << "updateStackFrame(\"" << variableName << "\", _oss_" << valueCode << ".str());" << std::endl;
-    }
-    else {
-        
-        //cout<< " y nombre: " << variableName << " initialvalue " << valueCode << endl;
-        ss << getCurrentIndent() << "updateStackFrame(\"" << variableName << "\", std::to_string(" << valueCode << "));" << std::endl;
-    }
-    //ss << getCurrentIndent() << "updateStackFrame(\"" << variableName << "\", std::to_string(" << valueCode << "));" << std::endl;
+    if (emitMode != EmitMode::Visualization) {
+        ss << getCurrentIndent() << "*(" << targetCode << ") = " << expressionCode << ";" << std::endl;
+        return ss.str();
+    }
+    // El destino se evalúa una sola vez: lo usan la comprobación, la escritura, el heap simulado y el paso.
+    // El valor se calcula antes de comprobar el destino (una llamada en él puede liberar el bloque) y no se
+    // escribe si el destino es memoria liberada o está fuera del bloque
+    ss << getCurrentIndent() << "{" << std::endl;
+    increaseIndent();
+    ss << getCurrentIndent() << "int* storeTarget = " << targetCode << ";" << std::endl;
+    ss << getCurrentIndent() << "const int storeValue = " << expressionCode << ";" << std::endl;
+    ss << getCurrentIndent() << "if (simHeapCheckStore(storeTarget, " << sourceLine << ")) {" << std::endl;
+    increaseIndent();
+    ss << getCurrentIndent() << "*storeTarget = storeValue;" << std::endl;
+    ss << getCurrentIndent() << "simHeapStore(storeTarget);" << std::endl;
+    ss << generateRecordStep("STEP_ASSIGNMENT", "Assigning to *%p = %d", "STEP_COLOR_ASSIGNMENT", {"storeTarget", "storeValue"});
+    decreaseIndent();
+    ss << getCurrentIndent() << "} else {" << std::endl;
+    increaseIndent();
+    // Como en free, el error se registra aunque el plan de instrumentación omita el paso de la sentencia
+    const std::string errorDescriptor = std::to_string(addStepDescriptor("STEP_ASSIGNMENT", "Error: write to %p outside an allocated block", "STEP_COLOR_HIGHLIGHT"));
+    ss << generateRecordStepCall(errorDescriptor, {"storeTarget", "storeValue"}, stepRecordingEnabled ? stepGuard : "");
+    decreaseIndent();
+    ss << getCurrentIndent() << "}" << std::endl;
+    decreaseIndent();
+    ss << getCurrentIndent() << "}" << std::endl;
     return ss.str();
 }
 
-std::string SFMLTranslator::generateScopeEnter() {
+// '*p = v' solo puede escribir variables int (int* es el único tipo puntero)
+std::string SFMLTranslator::generateStackAddressBinding(const std::string& variableName, const std::string& typeName, int slot) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "// Entrar en un nuevo ámbito genérico" << std::endl;
-    ss << getCurrentIndent() << "pushStackFrame();" << std::endl;
+    if (slot >= 0 && emitMode == EmitMode::Visualization && !isPointerType(typeName)) {
+        ss << getCurrentIndent() << "bindStackSlotAddress(" << slot << ", &" << variableName << ");" << std::endl;
+    }
     return ss.str();
 }
 
-std::string SFMLTranslator::generateScopeExit() {
+// Actualiza el slot de la variable leyendo su valor ya asignado (sin reevaluar la expresión)
+std::string SFMLTranslator::generateVariableUpdate(const std::string& variableName, int slot) {
     std::stringstream ss;
-    ss << getCurrentIndent() << "// Salir de un ámbito genérico" << std::endl;
-    ss << getCurrentIndent() << "popStackFrame();" << std::endl;
+    if (slot >= 0 && emitMode == EmitMode::Visualization) {
+        ss << getCurrentIndent() << "updateStackFrame(" << slot << ", " << variableName << ");" << std::endl;
+    }
     return ss.str();
 }
\ No newline at end of file
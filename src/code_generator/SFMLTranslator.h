@@ -6,42 +6,141 @@
 #include <map>
 #include <sstream>  // Para std::stringstream
 #include <utility> // Para std::pair
+#include "CodeBackend.h"
 
-class SFMLTranslator {
+// Backend por defecto: programa instrumentado que se enlaza con el visor SFML (sim_viewer)
+class SFMLTranslator : public CodeBackend {
 public:
     SFMLTranslator();
 
-    void increaseIndent();
-    void decreaseIndent();
-    std::string getCurrentIndent() const;
+    void increaseIndent() override;
+    void decreaseIndent() override;
+    std::string getCurrentIndent() const override;
+
+    void setEmitMode(EmitMode mode) override;
+    EmitMode getEmitMode() const override;
+
+    // Con el registro de pasos desactivado, las sentencias se generan sin recordStep
+    // (los marcos de pila se siguen actualizando). Lo controla el plan de instrumentación.
+    void setStepRecordingEnabled(bool enabled) override;
+    bool isStepRecordingEnabled() const override;
+    void setStepGuard(const std::string& guard) override;
+    std::string getStepGuard() const override;
+    void setSourceLine(int line) override;
+    int getSourceLine() const override;
+    void setTraceBudget(size_t maxBytes, SimTraceOverflow overflow) override;
+    void setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops) override;
+    void setLazyStepping(size_t window) override;
+    bool isLazyStepping() const override;
+    void setSourceFileName(const std::string& fileName) override;
+    std::string generateProfileSite() override;
+    int getProfileSite() const override;
+    void setProfileSite(int site) override;
 
     // Partes de generación de código SFML
-    std::string getSFMLHeader();
-    std::string getSFMLFooter();
+    // Las tablas estáticas y el main deben generarse después del cuerpo del programa,
+    // ya que dependen de los descriptores y diseños de marco registrados.
+    std::string getHeader() override;
+    std::string getStepDescriptorTable() override;
+    std::string getFrameLayoutTable() override;
+    std::string getFooter() override; // main(): entrega las tablas y run_c_program_simulation al runtime
+
+    std::string getOutputFileName() const override;
+    std::string getRuntimeLibraries() const override;
+    std::string getCxxStandard() const override; // c++20 con --lazy (corrutinas)
+    std::vector<GeneratedFile> getAuxiliaryFiles() const override;
+
+    // Modo nativo: solo el runtime de salida de printf y un main que ejecuta el programa (con --profile,
+    // además las tablas de contadores y un main que escribe el informe)
+    std::string getNativeHeader() const override;
+    std::string getNativeFooter() const override;
 
     // Pasos de visualización específicos
-    std::string generateProgramStart();
-    std::string generateProgramEnd();
+    std::string generateProgramStart() override;
+    std::string generateProgramEnd() override;
     std::string generateFunctionDeclaration(const std::string& returnType, const std::string& functionName, const std::string& paramsCode, const std::string& bodyCode);
     std::string generateFunctionCall(const std::string& functionName, const std::string& argsCode);
-    std::string generateVariableDeclaration(const std::string& typeName, const std::string& variableName, const std::string& initialValue);
-    std::string generateAssignment(const std::string& identifierName, const std::string& expressionCode);
-    std::string generateReturnStatement(const std::string& expressionCode, const std::string& functionName);
-    std::string generateIfStatement(const std::string& conditionCode, const std::string& thenBlockCode, const std::string& elseBlockCode);
-    std::string generateForLoop(const std::string& initCode, const std::string& conditionCode, const std::string& updateCode, const std::string& bodyCode);
-    std::string generatePrintStatement(const std::string& expressionCode);
+    std::string generateVariableDeclaration(const std::string& typeName, const std::string& variableName, int slot, const std::string& initialValue) override;
+    std::string generateAssignment(const std::string& identifierName, const std::string& typeName, int slot, const std::string& expressionCode) override;
+    std::string generateReturnStatement(const std::string& expressionCode, const std::string& functionName) override;
+    std::string generateIfStatement(const std::string& conditionCode, const std::string& thenBlockCode, const std::string& elseBlockCode) override;
+    // initCode y updateCode son sentencias completas ya generadas; bodyCode viene indentado un nivel más
+    std::string generateForLoop(const std::string& initCode, const std::string& conditionCode, const std::string& updateCode, const std::string& bodyCode,
+                                const std::string& sampleGuard, unsigned sampleEvery) override;
+    std::string generatePrintStatement(const std::vector<FormatSegment>& segments, const std::vector<std::string>& argumentCodes) override;
     std::string generateBreakStatement();
     std::string generateContinueStatement();
 
     // Manipulación de pila y heap para visualización
-    std::string generateFunctionEntry(const std::string& functionName, const std::vector<std::pair<std::string, std::string>>& params);
-    std::string generateFunctionExit(const std::string& functionName, const std::string& returnValueCode);
-    std::string generateVariableUpdate(const std::string& variableName, const std::string& valueCode);
-    std::string generateScopeEnter();
-    std::string generateScopeExit();
+    // paramSlots: (slot, nombre) de cada parámetro
+    std::string generateFunctionEntry(const std::string& functionName, int layoutId, const std::vector<std::pair<int, std::string>>& paramSlots) override;
+    std::string generateVariableUpdate(const std::string& variableName, int slot);
+    // En modo visualización, malloc y free pasan por el heap simulado del runtime (SimulationHeap.cpp)
+    std::string generateMallocExpression(const std::string& sizeCode) override;
+    std::string generateFreeStatement(const std::string& pointerCode) override;
+    std::string generatePointerAssignment(const std::string& targetCode, const std::string& expressionCode) override;
+    std::string generateStackAddressBinding(const std::string& variableName, const std::string& typeName, int slot) override;
+
+    // Diseño estático de los marcos de pila: un layout por función y un slot por variable local
+    int addFrameLayout(const std::string& functionName) override;
+    int addFrameSlot(int layoutId, const std::string& name, const std::string& typeName) override;
+
+    // Máximos usados por el programa; el CodeGenerator los valida contra SimulationLimits.h
+
+protected:
+    // Definición de 'const SimulationProgram program' con las tablas generadas (para el main de cada backend)
+    std::string getSimulationProgramDefinition() const;
 
 private:
+    // Descriptor estático de un paso; se emite como entrada de la tabla constexpr stepDescriptors
+    struct StepDescriptorInfo {
+        std::string kind;   // Enumerador StepKind
+        int line;           // Línea en el fuente C (0 si se desconoce)
+        std::string format; // Plantilla ya escapada como literal de C++
+        std::string color;  // Enumerador StepColor
+    };
+
+    // Diseño del marco de una función: slots (nombre, tipo) en orden de declaración
+    struct FrameLayoutInfo {
+        std::string functionName;
+        int line; // Cabecera de la función en el fuente C
+        std::vector<std::pair<std::string, std::string>> slots;
+    };
+
     int indentLevel;
+    EmitMode emitMode;
+    bool stepRecordingEnabled;
+    std::string stepGuard;
+    int sourceLine;
+    size_t traceBudgetBytes;
+    SimTraceOverflow traceOverflow;
+    size_t maxSteps;
+    unsigned maxMillis;
+    bool detectLoops;
+    size_t lazyWindow; // --lazy (0: desactivado)
+    int stopDescriptors[SIM_STOP_REASON_COUNT]; // Pasos finales de SimStopReason, registrados en generateProgramStart()
+    bool usesHeap;          // Algún malloc: al terminar, el runtime registra las fugas
+    int loopGuardCount;     // Para nombrar los SimulationLoopGuard de cada for
+    std::vector<StepDescriptorInfo> stepDescriptors;
+    std::vector<FrameLayoutInfo> frameLayouts;
+    std::string sourceFileName;
+    std::vector<int> profileSiteLines; // --profile: línea de cada sitio (el 0 son las llamadas fuera de sentencias)
+    int profileSite;                   // Sitio de la sentencia en generación
+
+    int addStepDescriptor(const std::string& kind, const std::string& format, const std::string& color);
+    // Registra un descriptor y devuelve la llamada recordStep(id, args...) correspondiente
+    std::string generateRecordStep(const std::string& kind, const std::string& format, const std::string& color,
+                                   const std::vector<std::string>& args = {});
+    // La llamada con un descriptor ya registrado (o una expresión que elige uno) y la condición dada
+    std::string generateRecordStepCall(const std::string& descriptor, const std::vector<std::string>& args, const std::string& guard);
+    static std::string escapeTemplateText(const std::string& text);
+    std::string getOutputRuntimeDeclarations() const;
+    std::string getOutputRuntime() const;
+    std::string getProfileTables() const;
+    std::string getProfileMain() const;
+    bool checksExecutionLimits() const;
+    static std::string valueFormat(const std::string& typeName);
+    static bool isPointerType(const std::string& typeName);
 };
 
 #endif // SFMLTRANSLATOR_H
\ No newline at end of file
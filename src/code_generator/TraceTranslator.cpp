@@ -0,0 +1,42 @@
+// src/code_generator/TraceTranslator.cpp
+#include "TraceTranslator.h"
+#include <sstream>
+
+std::string TraceTranslator::getHeader() {
+    std::stringstream ss;
+    ss << "// Generado por C_SFML_Compiler (--backend=html): enlazar solo con sim_runtime" << std::endl;
+    ss << "#include \"SimulationRuntime.h\"" << std::endl;
+    return ss.str();
+}
+
+std::string TraceTranslator::getFooter() {
+    std::stringstream ss;
+    ss << std::endl;
+    ss << "int main(int argc, char** argv) {" << std::endl;
+    ss << getSimulationProgramDefinition();
+    ss << "#ifdef SIMULATION_BENCHMARK" << std::endl;
+    ss << "    return runSimulationBenchmark(program);" << std::endl;
+    ss << "#else" << std::endl;
+    ss << "    return runSimulationTraceExport(program, argc > 1 ? argv[1] : \"trace\");" << std::endl;
+    ss << "#endif" << std::endl;
+    ss << "}" << std::endl;
+    return ss.str();
+}
+
+std::string TraceTranslator::getOutputFileName() const {
+    return getEmitMode() == EmitMode::Visualization ? "output_trace.cpp" : SFMLTranslator::getOutputFileName();
+}
+
+std::string TraceTranslator::getRuntimeLibraries() const {
+    if (getEmitMode() != EmitMode::Visualization) {
+        return SFMLTranslator::getRuntimeLibraries();
+    }
+    return "-lsim_runtime -pthread";
+}
+
+std::vector<GeneratedFile> TraceTranslator::getAuxiliaryFiles() const {
+    if (getEmitMode() != EmitMode::Visualization) {
+        return {};
+    }
+    return {GeneratedFile{"trace_viewer.html", TRACE_VIEWER_HTML}};
+}
@@ -0,0 +1,23 @@
+// src/code_generator/TraceTranslator.h
+#ifndef TRACETRANSLATOR_H
+#define TRACETRANSLATOR_H
+
+#include "SFMLTranslator.h"
+
+// Backend HTML: instrumenta igual que el SFMLTranslator, pero el main generado solo registra la
+// simulación y exporta la traza (trace.json / trace.js) con sim_runtime, sin SFML. La traza se
+// reproduce sin conexión en trace_viewer.html, que se genera junto al programa.
+class TraceTranslator : public SFMLTranslator {
+public:
+    std::string getHeader() override;
+    std::string getFooter() override; // main(int argc, char** argv): argv[1] = nombre base de la traza
+
+    std::string getOutputFileName() const override;
+    std::string getRuntimeLibraries() const override;
+    std::vector<GeneratedFile> getAuxiliaryFiles() const override;
+};
+
+// Visor estático (HTML + JS) de las trazas exportadas; definido en TraceViewerHtml.cpp
+extern const char* const TRACE_VIEWER_HTML;
+
+#endif // TRACETRANSLATOR_H
@@ -0,0 +1,118 @@
+// src/code_generator/TraceViewerHtml.cpp
+// Visor autónomo de trazas (--backend=html). Reproduce las vistas Heap/Stack del visor SFML
+// en cualquier navegador, sin servidor: carga trace.js con <script> o un .json elegido a mano.
+#include "TraceTranslator.h"
+
+const char* const TRACE_VIEWER_HTML = R"HTML(<!DOCTYPE html>
+<html lang="es">
+<head>
+<meta charset="utf-8">
+<title>C Simulation Trace</title>
+<style>
+  body { font-family: Arial, sans-serif; background: #f0f0f0; margin: 20px; }
+  #description { font-size: 18px; min-height: 24px; margin-bottom: 16px; }
+  #description.declaration { color: #0064c8; }
+  #description.assignment { color: #c86400; }
+  #description.call { color: #8000c0; }
+  #description.return { color: #c00000; }
+  #description.print { color: #008000; }
+  #description.highlight { color: #0000ff; }
+  h2 { font-size: 20px; margin: 12px 0 4px; }
+  .bar { display: flex; flex-wrap: wrap; gap: 6px; align-items: center; min-height: 44px;
+         padding: 8px; background: #d2d2d2; border: 2px solid black; }
+  .box { border: 1px solid black; padding: 6px 10px; font-size: 16px; white-space: nowrap; }
+  .frame { background: #96ff96; font-weight: bold; }
+  .value { background: #96ff96; }
+  .pointer { background: #ffff96; }
+  #controls { margin-top: 20px; display: flex; gap: 12px; align-items: center; }
+  button { width: 120px; height: 40px; font-size: 18px; color: white; background: #464646; border: 1px solid black; }
+  button:disabled { background: #1e1e1e; }
+</style>
+</head>
+<body>
+<div id="description">Cargando trace.js...</div>
+<h2>Heap</h2>
+<div id="heap" class="bar"></div>
+<h2>Stack</h2>
+<div id="stack" class="bar"></div>
+<div id="controls">
+  <button id="prev">Previous</button>
+  <button id="next">Next</button>
+  <span id="position"></span>
+  <input id="file" type="file" accept=".json,application/json">
+</div>
+<script src="trace.js"></script>
+<script>
+(function () {
+  var steps = [];
+  var current = 0;
+
+  function box(text, className) {
+    var element = document.createElement("div");
+    element.className = "box " + className;
+    element.textContent = text;
+    return element;
+  }
+
+  function render() {
+    var description = document.getElementById("description");
+    var heap = document.getElementById("heap");
+    var stack = document.getElementById("stack");
+    heap.innerHTML = "";
+    stack.innerHTML = "";
+    if (steps.length === 0) {
+      description.textContent = "No hay traza: ejecute el programa generado o elija un archivo .json";
+      description.className = "";
+    } else {
+      var step = steps[current];
+      description.textContent = step.text + (step.line > 0 ? "  (línea " + step.line + ")" : "");
+      description.className = step.color;
+      step.heap.forEach(function (object) {
+        heap.appendChild(box(object.address + ": " + object.value, "pointer"));
+      });
+      step.stack.forEach(function (frame) {
+        stack.appendChild(box(frame.function, "frame"));
+        frame.variables.forEach(function (variable) {
+          stack.appendChild(box(variable.name + " " + variable.value, variable.pointer ? "pointer" : "value"));
+        });
+      });
+    }
+    document.getElementById("prev").disabled = current <= 0;
+    document.getElementById("next").disabled = current + 1 >= steps.length;
+    document.getElementById("position").textContent = steps.length ? (current + 1) + " / " + steps.length : "";
+  }
+
+  function load(trace) {
+    steps = (trace && trace.steps) || [];
+    current = 0;
+    render();
+  }
+
+  function move(delta) {
+    var target = current + delta;
+    if (target >= 0 && target < steps.length) {
+      current = target;
+      render();
+    }
+  }
+
+  document.getElementById("prev").onclick = function () { move(-1); };
+  document.getElementById("next").onclick = function () { move(1); };
+  document.addEventListener("keydown", function (event) {
+    if (event.key === "ArrowLeft") move(-1);
+    if (event.key === "ArrowRight") move(1);
+  });
+  document.getElementById("file").onchange = function (event) {
+    var file = event.target.files[0];
+    if (!file) return;
+    var reader = new FileReader();
+    reader.onload = function () { load(JSON.parse(reader.result)); };
+    reader.readAsText(file);
+  };
+
+  load(window.SIMULATION_TRACE);
+})();
+</script>
+</body>
+</html>
+)HTML";
@@ -0,0 +1,155 @@
+// src/driver/RunDriver.cpp
+#include "RunDriver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Opciones de compilación del programa generado (además de -std=); la cabecera precompilada solo es
+// válida si se compila con exactamente las mismas, así que hay una por estándar. -pthread va aquí y no
+// solo al enlazar (getRuntimeLibraries también la pasa): define _REENTRANT, y con una definición
+// distinta de la de la cabecera g++ la descartaría sin avisar.
+const char* RUN_CXX_FLAGS = "-O1 -pthread";
+
+std::string runCxxFlags(const std::string& cxxStandard) {
+    return "-std=" + cxxStandard + " " + RUN_CXX_FLAGS;
+}
+
+std::string quote(const std::string& path) {
+    return "\"" + path + "\"";
+}
+
+std::string compilerCommand() {
+    const char* cxx = std::getenv("CXX");
+    return (cxx && *cxx) ? cxx : "g++";
+}
+
+// Ejecuta un comando y devuelve su código de salida
+int runCommand(const std::string& command) {
+    int status = std::system(command.c_str());
+#ifndef _WIN32
+    if (status != -1 && WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+#endif
+    return status;
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path);
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+// Clave de la cabecera precompilada: el compilador, las opciones y un hash (FNV-1a) del nombre y el
+// contenido de cada cabecera del runtime, de modo que cualquier cambio en una de ellas (incluidas las que
+// SimulationRuntime.h llegue a incluir) la regenera aunque las fechas de los archivos no lo reflejen
+std::string precompiledHeaderKey(const std::string& flags) {
+    std::vector<fs::path> headers;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(SIM_RUNTIME_INCLUDE_DIR, ec)) {
+        if (entry.path().extension() == ".h") {
+            headers.push_back(entry.path());
+        }
+    }
+    std::sort(headers.begin(), headers.end());
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const fs::path& header : headers) {
+        // El nombre separa los archivos: mover texto de una cabecera a otra cambia la clave
+        for (unsigned char c : header.filename().string() + '\0' + readFile(header) + '\0') {
+            hash = (hash ^ c) * 0x100000001b3ULL;
+        }
+    }
+    std::ostringstream key;
+    key << flags << "\n" << std::hex << hash << "\n";
+    return key.str();
+}
+
+// Regenera <cache>/<estándar>/SimulationRuntime.h.gch si falta o si cambió su clave (cabeceras del runtime,
+// compilador u opciones), guardada junto a ella. Devuelve el directorio de la caché ("" si no se pudo crear).
+std::string ensurePrecompiledHeader(const std::string& cxx, const std::string& cxxStandard) {
+    const fs::path header = fs::path(SIM_RUNTIME_INCLUDE_DIR) / "SimulationRuntime.h";
+    const fs::path cacheDir = fs::path(SIM_RUNTIME_LIBRARY_DIR) / "pch" / cxxStandard;
+    const fs::path gch = cacheDir / "SimulationRuntime.h.gch";
+    const fs::path stamp = cacheDir / "SimulationRuntime.h.gch.key";
+    const std::string key = precompiledHeaderKey(cxx + " " + runCxxFlags(cxxStandard));
+
+    std::error_code ec;
+    fs::create_directories(cacheDir, ec);
+    if (ec) {
+        return "";
+    }
+
+    if (fs::exists(gch) && fs::exists(stamp) && readFile(stamp) == key) {
+        return cacheDir.string();
+    }
+
+    std::cout << "Precompiling " << header.string() << "..." << std::endl;
+    std::string command = cxx + " " + runCxxFlags(cxxStandard) + " -x c++-header " + quote(header.string()) + " -o " + quote(gch.string());
+    if (runCommand(command) != 0) {
+        return "";
+    }
+    std::ofstream(stamp) << key;
+    return cacheDir.string();
+}
+
+} // namespace
+
+int compileAndRun(const std::string& generatedFile, EmitMode mode, const std::string& runtimeLibraries, const std::string& cxxStandard,
+                  ErrorHandler& errorHandler) {
+    const std::string cxx = compilerCommand();
+    const fs::path source(generatedFile);
+#ifdef _WIN32
+    const fs::path executable = fs::path(source).replace_extension(".exe");
+    const std::string launch = quote(executable.string());
+#else
+    const fs::path executable = fs::path(source).replace_extension("");
+    const std::string launch = quote((fs::absolute(executable)).string());
+#endif
+
+    std::string command;
+    if (mode == EmitMode::Native) {
+        // -g: con las directivas #line, perf y gdb muestran las líneas del fuente C
+        command = cxx + " -std=" + cxxStandard + " -O2 -g " + quote(source.string()) + " -o " + quote(executable.string());
+    } else if (mode == EmitMode::Profile) {
+        // Optimizado como el nativo (se mide el programa real); de sim_runtime solo enlaza el informe
+        command = cxx + " -std=" + cxxStandard + " -O2 -g -I" + quote(SIM_RUNTIME_INCLUDE_DIR) + " " + quote(source.string()) + " -o " +
+                  quote(executable.string()) + " -L" + quote(SIM_RUNTIME_LIBRARY_DIR) + " " + runtimeLibraries;
+    } else {
+        std::string pchDir = ensurePrecompiledHeader(cxx, cxxStandard);
+        if (pchDir.empty()) {
+            errorHandler.reportWarning("No se pudo preparar la cabecera precompilada; se compila sin ella.", -1, -1);
+        }
+        command = cxx + " " + runCxxFlags(cxxStandard);
+        if (!pchDir.empty()) {
+            // Antes que el runtime: g++ usa el .gch de este directorio, y avisa si no puede usarlo
+            command += " -Winvalid-pch -I" + quote(pchDir);
+        }
+        command += " -I" + quote(SIM_RUNTIME_INCLUDE_DIR) + " " + quote(source.string()) + " -o " + quote(executable.string());
+        command += " -L" + quote(SIM_RUNTIME_LIBRARY_DIR) + " " + runtimeLibraries;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (runCommand(command) != 0) {
+        errorHandler.reportError("Falló la compilación de " + source.string() + ": " + command, -1, -1);
+        return 1;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Compiled " << executable.string() << " in " << static_cast<long>(elapsed.count()) << " ms" << std::endl;
+
+    return runCommand(launch);
+}
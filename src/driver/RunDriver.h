@@ -0,0 +1,26 @@
+// src/driver/RunDriver.h
+#ifndef RUNDRIVER_H
+#define RUNDRIVER_H
+
+#include "../code_generator/CodeBackend.h" // EmitMode
+#include "../utils/ErrorHandler.h"
+#include <string>
+
+// Rutas fijadas por CMake al construir el compilador (ver src/CMakeLists.txt)
+#ifndef SIM_RUNTIME_INCLUDE_DIR
+#define SIM_RUNTIME_INCLUDE_DIR "src/runtime"
+#endif
+#ifndef SIM_RUNTIME_LIBRARY_DIR
+#define SIM_RUNTIME_LIBRARY_DIR "build/src/runtime"
+#endif
+
+// Compila el archivo generado y lo ejecuta (opción --run).
+// En modo visualización enlaza contra las bibliotecas del runtime precompilado que indique el backend
+// (runtimeLibraries, p. ej. "-lsim_viewer -lsim_runtime ...") y usa una cabecera precompilada de
+// SimulationRuntime.h guardada en caché; en modo nativo solo compila, y con --profile enlaza además el
+// informe de sim_runtime. cxxStandard es el que pide el backend (c++20 con --lazy).
+// Devuelve el código de salida del programa, o 1 si falla la compilación.
+int compileAndRun(const std::string& generatedFile, EmitMode mode, const std::string& runtimeLibraries, const std::string& cxxStandard,
+                  ErrorHandler& errorHandler);
+
+#endif // RUNDRIVER_H
@@ -0,0 +1,110 @@
+// src/ir/IR.cpp
+#include "IR.h"
+#include <sstream>
+
+namespace {
+
+std::string operandToString(const IROperand& operand) {
+    switch (operand.kind) {
+        case IROperandKind::Temporary:      return "%t" + operand.text;
+        case IROperandKind::Variable:       return operand.text;
+        case IROperandKind::IntConstant:    return operand.text;
+        case IROperandKind::StringConstant: return "\"" + operand.text + "\"";
+        default:                            return "<none>";
+    }
+}
+
+std::string operandList(const std::vector<IROperand>& operands) {
+    std::string result;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        if (i > 0) {
+            result += ", ";
+        }
+        result += operandToString(operands[i]);
+    }
+    return result;
+}
+
+std::string instructionToString(const IRInstruction& instruction) {
+    std::stringstream ss;
+    if (!instruction.dest.isNone()) {
+        ss << (instruction.declaresDest ? "decl " : "") << operandToString(instruction.dest) << " = ";
+    }
+
+    switch (instruction.opcode) {
+        case IROpcode::Copy:
+            ss << operandToString(instruction.operands[0]);
+            break;
+        case IROpcode::Unary:
+            ss << instruction.op << operandToString(instruction.operands[0]);
+            break;
+        case IROpcode::Binary:
+            ss << operandToString(instruction.operands[0]) << " " << instruction.op << " " << operandToString(instruction.operands[1]);
+            break;
+        case IROpcode::AddressOf:
+            ss << "&" << operandToString(instruction.operands[0]);
+            break;
+        case IROpcode::Load:
+            ss << "*" << operandToString(instruction.operands[0]);
+            break;
+        case IROpcode::Store:
+            ss << "*" << operandToString(instruction.operands[0]) << " = " << operandToString(instruction.operands[1]);
+            break;
+        case IROpcode::Call:
+            ss << "call " << instruction.op << "(" << operandList(instruction.operands) << ")";
+            break;
+        case IROpcode::Print:
+            ss << "print \"" << instruction.op << "\"";
+            if (!instruction.operands.empty()) {
+                ss << ", " << operandList(instruction.operands);
+            }
+            break;
+    }
+    return ss.str();
+}
+
+std::string terminatorToString(const IRFunction& function, const IRTerminator& terminator) {
+    auto label = [&function](int id) { return function.blocks[id].label; };
+    switch (terminator.kind) {
+        case IRTerminatorKind::Jump:
+            return "jump " + label(terminator.target);
+        case IRTerminatorKind::Branch:
+            return "branch " + operandToString(terminator.value) + ", " + label(terminator.target) + ", " + label(terminator.falseTarget);
+        case IRTerminatorKind::Return:
+            return terminator.value.isNone() ? "return" : "return " + operandToString(terminator.value);
+    }
+    return "";
+}
+
+} // namespace
+
+std::string printIR(const IRProgram& program) {
+    std::stringstream ss;
+    for (const auto& function : program.functions) {
+        ss << "function " << function.returnType << " " << function.name << "(";
+        for (size_t i = 0; i < function.parameters.size(); ++i) {
+            ss << (i > 0 ? ", " : "") << function.parameters[i].first << " " << function.parameters[i].second;
+        }
+        ss << ") {" << std::endl;
+
+        for (const auto& block : function.blocks) {
+            ss << block.label << ":";
+            if (!block.predecessors.empty()) {
+                ss << "    ; preds:";
+                for (int pred : block.predecessors) {
+                    ss << " " << function.blocks[pred].label;
+                }
+            }
+            if (!block.reachable) {
+                ss << "    ; inalcanzable";
+            }
+            ss << std::endl;
+            for (const auto& instruction : block.instructions) {
+                ss << "    " << instructionToString(instruction) << std::endl;
+            }
+            ss << "    " << terminatorToString(function, block.terminator) << std::endl;
+        }
+        ss << "}" << std::endl << std::endl;
+    }
+    return ss.str();
+}
@@ -0,0 +1,94 @@
+// src/ir/IR.h
+#ifndef IR_H
+#define IR_H
+
+#include <string>
+#include <vector>
+#include <utility> // Para std::move
+
+class ASTNode;
+
+// Representación intermedia: grafo de flujo de control (CFG) de bloques básicos
+// con instrucciones de tres direcciones. Se obtiene del AST ya verificado por el
+// SemanticAnalyzer y sirve para decidir dónde instrumentar el código generado.
+
+// Tipo de operando de una instrucción
+enum class IROperandKind {
+    None,          // Operando ausente (ej. return sin valor)
+    Temporary,     // Temporal generado por la bajada (t0, t1, ...)
+    Variable,      // Variable o parámetro del programa C
+    IntConstant,   // Literal entero
+    StringConstant // Literal de cadena
+};
+
+struct IROperand {
+    IROperandKind kind;
+    std::string text; // Nombre de la variable, número del temporal o valor del literal
+
+    IROperand(IROperandKind kind = IROperandKind::None, std::string text = "")
+        : kind(kind), text(std::move(text)) {}
+
+    bool isNone() const { return kind == IROperandKind::None; }
+};
+
+// Operaciones de tres direcciones
+enum class IROpcode {
+    Copy,      // dest = a
+    Unary,     // dest = op a
+    Binary,    // dest = a op b
+    AddressOf, // dest = &variable
+    Load,      // dest = *a
+    Store,     // *a = b
+    Call,      // [dest =] callee(args...) (malloc y free también son llamadas)
+    Print      // printf(formato, args...)
+};
+
+struct IRInstruction {
+    IROpcode opcode;
+    IROperand dest;                 // Destino (None si la instrucción no produce valor)
+    std::string op;                 // Operador para Unary/Binary, función para Call, formato para Print
+    std::vector<IROperand> operands;
+    bool declaresDest = false;      // true si el destino es una variable declarada aquí
+    const ASTNode* source = nullptr; // Sentencia del AST que originó la instrucción
+};
+
+// Instrucción final de un bloque básico
+enum class IRTerminatorKind {
+    Jump,   // goto target
+    Branch, // if (condition) goto target else goto falseTarget
+    Return  // return [value]
+};
+
+struct IRTerminator {
+    IRTerminatorKind kind = IRTerminatorKind::Return;
+    IROperand value;  // Condición de Branch o valor de Return
+    int target = -1;
+    int falseTarget = -1;
+    const ASTNode* source = nullptr; // Sentencia que produjo el salto (if, for, return)
+};
+
+struct BasicBlock {
+    int id;
+    std::string label;
+    std::vector<IRInstruction> instructions;
+    IRTerminator terminator;
+    std::vector<int> predecessors;
+    bool reachable = true;
+};
+
+struct IRFunction {
+    std::string name;
+    std::string returnType;
+    std::vector<std::pair<std::string, std::string>> parameters; // Tipo, Nombre
+    std::vector<BasicBlock> blocks; // blocks[0] es el bloque de entrada
+    int temporaryCount = 0;
+};
+
+struct IRProgram {
+    std::vector<IRFunction> functions;
+};
+
+// Imprime el IR en formato textual (usado por --dump-ir).
+std::string printIR(const IRProgram& program);
+
+#endif // IR_H
@@ -0,0 +1,348 @@
+// src/ir/IRBuilder.cpp
+#include "IRBuilder.h"
+#include <utility> // Para std::move
+
+IRBuilder::IRBuilder(ErrorHandler& errorHandler)
+    : errorHandler(errorHandler), currentFunction(nullptr), currentBlock(-1), currentStatement(nullptr) {
+}
+
+IRProgram IRBuilder::lower(ProgramNode* program) {
+    IRProgram result;
+    if (!program) {
+        return result;
+    }
+
+    bool mainFound = false;
+    for (const auto& func : program->functionDeclarations) {
+        auto funcDecl = static_cast<FunctionDeclarationNode*>(func.get());
+        mainFound = mainFound || funcDecl->name == "main";
+
+        std::vector<ASTNode*> body;
+        if (funcDecl->body) {
+            body.push_back(funcDecl->body.get());
+        }
+        result.functions.emplace_back();
+        currentFunction = &result.functions.back();
+        lowerFunction(funcDecl->name, funcDecl->returnType, funcDecl->parameters, body);
+    }
+
+    // Sin main, las sentencias globales forman su propia función (igual que en el CodeGenerator)
+    if (!mainFound) {
+        std::vector<ASTNode*> statements;
+        for (const auto& stmt : program->statements) {
+            statements.push_back(stmt.get());
+        }
+        result.functions.emplace_back();
+        currentFunction = &result.functions.back();
+        lowerFunction("global_scope", "void", {}, statements);
+    }
+
+    currentFunction = nullptr;
+    return result;
+}
+
+void IRBuilder::lowerFunction(const std::string& name, const std::string& returnType,
+                              const std::vector<std::pair<std::string, std::string>>& parameters,
+                              const std::vector<ASTNode*>& statements) {
+    currentFunction->name = name;
+    currentFunction->returnType = returnType;
+    currentFunction->parameters = parameters;
+    blockTerminated.clear();
+    currentStatement = nullptr;
+    currentBlock = newBlock("entry");
+
+    for (ASTNode* stmt : statements) {
+        lowerStatement(stmt);
+    }
+
+    // Retorno implícito al final de la función
+    if (!blockTerminated[currentBlock]) {
+        currentStatement = nullptr;
+        terminate(IRTerminator{});
+    }
+    computePredecessors(*currentFunction);
+}
+
+void IRBuilder::lowerStatement(ASTNode* node) {
+    if (!node) {
+        return;
+    }
+
+    const ASTNode* previousStatement = currentStatement;
+    if (node->type != ASTNodeType::BlockStatement) {
+        currentStatement = node;
+    }
+
+    switch (node->type) {
+        case ASTNodeType::VariableDeclaration: {
+            auto decl = static_cast<VariableDeclarationNode*>(node);
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Copy;
+            instruction.operands.push_back(decl->initializer ? lowerExpression(decl->initializer.get())
+                                                             : IROperand(IROperandKind::IntConstant, "0"));
+            instruction.dest = IROperand(IROperandKind::Variable, decl->variableName);
+            instruction.declaresDest = true;
+            emit(std::move(instruction));
+            break;
+        }
+        case ASTNodeType::AssignmentStatement: {
+            auto assign = static_cast<AssignmentStatementNode*>(node);
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Copy;
+            instruction.operands.push_back(lowerExpression(assign->expression.get()));
+            instruction.dest = IROperand(IROperandKind::Variable, assign->identifierName);
+            emit(std::move(instruction));
+            break;
+        }
+        case ASTNodeType::FunctionCall:
+            lowerCall(static_cast<FunctionCallNode*>(node), false);
+            break;
+        case ASTNodeType::FreeStatement: {
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Call;
+            instruction.op = "free";
+            instruction.operands.push_back(lowerExpression(static_cast<FreeStatementNode*>(node)->pointer.get()));
+            emit(std::move(instruction));
+            break;
+        }
+        case ASTNodeType::PointerAssignmentStatement: {
+            auto store = static_cast<PointerAssignmentStatementNode*>(node);
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Store;
+            instruction.operands.push_back(lowerExpression(store->target.get()));
+            instruction.operands.push_back(lowerExpression(store->expression.get()));
+            emit(std::move(instruction));
+            break;
+        }
+        case ASTNodeType::PrintStatement: {
+            auto print = static_cast<PrintStatementNode*>(node);
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Print;
+            instruction.op = print->formatString;
+            for (const auto& arg : print->arguments) {
+                instruction.operands.push_back(lowerExpression(arg.get()));
+            }
+            emit(std::move(instruction));
+            break;
+        }
+        case ASTNodeType::ReturnStatement: {
+            auto ret = static_cast<ReturnStatementNode*>(node);
+            IRTerminator terminator;
+            terminator.kind = IRTerminatorKind::Return;
+            if (ret->expression) {
+                terminator.value = lowerExpression(ret->expression.get());
+            }
+            terminator.source = node;
+            terminate(terminator);
+            // Lo que siga al return en el mismo bloque es código muerto
+            currentBlock = newBlock("after.return");
+            break;
+        }
+        case ASTNodeType::IfStatement:
+            lowerIfStatement(static_cast<IfStatementNode*>(node));
+            break;
+        case ASTNodeType::ForStatement:
+            lowerForStatement(static_cast<ForStatementNode*>(node));
+            break;
+        case ASTNodeType::BlockStatement:
+            for (const auto& stmt : static_cast<BlockStatementNode*>(node)->statements) {
+                lowerStatement(stmt.get());
+            }
+            break;
+        default:
+            errorHandler.reportError("Nodo AST inesperado como sentencia al construir el IR: " + std::to_string(static_cast<int>(node->type)), -1, -1);
+            break;
+    }
+
+    currentStatement = previousStatement;
+}
+
+void IRBuilder::lowerIfStatement(IfStatementNode* node) {
+    IRTerminator branch;
+    branch.kind = IRTerminatorKind::Branch;
+    branch.value = lowerExpression(node->condition.get());
+    branch.source = node;
+
+    int thenBlock = newBlock("if.then");
+    int elseBlock = node->elseBlock ? newBlock("if.else") : -1;
+    int endBlock = newBlock("if.end");
+    branch.target = thenBlock;
+    branch.falseTarget = elseBlock >= 0 ? elseBlock : endBlock;
+    terminate(branch);
+
+    currentBlock = thenBlock;
+    lowerStatement(node->thenBlock.get());
+    jumpTo(endBlock);
+
+    if (elseBlock >= 0) {
+        currentBlock = elseBlock;
+        lowerStatement(node->elseBlock.get());
+        jumpTo(endBlock);
+    }
+    currentBlock = endBlock;
+}
+
+void IRBuilder::lowerForStatement(ForStatementNode* node) {
+    lowerStatement(node->initialization.get());
+    currentStatement = node;
+
+    int condBlock = newBlock("for.cond");
+    int bodyBlock = newBlock("for.body");
+    int endBlock = newBlock("for.end");
+    jumpTo(condBlock, node); // La entrada al bucle es el punto donde se registra su paso
+
+    // La condición es una expresión pura: no pertenece a ninguna sentencia instrumentable
+    currentBlock = condBlock;
+    currentStatement = nullptr;
+    if (node->condition) {
+        IRTerminator branch;
+        branch.kind = IRTerminatorKind::Branch;
+        branch.value = lowerExpression(node->condition.get());
+        branch.target = bodyBlock;
+        branch.falseTarget = endBlock;
+        terminate(branch);
+    } else {
+        jumpTo(bodyBlock);
+    }
+
+    currentBlock = bodyBlock;
+    lowerStatement(node->body.get());
+    lowerStatement(node->increment.get());
+    jumpTo(condBlock);
+
+    currentBlock = endBlock;
+}
+
+IROperand IRBuilder::lowerExpression(ASTNode* node) {
+    if (!node) {
+        return IROperand();
+    }
+
+    switch (node->type) {
+        case ASTNodeType::Identifier:
+            return IROperand(IROperandKind::Variable, static_cast<IdentifierNode*>(node)->name);
+        case ASTNodeType::Literal: {
+            auto literal = static_cast<LiteralNode*>(node);
+            return IROperand(literal->isString ? IROperandKind::StringConstant : IROperandKind::IntConstant, literal->value);
+        }
+        case ASTNodeType::BinaryExpression: {
+            auto binary = static_cast<BinaryExpressionNode*>(node);
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Binary;
+            instruction.op = binary->op;
+            instruction.operands.push_back(lowerExpression(binary->left.get()));
+            instruction.operands.push_back(lowerExpression(binary->right.get()));
+            instruction.dest = newTemporary();
+            IROperand result = instruction.dest;
+            emit(std::move(instruction));
+            return result;
+        }
+        case ASTNodeType::UnaryExpression: {
+            auto unary = static_cast<UnaryExpressionNode*>(node);
+            IRInstruction instruction;
+            if (unary->op == "&") {
+                instruction.opcode = IROpcode::AddressOf;
+            } else if (unary->op == "*") {
+                instruction.opcode = IROpcode::Load;
+            } else {
+                instruction.opcode = IROpcode::Unary;
+                instruction.op = unary->op;
+            }
+            instruction.operands.push_back(lowerExpression(unary->operand.get()));
+            instruction.dest = newTemporary();
+            IROperand result = instruction.dest;
+            emit(std::move(instruction));
+            return result;
+        }
+        case ASTNodeType::FunctionCall:
+            return lowerCall(static_cast<FunctionCallNode*>(node), true);
+        case ASTNodeType::MallocExpression: {
+            IRInstruction instruction;
+            instruction.opcode = IROpcode::Call;
+            instruction.op = "malloc";
+            instruction.operands.push_back(lowerExpression(static_cast<MallocExpressionNode*>(node)->size.get()));
+            instruction.dest = newTemporary();
+            IROperand result = instruction.dest;
+            emit(std::move(instruction));
+            return result;
+        }
+        default:
+            errorHandler.reportError("Nodo AST inesperado como expresión al construir el IR: " + std::to_string(static_cast<int>(node->type)), -1, -1);
+            return IROperand();
+    }
+}
+
+IROperand IRBuilder::lowerCall(FunctionCallNode* node, bool wantsResult) {
+    IRInstruction instruction;
+    instruction.opcode = IROpcode::Call;
+    instruction.op = node->functionName;
+    for (const auto& arg : node->arguments) {
+        instruction.operands.push_back(lowerExpression(arg.get()));
+    }
+    if (wantsResult) {
+        instruction.dest = newTemporary();
+    }
+    IROperand result = instruction.dest;
+    emit(std::move(instruction));
+    return result;
+}
+
+int IRBuilder::newBlock(const std::string& prefix) {
+    BasicBlock block;
+    block.id = static_cast<int>(currentFunction->blocks.size());
+    block.label = block.id == 0 ? prefix : prefix + "." + std::to_string(block.id);
+    currentFunction->blocks.push_back(std::move(block));
+    blockTerminated.push_back(false);
+    return currentFunction->blocks.back().id;
+}
+
+IROperand IRBuilder::newTemporary() {
+    return IROperand(IROperandKind::Temporary, std::to_string(currentFunction->temporaryCount++));
+}
+
+void IRBuilder::emit(IRInstruction instruction) {
+    instruction.source = currentStatement;
+    currentFunction->blocks[currentBlock].instructions.push_back(std::move(instruction));
+}
+
+void IRBuilder::terminate(IRTerminator terminator) {
+    if (blockTerminated[currentBlock]) {
+        return;
+    }
+    currentFunction->blocks[currentBlock].terminator = terminator;
+    blockTerminated[currentBlock] = true;
+}
+
+void IRBuilder::jumpTo(int target, const ASTNode* source) {
+    IRTerminator jump;
+    jump.kind = IRTerminatorKind::Jump;
+    jump.target = target;
+    jump.source = source;
+    terminate(jump);
+}
+
+// Calcula predecesores y alcanzabilidad desde el bloque de entrada
+void IRBuilder::computePredecessors(IRFunction& function) {
+    for (auto& block : function.blocks) {
+        block.predecessors.clear();
+        block.reachable = false;
+    }
+
+    std::vector<int> worklist = {0};
+    function.blocks[0].reachable = true;
+    while (!worklist.empty()) {
+        int id = worklist.back();
+        worklist.pop_back();
+        const IRTerminator& terminator = function.blocks[id].terminator;
+        for (int successor : {terminator.target, terminator.falseTarget}) {
+            if (successor < 0 || terminator.kind == IRTerminatorKind::Return) {
+                continue;
+            }
+            function.blocks[successor].predecessors.push_back(id);
+            if (!function.blocks[successor].reachable) {
+                function.blocks[successor].reachable = true;
+                worklist.push_back(successor);
+            }
+        }
+    }
+}
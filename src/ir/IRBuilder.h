@@ -0,0 +1,42 @@
+// src/ir/IRBuilder.h
+#ifndef IRBUILDER_H
+#define IRBUILDER_H
+
+#include "IR.h"
+#include "../parser/AST.h"
+#include "../utils/ErrorHandler.h"
+#include <string>
+#include <vector>
+
+// Baja el AST verificado a un CFG de bloques básicos (una IRFunction por función C).
+class IRBuilder {
+public:
+    explicit IRBuilder(ErrorHandler& errorHandler);
+
+    IRProgram lower(ProgramNode* program);
+
+private:
+    void lowerFunction(const std::string& name, const std::string& returnType,
+                       const std::vector<std::pair<std::string, std::string>>& parameters,
+                       const std::vector<ASTNode*>& statements);
+    void lowerStatement(ASTNode* node);
+    void lowerIfStatement(IfStatementNode* node);
+    void lowerForStatement(ForStatementNode* node);
+    IROperand lowerExpression(ASTNode* node);
+    IROperand lowerCall(FunctionCallNode* node, bool wantsResult);
+
+    int newBlock(const std::string& prefix);
+    IROperand newTemporary();
+    void emit(IRInstruction instruction);
+    void terminate(IRTerminator terminator);
+    void jumpTo(int target, const ASTNode* source = nullptr);
+    void computePredecessors(IRFunction& function);
+
+    ErrorHandler& errorHandler;
+    IRFunction* currentFunction;
+    int currentBlock;
+    std::vector<bool> blockTerminated;
+    const ASTNode* currentStatement; // Sentencia que se está bajando (origen de las instrucciones)
+};
+
+#endif // IRBUILDER_H
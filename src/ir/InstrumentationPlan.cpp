@@ -0,0 +1,239 @@
+// src/ir/InstrumentationPlan.cpp
+#include "InstrumentationPlan.h"
+#include "../parser/AST.h"
+
+namespace {
+
+// Sentencias para las que el CodeGenerator emite un recordStep
+bool isSteppingStatement(const ASTNode* node) {
+    if (!node) {
+        return false;
+    }
+    switch (node->type) {
+        case ASTNodeType::VariableDeclaration:
+        case ASTNodeType::AssignmentStatement:
+        case ASTNodeType::PrintStatement:
+        case ASTNodeType::FreeStatement:
+        case ASTNodeType::PointerAssignmentStatement:
+        case ASTNodeType::IfStatement:
+        case ASTNodeType::ForStatement:
+        case ASTNodeType::ReturnStatement:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Nombres de variable que lee la expresión (incluidos los argumentos de las llamadas)
+void collectIdentifiers(const ASTNode* node, std::unordered_set<std::string>& names) {
+    if (!node) {
+        return;
+    }
+    switch (node->type) {
+        case ASTNodeType::Identifier:
+            names.insert(static_cast<const IdentifierNode*>(node)->name);
+            break;
+        case ASTNodeType::BinaryExpression: {
+            auto binary = static_cast<const BinaryExpressionNode*>(node);
+            collectIdentifiers(binary->left.get(), names);
+            collectIdentifiers(binary->right.get(), names);
+            break;
+        }
+        case ASTNodeType::UnaryExpression:
+            collectIdentifiers(static_cast<const UnaryExpressionNode*>(node)->operand.get(), names);
+            break;
+        case ASTNodeType::FunctionCall:
+            for (const auto& arg : static_cast<const FunctionCallNode*>(node)->arguments) {
+                collectIdentifiers(arg.get(), names);
+            }
+            break;
+        case ASTNodeType::MallocExpression:
+            collectIdentifiers(static_cast<const MallocExpressionNode*>(node)->size.get(), names);
+            break;
+        default:
+            break;
+    }
+}
+
+// Variables que escribe o lee la sentencia, sin entrar en los bloques que contiene
+std::unordered_set<std::string> statementVariables(const ASTNode* node) {
+    std::unordered_set<std::string> names;
+    switch (node->type) {
+        case ASTNodeType::VariableDeclaration: {
+            auto declaration = static_cast<const VariableDeclarationNode*>(node);
+            names.insert(declaration->variableName);
+            collectIdentifiers(declaration->initializer.get(), names);
+            break;
+        }
+        case ASTNodeType::AssignmentStatement: {
+            auto assignment = static_cast<const AssignmentStatementNode*>(node);
+            names.insert(assignment->identifierName);
+            collectIdentifiers(assignment->expression.get(), names);
+            break;
+        }
+        case ASTNodeType::IfStatement:
+            collectIdentifiers(static_cast<const IfStatementNode*>(node)->condition.get(), names);
+            break;
+        case ASTNodeType::ForStatement:
+            collectIdentifiers(static_cast<const ForStatementNode*>(node)->condition.get(), names);
+            break;
+        case ASTNodeType::ReturnStatement:
+            collectIdentifiers(static_cast<const ReturnStatementNode*>(node)->expression.get(), names);
+            break;
+        case ASTNodeType::PrintStatement:
+            for (const auto& arg : static_cast<const PrintStatementNode*>(node)->arguments) {
+                collectIdentifiers(arg.get(), names);
+            }
+            break;
+        case ASTNodeType::FreeStatement:
+            collectIdentifiers(static_cast<const FreeStatementNode*>(node)->pointer.get(), names);
+            break;
+        case ASTNodeType::PointerAssignmentStatement: {
+            auto store = static_cast<const PointerAssignmentStatementNode*>(node);
+            collectIdentifiers(store->target.get(), names);
+            collectIdentifiers(store->expression.get(), names);
+            break;
+        }
+        default:
+            break;
+    }
+    return names;
+}
+
+bool mentionsAny(const std::unordered_set<std::string>& names, const std::unordered_set<std::string>& wanted) {
+    for (const auto& name : names) {
+        if (wanted.count(name) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+InstrumentationPlan InstrumentationPlan::everyStatement() {
+    return InstrumentationPlan();
+}
+
+InstrumentationPlan InstrumentationPlan::fromBasicBlocks(const IRProgram& program) {
+    InstrumentationPlan plan;
+    plan.allStatements = false;
+
+    for (const auto& function : program.functions) {
+        for (const auto& block : function.blocks) {
+            if (!block.reachable) {
+                continue;
+            }
+            if (isSteppingStatement(block.terminator.source)) {
+                plan.stepSites.insert(block.terminator.source);
+                continue;
+            }
+            for (auto it = block.instructions.rbegin(); it != block.instructions.rend(); ++it) {
+                if (isSteppingStatement(it->source)) {
+                    plan.stepSites.insert(it->source);
+                    break;
+                }
+            }
+        }
+    }
+    return plan;
+}
+
+std::vector<std::string> InstrumentationPlan::applyFilter(const ProgramNode& program, const TraceFilter& traceFilter) {
+    filter = traceFilter;
+    filteredSites.clear();
+    seenNames.clear();
+
+    for (const auto& func : program.functionDeclarations) {
+        auto funcDecl = static_cast<const FunctionDeclarationNode*>(func.get());
+        seenNames.insert(funcDecl->name);
+        for (const auto& param : funcDecl->parameters) {
+            seenNames.insert(param.second);
+        }
+        const bool traced = filter.functions.empty() || filter.functions.count(funcDecl->name) > 0;
+        filterStatement(funcDecl->body.get(), traced);
+    }
+    // Sin main, el CodeGenerator ejecuta las sentencias globales como "global_scope"
+    seenNames.insert("global_scope");
+    const bool globalTraced = filter.functions.empty() || filter.functions.count("global_scope") > 0;
+    for (const auto& stmt : program.statements) {
+        filterStatement(stmt.get(), globalTraced);
+    }
+
+    std::vector<std::string> unknownNames;
+    for (const auto* names : {&filter.functions, &filter.variables}) {
+        for (const auto& name : *names) {
+            if (seenNames.count(name) == 0) {
+                unknownNames.push_back(name);
+            }
+        }
+    }
+    return unknownNames;
+}
+
+void InstrumentationPlan::filterStatement(const ASTNode* statement, bool tracedFunction) {
+    if (!statement) {
+        return;
+    }
+    switch (statement->type) {
+        case ASTNodeType::BlockStatement:
+            for (const auto& stmt : static_cast<const BlockStatementNode*>(statement)->statements) {
+                filterStatement(stmt.get(), tracedFunction);
+            }
+            return;
+        case ASTNodeType::IfStatement: {
+            auto ifNode = static_cast<const IfStatementNode*>(statement);
+            filterStatement(ifNode->thenBlock.get(), tracedFunction);
+            filterStatement(ifNode->elseBlock.get(), tracedFunction);
+            break;
+        }
+        case ASTNodeType::ForStatement: {
+            auto forNode = static_cast<const ForStatementNode*>(statement);
+            filterStatement(forNode->initialization.get(), tracedFunction);
+            filterStatement(forNode->increment.get(), tracedFunction);
+            filterStatement(forNode->body.get(), tracedFunction);
+            break;
+        }
+        case ASTNodeType::VariableDeclaration:
+            seenNames.insert(static_cast<const VariableDeclarationNode*>(statement)->variableName);
+            break;
+        default:
+            break;
+    }
+    if (!isSteppingStatement(statement)) {
+        return;
+    }
+
+    bool traced = tracedFunction;
+    if (filter.callsOnly && statement->type != ASTNodeType::ReturnStatement) {
+        traced = false;
+    }
+    if (traced && !filter.variables.empty()) {
+        traced = mentionsAny(statementVariables(statement), filter.variables);
+    }
+    if (!traced) {
+        filteredSites.insert(statement);
+    }
+}
+
+bool InstrumentationPlan::recordsStep(const ASTNode* statement) const {
+    return (allStatements || stepSites.count(statement) > 0) && filteredSites.count(statement) == 0;
+}
+
+// El paso "Entering function" cuenta como llamada; con --trace-vars solo se conserva si
+// la función recibe alguna de las variables como parámetro
+bool InstrumentationPlan::recordsFunctionEntry(const std::string& functionName,
+                                               const std::vector<std::pair<std::string, std::string>>& parameters) const {
+    if (!filter.functions.empty() && filter.functions.count(functionName) == 0) {
+        return false;
+    }
+    if (filter.variables.empty()) {
+        return true;
+    }
+    for (const auto& param : parameters) {
+        if (filter.variables.count(param.second) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
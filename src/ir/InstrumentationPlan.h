@@ -0,0 +1,61 @@
+// src/ir/InstrumentationPlan.h
+#ifndef INSTRUMENTATIONPLAN_H
+#define INSTRUMENTATIONPLAN_H
+
+#include "IR.h"
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class ProgramNode;
+
+// Granularidad con la que el código generado registra pasos de simulación
+enum class InstrumentationGranularity {
+    Statement, // Un recordStep por sentencia (comportamiento original)
+    Block      // Un recordStep por bloque básico del CFG
+};
+
+// Filtros de la traza (--trace=calls, --trace-functions, --trace-vars, --trace-every). Se aplican en
+// tiempo de compilación sobre el plan: los sitios descartados no generan ninguna instrumentación.
+// Los filtros se combinan: un paso se registra si los cumple todos.
+struct TraceFilter {
+    bool callsOnly = false;                    // Solo entradas a funciones y returns
+    std::unordered_set<std::string> functions; // Solo los pasos de estas funciones (vacío: todas)
+    std::unordered_set<std::string> variables; // Solo las sentencias que leen o escriben estas variables
+    unsigned sampleEvery = 1;                  // El cuerpo de cada for registra pasos en una de cada N iteraciones
+
+    bool filtersSites() const { return callsOnly || !functions.empty() || !variables.empty(); }
+};
+
+// Decide qué sentencias del AST registran un paso. Con granularidad de bloque, cada
+// bloque básico alcanzable registra un único paso: el de la sentencia que lo termina
+// (if, entrada a un for, return) o, si el salto no proviene de ninguna, el de su última
+// sentencia instrumentable. Los marcos de pila se siguen actualizando en cada sentencia,
+// así que la instantánea del paso refleja todo lo ejecutado en el bloque.
+class InstrumentationPlan {
+public:
+    static InstrumentationPlan everyStatement();
+    static InstrumentationPlan fromBasicBlocks(const IRProgram& program);
+
+    // Descarta los sitios que no cumplen el filtro; devuelve los nombres del filtro que no aparecen en el programa
+    std::vector<std::string> applyFilter(const ProgramNode& program, const TraceFilter& filter);
+
+    bool recordsStep(const ASTNode* statement) const;
+    bool recordsFunctionEntry(const std::string& functionName, const std::vector<std::pair<std::string, std::string>>& parameters) const;
+    unsigned loopSampling() const { return filter.sampleEvery; }
+    size_t stepSiteCount() const { return stepSites.size(); }
+
+private:
+    InstrumentationPlan() = default;
+
+    void filterStatement(const ASTNode* statement, bool tracedFunction);
+
+    bool allStatements = true;
+    std::unordered_set<const ASTNode*> stepSites;
+    TraceFilter filter;
+    std::unordered_set<const ASTNode*> filteredSites;
+    std::unordered_set<std::string> seenNames; // Funciones y variables del programa, para avisar de nombres mal escritos
+};
+
+#endif // INSTRUMENTATIONPLAN_H
@@ -13,6 +13,9 @@ Lexer::Lexer(const std::string& sourceCode, ErrorHandler& errorHandler)
     keywords["for"] = TokenType::KEYWORD_FOR;
     keywords["return"] = TokenType::KEYWORD_RETURN;
     keywords["printf"] = TokenType::KEYWORD_PRINTF;
+    keywords["malloc"] = TokenType::KEYWORD_MALLOC;
+    keywords["free"] = TokenType::KEYWORD_FREE;
+    keywords["sizeof"] = TokenType::KEYWORD_SIZEOF;
     // Añade aquí más palabras clave si tu lenguaje las tiene (ej. while, break, continue)
 }
 
@@ -8,6 +8,7 @@
 enum class TokenType {
     // Palabras clave
     KEYWORD_INT, KEYWORD_VOID, KEYWORD_IF, KEYWORD_ELSE, KEYWORD_FOR, KEYWORD_RETURN, KEYWORD_PRINTF,
+    KEYWORD_MALLOC, KEYWORD_FREE, KEYWORD_SIZEOF,
 
     // Identificadores
     IDENTIFIER,
@@ -1,4 +1,5 @@
 // src/main.cpp
+#include <cctype>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -10,15 +11,320 @@
 #include "parser/Parser.h"
 #include "semantic_analyzer/SemanticAnalyzer.h"
 #include "code_generator/CodeGenerator.h"
+#include "driver/RunDriver.h"
+#include "ir/IRBuilder.h"
+#include "ir/InstrumentationPlan.h"
 #include "utils/ErrorHandler.h" // Assuming ErrorHandler is used
+#include "utils/PassTimer.h"
+#include "vm/BytecodeCompiler.h"
+#include "vm/VirtualMachine.h"
+
+// Límites de --precompute: más allá, la traza embebida pesaría más que el programa instrumentado
+const size_t PRECOMPUTE_DEFAULT_MAX_STEPS = 50000;
+const size_t PRECOMPUTE_MAX_TRACE_BYTES = 16 << 20;
+const size_t PRECOMPUTE_JUMPS_PER_STEP = 64;
+// Por debajo, los tramos de la traza serían tan pequeños que el registro pasaría el tiempo sellándolos
+const size_t TRACE_BUDGET_MIN_BYTES = 1 << 20;
+// Pasos que conserva --lazy para volver atrás
+const size_t LAZY_DEFAULT_WINDOW = 1024;
+
+static void printUsage(const char* programName) {
+    std::cerr << "Usage: " << programName << " [options] <input_file.c>" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --dump-ir                     Print the control-flow-graph IR" << std::endl;
+    std::cerr << "  --time-passes                 Print the time spent in each compiler pass" << std::endl;
+    std::cerr << "  --instrument=statement|block  Record one step per statement (default) or per basic block" << std::endl;
+    std::cerr << "  --emit=sfml|native            Emit the instrumented visualization (default) or plain uninstrumented C++" << std::endl;
+    std::cerr << "  --profile                     Emit the native program with line hit counters and per-function timing; it writes profile.txt" << std::endl;
+    std::cerr << "  --backend=sfml|html           Visualize with the SFML viewer (default) or export a trace for trace_viewer.html" << std::endl;
+    std::cerr << "  --run                         Compile the generated program against the prebuilt runtime and launch it" << std::endl;
+    std::cerr << "  --vm                          Run the program in the built-in bytecode VM instead of generating C++" << std::endl;
+    std::cerr << "  --dump-bytecode               Print the bytecode executed by --vm" << std::endl;
+    std::cerr << "  --record=FILE                 With --vm, write the trace to a binary .simtrace file instead of opening the viewer" << std::endl;
+    std::cerr << "  --checkpoint                  With --vm, keep only periodic checkpoints and re-run each viewed window from them" << std::endl;
+    std::cerr << "  --checkpoint-interval=N       Steps between checkpoints (default " << VM_DEFAULT_CHECKPOINT_INTERVAL << ")" << std::endl;
+    std::cerr << "  --precompute                  Run the program at compile time and embed its trace as static data" << std::endl;
+    std::cerr << "  --precompute-max-steps=N      Fall back to the instrumented program beyond N steps (default " << PRECOMPUTE_DEFAULT_MAX_STEPS << ")" << std::endl;
+    std::cerr << "  --trace-budget=SIZE[K|M|G]    Bound the memory of the recorded trace; older steps go to a temporary file" << std::endl;
+    std::cerr << "  --trace-overflow=spill|drop   With --trace-budget, spill older steps to disk (default) or drop them" << std::endl;
+    std::cerr << "  --lazy                        Run the generated program as a coroutine that the viewer advances one step at a time" << std::endl;
+    std::cerr << "  --lazy-window=N               With --lazy, steps kept for going back (default " << LAZY_DEFAULT_WINDOW << ")" << std::endl;
+    std::cerr << "  --max-steps=N                 Stop the program after N recorded steps (--vm without --checkpoint or --trace-budget: default " << VM_DEFAULT_MAX_STEPS << ")" << std::endl;
+    std::cerr << "  --max-seconds=S               Stop the program after S seconds (e.g. 2.5)" << std::endl;
+    std::cerr << "  --detect-loops                Stop the program when a for loop repeats the same state" << std::endl;
+    std::cerr << "  --trace=all|calls             Record every step (default) or only function entries and returns" << std::endl;
+    std::cerr << "  --trace-functions=f,g         Record only the steps of the listed functions" << std::endl;
+    std::cerr << "  --trace-vars=x,y              Record only the statements that read or write the listed variables" << std::endl;
+    std::cerr << "  --trace-every=N               Record the body of each for loop in one of every N iterations" << std::endl;
+}
+
+// Lista de nombres separados por comas (--trace-functions, --trace-vars)
+static bool parseNameList(const std::string& text, std::unordered_set<std::string>& names) {
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        end = end == std::string::npos ? text.size() : end;
+        if (end == start) {
+            return false; // Nombre vacío
+        }
+        names.insert(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return true;
+}
+
+// Entero decimal de como mucho maxDigits cifras: con el límite, std::stoull no puede desbordarse
+static bool parseCount(const std::string& text, size_t maxDigits, size_t& value) {
+    if (text.empty() || text.size() > maxDigits || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    value = static_cast<size_t>(std::stoull(text));
+    return true;
+}
+
+// Tamaño en bytes con sufijo opcional K, M o G (potencias de 1024)
+static bool parseByteSize(const std::string& text, size_t& bytes) {
+    const size_t digits = text.find_first_not_of("0123456789");
+    if (digits != std::string::npos && digits + 1 != text.size()) {
+        return false; // Solo un sufijo, al final
+    }
+    int shift = 0;
+    if (digits != std::string::npos) {
+        const char suffix = static_cast<char>(std::toupper(static_cast<unsigned char>(text[digits])));
+        shift = suffix == 'K' ? 10 : suffix == 'M' ? 20 : suffix == 'G' ? 30 : -1;
+    }
+    if (shift < 0 || !parseCount(text.substr(0, digits), 9, bytes)) {
+        return false;
+    }
+    bytes <<= shift;
+    return true;
+}
+
+// --precompute: el programa no lee entrada, así que su traza es la misma en cada ejecución. La VM
+// lo ejecuta dentro del compilador con límites de pasos, memoria y saltos, y el código generado
+// solo contiene la traza resultante. Devuelve false con el motivo si hay que instrumentar como siempre.
+static bool generatePrecomputedProgram(ProgramNode* programNode, const InstrumentationPlan& plan, size_t maxSteps,
+                                       CodeGenerator& codeGenerator, std::string& generatedCode, std::string& reason) {
+    ErrorHandler precomputeErrors; // Sus errores no detienen la compilación: solo impiden precalcular
+    BytecodeCompiler bytecodeCompiler(precomputeErrors);
+    bytecodeCompiler.setInstrumentationPlan(&plan);
+    std::unique_ptr<BytecodeProgram> bytecode = bytecodeCompiler.compile(programNode);
+    if (precomputeErrors.hasErrors()) {
+        reason = "el programa no se pudo compilar a bytecode";
+        return false;
+    }
+
+    VirtualMachine virtualMachine(*bytecode, precomputeErrors);
+    virtualMachine.setTraceLimits(maxSteps, PRECOMPUTE_MAX_TRACE_BYTES, maxSteps * PRECOMPUTE_JUMPS_PER_STEP);
+    const SimulationProgram simulation = virtualMachine.getSimulationProgram();
+    std::string output;
+    setOutputCapture(&output);
+    runSimulationProgram(simulation);
+    setOutputCapture(nullptr);
+
+    if (virtualMachine.traceLimitExceeded()) {
+        reason = "la ejecución supera el límite de " + std::to_string(maxSteps) + " pasos o de memoria de la traza";
+    } else if (virtualMachine.hasRuntimeError()) {
+        reason = "la ejecución termina con un error: " + precomputeErrors.getMessages().back().message;
+    } else {
+        generatedCode = codeGenerator.generatePrecomputed(*bytecode, output);
+    }
+    simulationHistory.clear();
+    return reason.empty();
+}
+
+// Escribe los archivos que acompañan al programa (p. ej. el visor HTML del backend html)
+static bool writeAuxiliaryFiles(const std::vector<GeneratedFile>& files) {
+    for (const GeneratedFile& file : files) {
+        std::ofstream auxiliaryFile(file.fileName);
+        if (!auxiliaryFile.is_open()) {
+            std::cerr << "Error: Could not open " << file.fileName << " for writing." << std::endl;
+            return false;
+        }
+        auxiliaryFile << file.contents;
+        std::cout << "Generated " << file.fileName << std::endl;
+    }
+    return true;
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file.c>" << std::endl;
+    std::string inputFileName;
+    bool dumpIR = false;
+    bool timePasses = false;
+    bool runAfterCompile = false;
+    bool useVirtualMachine = false;
+    bool dumpBytecode = false;
+    bool precompute = false;
+    size_t checkpointInterval = 0;
+    std::string recordFileName;
+    size_t traceBudget = 0;
+    SimTraceOverflow traceOverflow = SIM_TRACE_SPILL;
+    bool traceOverflowGiven = false;
+    size_t precomputeMaxSteps = PRECOMPUTE_DEFAULT_MAX_STEPS;
+    TraceFilter traceFilter;
+    size_t maxSteps = 0;
+    unsigned maxMillis = 0;
+    bool detectLoops = false;
+    size_t lazyWindow = 0;
+    InstrumentationGranularity granularity = InstrumentationGranularity::Statement;
+    EmitMode emitMode = EmitMode::Visualization;
+    BackendKind backend = BackendKind::SFML;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dump-ir") {
+            dumpIR = true;
+        } else if (arg == "--run") {
+            runAfterCompile = true;
+        } else if (arg == "--vm") {
+            useVirtualMachine = true;
+        } else if (arg == "--dump-bytecode") {
+            dumpBytecode = true;
+        } else if (arg.rfind("--record=", 0) == 0 && arg.size() > std::string("--record=").size()) {
+            recordFileName = arg.substr(std::string("--record=").size());
+        } else if (arg == "--checkpoint") {
+            checkpointInterval = VM_DEFAULT_CHECKPOINT_INTERVAL;
+        } else if (arg.rfind("--checkpoint-interval=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--checkpoint-interval=").size()), 18, checkpointInterval) || checkpointInterval == 0) {
+                std::cerr << "Error: Invalid checkpoint interval in '" << arg << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--precompute") {
+            precompute = true;
+        } else if (arg.rfind("--precompute-max-steps=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--precompute-max-steps=").size()), 18, precomputeMaxSteps)) {
+                std::cerr << "Error: Invalid step limit in '" << arg << "'" << std::endl;
+                return 1;
+            }
+            precompute = true;
+        } else if (arg.rfind("--trace-budget=", 0) == 0) {
+            if (!parseByteSize(arg.substr(std::string("--trace-budget=").size()), traceBudget) || traceBudget < TRACE_BUDGET_MIN_BYTES) {
+                std::cerr << "Error: Invalid trace budget in '" << arg << "' (minimum 1M)" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--trace-overflow=spill" || arg == "--trace-overflow=drop") {
+            traceOverflow = arg == "--trace-overflow=drop" ? SIM_TRACE_DROP : SIM_TRACE_SPILL;
+            traceOverflowGiven = true;
+        } else if (arg.rfind("--max-steps=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--max-steps=").size()), 18, maxSteps) || maxSteps == 0) {
+                std::cerr << "Error: Invalid step limit in '" << arg << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--max-seconds=", 0) == 0) {
+            const std::string value = arg.substr(std::string("--max-seconds=").size());
+            const size_t point = value.find('.');
+            const bool valid = !value.empty() && value.size() <= 9 && value.find_first_not_of("0123456789.") == std::string::npos &&
+                               (point == std::string::npos || value.find('.', point + 1) == std::string::npos) && value != ".";
+            const double millis = valid ? std::stod(value) * 1000 : 0;
+            if (millis < 1) {
+                std::cerr << "Error: Invalid time limit in '" << arg << "'" << std::endl;
+                return 1;
+            }
+            maxMillis = static_cast<unsigned>(millis);
+        } else if (arg == "--lazy") {
+            lazyWindow = lazyWindow != 0 ? lazyWindow : LAZY_DEFAULT_WINDOW;
+        } else if (arg.rfind("--lazy-window=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--lazy-window=").size()), 9, lazyWindow) || lazyWindow == 0) {
+                std::cerr << "Error: Invalid lazy window in '" << arg << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--detect-loops") {
+            detectLoops = true;
+        } else if (arg == "--trace=all" || arg == "--trace=calls") {
+            traceFilter.callsOnly = arg == "--trace=calls";
+        } else if (arg.rfind("--trace-functions=", 0) == 0) {
+            if (!parseNameList(arg.substr(std::string("--trace-functions=").size()), traceFilter.functions)) {
+                std::cerr << "Error: Invalid function list in '" << arg << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--trace-vars=", 0) == 0) {
+            if (!parseNameList(arg.substr(std::string("--trace-vars=").size()), traceFilter.variables)) {
+                std::cerr << "Error: Invalid variable list in '" << arg << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--trace-every=", 0) == 0) {
+            size_t sampleEvery = 0;
+            if (!parseCount(arg.substr(std::string("--trace-every=").size()), 9, sampleEvery) || sampleEvery == 0) {
+                std::cerr << "Error: Invalid sampling interval in '" << arg << "'" << std::endl;
+                return 1;
+            }
+            traceFilter.sampleEvery = static_cast<unsigned>(sampleEvery);
+        } else if (arg == "--time-passes") {
+            timePasses = true;
+        } else if (arg == "--instrument=statement") {
+            granularity = InstrumentationGranularity::Statement;
+        } else if (arg == "--instrument=block") {
+            granularity = InstrumentationGranularity::Block;
+        } else if (arg == "--emit=sfml") {
+            emitMode = EmitMode::Visualization;
+        } else if (arg == "--emit=native") {
+            emitMode = EmitMode::Native;
+        } else if (arg == "--profile") {
+            emitMode = EmitMode::Profile;
+        } else if (arg == "--backend=sfml") {
+            backend = BackendKind::SFML;
+        } else if (arg == "--backend=html") {
+            backend = BackendKind::HTML;
+        } else if (arg.rfind("--", 0) == 0 || !inputFileName.empty()) {
+            std::cerr << "Error: Unknown or repeated argument '" << arg << "'" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            inputFileName = arg;
+        }
+    }
+
+    if (inputFileName.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // --emit=native y --profile generan el programa sin instrumentar: no hay traza que limitar ni visor
+    const bool nativeProgram = emitMode != EmitMode::Visualization;
+    if (useVirtualMachine && (runAfterCompile || nativeProgram)) {
+        std::cerr << "Error: --vm cannot be combined with --run, --emit=native or --profile" << std::endl;
+        return 1;
+    }
+    if ((checkpointInterval != 0 || !recordFileName.empty()) && !useVirtualMachine) {
+        std::cerr << "Error: --checkpoint and --record require --vm" << std::endl;
+        return 1;
+    }
+    if (precompute && (useVirtualMachine || nativeProgram)) {
+        std::cerr << "Error: --precompute cannot be combined with --vm, --emit=native or --profile" << std::endl;
+        return 1;
+    }
+    if (traceOverflowGiven && traceBudget == 0) {
+        std::cerr << "Error: --trace-overflow requires --trace-budget" << std::endl;
+        return 1;
+    }
+    if (traceBudget != 0 && (checkpointInterval != 0 || nativeProgram)) {
+        std::cerr << "Error: --trace-budget cannot be combined with --checkpoint, --emit=native or --profile" << std::endl;
+        return 1;
+    }
+
+    if ((maxSteps != 0 || maxMillis != 0 || detectLoops) && (precompute || nativeProgram)) {
+        std::cerr << "Error: --max-steps, --max-seconds and --detect-loops cannot be combined with --precompute, --emit=native or --profile" << std::endl;
+        return 1;
+    }
+    // El reloj de --max-seconds seguiría corriendo mientras el visor espera a Next
+    if (lazyWindow != 0 && (useVirtualMachine || precompute || nativeProgram || backend == BackendKind::HTML ||
+                            traceBudget != 0 || maxMillis != 0)) {
+        std::cerr << "Error: --lazy cannot be combined with --vm, --precompute, --emit=native, --profile, --backend=html, --trace-budget or --max-seconds" << std::endl;
+        return 1;
+    }
+    if (traceFilter.sampleEvery > 1 && (useVirtualMachine || precompute)) {
+        std::cerr << "Error: --trace-every cannot be combined with --vm or --precompute" << std::endl;
         return 1;
     }
 
-    std::string inputFileName = argv[1];
+#if !SIM_VIEWER_AVAILABLE
+    // Compilado sin SFML no hay visor en proceso: la VM exporta su traza para el visor HTML
+    if (useVirtualMachine && backend == BackendKind::SFML && recordFileName.empty()) {
+        std::cout << "Built without the SFML viewer; --vm exports the trace for trace_viewer.html instead" << std::endl;
+        backend = BackendKind::HTML;
+    }
+#endif
+
+    PassTimer passTimer(timePasses);
     std::ifstream inputFile(inputFileName);
 
     if (!inputFile.is_open()) {
@@ -33,8 +339,10 @@ int main(int argc, char* argv[]) {
     ErrorHandler errorHandler; // Create an error handler instance
 
     // 1. Lexical Analysis
+    passTimer.begin("lexer");
     Lexer lexer(sourceCode, errorHandler); // Pasa errorHandler al lexer
     std::vector<Token> tokens = lexer.tokenize();
+    passTimer.end();
     // --- DEBUG: Imprimir tokens léxicos ---
     std::cout << "\n=== TOKENS GENERADOS ===" << std::endl;
     for (const auto& token : tokens) {
@@ -51,8 +359,10 @@ int main(int argc, char* argv[]) {
     }
 
     // 2. Syntactic Analysis (Parsing)
+    passTimer.begin("parser");
     Parser parser(tokens, errorHandler); // Pasa errorHandler al parser
     std::unique_ptr<ASTNode> programAST = parser.parse();
+    passTimer.end();
 
     if (errorHandler.hasErrors()) {
         errorHandler.printMessages();
@@ -68,33 +378,191 @@ int main(int argc, char* argv[]) {
     }
 
     // 3. Semantic Analysis
+    passTimer.begin("semantic analysis");
     SemanticAnalyzer semanticAnalyzer(errorHandler); // Pasa errorHandler al analizador semántico
     semanticAnalyzer.analyze(programNode); // Pasa el ProgramNode*
+    passTimer.end();
+
+    if (errorHandler.hasErrors()) {
+        errorHandler.printMessages();
+        return 1;
+    }
+
+    // 4. Lowering to the control-flow-graph IR
+    passTimer.begin("IR lowering");
+    IRBuilder irBuilder(errorHandler);
+    IRProgram ir = irBuilder.lower(programNode);
+    passTimer.end();
 
     if (errorHandler.hasErrors()) {
         errorHandler.printMessages();
         return 1;
     }
 
+    if (dumpIR) {
+        std::cout << "=== IR ===" << std::endl << printIR(ir) << "==========" << std::endl;
+    }
+
+    passTimer.begin("instrumentation plan");
+    InstrumentationPlan instrumentationPlan = granularity == InstrumentationGranularity::Block
+        ? InstrumentationPlan::fromBasicBlocks(ir)
+        : InstrumentationPlan::everyStatement();
+    for (const auto& name : instrumentationPlan.applyFilter(*programNode, traceFilter)) {
+        errorHandler.reportWarning("El filtro de la traza menciona '" + name + "', que no aparece en el programa.", -1, -1);
+    }
+    passTimer.end();
+
+    // --vm: compila a bytecode y ejecuta el programa dentro del compilador, sin generar C++ ni invocar g++
+    if (useVirtualMachine) {
+        passTimer.begin("bytecode compilation");
+        BytecodeCompiler bytecodeCompiler(errorHandler);
+        bytecodeCompiler.setInstrumentationPlan(&instrumentationPlan);
+        bytecodeCompiler.enableExecutionStops();
+        std::unique_ptr<BytecodeProgram> bytecode = bytecodeCompiler.compile(programNode);
+        passTimer.end();
+
+        if (errorHandler.hasErrors()) {
+            errorHandler.printMessages();
+            return 1;
+        }
+        if (dumpBytecode) {
+            std::cout << "=== BYTECODE ===" << std::endl << printBytecode(*bytecode) << "================" << std::endl;
+        }
+
+        // El runtime guarda un puntero a las tablas: deben vivir mientras se muestre la traza
+        VirtualMachine virtualMachine(*bytecode, errorHandler);
+        virtualMachine.setCheckpointInterval(checkpointInterval);
+        // Sin --checkpoint ni --trace-budget la traza de un bucle sin fin crecería hasta agotar la memoria:
+        // entonces hay un límite de pasos por defecto. Con ellos la memoria ya está acotada.
+        const bool boundedTrace = checkpointInterval != 0 || traceBudget != 0;
+        const size_t vmMaxSteps = maxSteps != 0 || boundedTrace ? maxSteps : VM_DEFAULT_MAX_STEPS;
+        virtualMachine.setExecutionLimits(vmMaxSteps, maxMillis, detectLoops);
+        const SimulationProgram simulation = virtualMachine.getSimulationProgram();
+        setSimulationTraceBudget(traceBudget, traceOverflow);
+        // El índice de cambios solo sirve al visor, y crece con la ejecución: no con la memoria acotada
+        if (backend == BackendKind::SFML && recordFileName.empty() && checkpointInterval == 0 && traceBudget == 0) {
+            requestSimulationChangeIndex();
+        }
+        passTimer.begin("vm execution");
+        runSimulationProgram(simulation);
+        passTimer.end();
+        std::cout << std::endl << "Executed in the VM: " << virtualMachine.getRecordedStepCount() << " steps recorded" << std::endl;
+        if (checkpointInterval != 0) {
+            // El visor y la exportación recorren la ejecución por ventanas que se vuelven a ejecutar
+            setSimulationReplay(virtualMachine.getSimulationReplay());
+            std::cout << virtualMachine.getCheckpointCount() << " checkpoints every " << checkpointInterval << " steps ("
+                      << virtualMachine.getCheckpointBytes() / 1024 << " KB)" << std::endl;
+        }
+        passTimer.report(std::cout);
+        errorHandler.printMessages();
+
+        int exitCode = 0;
+        if (!recordFileName.empty()) {
+            exitCode = writeSimulationTraceFile(recordFileName);
+            if (exitCode == 0) {
+                std::cout << "Trace written to " << recordFileName << "; open it with sim_trace_viewer" << std::endl;
+            }
+        } else if (backend == BackendKind::HTML) {
+            exitCode = writeSimulationTrace("trace");
+            if (!writeAuxiliaryFiles(createBackend(BackendKind::HTML)->getAuxiliaryFiles())) {
+                return 1;
+            }
+            std::cout << "Open trace_viewer.html in a browser to replay trace.js" << std::endl;
+        } else {
+#if SIM_VIEWER_AVAILABLE
+            exitCode = showSimulationViewer();
+#endif
+        }
+        return virtualMachine.hasRuntimeError() ? 1 : exitCode;
+    }
+
     // --- CORRECCIÓN AQUÍ ---
     // Pasa la instancia de errorHandler al constructor de CodeGenerator
-    CodeGenerator codeGenerator(errorHandler); // <--- ¡CAMBIO AQUÍ!
+    CodeGenerator codeGenerator(errorHandler, createBackend(backend)); // <--- ¡CAMBIO AQUÍ!
     // --- FIN CORRECCIÓN ---
+    codeGenerator.setInstrumentationPlan(&instrumentationPlan);
+    codeGenerator.setEmitMode(emitMode);
+    codeGenerator.setTraceBudget(traceBudget, traceOverflow);
+    codeGenerator.setExecutionLimits(maxSteps, maxMillis, detectLoops);
+    codeGenerator.setLazyStepping(lazyWindow);
+    codeGenerator.setSourceFileName(inputFileName); // Directivas #line hacia el fuente C
 
-    std::string generatedSFMLCode = codeGenerator.generate(programNode); // Pasa el ProgramNode*
+    std::string generatedSFMLCode;
+    bool tracePrecomputed = false;
+    if (precompute) {
+        passTimer.begin("trace precomputation");
+        std::string reason;
+        tracePrecomputed = generatePrecomputedProgram(programNode, instrumentationPlan, precomputeMaxSteps, codeGenerator, generatedSFMLCode, reason);
+        passTimer.end();
+        if (!tracePrecomputed) {
+            errorHandler.reportWarning("No se precalcula la traza (" + reason + "); se genera el programa instrumentado.", -1, -1);
+        }
+    }
+
+    if (!tracePrecomputed) {
+        passTimer.begin("code generation");
+        generatedSFMLCode = codeGenerator.generate(programNode); // Pasa el ProgramNode*
+        passTimer.end();
+    }
+
+    if (errorHandler.hasErrors()) {
+        errorHandler.printMessages();
+        return 1;
+    }
 
-    // Guarda el código C++ SFML generado en un archivo
-    std::ofstream outputFile("output_sfml.cpp");
+    // Guarda el código C++ generado en un archivo
+    const bool nativeOutput = emitMode == EmitMode::Native;
+    const bool profileOutput = emitMode == EmitMode::Profile;
+    const std::string outputFileName = codeGenerator.getOutputFileName();
+    const std::string runtimeLibraries = codeGenerator.getRuntimeLibraries();
+    const std::string cxxStandard = codeGenerator.getCxxStandard();
+    std::ofstream outputFile(outputFileName);
     if (outputFile.is_open()) {
         outputFile << generatedSFMLCode;
         outputFile.close();
-        std::cout << "Generated SFML code saved to output_sfml.cpp" << std::endl;
-        std::cout << "Compile and run output_sfml.cpp with SFML libraries: " << std::endl;
-        std::cout << "g++ output_sfml.cpp -o output_sfml -lsfml-graphics -lsfml-window -lsfml-system" << std::endl;
+        if (nativeOutput) {
+            std::cout << "Generated native code saved to " << outputFileName << std::endl;
+            std::cout << "Compile and run it without SFML: " << std::endl;
+            std::cout << "g++ -O2 -g " << outputFileName << " -o output_native" << std::endl;
+        } else if (profileOutput) {
+            std::cout << "Generated profiling code saved to " << outputFileName << std::endl;
+            std::cout << "Compile and run it (or use --run); it writes the report to profile.txt, or to the path given as its argument: " << std::endl;
+            std::cout << "g++ -std=" << cxxStandard << " -O2 " << outputFileName << " -o output_profile -I" << SIM_RUNTIME_INCLUDE_DIR << " -L" << SIM_RUNTIME_LIBRARY_DIR
+                      << " " << runtimeLibraries << std::endl;
+        } else {
+            const std::string executableName = outputFileName.substr(0, outputFileName.rfind('.'));
+            std::cout << "Generated " << (backend == BackendKind::HTML ? "trace" : "SFML") << " code saved to " << outputFileName << std::endl;
+            if (backend == BackendKind::SFML && !SIM_VIEWER_AVAILABLE) {
+                std::cout << "Built without the SFML viewer: the program is compiled headless and writes its trace as NDJSON" << std::endl;
+            }
+            std::cout << "Compile and run " << outputFileName << " against the prebuilt runtime (or use --run): " << std::endl;
+            std::cout << "g++ -std=" << cxxStandard << " " << outputFileName << " -o " << executableName << " -I" << SIM_RUNTIME_INCLUDE_DIR << " -L" << SIM_RUNTIME_LIBRARY_DIR
+                      << " " << runtimeLibraries << std::endl;
+        }
     } else {
-        std::cerr << "Error: Could not open output_sfml.cpp for writing." << std::endl;
+        std::cerr << "Error: Could not open " << outputFileName << " for writing." << std::endl;
         return 1;
     }
 
+    if (!writeAuxiliaryFiles(codeGenerator.getAuxiliaryFiles())) {
+        return 1;
+    }
+    if (tracePrecomputed) {
+        std::cout << "The trace was precomputed at compile time and embedded in " << outputFileName << std::endl;
+    }
+
+    errorHandler.printMessages(); // Advertencias (p. ej. --precompute sin precalcular)
+    errorHandler.clearMessages();
+    passTimer.report(std::cout);
+
+    if (runAfterCompile) {
+        int exitCode = compileAndRun(outputFileName, emitMode, runtimeLibraries, cxxStandard, errorHandler);
+        errorHandler.printMessages();
+        if (exitCode == 0 && backend == BackendKind::HTML && !nativeOutput && !profileOutput) {
+            std::cout << "Open trace_viewer.html in a browser to replay trace.js" << std::endl;
+        }
+        return exitCode;
+    }
+
     return 0;
 }
\ No newline at end of file
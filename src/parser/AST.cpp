@@ -2,7 +2,7 @@
 #include "AST.h" // Incluir el propio encabezado
 
 // Definiciones de constructores
-ASTNode::ASTNode(ASTNodeType type) : type(type) {}
+ASTNode::ASTNode(ASTNodeType type) : type(type), line(0), column(0) {}
 
 ProgramNode::ProgramNode() : ASTNode(ASTNodeType::Program) {}
 
@@ -24,7 +24,7 @@ BinaryExpressionNode::BinaryExpressionNode(std::unique_ptr<ASTNode> l, std::uniq
 UnaryExpressionNode::UnaryExpressionNode(const std::string& op, std::unique_ptr<ASTNode> operand)
     : ASTNode(ASTNodeType::UnaryExpression), op(op), operand(std::move(operand)) {}
 
-LiteralNode::LiteralNode(const std::string& val) : ASTNode(ASTNodeType::Literal), value(val) {}
+LiteralNode::LiteralNode(const std::string& val, bool isString) : ASTNode(ASTNodeType::Literal), value(val), isString(isString) {}
 
 IdentifierNode::IdentifierNode(const std::string& name) : ASTNode(ASTNodeType::Identifier), name(name) {}
 
@@ -43,5 +43,14 @@ FunctionCallNode::FunctionCallNode(const std::string& name, std::vector<std::uni
 PrintStatementNode::PrintStatementNode(const std::string& format, std::vector<std::unique_ptr<ASTNode>> args)
     : ASTNode(ASTNodeType::PrintStatement), formatString(format), arguments(std::move(args)) {}
 
+MallocExpressionNode::MallocExpressionNode(std::unique_ptr<ASTNode> size)
+    : ASTNode(ASTNodeType::MallocExpression), size(std::move(size)) {}
+
+FreeStatementNode::FreeStatementNode(std::unique_ptr<ASTNode> pointer)
+    : ASTNode(ASTNodeType::FreeStatement), pointer(std::move(pointer)) {}
+
+PointerAssignmentStatementNode::PointerAssignmentStatementNode(std::unique_ptr<ASTNode> target, std::unique_ptr<ASTNode> expr)
+    : ASTNode(ASTNodeType::PointerAssignmentStatement), target(std::move(target)), expression(std::move(expr)) {}
+
 BlockStatementNode::BlockStatementNode(std::vector<std::unique_ptr<ASTNode>> stmts)
     : ASTNode(ASTNodeType::BlockStatement), statements(std::move(stmts)) {}
\ No newline at end of file
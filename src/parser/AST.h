@@ -6,6 +6,7 @@
 #include <string>
 #include <memory> // Para std::unique_ptr
 #include <utility> // Para std::move en constructores
+#include "FormatString.h" // Segmentos de la cadena de formato de printf
 
 // Enumeración para los tipos de nodos AST
 enum class ASTNodeType {
@@ -22,6 +23,9 @@ enum class ASTNodeType {
     ReturnStatement,
     FunctionCall,
     PrintStatement, // Para printf
+    MallocExpression,
+    FreeStatement,
+    PointerAssignmentStatement, // *p = valor;
     BlockStatement  // Para bloques de código {}
 };
 
@@ -29,6 +33,8 @@ enum class ASTNodeType {
 class ASTNode {
 public:
     ASTNodeType type;
+    int line;   // Posición del primer token del nodo en el fuente C (0 si se desconoce)
+    int column;
 
     explicit ASTNode(ASTNodeType type);
     virtual ~ASTNode() = default; // Destructor virtual para asegurar la correcta limpieza
@@ -98,9 +104,10 @@ public:
 // Nodo para un literal (entero, cadena)
 class LiteralNode : public ASTNode {
 public:
-    std::string value; // El valor del literal (ej. "10", "\"hola\"")
-    // Considerar un campo para el tipo de literal (INT, STRING) si es necesario
-    LiteralNode(const std::string& val); // Constructor declarado
+    std::string value; // El valor del literal sin comillas (ej. "10", "hola")
+    bool isString;     // true si proviene de un STRING_LITERAL
+
+    LiteralNode(const std::string& val, bool isString = false); // Constructor declarado
 };
 
 // Nodo para un identificador
@@ -154,10 +161,36 @@ class PrintStatementNode : public ASTNode {
 public:
     std::string formatString;
     std::vector<std::unique_ptr<ASTNode>> arguments; // Argumentos después de la cadena de formato
+    std::vector<FormatSegment> segments; // Cadena de formato ya analizada (la rellena el SemanticAnalyzer)
 
     PrintStatementNode(const std::string& format, std::vector<std::unique_ptr<ASTNode>> args = {}); // Constructor declarado
 };
 
+// Nodo para malloc(tamaño): el resultado es un void* que se convierte al puntero que lo recibe
+class MallocExpressionNode : public ASTNode {
+public:
+    std::unique_ptr<ASTNode> size; // Bytes pedidos
+
+    MallocExpressionNode(std::unique_ptr<ASTNode> size);
+};
+
+// Nodo para free(puntero);
+class FreeStatementNode : public ASTNode {
+public:
+    std::unique_ptr<ASTNode> pointer;
+
+    FreeStatementNode(std::unique_ptr<ASTNode> pointer);
+};
+
+// Nodo para una escritura a través de un puntero (ej. *(p + 1) = 5;)
+class PointerAssignmentStatementNode : public ASTNode {
+public:
+    std::unique_ptr<ASTNode> target;     // Expresión del puntero (sin el '*')
+    std::unique_ptr<ASTNode> expression; // Valor que se escribe
+
+    PointerAssignmentStatementNode(std::unique_ptr<ASTNode> target, std::unique_ptr<ASTNode> expr);
+};
+
 // Nodo para un bloque de sentencias (ej. el cuerpo de una función o un bloque if/else)
 class BlockStatementNode : public ASTNode {
 public:
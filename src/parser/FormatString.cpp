@@ -0,0 +1,62 @@
+// src/parser/FormatString.cpp
+#include "FormatString.h"
+
+bool parseFormatString(const std::string& format, std::vector<FormatSegment>& segments, std::string& errorMessage) {
+    segments.clear();
+    std::string literal;
+
+    auto flushLiteral = [&]() {
+        if (!literal.empty()) {
+            segments.emplace_back(FormatSegmentKind::Literal, literal);
+            literal.clear();
+        }
+    };
+
+    for (size_t i = 0; i < format.size(); ++i) {
+        char c = format[i];
+        if (c != '%') {
+            literal += c;
+            continue;
+        }
+
+        if (i + 1 >= format.size()) {
+            errorMessage = "Conversión incompleta '%' al final de la cadena de formato.";
+            return false;
+        }
+
+        char conversion = format[++i];
+        switch (conversion) {
+            case '%':
+                literal += '%';
+                break;
+            case 'd':
+            case 'i':
+                flushLiteral();
+                segments.emplace_back(FormatSegmentKind::Int);
+                break;
+            case 's':
+                flushLiteral();
+                segments.emplace_back(FormatSegmentKind::String);
+                break;
+            case 'p':
+                flushLiteral();
+                segments.emplace_back(FormatSegmentKind::Pointer);
+                break;
+            default:
+                errorMessage = std::string("Conversión de formato no soportada: '%") + conversion + "'.";
+                return false;
+        }
+    }
+    flushLiteral();
+    return true;
+}
+
+size_t countFormatConversions(const std::vector<FormatSegment>& segments) {
+    size_t count = 0;
+    for (const auto& segment : segments) {
+        if (segment.kind != FormatSegmentKind::Literal) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,34 @@
+// src/parser/FormatString.h
+#ifndef FORMATSTRING_H
+#define FORMATSTRING_H
+
+#include <string>
+#include <vector>
+#include <utility> // Para std::move
+
+// Tipo de cada segmento de una cadena de formato de printf
+enum class FormatSegmentKind {
+    Literal, // Texto literal (con las secuencias de escape tal como aparecen en el fuente)
+    Int,     // %d / %i
+    String,  // %s
+    Pointer  // %p
+};
+
+// Segmento de una cadena de formato ya analizada
+struct FormatSegment {
+    FormatSegmentKind kind;
+    std::string text; // Solo para segmentos Literal
+
+    FormatSegment(FormatSegmentKind kind, std::string text = "")
+        : kind(kind), text(std::move(text)) {}
+};
+
+// Divide una cadena de formato de printf en segmentos literales y conversiones tipadas.
+// "%%" se convierte en un '%' literal. Devuelve false y rellena 'errorMessage'
+// si encuentra una conversión no soportada.
+bool parseFormatString(const std::string& format, std::vector<FormatSegment>& segments, std::string& errorMessage);
+
+// Número de conversiones (argumentos esperados) en una lista de segmentos.
+size_t countFormatConversions(const std::vector<FormatSegment>& segments);
+
+#endif // FORMATSTRING_H
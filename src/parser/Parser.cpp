@@ -53,6 +53,14 @@ bool Parser::isAtEnd() {
 // Métodos de Parseo
 // -------------------------------------------------------------------------------------------------
 
+std::unique_ptr<ASTNode> Parser::located(std::unique_ptr<ASTNode> node, const Token& token) {
+    if (node) {
+        node->line = token.line;
+        node->column = token.column;
+    }
+    return node;
+}
+
 // Método principal para iniciar el análisis y construir el AST.
 std::unique_ptr<ASTNode> Parser::parse() {
     return parseProgram();
@@ -97,15 +105,21 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration() {
 
     // Inicializar funcDecl con parámetros vacíos y cuerpo nulo por ahora
     auto funcDecl = std::make_unique<FunctionDeclarationNode>(functionName.value, returnType.value, std::vector<std::pair<std::string, std::string>>{}, nullptr);
+    funcDecl->line = returnType.line;
+    funcDecl->column = returnType.column;
 
     expect(TokenType::LPAREN, "Se esperaba '(' después del nombre de la función.");
     // Aquí iría el parseo de parámetros
     while (peek().type != TokenType::RPAREN && peek().type != TokenType::END_OF_FILE) {
         if (peek().type == TokenType::KEYWORD_INT || peek().type == TokenType::KEYWORD_VOID) { // Permite void también para parámetros
             Token paramType = consume();
+            std::string paramTypeName = paramType.value;
+            if (match(TokenType::MULTIPLY)) { // Puntero (p. ej. un bloque de malloc)
+                paramTypeName += "*";
+            }
             Token paramName = expect(TokenType::IDENTIFIER, "Se esperaba un nombre de parámetro.");
             if (paramName.type != TokenType::UNKNOWN) {
-                funcDecl->parameters.push_back({paramType.value, paramName.value});
+                funcDecl->parameters.push_back({paramTypeName, paramName.value});
             }
             if (peek().type == TokenType::COMMA) {
                 consume(); // Consumir la coma
@@ -133,6 +147,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration() {
 
 // <blockStatement> ::= "{" { <statement> | <declarationStatement> }* "}"
 std::unique_ptr<ASTNode> Parser::parseBlockStatement() {
+    const Token start = peek();
     expect(TokenType::LBRACE, "Se esperaba '{' para el bloque de código.");
     if (peek().type == TokenType::UNKNOWN) return nullptr; // Error de recuperación
 
@@ -155,7 +170,7 @@ std::unique_ptr<ASTNode> Parser::parseBlockStatement() {
     }
 
     expect(TokenType::RBRACE, "Se esperaba '}' para cerrar el bloque de código.");
-    return std::make_unique<BlockStatementNode>(std::move(statementsInBlock));
+    return located(std::make_unique<BlockStatementNode>(std::move(statementsInBlock)), start);
 }
 
 // <statement> ::= <assignmentStatement> ";"
@@ -189,6 +204,10 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
         stmt = parseReturnStatement();
     } else if (currentType == TokenType::KEYWORD_PRINTF) {
         stmt = parsePrintStatement();
+    } else if (currentType == TokenType::KEYWORD_FREE) {
+        stmt = parseFreeStatement();
+    } else if (currentType == TokenType::MULTIPLY) { // Escritura a través de un puntero
+        stmt = parsePointerAssignmentStatement();
     }
 
     if (stmt) {
@@ -198,7 +217,9 @@ std::unique_ptr<ASTNode> Parser::parseStatement() {
             stmt->type == ASTNodeType::ReturnStatement ||
             stmt->type == ASTNodeType::FunctionCall ||
             stmt->type == ASTNodeType::VariableDeclaration || // Si la declaración se maneja aquí
-            stmt->type == ASTNodeType::PrintStatement) {
+            stmt->type == ASTNodeType::PrintStatement ||
+            stmt->type == ASTNodeType::FreeStatement ||
+            stmt->type == ASTNodeType::PointerAssignmentStatement) {
             expect(TokenType::SEMICOLON, "Se esperaba ';' después de la sentencia.");
         }
         return stmt;
@@ -231,7 +252,7 @@ std::unique_ptr<ASTNode> Parser::parseDeclarationStatement() {
     }
 
     expect(TokenType::SEMICOLON, "Se esperaba ';' después de la declaración de variable.");
-    return std::make_unique<VariableDeclarationNode>(typeName, varName.value, std::move(initializer));
+    return located(std::make_unique<VariableDeclarationNode>(typeName, varName.value, std::move(initializer)), typeToken);
 }
 
 // <assignmentStatement> ::= IDENTIFIER "=" <expression>
@@ -245,11 +266,12 @@ std::unique_ptr<ASTNode> Parser::parseAssignmentStatement() {
     auto expr = parseExpression();
     if (!expr) return nullptr;
 
-    return std::make_unique<AssignmentStatementNode>(identifier.value, std::move(expr));
+    return located(std::make_unique<AssignmentStatementNode>(identifier.value, std::move(expr)), identifier);
 }
 
 // <ifStatement> ::= "if" "(" <expression> ")" <statement> [ "else" <statement> ]
 std::unique_ptr<ASTNode> Parser::parseIfStatement() {
+    const Token start = peek();
     expect(TokenType::KEYWORD_IF, "Se esperaba 'if'.");
     if (peek().type == TokenType::UNKNOWN) return nullptr;
 
@@ -270,11 +292,12 @@ std::unique_ptr<ASTNode> Parser::parseIfStatement() {
         elseBlock = parseStatement();
     }
 
-    return std::make_unique<IfStatementNode>(std::move(condition), std::move(thenBlock), std::move(elseBlock));
+    return located(std::make_unique<IfStatementNode>(std::move(condition), std::move(thenBlock), std::move(elseBlock)), start);
 }
 
 // <forStatement> ::= "for" "(" ( <declarationStatement> | <assignmentStatement> | ";" ) <expression> ";" <assignmentStatement> ")" <statement>
 std::unique_ptr<ASTNode> Parser::parseForStatement() {
+    const Token start = peek();
     expect(TokenType::KEYWORD_FOR, "Se esperaba 'for'.");
     if (peek().type == TokenType::UNKNOWN) return nullptr;
 
@@ -317,11 +340,12 @@ std::unique_ptr<ASTNode> Parser::parseForStatement() {
     auto body = parseStatement();
     if (!body) return nullptr;
 
-    return std::make_unique<ForStatementNode>(std::move(initialization), std::move(condition), std::move(increment), std::move(body));
+    return located(std::make_unique<ForStatementNode>(std::move(initialization), std::move(condition), std::move(increment), std::move(body)), start);
 }
 
 // <returnStatement> ::= "return" [ <expression> ] ";"
 std::unique_ptr<ASTNode> Parser::parseReturnStatement() {
+    const Token start = peek();
     expect(TokenType::KEYWORD_RETURN, "Se esperaba 'return'.");
     if (peek().type == TokenType::UNKNOWN) return nullptr;
 
@@ -330,11 +354,12 @@ std::unique_ptr<ASTNode> Parser::parseReturnStatement() {
     if (peek().type != TokenType::SEMICOLON && peek().type != TokenType::RBRACE) {
         expr = parseExpression();
     }
-    return std::make_unique<ReturnStatementNode>(std::move(expr));
+    return located(std::make_unique<ReturnStatementNode>(std::move(expr)), start);
 }
 
 // <printStatement> ::= "printf" "(" STRING_LITERAL { "," <expression> }* ")"
 std::unique_ptr<ASTNode> Parser::parsePrintStatement() {
+    const Token start = peek();
     expect(TokenType::KEYWORD_PRINTF, "Se esperaba 'printf'.");
     if (peek().type == TokenType::UNKNOWN) return nullptr;
 
@@ -366,7 +391,41 @@ std::unique_ptr<ASTNode> Parser::parsePrintStatement() {
     }
 
     expect(TokenType::RPAREN, "Se esperaba ')' después de los argumentos de printf.");
-    return std::make_unique<PrintStatementNode>(formatStringToken.value, std::move(printArgs));
+    return located(std::make_unique<PrintStatementNode>(formatStringToken.value, std::move(printArgs)), start);
+}
+
+// <freeStatement> ::= "free" "(" <expression> ")"
+std::unique_ptr<ASTNode> Parser::parseFreeStatement() {
+    const Token start = peek();
+    expect(TokenType::KEYWORD_FREE, "Se esperaba 'free'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    expect(TokenType::LPAREN, "Se esperaba '(' después de 'free'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    auto pointer = parseExpression();
+    if (!pointer) return nullptr;
+
+    expect(TokenType::RPAREN, "Se esperaba ')' después del argumento de free.");
+    return located(std::make_unique<FreeStatementNode>(std::move(pointer)), start);
+}
+
+// <pointerAssignmentStatement> ::= "*" <primaryExpression> "=" <expression>
+std::unique_ptr<ASTNode> Parser::parsePointerAssignmentStatement() {
+    const Token start = peek();
+    expect(TokenType::MULTIPLY, "Se esperaba '*'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    auto target = parsePrimaryExpression();
+    if (!target) return nullptr;
+
+    expect(TokenType::ASSIGN, "Se esperaba '=' para la asignación a través del puntero.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    auto expr = parseExpression();
+    if (!expr) return nullptr;
+
+    return located(std::make_unique<PointerAssignmentStatementNode>(std::move(target), std::move(expr)), start);
 }
 
 // <functionCall> ::= IDENTIFIER "(" [ <argumentList> ] ")"
@@ -399,7 +458,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionCall() {
     }
 
     expect(TokenType::RPAREN, "Se esperaba ')' para cerrar la llamada a función.");
-    return std::make_unique<FunctionCallNode>(funcName.value, std::move(arguments));
+    return located(std::make_unique<FunctionCallNode>(funcName.value, std::move(arguments)), funcName);
 }
 
 // <expression> ::= <equalityExpression>
@@ -420,7 +479,7 @@ std::unique_ptr<ASTNode> Parser::parseEqualityExpression() {
             errorHandler.reportError("Expresión derecha esperada para operador de igualdad.", peek().line, peek().column);
             return nullptr;
         }
-        expr = std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value);
+        expr = located(std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value), op);
     }
     return expr;
 }
@@ -439,7 +498,7 @@ std::unique_ptr<ASTNode> Parser::parseComparisonExpression() {
             errorHandler.reportError("Expresión derecha esperada para operador de comparación.", peek().line, peek().column);
             return nullptr;
         }
-        expr = std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value);
+        expr = located(std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value), op);
     }
     return expr;
 }
@@ -457,7 +516,7 @@ std::unique_ptr<ASTNode> Parser::parseAdditiveExpression() {
             errorHandler.reportError("Expresión derecha esperada para operador aditivo.", peek().line, peek().column);
             return nullptr;
         }
-        expr = std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value);
+        expr = located(std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value), op);
     }
     return expr;
 }
@@ -475,7 +534,7 @@ std::unique_ptr<ASTNode> Parser::parseMultiplicativeExpression() {
             errorHandler.reportError("Expresión derecha esperada para operador multiplicativo.", peek().line, peek().column);
             return nullptr;
         }
-        expr = std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value);
+        expr = located(std::make_unique<BinaryExpressionNode>(std::move(expr), std::move(right), op.value), op);
     }
     return expr;
 }
@@ -485,19 +544,31 @@ std::unique_ptr<ASTNode> Parser::parseMultiplicativeExpression() {
 //                       | IDENTIFIER
 //                       | "(" <expression> ")"
 //                       | <functionCall>
+//                       | <mallocExpression>
+//                       | <sizeofExpression>
 //                       | "-" <primaryExpression> (para negación unaria)
 std::unique_ptr<ASTNode> Parser::parsePrimaryExpression() {
     switch (peek().type) {
-        case TokenType::INTEGER_LITERAL:
-            return std::make_unique<LiteralNode>(consume().value);
-        case TokenType::STRING_LITERAL:
-            return std::make_unique<LiteralNode>(consume().value);
-        case TokenType::IDENTIFIER:
+        case TokenType::INTEGER_LITERAL: {
+            Token literal = consume();
+            return located(std::make_unique<LiteralNode>(literal.value), literal);
+        }
+        case TokenType::STRING_LITERAL: {
+            Token literal = consume();
+            return located(std::make_unique<LiteralNode>(literal.value, true), literal);
+        }
+        case TokenType::IDENTIFIER: {
             // Si el identificador es seguido por '(', es una llamada a función
             if (peek(1).type == TokenType::LPAREN) {
                 return parseFunctionCall();
             }
-            return std::make_unique<IdentifierNode>(consume().value);
+            Token identifier = consume();
+            return located(std::make_unique<IdentifierNode>(identifier.value), identifier);
+        }
+        case TokenType::KEYWORD_MALLOC:
+            return parseMallocExpression();
+        case TokenType::KEYWORD_SIZEOF:
+            return parseSizeofExpression();
         case TokenType::LPAREN: {
             consume(); // Consume '('
             auto expr = parseExpression();
@@ -517,7 +588,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression() {
                 errorHandler.reportError("Operando esperado para operador unario '-'.", peek().line, peek().column);
                 return nullptr;
             }
-            return std::make_unique<UnaryExpressionNode>(op.value, std::move(operand));
+            return located(std::make_unique<UnaryExpressionNode>(op.value, std::move(operand)), op);
         }
         case TokenType::MULTIPLY: { // Desreferenciación de puntero: *p
             Token op = consume(); // consume '*'
@@ -526,7 +597,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression() {
                 errorHandler.reportError("Operando esperado para operador unario '*'.", peek().line, peek().column);
                 return nullptr;
             }
-            return std::make_unique<UnaryExpressionNode>(op.value, std::move(operand));
+            return located(std::make_unique<UnaryExpressionNode>(op.value, std::move(operand)), op);
         }
         case TokenType::AMPERSAND: { // NUEVO: operador '&'
             Token op = consume(); // consume '&'
@@ -535,7 +606,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression() {
                 errorHandler.reportError("Operando esperado para operador unario '&'.", peek().line, peek().column);
                 return nullptr;
             }
-            return std::make_unique<UnaryExpressionNode>(op.value, std::move(operand));
+            return located(std::make_unique<UnaryExpressionNode>(op.value, std::move(operand)), op);
         }
         default:
             // CORRECCIÓN AQUÍ: Orden de argumentos
@@ -543,4 +614,43 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression() {
             consume(); // Intenta recuperarse
             return nullptr;
     }
-}
\ No newline at end of file
+}
+
+// <mallocExpression> ::= "malloc" "(" <expression> ")"
+std::unique_ptr<ASTNode> Parser::parseMallocExpression() {
+    const Token start = peek();
+    expect(TokenType::KEYWORD_MALLOC, "Se esperaba 'malloc'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    expect(TokenType::LPAREN, "Se esperaba '(' después de 'malloc'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    auto size = parseExpression();
+    if (!size) return nullptr;
+
+    expect(TokenType::RPAREN, "Se esperaba ')' después del tamaño de malloc.");
+    return located(std::make_unique<MallocExpressionNode>(std::move(size)), start);
+}
+
+// <sizeofExpression> ::= "sizeof" "(" "int" [ "*" ] ")"
+// Se resuelve aquí a un literal con el tamaño del tipo en el programa generado (LP64: int de 4 bytes,
+// punteros de 8)
+std::unique_ptr<ASTNode> Parser::parseSizeofExpression() {
+    const Token start = peek();
+    expect(TokenType::KEYWORD_SIZEOF, "Se esperaba 'sizeof'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    expect(TokenType::LPAREN, "Se esperaba '(' después de 'sizeof'.");
+    if (peek().type == TokenType::UNKNOWN) return nullptr;
+
+    Token typeToken = expect(TokenType::KEYWORD_INT, "sizeof solo admite los tipos 'int' e 'int*'.");
+    if (typeToken.type == TokenType::UNKNOWN) return nullptr;
+
+    std::string size = "4";
+    if (match(TokenType::MULTIPLY)) {
+        size = "8";
+    }
+
+    expect(TokenType::RPAREN, "Se esperaba ')' después del tipo de sizeof.");
+    return located(std::make_unique<LiteralNode>(size), start);
+}
@@ -29,6 +29,8 @@ private:
     // expect ahora usa el miembro errorHandler para reportar errores
     Token expect(TokenType type, const std::string& errorMessage);
     bool isAtEnd();             // Verifica si se ha llegado al final de los tokens.
+    // Anota en el nodo la posición del token que lo inicia (diagnósticos y directivas #line)
+    std::unique_ptr<ASTNode> located(std::unique_ptr<ASTNode> node, const Token& token);
 
     // Métodos para parsear diferentes construcciones del lenguaje C (Devuelven unique_ptr<ASTNode>)
     std::unique_ptr<ASTNode> parseProgram();
@@ -41,6 +43,8 @@ private:
     std::unique_ptr<ASTNode> parseForStatement();
     std::unique_ptr<ASTNode> parseReturnStatement();
     std::unique_ptr<ASTNode> parsePrintStatement(); // printf(...)
+    std::unique_ptr<ASTNode> parseFreeStatement(); // free(p);
+    std::unique_ptr<ASTNode> parsePointerAssignmentStatement(); // *p = 10;
     std::unique_ptr<ASTNode> parseFunctionCall();
 
     // Métodos para parsear expresiones (Devuelven unique_ptr<ASTNode>)
@@ -50,6 +54,8 @@ private:
     std::unique_ptr<ASTNode> parseAdditiveExpression();   // +, -
     std::unique_ptr<ASTNode> parseMultiplicativeExpression(); // *, /
     std::unique_ptr<ASTNode> parsePrimaryExpression();    // Literales, identificadores, (expresiones)
+    std::unique_ptr<ASTNode> parseMallocExpression();     // malloc(tamaño)
+    std::unique_ptr<ASTNode> parseSizeofExpression();     // sizeof(int), sizeof(int*)
 };
 
 #endif // PARSER_H
\ No newline at end of file
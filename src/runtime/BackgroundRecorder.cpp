@@ -0,0 +1,199 @@
+// src/runtime/BackgroundRecorder.cpp
+// Registro en un hilo de fondo: el programa publica la traza por bloques mientras el visor ya la muestra.
+// La publicación por bloques también la usa el flujo en vivo (TraceStream.cpp).
+#include "TraceBlock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+namespace {
+
+const size_t CHUNK_MAX_STEPS = 4096; // Como los bloques del .simtrace: lo que decodifica el visor al saltar
+const std::chrono::milliseconds PUBLISH_INTERVAL(100); // Un programa lento publica al menos así de a menudo
+
+// Nodo de la cola: el productor solo escribe 'next' del último nodo y el consumidor solo lee a partir
+// del primero, así que basta con publicar 'next' con release y leerlo con acquire
+struct TraceChunk {
+    size_t firstStep = 0;
+    uint32_t stepCount = 0;
+    std::string strings;
+    std::string block; // Sin comprimir
+    std::atomic<TraceChunk*> next{nullptr};
+};
+
+// Bloque ya recibido por el visor
+struct PublishedChunk {
+    size_t firstStep;
+    uint32_t stepCount;
+    std::string strings;
+    std::string block;
+};
+
+struct BackgroundRecorder {
+    // Hilo del programa
+    TraceChunkPublisher publisher = nullptr; // nullptr: no se publica
+    std::vector<unsigned> publishedStringArgs;
+    TraceChunk* tail = nullptr;
+    size_t publishedSteps = 0;
+    size_t threshold = 1; // Pasos del próximo bloque: crece hasta CHUNK_MAX_STEPS para que el primero salga enseguida
+    std::chrono::steady_clock::time_point lastPublish;
+    TraceStringTable strings;
+
+    // Compartido
+    std::atomic<size_t> recordedSteps{0};
+    std::atomic<bool> finished{false};
+    std::atomic<bool> cancelled{false};
+
+    // Hilo del visor
+    std::thread worker;
+    TraceChunk* head = nullptr; // Último nodo consumido (al empezar, uno vacío)
+    std::deque<PublishedChunk> chunks; // Los %s decodificados apuntan a sus cadenas: no se mueven
+    std::vector<unsigned> stringArgs;
+    SimulationReplay replay = {0, nullptr};
+    std::chrono::steady_clock::time_point start;
+    std::string decoded;
+};
+
+BackgroundRecorder recorder;
+
+// Hilo del programa: la traza en memoria se codifica, se publica y se vacía
+void publishChunk() {
+    const TraceKeyframe& first = simulationKeyframes.front(); // Estado del primer paso del bloque
+    std::string block;
+    recorder.strings.clear();
+    encodeTraceBlock(block, 0, simulationHistory.size(), first.stack, first.heap, recorder.publishedStringArgs, recorder.strings);
+    std::string strings = recorder.strings.data();
+    recorder.publisher(recorder.publishedSteps, static_cast<uint32_t>(simulationHistory.size()), strings, block);
+    recorder.publishedSteps += simulationHistory.size();
+    clearSimulationTrace();
+    recorder.threshold = std::min(recorder.threshold * 2, CHUNK_MAX_STEPS);
+    recorder.lastPublish = std::chrono::steady_clock::now();
+}
+
+// Publicación en la cola del visor de este proceso
+void queueChunk(size_t firstStep, uint32_t stepCount, std::string& strings, std::string& block) {
+    TraceChunk* chunk = new TraceChunk();
+    chunk->firstStep = firstStep;
+    chunk->stepCount = stepCount;
+    chunk->strings = std::move(strings);
+    chunk->block = std::move(block);
+    recorder.tail->next.store(chunk, std::memory_order_release);
+    recorder.tail = chunk;
+}
+
+void recordInBackground(const SimulationProgram* program) {
+    beginTraceChunkPublishing(*program, queueChunk);
+    runSimulationProgram(*program);
+    finishTraceChunkPublishing();
+    recorder.recordedSteps.store(recorder.publishedSteps, std::memory_order_relaxed);
+    recorder.finished.store(true, std::memory_order_release);
+}
+
+// Hilo del visor: pasos [firstStep, firstStep + stepCount) del bloque que contiene stepIndex
+size_t loadChunkWindow(size_t stepIndex) {
+    const auto found = std::upper_bound(recorder.chunks.begin(), recorder.chunks.end(), stepIndex,
+                                        [](size_t step, const PublishedChunk& candidate) { return step < candidate.firstStep; }) - 1;
+    const SimulationProgram& program = getActiveSimulationProgram();
+    const TraceBlockContext context = {recorder.stringArgs, program.frameLayouts, static_cast<size_t>(program.frameLayoutCount),
+                                       found->strings.data(), found->strings.size()};
+    TraceKeyframe initial;
+    decodeTraceBlock(reinterpret_cast<const unsigned char*>(found->block.data()), found->block.size(), TRACE_BLOCK_RAW,
+                     found->block.size(), found->stepCount, context, recorder.decoded, initial);
+    rebuildSimulationKeyframes(initial);
+    return found->firstStep;
+}
+
+} // namespace
+
+bool startSimulationRecording(const SimulationProgram& program) {
+    if (getSimulationTraceBudget() != 0) {
+        return false; // Los tramos del presupuesto ya son ventanas de la traza; no se publican dos veces
+    }
+    recorder.head = recorder.tail = new TraceChunk();
+    recorder.chunks.clear();
+    recorder.recordedSteps.store(0);
+    recorder.finished.store(false);
+    recorder.cancelled.store(false);
+    recorder.stringArgs = stringArgumentMasks(program);
+    recorder.replay = {0, loadChunkWindow};
+    recorder.start = std::chrono::steady_clock::now();
+    clearSimulationTrace();
+    setSimulationReplay(&recorder.replay);
+    recorder.worker = std::thread(recordInBackground, &program);
+    return true;
+}
+
+void beginTraceChunkPublishing(const SimulationProgram& program, TraceChunkPublisher publisher) {
+    recorder.publisher = publisher;
+    recorder.publishedStringArgs = stringArgumentMasks(program);
+    recorder.publishedSteps = 0;
+    recorder.threshold = 1;
+    recorder.lastPublish = std::chrono::steady_clock::now();
+}
+
+void finishTraceChunkPublishing() {
+    if (!simulationHistory.empty()) {
+        publishChunk();
+    }
+    recorder.publisher = nullptr;
+}
+
+void publishSimulationStepsIfDue() {
+    if (!recorder.publisher) {
+        return;
+    }
+    const size_t steps = simulationHistory.size();
+    if (steps % SIM_KEYFRAME_INTERVAL == 0) {
+        recorder.recordedSteps.store(recorder.publishedSteps + steps, std::memory_order_relaxed);
+        if (recorder.cancelled.load(std::memory_order_relaxed)) {
+            abandonSimulation();
+        }
+    }
+    if (steps == 0 || (steps < recorder.threshold &&
+                       (steps % SIM_KEYFRAME_INTERVAL != 0 || std::chrono::steady_clock::now() - recorder.lastPublish < PUBLISH_INTERVAL))) {
+        return;
+    }
+    publishChunk();
+}
+
+bool pollSimulationRecording(SimulationProgress& progress) {
+    if (!recorder.worker.joinable()) {
+        return false;
+    }
+    // 'finished' se lee antes de vaciar la cola: si ya estaba, el último bloque también está en ella
+    const bool finished = recorder.finished.load(std::memory_order_acquire);
+    while (TraceChunk* next = recorder.head->next.load(std::memory_order_acquire)) {
+        delete recorder.head;
+        recorder.head = next;
+        recorder.chunks.push_back({next->firstStep, next->stepCount, std::move(next->strings), std::move(next->block)});
+        recorder.replay.stepCount += next->stepCount;
+    }
+    progress.steps = recorder.recordedSteps.load(std::memory_order_relaxed);
+    progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - recorder.start).count();
+    progress.active = !finished;
+    progress.droppedSteps = 0;
+    progress.evictedSteps = 0;
+    if (finished) {
+        recorder.worker.join();
+        delete recorder.head;
+        recorder.head = recorder.tail = nullptr;
+    }
+    return true;
+}
+
+void stopSimulationRecording() {
+    if (!recorder.worker.joinable()) {
+        return;
+    }
+    recorder.cancelled.store(true, std::memory_order_relaxed);
+    recorder.worker.join();
+    for (TraceChunk* chunk = recorder.head; chunk;) {
+        TraceChunk* next = chunk->next.load(std::memory_order_acquire);
+        delete chunk;
+        chunk = next;
+    }
+    recorder.head = recorder.tail = nullptr;
+}
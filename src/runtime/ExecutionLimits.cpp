@@ -0,0 +1,113 @@
+// src/runtime/ExecutionLimits.cpp
+// Límites de pasos, de tiempo y detección de bucles sin fin del programa generado
+#include "SimulationRuntime.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+size_t simulationRecordedSteps = 0;
+size_t simulationStoreVersion = 0;
+size_t simulationStepLimit = SIZE_MAX;
+unsigned simulationClockCountdown = 1;
+bool simulationDetectLoops = false;
+
+namespace {
+
+// Lecturas del reloj: una cada tantas comprobaciones, para que el salto de vuelta siga siendo barato
+const unsigned CLOCK_CHECK_INTERVAL = 4096;
+
+// Se lanza desde el código generado y la recoge runWithinExecutionLimits: al deshacer la pila,
+// los StackFrameScope sacan los marcos abiertos
+struct SimulationStopped {};
+
+SimulationExecutionLimits activeLimits = {0, 0, false, {-1, -1, -1}};
+std::chrono::steady_clock::time_point runStart;
+
+} // namespace
+
+const char* simulationStopReasonText(SimStopReason reason) {
+    switch (reason) {
+        case SIM_STOP_STEPS:
+            return "step budget exceeded";
+        case SIM_STOP_TIME:
+            return "time budget exceeded";
+        default:
+            return "infinite loop detected";
+    }
+}
+
+void setSimulationExecutionLimits(const SimulationExecutionLimits& limits) {
+    activeLimits = limits;
+}
+
+void resetExecutionLimits() {
+    simulationRecordedSteps = 0;
+    simulationStoreVersion = 0;
+    simulationStepLimit = activeLimits.maxSteps != 0 ? activeLimits.maxSteps : SIZE_MAX;
+    simulationClockCountdown = CLOCK_CHECK_INTERVAL;
+    simulationDetectLoops = activeLimits.detectLoops;
+    runStart = std::chrono::steady_clock::now();
+}
+
+bool runWithinExecutionLimits(void (*run)()) {
+    resetExecutionLimits();
+    try {
+        run();
+    } catch (const SimulationStopped&) {
+        return false;
+    }
+    return true;
+}
+
+bool resumeWithinExecutionLimits(bool (*resume)()) {
+    // La corrutina guarda la excepción y la vuelve a lanzar al reanudarla desde aquí
+    try {
+        return resume();
+    } catch (const SimulationStopped&) {
+        return false;
+    }
+}
+
+void stopSimulation(SimStopReason reason, int line) {
+    const int descriptor = activeLimits.stopDescriptors[reason];
+    if (descriptor >= 0) {
+        recordStep(descriptor, static_cast<long long>(line));
+    }
+    flushOutput();
+    std::fprintf(stderr, "execution stopped: %s at line %d after %zu steps\n", simulationStopReasonText(reason), line, simulationRecordedSteps);
+    throw SimulationStopped();
+}
+
+void abandonSimulation() {
+    throw SimulationStopped();
+}
+
+void checkSimulationLimitsSlow(int line) {
+    if (simulationRecordedSteps >= simulationStepLimit) {
+        stopSimulation(SIM_STOP_STEPS, line);
+    }
+    if (simulationClockCountdown == 0) {
+        simulationClockCountdown = CLOCK_CHECK_INTERVAL;
+        if (activeLimits.maxMillis != 0 &&
+            std::chrono::steady_clock::now() - runStart >= std::chrono::milliseconds(activeLimits.maxMillis)) {
+            stopSimulation(SIM_STOP_TIME, line);
+        }
+    }
+}
+
+void SimulationLoopGuard::takeSnapshot() {
+    const StackFrame& frame = currentStackFrames.back();
+    snapshot = frame;
+    snapshotSlotCount = getFrameLayout(frame.layout).slotCount;
+    snapshotDepth = currentStackFrames.size();
+    snapshotStoreVersion = simulationStoreVersion;
+    nextSnapshot *= 2;
+}
+
+bool SimulationLoopGuard::matchesSnapshot() const {
+    const StackFrame& frame = currentStackFrames.back();
+    return currentStackFrames.size() == snapshotDepth && simulationStoreVersion == snapshotStoreVersion &&
+           frame.live == snapshot.live && std::memcmp(frame.slots, snapshot.slots, snapshotSlotCount * sizeof(long long)) == 0;
+}
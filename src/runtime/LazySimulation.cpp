@@ -0,0 +1,62 @@
+// src/runtime/LazySimulation.cpp
+// Ejecución paso a paso (--lazy): el visor reanuda la corrutina del programa solo cuando necesita un paso más
+#include "SimulationRuntime.h"
+
+#include <algorithm>
+
+namespace {
+
+struct LazySimulation {
+    SimulationStepper stepper = {nullptr, nullptr, nullptr};
+    size_t window = 0; // Pasos anteriores al mostrado que se conservan
+    bool running = false;
+};
+
+LazySimulation lazy;
+
+void finishLazySimulation() {
+    lazy.running = false;
+    lazy.stepper.destroy();
+    finishSimulationRun();
+}
+
+} // namespace
+
+void beginLazySimulation(const SimulationProgram& program, const SimulationStepper& stepper, size_t window) {
+    beginSimulationRun(program);
+    discardSimulationChangeIndex();
+    resetExecutionLimits();
+    lazy.stepper = stepper;
+    // Los pasos se descartan por keyframes: la ventana abarca al menos uno
+    lazy.window = std::max(window, SIM_KEYFRAME_INTERVAL);
+    lazy.running = true;
+    stepper.start();
+}
+
+void advanceLazySimulation(size_t stepIndex) {
+    if (lazy.window == 0) {
+        return; // Sin beginLazySimulation: la traza está entera en memoria
+    }
+    // Un paso por delante del mostrado: así se sabe si Next tiene adónde ir
+    while (lazy.running && getSimulationStepCount() <= stepIndex + 1) {
+        if (!resumeWithinExecutionLimits(lazy.stepper.resume)) {
+            finishLazySimulation();
+        }
+    }
+    // Se descarta cada vez otra ventana entera, para que el coste de mover la traza se reparta entre sus pasos
+    if (stepIndex >= getSimulationFirstStep() + 2 * lazy.window) {
+        discardSimulationStepsBefore(stepIndex - lazy.window);
+    }
+}
+
+bool isLazySimulationRunning() {
+    return lazy.running;
+}
+
+void stopLazySimulation() {
+    if (lazy.running) {
+        lazy.running = false;
+        lazy.stepper.destroy();
+        flushOutput();
+    }
+}
@@ -0,0 +1,217 @@
+// src/runtime/ProfileReport.cpp
+// --profile: muestreo del tiempo e informe (perfil plano por función y el fuente C anotado con las
+// visitas y el tiempo de cada línea). No depende del resto de sim_runtime: el programa de perfil solo
+// enlaza este archivo.
+#include "SimulationProfile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+namespace {
+
+// De tiempo de CPU del proceso (ITIMER_PROF). Es lo que se pide: el núcleo puede entregar las señales
+// con la resolución de su reloj, así que el informe reparte el tiempo de CPU medido entre las muestras
+const long SAMPLE_INTERVAL_MICROS = 1000;
+const size_t HOTTEST_LINE_COUNT = 10;
+
+const SimulationProfile* sampledProfile = nullptr;
+volatile std::sig_atomic_t stopSampling = 0;
+std::chrono::steady_clock::time_point profileStartTime;
+std::clock_t profileStartClock;
+
+// Por línea del fuente: la sentencia más ejecutada (un for cuenta la entrada, la inicialización y
+// cada incremento) y las muestras de todas las suyas
+struct LineProfile {
+    bool hasSite = false;
+    unsigned long long hits = 0;
+    unsigned long long samples = 0;
+    std::vector<size_t> functions; // Funciones cuya cabecera está en la línea
+};
+
+#ifndef _WIN32
+// Manejador de SIGPROF: solo incrementa contadores que el programa no toca mientras se ejecuta
+void sampleProfile(int) {
+    if (stopSampling) {
+        return;
+    }
+    const SimulationProfile& profile = *sampledProfile;
+    const int site = simProfileSite;
+    if (site >= 0 && static_cast<size_t>(site) < profile.siteCount) {
+        ++profile.siteSamples[site];
+    }
+    const int function = simProfileFunction;
+    if (function >= 0 && static_cast<size_t>(function) < profile.functionCount) {
+        ++profile.counters[function].selfSamples;
+    }
+    for (size_t i = 0; i < profile.functionCount; ++i) {
+        if (profile.counters[i].active.load(std::memory_order_relaxed) != 0) {
+            ++profile.counters[i].totalSamples;
+        }
+    }
+}
+
+void setSamplingTimer(long intervalMicros) {
+    itimerval timer = {};
+    timer.it_interval.tv_usec = intervalMicros;
+    timer.it_value.tv_usec = intervalMicros;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+}
+#endif
+
+std::vector<std::string> readSourceLines(const char* path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+} // namespace
+
+void startSimulationProfile(const SimulationProfile& profile) {
+    sampledProfile = &profile;
+    profileStartTime = std::chrono::steady_clock::now();
+    profileStartClock = std::clock();
+#ifndef _WIN32
+    struct sigaction action = {};
+    action.sa_handler = sampleProfile;
+    action.sa_flags = SA_RESTART; // Las escrituras de printf no fallan con EINTR
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+    setSamplingTimer(SAMPLE_INTERVAL_MICROS);
+#endif
+}
+
+int writeSimulationProfile(const SimulationProfile& profile, const char* reportPath) {
+    const std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - profileStartTime;
+    const double cpuMillis = 1000.0 * (std::clock() - profileStartClock) / CLOCKS_PER_SEC;
+#ifndef _WIN32
+    stopSampling = 1;
+    setSamplingTimer(0);
+#endif
+    unsigned long long sampleCount = 0;
+    for (size_t site = 0; site < profile.siteCount; ++site) {
+        sampleCount += profile.siteSamples[site];
+    }
+    const double millisPerSample = sampleCount != 0 ? cpuMillis / sampleCount : 0.0;
+    auto percent = [&](unsigned long long samples) { return sampleCount != 0 ? 100.0 * samples / sampleCount : 0.0; };
+
+    std::FILE* report = std::string(reportPath) == "-" ? stderr : std::fopen(reportPath, "w");
+    if (!report) {
+        std::fprintf(stderr, "Error: no se pudo escribir %s\n", reportPath);
+        return 1;
+    }
+
+    std::fprintf(report, "Profile of %s (%.3f ms, %.1f ms of CPU time in %llu samples)\n\n", profile.sourcePath, wall.count(), cpuMillis,
+                 sampleCount);
+    std::fprintf(report, "Flat profile (self: without the functions it calls; total: with them)\n");
+    std::fprintf(report, "  self %%     self ms    total ms        calls  function\n");
+    std::vector<size_t> order(profile.functionCount);
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return profile.counters[a].selfSamples > profile.counters[b].selfSamples;
+    });
+    for (size_t function : order) {
+        const SimProfileCounters& counters = profile.counters[function];
+        if (counters.calls == 0) {
+            continue;
+        }
+        // Una muestra entre la vuelta de la función y la restauración de quien la llamó no está en 'total'
+        const unsigned long long totalSamples = std::max(counters.totalSamples, counters.selfSamples);
+        std::fprintf(report, "%7.2f %11.1f %11.1f %12llu  %s\n", percent(counters.selfSamples), counters.selfSamples * millisPerSample,
+                     totalSamples * millisPerSample, counters.calls, profile.functions[function].name);
+    }
+
+    std::vector<std::string> source = readSourceLines(profile.sourcePath);
+    std::vector<LineProfile> lines(source.size() + 1);
+    auto lineAt = [&](int line) -> LineProfile& {
+        if (static_cast<size_t>(line) >= lines.size()) {
+            lines.resize(line + 1);
+        }
+        return lines[line];
+    };
+    for (size_t site = 0; site < profile.siteCount; ++site) {
+        if (profile.siteLines[site] <= 0) {
+            continue;
+        }
+        LineProfile& line = lineAt(profile.siteLines[site]);
+        line.hasSite = true;
+        line.hits = std::max(line.hits, profile.siteHits[site]);
+        line.samples += profile.siteSamples[site];
+    }
+    for (size_t function = 0; function < profile.functionCount; ++function) {
+        if (profile.functions[function].line > 0) {
+            lineAt(profile.functions[function].line).functions.push_back(function);
+        }
+    }
+    auto sourceText = [&](size_t line) { return line <= source.size() ? source[line - 1].c_str() : ""; };
+
+    // Las que más tiempo se llevan y, sin muestras, las más ejecutadas
+    std::vector<size_t> hottest;
+    for (size_t line = 1; line < lines.size(); ++line) {
+        if (lines[line].hits != 0) {
+            hottest.push_back(line);
+        }
+    }
+    std::stable_sort(hottest.begin(), hottest.end(), [&](size_t a, size_t b) {
+        return lines[a].samples != lines[b].samples ? lines[a].samples > lines[b].samples : lines[a].hits > lines[b].hits;
+    });
+    hottest.resize(std::min(hottest.size(), HOTTEST_LINE_COUNT));
+    std::fprintf(report, "\nHottest lines\n");
+    std::fprintf(report, "        hits       ms  time %%  line\n");
+    for (size_t line : hottest) {
+        std::fprintf(report, "%12llu %8.1f %7.2f %5zu  %s\n", lines[line].hits, lines[line].samples * millisPerSample, percent(lines[line].samples),
+                     line, sourceText(line));
+    }
+
+    std::fprintf(report, "\nAnnotated source (hits: most executed statement of the line, or calls of the function it declares;\n"
+                         "ms: time in the line's own statements, without the functions they call)\n");
+    if (source.empty()) {
+        std::fprintf(report, "(%s could not be read: only lines with statements are listed)\n", profile.sourcePath);
+    }
+    for (size_t line = 1; line < lines.size(); ++line) {
+        const LineProfile& info = lines[line];
+        if (source.empty() && !info.hasSite && info.functions.empty()) {
+            continue;
+        }
+        char hits[24] = "";
+        char millis[24] = "";
+        if (!info.functions.empty()) {
+            unsigned long long calls = 0;
+            for (size_t function : info.functions) {
+                calls += profile.counters[function].calls;
+            }
+            std::snprintf(hits, sizeof(hits), "%llu", calls);
+        } else if (info.hasSite) {
+            std::snprintf(hits, sizeof(hits), "%llu", info.hits);
+        }
+        if (info.samples != 0) {
+            std::snprintf(millis, sizeof(millis), "%.1f", info.samples * millisPerSample);
+        }
+        std::fprintf(report, "%12s %8s %5zu  %s\n", hits, millis, line, sourceText(line));
+    }
+
+    const bool ok = !std::ferror(report);
+    if (report != stderr) {
+        if (std::fclose(report) != 0 || !ok) {
+            std::fprintf(stderr, "Error: no se pudo escribir %s\n", reportPath);
+            return 1;
+        }
+        std::fprintf(stderr, "profile written to %s\n", reportPath);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+// src/runtime/SimulationCoroutine.h
+#ifndef SIMULATIONCOROUTINE_H
+#define SIMULATIONCOROUTINE_H
+
+// Modo --lazy: las funciones traducidas son corrutinas C++20 que se suspenden tras registrar cada paso.
+// Solo lo incluyen los programas generados con --lazy (compilados con -std=c++20); sim_runtime sigue
+// en C++17 y maneja la corrutina a través de SimulationStepper.
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "SimulationRuntime.h"
+
+// Tras cada paso, la corrutina más interna guarda su punto de reanudación y devuelve el control al visor
+inline std::coroutine_handle<> simulationResumePoint;
+
+struct SimulationStepPause {
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const noexcept { simulationResumePoint = handle; }
+    void await_resume() const noexcept {}
+};
+
+template <typename... Args>
+inline SimulationStepPause recordLazyStep(int descriptorId, Args... args) {
+    recordStep(descriptorId, args...);
+    return {};
+}
+
+template <typename T>
+class SimulationTask;
+
+namespace simulation_coroutine {
+
+// Al terminar, la corrutina cede el control a la que la esperaba sin anidar llamadas (transferencia
+// simétrica): la recursión del programa C no crece la pila nativa
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+        std::coroutine_handle<> caller = handle.promise().caller;
+        return caller ? caller : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> caller;
+    std::exception_ptr exception; // SimulationStopped de un límite: sube hasta resumeWithinExecutionLimits
+
+    std::suspend_always initial_suspend() const noexcept { return {}; } // Empieza cuando se la espera
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T>
+struct Promise : PromiseBase {
+    T value{};
+    SimulationTask<T> get_return_object();
+    void return_value(T result) { value = result; }
+    T result() {
+        if (exception) std::rethrow_exception(exception);
+        return value;
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    SimulationTask<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+} // namespace simulation_coroutine
+
+// Llamada a una función traducida: 'co_await f(x)' la ejecuta y devuelve su valor de retorno
+template <typename T>
+class SimulationTask {
+public:
+    using promise_type = simulation_coroutine::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    SimulationTask() = default;
+    explicit SimulationTask(Handle handle) : handle(handle) {}
+    SimulationTask(SimulationTask&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    SimulationTask& operator=(SimulationTask&& other) noexcept {
+        std::swap(handle, other.handle);
+        return *this;
+    }
+    ~SimulationTask() {
+        if (handle) handle.destroy(); // Con el visor cerrado a medias, los StackFrameScope sacan sus marcos
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle.promise().caller = caller;
+        return handle;
+    }
+    T await_resume() { return handle.promise().result(); }
+
+    Handle handle;
+};
+
+template <typename T>
+SimulationTask<T> simulation_coroutine::Promise<T>::get_return_object() {
+    return SimulationTask<T>(SimulationTask<T>::Handle::from_promise(*this));
+}
+
+inline SimulationTask<void> simulation_coroutine::Promise<void>::get_return_object() {
+    return SimulationTask<void>(SimulationTask<void>::Handle::from_promise(*this));
+}
+
+// Definida por el programa generado
+SimulationTask<void> run_c_program_simulation();
+
+inline SimulationTask<void> simulationProgramTask;
+
+inline void startSimulationCoroutine() {
+    simulationProgramTask = run_c_program_simulation();
+    simulationResumePoint = simulationProgramTask.handle;
+}
+
+inline bool resumeSimulationCoroutine() {
+    simulationResumePoint.resume();
+    if (!simulationProgramTask.handle.done()) {
+        return true;
+    }
+    simulationProgramTask.handle.promise().result(); // Relanza un límite superado
+    return false;
+}
+
+inline void destroySimulationCoroutine() {
+    simulationProgramTask = SimulationTask<void>();
+}
+
+// Sin visor (grabación de la traza, benchmark): el programa entero, sin pausas
+inline void runSimulationCoroutine() {
+    startSimulationCoroutine();
+    while (resumeSimulationCoroutine()) {
+    }
+    destroySimulationCoroutine();
+}
+
+constexpr SimulationStepper simulationStepper = {startSimulationCoroutine, resumeSimulationCoroutine, destroySimulationCoroutine};
+
+#endif // SIMULATIONCOROUTINE_H
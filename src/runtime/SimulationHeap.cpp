@@ -0,0 +1,296 @@
+// src/runtime/SimulationHeap.cpp
+// Heap simulado del programa C: asignador por clases de tamaño con listas de bloques libres, tabla de
+// bloques indexada por handle y publicación de cada bloque en la traza (ver SimulationRuntime.h).
+#include "SimulationRuntime.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+const size_t ARENA_BYTES = size_t(1) << 30; // Solo se reserva: las páginas se usan al cortar los tramos
+const uintptr_t ARENA_ADDRESS_HINT = uintptr_t(0x100000000000ULL);
+const size_t PAGE_BYTES = 4096;
+const size_t SPAN_BYTES = 64 * 1024;  // Tramo de los bloques de una clase
+const size_t MIN_CLASS_BYTES = 16;
+const size_t MAX_CLASS_BYTES = 2048;
+const int CLASS_COUNT = 8;            // 16, 32, ..., 2048
+const size_t MAX_SHOWN_VALUES = 16;   // Enteros del contenido de un bloque en su valor de la traza
+const size_t MAX_REPORTED_LEAKS = 10; // Fugas detalladas en la salida de errores
+
+enum BlockState : unsigned char { BLOCK_UNUSED, BLOCK_LIVE, BLOCK_FREED };
+
+struct HeapBlock {
+    char* data;
+    size_t size;         // Bytes del bloque (clase o páginas)
+    size_t requested;    // Bytes pedidos en el último malloc
+    int line;            // Línea del último malloc
+    int freedLine;
+    BlockState state;
+    std::string address; // Clave en el heap de la traza; se formatea en el primer malloc
+};
+
+// Tramo contiguo del arena: los bloques de una clase o un único bloque grande
+struct HeapSpan {
+    char* start;
+    size_t blockSize;
+    uint32_t firstHandle; // Handle del primer bloque; los demás son consecutivos
+};
+
+struct SizeClass {
+    std::vector<uint32_t> freeList; // Bloques liberados, el último se reutiliza primero
+    int currentSpan = -1;           // Tramo del que se cortan los bloques nuevos
+    size_t nextBlock = 0;
+};
+
+char* arena = nullptr;
+size_t arenaUsed = 0;
+std::vector<HeapBlock> blocks; // Por handle
+std::vector<HeapSpan> spans;
+std::vector<int> pageSpans;    // Tramo de cada página usada del arena
+SizeClass sizeClasses[CLASS_COUNT];
+std::multimap<size_t, uint32_t> freeLargeBlocks; // Bloques grandes liberados por tamaño (mejor ajuste)
+
+bool reserveArena() {
+    if (arena) {
+        return true;
+    }
+#ifdef _WIN32
+    arena = static_cast<char*>(VirtualAlloc(reinterpret_cast<void*>(ARENA_ADDRESS_HINT), ARENA_BYTES, MEM_RESERVE, PAGE_READWRITE));
+    if (!arena) {
+        arena = static_cast<char*>(VirtualAlloc(nullptr, ARENA_BYTES, MEM_RESERVE, PAGE_READWRITE));
+    }
+#else
+    void* reserved = mmap(reinterpret_cast<void*>(ARENA_ADDRESS_HINT), ARENA_BYTES, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    arena = reserved == MAP_FAILED ? nullptr : static_cast<char*>(reserved);
+#endif
+    if (!arena) {
+        std::fprintf(stderr, "error: could not reserve the simulated heap\n");
+    }
+    return arena != nullptr;
+}
+
+// Corta un tramo nuevo del final del arena; nullptr si no cabe
+char* addSpan(size_t bytes, size_t blockSize) {
+    if (!reserveArena() || bytes > ARENA_BYTES - arenaUsed) {
+        return nullptr;
+    }
+    char* start = arena + arenaUsed;
+#ifdef _WIN32
+    if (!VirtualAlloc(start, bytes, MEM_COMMIT, PAGE_READWRITE)) {
+        return nullptr;
+    }
+#endif
+    arenaUsed += bytes;
+    pageSpans.resize(arenaUsed / PAGE_BYTES, static_cast<int>(spans.size()));
+    spans.push_back({start, blockSize, static_cast<uint32_t>(blocks.size())});
+    for (size_t offset = 0; offset < bytes; offset += blockSize) {
+        blocks.push_back({start + offset, blockSize, 0, 0, 0, BLOCK_UNUSED, std::string()});
+    }
+    return start;
+}
+
+int sizeClassOf(size_t size) {
+    int sizeClass = 0;
+    while ((MIN_CLASS_BYTES << sizeClass) < size) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+// Bloque que contiene la dirección (handle), sin recorrer nada: página -> tramo -> bloque
+bool findBlock(const void* address, uint32_t& handle) {
+    const char* pointer = static_cast<const char*>(address);
+    if (!arena || pointer < arena || pointer >= arena + arenaUsed) {
+        return false;
+    }
+    const HeapSpan& span = spans[pageSpans[(pointer - arena) / PAGE_BYTES]];
+    handle = span.firstHandle + static_cast<uint32_t>((pointer - span.start) / span.blockSize);
+    return true;
+}
+
+// Objeto del bloque en el heap de la traza: los campos para las estadísticas y el texto para mostrarlo
+void publishBlock(uint32_t handle) {
+    HeapBlock& block = blocks[handle];
+    if (block.address.empty()) {
+        block.address = formatPointer(block.data);
+    }
+    HeapObject object;
+    object.kind = block.state == BLOCK_FREED ? HEAP_BLOCK_FREED : HEAP_BLOCK_LIVE;
+    object.handle = handle;
+    object.requested = block.state == BLOCK_FREED ? 0 : block.requested;
+    object.size = block.size;
+    if (block.state == BLOCK_FREED) {
+        object.value = "[free, " + std::to_string(block.size) + " B]";
+        updateHeapObject(block.address, object);
+        return;
+    }
+    object.value = "[" + std::to_string(block.requested) + " of " + std::to_string(block.size) + " B, line " + std::to_string(block.line) + "] {";
+    const size_t count = block.requested / sizeof(int);
+    for (size_t i = 0; i < count && i < MAX_SHOWN_VALUES; ++i) {
+        int element;
+        std::memcpy(&element, block.data + i * sizeof(int), sizeof(int));
+        object.value += (i == 0 ? "" : ", ") + std::to_string(element);
+    }
+    object.value += count > MAX_SHOWN_VALUES ? ", ...}" : "}";
+    updateHeapObject(block.address, object);
+}
+
+} // namespace
+
+void* simMalloc(long long size, int line) {
+    if (size <= 0 || static_cast<unsigned long long>(size) > ARENA_BYTES) {
+        return nullptr; // malloc(0) puede devolver NULL
+    }
+    const size_t requested = static_cast<size_t>(size);
+    uint32_t handle;
+    if (requested <= MAX_CLASS_BYTES) {
+        const int index = sizeClassOf(requested);
+        SizeClass& sizeClass = sizeClasses[index];
+        if (!sizeClass.freeList.empty()) {
+            handle = sizeClass.freeList.back();
+            sizeClass.freeList.pop_back();
+        } else {
+            const size_t blockSize = MIN_CLASS_BYTES << index;
+            if (sizeClass.currentSpan < 0 || sizeClass.nextBlock == SPAN_BYTES / blockSize) {
+                if (!addSpan(SPAN_BYTES, blockSize)) {
+                    return nullptr;
+                }
+                sizeClass.currentSpan = static_cast<int>(spans.size() - 1);
+                sizeClass.nextBlock = 0;
+            }
+            handle = spans[sizeClass.currentSpan].firstHandle + static_cast<uint32_t>(sizeClass.nextBlock++);
+        }
+    } else {
+        const size_t blockSize = (requested + PAGE_BYTES - 1) / PAGE_BYTES * PAGE_BYTES;
+        auto fit = freeLargeBlocks.lower_bound(blockSize);
+        if (fit != freeLargeBlocks.end()) {
+            handle = fit->second;
+            freeLargeBlocks.erase(fit);
+        } else {
+            if (!addSpan(blockSize, blockSize)) {
+                return nullptr;
+            }
+            handle = spans.back().firstHandle;
+        }
+    }
+
+    HeapBlock& block = blocks[handle];
+    block.requested = requested;
+    block.line = line;
+    block.freedLine = 0;
+    block.state = BLOCK_LIVE;
+    std::memset(block.data, 0, block.size); // El contenido no depende de usos anteriores del bloque
+    publishBlock(handle);
+    return block.data;
+}
+
+SimFreeResult simFree(const void* address, int line) {
+    if (!address) {
+        return SIM_FREE_OK;
+    }
+    uint32_t handle;
+    if (!findBlock(address, handle) || blocks[handle].data != address || blocks[handle].state == BLOCK_UNUSED) {
+        std::fprintf(stderr, "error: free of %s at line %d, which is not a block returned by malloc\n", formatPointer(address).c_str(), line);
+        return SIM_FREE_INVALID;
+    }
+    HeapBlock& block = blocks[handle];
+    if (block.state == BLOCK_FREED) {
+        std::fprintf(stderr, "error: double free of %s at line %d (already freed at line %d)\n", block.address.c_str(), line, block.freedLine);
+        return SIM_FREE_DOUBLE;
+    }
+    block.state = BLOCK_FREED;
+    block.freedLine = line;
+    if (block.size <= MAX_CLASS_BYTES) {
+        sizeClasses[sizeClassOf(block.size)].freeList.push_back(handle);
+    } else {
+        freeLargeBlocks.emplace(block.size, handle);
+    }
+    publishBlock(handle);
+    return SIM_FREE_OK;
+}
+
+bool simHeapCheckStore(const void* address, int line) {
+    uint32_t handle;
+    if (!findBlock(address, handle)) {
+        return true; // Fuera del arena: variable de la pila (p = &x)
+    }
+    const HeapBlock& block = blocks[handle];
+    if (block.state != BLOCK_LIVE) {
+        std::fprintf(stderr, "error: write to %s at line %d, which is not in an allocated block\n", formatPointer(address).c_str(), line);
+        return false;
+    }
+    if (static_cast<const char*>(address) - block.data >= static_cast<std::ptrdiff_t>(block.requested)) {
+        std::fprintf(stderr, "error: write to %s at line %d, past the end of the %zu-byte block allocated at line %d\n",
+                     formatPointer(address).c_str(), line, block.requested, block.line);
+        return false;
+    }
+    return true;
+}
+
+void simHeapStore(const void* address) {
+    // El estado cambia fuera del marco que compara la detección de bucles (puede ser el de quien llama)
+    ++simulationStoreVersion;
+    uint32_t handle;
+    if (!findBlock(address, handle)) {
+        updateStackSlotAtAddress(address); // Variable de la pila (p = &x)
+        return;
+    }
+    publishBlock(handle);
+}
+
+void reportSimulationHeapLeaks(int leakDescriptor) {
+    size_t leakCount = 0;
+    size_t leakBytes = 0;
+    for (const HeapBlock& block : blocks) {
+        if (block.state != BLOCK_LIVE) {
+            continue;
+        }
+        recordStep(leakDescriptor, static_cast<long long>(block.requested), static_cast<const void*>(block.data), static_cast<long long>(block.line));
+        if (leakCount < MAX_REPORTED_LEAKS) {
+            std::fprintf(stderr, "memory leak: %zu bytes at %s allocated at line %d\n", block.requested, block.address.c_str(), block.line);
+        }
+        ++leakCount;
+        leakBytes += block.requested;
+    }
+    if (leakCount > MAX_REPORTED_LEAKS) {
+        std::fprintf(stderr, "memory leak: %zu bytes in %zu blocks in total\n", leakBytes, leakCount);
+    }
+}
+
+void resetSimulationHeap() {
+    // El arena se conserva: los bloques se ponen a cero al asignarlos
+    arenaUsed = 0;
+    blocks.clear();
+    spans.clear();
+    pageSpans.clear();
+    for (SizeClass& sizeClass : sizeClasses) {
+        sizeClass = SizeClass();
+    }
+    freeLargeBlocks.clear();
+}
+
+SimHeapStats computeSimulationHeapStats(const HeapObjectMap& heap) {
+    SimHeapStats stats = {0, 0, 0, 0, 0};
+    for (const auto& object : heap) {
+        if (object.second.kind == HEAP_BLOCK_FREED) {
+            ++stats.freeBlocks;
+            stats.freeBytes += object.second.size;
+        } else if (object.second.kind == HEAP_BLOCK_LIVE) {
+            ++stats.liveBlocks;
+            stats.requestedBytes += object.second.requested;
+            stats.liveBytes += object.second.size;
+        }
+    }
+    return stats;
+}
@@ -0,0 +1,19 @@
+// src/runtime/SimulationLimits.h
+#ifndef SIMULATIONLIMITS_H
+#define SIMULATIONLIMITS_H
+
+// Capacidades fijas del runtime precompilado. Las comparte el compilador, que rechaza
+// los programas que las superan, y la biblioteca sim_runtime.
+constexpr int SIM_MAX_STEP_ARGS = 8;    // Valores por paso (p. ej. conversiones de un printf)
+constexpr int SIM_MAX_FRAME_SLOTS = 32; // Variables locales y parámetros por función
+
+// Qué hace el registro con presupuesto de memoria (--trace-budget) con los pasos que ya no caben
+enum SimTraceOverflow : unsigned char {
+    SIM_TRACE_SPILL, // Se vuelcan a un archivo temporal y el visor los vuelve a leer
+    SIM_TRACE_DROP   // Se descartan: solo se conservan los pasos más recientes
+};
+
+// Motivos por los que el programa generado se detiene antes de terminar (--max-steps, --max-seconds, --detect-loops)
+enum SimStopReason : unsigned char { SIM_STOP_STEPS, SIM_STOP_TIME, SIM_STOP_LOOP, SIM_STOP_REASON_COUNT };
+
+#endif // SIMULATIONLIMITS_H
@@ -0,0 +1,86 @@
+// src/runtime/SimulationProfile.h
+#ifndef SIMULATIONPROFILE_H
+#define SIMULATIONPROFILE_H
+
+// Modo --profile: el programa generado es el nativo más contadores en tablas estáticas indexadas por
+// sitio (una sentencia del fuente C) y por función. Aquí está lo que se ejecuta en cada sentencia y
+// en cada llamada; el muestreo del tiempo y el informe viven en sim_runtime (ProfileReport.cpp), que
+// es lo único que el programa enlaza de la biblioteca.
+//
+// Las visitas y las llamadas son exactas. El tiempo se mide por muestreo: cada milisegundo de CPU (o lo
+// que permita el reloj del núcleo) una señal anota la sentencia y la función en curso, así que ni las
+// sentencias ni las llamadas leen el reloj (leerlo en cada llamada multiplicaba por 45 el tiempo de un bucle que llama a una función corta).
+
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <iterator> // std::size de las tablas generadas
+
+// Sentencia y función en curso; las lee el manejador de la señal de muestreo. volatile sig_atomic_t
+// basta para un manejador del mismo hilo: cada escritura es un mov que el compilador no elimina, y a
+// diferencia de un atómico no le impide mantener en registros el resto del bucle (los contadores de
+// visitas incluidos), que con atómicos se leían y escribían en memoria en cada sentencia.
+inline volatile std::sig_atomic_t simProfileSite = 0;
+inline volatile std::sig_atomic_t simProfileFunction = -1;
+
+inline void simProfileAt(int site) {
+    simProfileSite = site;
+}
+
+struct SimProfileFunction {
+    const char* name;
+    int line; // Cabecera de la función en el fuente C
+};
+
+struct SimProfileCounters {
+    unsigned long long calls;
+    std::atomic<unsigned> active;    // Llamadas en curso (una recursión cuenta una vez en 'totalSamples')
+    unsigned long long selfSamples;  // Muestras con la función en curso
+    unsigned long long totalSamples; // Muestras con la función en la pila
+};
+
+// Prólogo de una función traducida: cuenta la llamada y la marca como función en curso; al salir, la
+// sentencia y la función en curso vuelven a ser las de quien la llamó
+class SimProfileScope {
+public:
+    SimProfileScope(SimProfileCounters& counters, int function)
+        : counters(counters), callerSite(simProfileSite), callerFunction(simProfileFunction) {
+        ++counters.calls;
+        counters.active.store(counters.active.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        simProfileFunction = function;
+    }
+
+    ~SimProfileScope() {
+        simProfileFunction = callerFunction;
+        simProfileSite = callerSite;
+        counters.active.store(counters.active.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+    }
+
+    SimProfileScope(const SimProfileScope&) = delete;
+    SimProfileScope& operator=(const SimProfileScope&) = delete;
+
+private:
+    SimProfileCounters& counters;
+    int callerSite;
+    int callerFunction;
+};
+
+// Tablas del programa generado
+struct SimulationProfile {
+    const char* sourcePath;              // Fuente C que se anota (ruta absoluta al compilar)
+    const int* siteLines;                // Línea de cada sitio (el 0 es el código fuera de sentencias)
+    const unsigned long long* siteHits;  // Ejecuciones de cada sitio
+    unsigned long long* siteSamples;     // Muestras de tiempo de cada sitio
+    size_t siteCount;
+    const SimProfileFunction* functions; // Por layout de marco, como en el modo visualización
+    SimProfileCounters* counters;
+    size_t functionCount;
+};
+
+// sim_runtime: el main generado llama a startSimulationProfile() antes de ejecutar el programa (arranca
+// el muestreo) y a writeSimulationProfile() al terminar, con la ruta del informe ("-": salida de
+// errores). Devuelve el código de salida del programa.
+void startSimulationProfile(const SimulationProfile& profile);
+int writeSimulationProfile(const SimulationProfile& profile, const char* reportPath);
+
+#endif // SIMULATIONPROFILE_H
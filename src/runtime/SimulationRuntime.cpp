@@ -0,0 +1,550 @@
+// src/runtime/SimulationRuntime.cpp
+#include "SimulationRuntime.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <sstream>
+
+std::vector<StackFrame> currentStackFrames;
+HeapObjectMap currentHeapObjects;
+thread_local std::vector<SimulationStep> simulationHistory;
+thread_local std::vector<long long> simulationArgs;
+thread_local std::vector<TraceDelta> simulationDeltas;
+thread_local std::vector<std::pair<std::string, HeapObject>> simulationHeapWrites;
+thread_local std::vector<TraceKeyframe> simulationKeyframes;
+thread_local std::vector<uint64_t> simulationStateHashes;
+
+namespace {
+
+const SimulationProgram* activeProgram = nullptr;
+thread_local size_t keyframeStackWords = 0; // Para getSimulationTraceBytes()
+thread_local const SimulationReplay* activeReplay = nullptr;
+thread_local size_t windowStart = 0;     // Índice global de simulationHistory[0]
+thread_local size_t traceGeneration = 0; // Invalida los SimulationState al vaciar la traza
+
+// Variable local con la dirección tomada (bindStackSlotAddress); las de los marcos más internos, al final
+struct BoundStackSlot {
+    const void* address;
+    size_t depth;
+    int slot;
+};
+std::vector<BoundStackSlot> boundStackSlots;
+
+// Se llama al registrar el primer paso de cada intervalo, con el estado ya actualizado
+void captureKeyframe(const std::vector<StackFrame>& frames, const HeapObjectMap& heap, size_t deltaPosition) {
+    TraceKeyframe& keyframe = simulationKeyframes.emplace_back();
+    keyframe.deltaPosition = static_cast<uint32_t>(deltaPosition);
+    packStackFrames(frames, keyframe.stack);
+    keyframe.heap = heap; // Copia profunda, solo en los keyframes
+    keyframeStackWords += keyframe.stack.size() + 2 * keyframe.heap.size();
+}
+
+void applyDelta(const TraceDelta& delta, std::vector<StackFrame>& frames, HeapObjectMap& heap) {
+    switch (delta.kind) {
+        case DELTA_PUSH_FRAME: {
+            StackFrame& frame = frames.emplace_back();
+            frame.layout = delta.layout;
+            frame.live.reset();
+            break;
+        }
+        case DELTA_POP_FRAME:
+            if (!frames.empty()) {
+                frames.pop_back();
+            }
+            break;
+        case DELTA_SLOT_WRITE:
+            if (delta.frame < frames.size()) {
+                StackFrame& frame = frames[frames.size() - 1 - delta.frame];
+                frame.slots[delta.slot] = delta.value;
+                frame.live.set(delta.slot);
+            }
+            break;
+        case DELTA_HEAP_WRITE: {
+            const auto& write = simulationHeapWrites[static_cast<size_t>(delta.value)];
+            heap[write.first] = write.second;
+            break;
+        }
+    }
+}
+
+const size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+char outputBuffer[OUTPUT_BUFFER_SIZE];
+size_t outputLength = 0;
+std::string* outputCapture = nullptr;
+
+void emitOutput(const char* data, size_t length) {
+    if (outputCapture) {
+        outputCapture->append(data, length);
+        return;
+    }
+    std::fwrite(data, 1, length, stdout);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+void packStackFrames(const std::vector<StackFrame>& frames, std::vector<long long>& packed) {
+    // Solo se copian los slots que usa cada función, no la capacidad fija del marco
+    size_t packedSize = 0;
+    for (const StackFrame& frame : frames) {
+        packedSize += 2 + getFrameLayout(frame.layout).slotCount;
+    }
+    packed.reserve(packedSize);
+    for (const StackFrame& frame : frames) {
+        const int slotCount = getFrameLayout(frame.layout).slotCount;
+        packed.push_back(frame.layout);
+        packed.push_back(static_cast<long long>(frame.live.to_ulong()));
+        packed.insert(packed.end(), frame.slots, frame.slots + slotCount);
+    }
+}
+
+void unpackStackFrames(const std::vector<long long>& packed, std::vector<StackFrame>& frames) {
+    frames.clear();
+    size_t position = 0;
+    while (position + 2 <= packed.size()) {
+        StackFrame& frame = frames.emplace_back();
+        frame.layout = static_cast<unsigned short>(packed[position++]);
+        frame.live = std::bitset<SIM_MAX_FRAME_SLOTS>(static_cast<unsigned long long>(packed[position++]));
+        const int slotCount = getFrameLayout(frame.layout).slotCount;
+        std::copy(packed.begin() + position, packed.begin() + position + slotCount, frame.slots);
+        position += slotCount;
+    }
+}
+
+void attachSimulationProgram(const SimulationProgram& program) {
+    activeProgram = &program;
+    buildSimulationHashKeys(program);
+}
+
+const SimulationProgram& getActiveSimulationProgram() {
+    return *activeProgram;
+}
+
+void runSimulationProgram(const SimulationProgram& program) {
+    beginSimulationRun(program);
+    runWithinExecutionLimits(program.run); // Un límite la detiene tras registrar el paso final
+    finishSimulationRun();
+}
+
+void beginSimulationRun(const SimulationProgram& program) {
+    activeProgram = &program;
+    activeReplay = nullptr;
+    windowStart = 0;
+    clearSimulationTrace();
+    currentStackFrames.clear();
+    boundStackSlots.clear();
+    currentHeapObjects.clear();
+    resetSimulationHeap();
+    buildSimulationHashKeys(program);
+    resetSimulationStateHash(currentStackFrames, currentHeapObjects, 0);
+    beginSimulationTraceSegments();
+    beginSimulationChangeIndex();
+}
+
+void finishSimulationRun() {
+    flushOutput(); // La simulación puede terminar con un return antes de 'Program Ended'
+    finishSimulationTraceSegments();
+    finishSimulationChangeIndex();
+}
+
+const StepDescriptor& getStepDescriptor(int id) {
+    return activeProgram->stepDescriptors[id];
+}
+
+const FrameLayout& getFrameLayout(int id) {
+    return activeProgram->frameLayouts[id];
+}
+
+int runSimulationBenchmark(const SimulationProgram& program) {
+    runSimulationProgram(program);
+    std::fprintf(stderr, "steps: %zu\n", getSimulationStepCount());
+    return 0;
+}
+
+int runSimulationCommand(const SimulationProgram& program, int argc, char** argv) {
+    std::string tracePath;
+    std::string streamName;
+    SimStreamBackpressure backpressure = SIM_STREAM_BLOCK;
+    bool headless = false;
+    SimHeadlessFormat format = SIM_HEADLESS_NDJSON;
+    bool formatGiven = false;
+    std::string outputPath;
+    bool valid = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.rfind("--stream=", 0) == 0 && arg.size() > 9) {
+            streamName = arg.substr(9);
+        } else if (arg == "--backpressure=block") {
+            backpressure = SIM_STREAM_BLOCK;
+        } else if (arg == "--backpressure=drop") {
+            backpressure = SIM_STREAM_DROP;
+        } else if (arg == "--backpressure=sample") {
+            backpressure = SIM_STREAM_SAMPLE;
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--format=ndjson") {
+            format = SIM_HEADLESS_NDJSON;
+            formatGiven = true;
+        } else if (arg == "--format=binary") {
+            format = SIM_HEADLESS_BINARY;
+            formatGiven = true;
+        } else if (arg == "--format=chrome") {
+            format = SIM_HEADLESS_CHROME;
+            formatGiven = true;
+        } else if (arg.rfind("--output=", 0) == 0 && arg.size() > 9) {
+            outputPath = arg.substr(9);
+        } else if (arg[0] != '-' && tracePath.empty()) {
+            tracePath = arg;
+        } else {
+            valid = false;
+        }
+    }
+    const int modes = !tracePath.empty() + !streamName.empty() + headless;
+    if (!valid || modes != 1 || ((formatGiven || !outputPath.empty()) && !headless)) {
+        std::fprintf(stderr,
+                     "Usage: %s [<trace.simtrace> | --stream=<name> [--backpressure=block|drop|sample] |"
+                     " --headless [--format=ndjson|binary|chrome] [--output=<file>]]\n",
+                     argv[0]);
+        return 2;
+    }
+    if (headless) {
+        return runSimulationHeadless(program, format, outputPath.empty() ? "-" : outputPath);
+    }
+    if (!streamName.empty()) {
+        return runSimulationStreamer(program, streamName, backpressure);
+    }
+    return runSimulationRecorder(program, tracePath);
+}
+
+void recordStepValues(int descriptorId, const long long* values, int count) {
+    indexSimulationStepDeltas(); // Antes de que sellar un tramo vacíe los deltas
+    publishSimulationStepsIfDue();
+    if (simulationHistory.size() % SIM_KEYFRAME_INTERVAL == 0) {
+        if (simulationTraceSegmentFull()) {
+            sealSimulationTraceSegment();
+        }
+        captureKeyframe(currentStackFrames, currentHeapObjects, simulationDeltas.size());
+    }
+    ++simulationRecordedSteps;
+    recordSimulationStateHash();
+    SimulationStep& step = simulationHistory.emplace_back();
+    step.descriptor = static_cast<unsigned short>(descriptorId);
+    step.argCount = static_cast<unsigned char>(count);
+    step.argOffset = static_cast<uint32_t>(simulationArgs.size());
+    step.deltaEnd = static_cast<uint32_t>(simulationDeltas.size());
+    simulationArgs.insert(simulationArgs.end(), values, values + count);
+}
+
+size_t getSimulationTraceBytes() {
+    return simulationHistory.size() * sizeof(SimulationStep) + simulationArgs.size() * sizeof(long long) +
+           simulationDeltas.size() * sizeof(TraceDelta) + keyframeStackWords * sizeof(long long) +
+           simulationStateHashes.size() * sizeof(uint64_t);
+}
+
+// Formatea la descripción de un paso a partir de su plantilla; solo se llama al mostrarlo
+std::string formatStepDescription(const SimulationStep& step) {
+    const StepDescriptor& descriptor = getStepDescriptor(step.descriptor);
+    std::string text;
+    int argIndex = 0;
+    for (const char* c = descriptor.format; *c; ++c) {
+        if (*c != '%' || c[1] == '\0') {
+            text += *c;
+            continue;
+        }
+        ++c;
+        if (*c == '%') {
+            text += '%';
+            continue;
+        }
+        long long value = argIndex < step.argCount ? simulationArgs[step.argOffset + argIndex] : 0;
+        argIndex++;
+        if (*c == 'd') {
+            text += std::to_string(value);
+        } else if (*c == 'p') {
+            text += formatPointer(reinterpret_cast<const void*>(static_cast<std::intptr_t>(value)));
+        } else if (*c == 's') {
+            const char* str = reinterpret_cast<const char*>(static_cast<std::intptr_t>(value));
+            text += str ? str : "(null)";
+        }
+    }
+    return text;
+}
+
+void seekSimulationState(SimulationState& state, size_t stepIndex) {
+    if (stepIndex >= simulationHistory.size()) {
+        return;
+    }
+    // Hacia delante, dentro del intervalo de un keyframe, basta con aplicar los deltas pendientes;
+    // en cualquier otro caso se parte del keyframe del paso (como mucho SIM_KEYFRAME_INTERVAL pasos)
+    const size_t keyframeIndex = stepIndex / SIM_KEYFRAME_INTERVAL;
+    const bool forward = state.step != SIZE_MAX && state.step <= stepIndex &&
+                         (state.step / SIM_KEYFRAME_INTERVAL == keyframeIndex || stepIndex - state.step <= SIM_KEYFRAME_INTERVAL);
+    if (!forward) {
+        const TraceKeyframe& keyframe = simulationKeyframes[keyframeIndex];
+        unpackStackFrames(keyframe.stack, state.frames);
+        state.heap = keyframe.heap;
+        state.deltaPosition = keyframe.deltaPosition;
+    }
+    const size_t deltaEnd = simulationHistory[stepIndex].deltaEnd;
+    for (; state.deltaPosition < deltaEnd; ++state.deltaPosition) {
+        applyDelta(simulationDeltas[state.deltaPosition], state.frames, state.heap);
+    }
+    state.step = stepIndex;
+}
+
+void clearSimulationTrace() {
+    simulationHistory.clear();
+    simulationArgs.clear();
+    simulationDeltas.clear();
+    simulationHeapWrites.clear();
+    simulationKeyframes.clear();
+    simulationStateHashes.clear();
+    keyframeStackWords = 0;
+    traceGeneration++;
+    resetSimulationChangeIndexCursor();
+}
+
+void setSimulationReplay(const SimulationReplay* replay) {
+    activeReplay = replay;
+}
+
+size_t getSimulationWindowStart() {
+    return windowStart;
+}
+
+size_t getSimulationStepCount() {
+    return activeReplay ? activeReplay->stepCount : windowStart + simulationHistory.size();
+}
+
+size_t getSimulationFirstStep() {
+    return activeReplay ? activeReplay->firstStep : windowStart;
+}
+
+// Sin ventanas, windowStart solo avanza aquí: los pasos descartados ya no se pueden mostrar
+void discardSimulationStepsBefore(size_t stepIndex) {
+    if (activeReplay || stepIndex <= windowStart) {
+        return;
+    }
+    if (simulationKeyframes.empty()) {
+        return;
+    }
+    const size_t keyframes = std::min((stepIndex - windowStart) / SIM_KEYFRAME_INTERVAL, simulationKeyframes.size() - 1);
+    if (keyframes == 0) {
+        return;
+    }
+    // El keyframe del nuevo primer paso tiene el estado completo: los deltas anteriores sobran
+    const size_t steps = keyframes * SIM_KEYFRAME_INTERVAL;
+    const uint32_t deltaBase = simulationKeyframes[keyframes].deltaPosition;
+    const uint32_t argBase = simulationHistory[steps].argOffset;
+    for (size_t i = 0; i < keyframes; ++i) {
+        keyframeStackWords -= simulationKeyframes[i].stack.size() + 2 * simulationKeyframes[i].heap.size();
+    }
+    simulationKeyframes.erase(simulationKeyframes.begin(), simulationKeyframes.begin() + keyframes);
+    for (TraceKeyframe& keyframe : simulationKeyframes) {
+        keyframe.deltaPosition -= deltaBase;
+    }
+    simulationHistory.erase(simulationHistory.begin(), simulationHistory.begin() + steps);
+    for (SimulationStep& step : simulationHistory) {
+        step.argOffset -= argBase;
+        step.deltaEnd -= deltaBase;
+    }
+    simulationArgs.erase(simulationArgs.begin(), simulationArgs.begin() + argBase);
+    simulationStateHashes.erase(simulationStateHashes.begin(), simulationStateHashes.begin() + steps);
+    simulationDeltas.erase(simulationDeltas.begin(), simulationDeltas.begin() + deltaBase);
+    // Las escrituras del heap se añaden en orden: las anteriores a la primera que queda ya están en los keyframes
+    size_t heapBase = simulationHeapWrites.size();
+    for (const TraceDelta& delta : simulationDeltas) {
+        if (delta.kind == DELTA_HEAP_WRITE) {
+            heapBase = static_cast<size_t>(delta.value);
+            break;
+        }
+    }
+    simulationHeapWrites.erase(simulationHeapWrites.begin(), simulationHeapWrites.begin() + heapBase);
+    for (TraceDelta& delta : simulationDeltas) {
+        if (delta.kind == DELTA_HEAP_WRITE) {
+            delta.value -= static_cast<long long>(heapBase);
+        }
+    }
+    windowStart += steps;
+    traceGeneration++;
+}
+
+const SimulationStep& loadSimulationStep(SimulationState& state, size_t stepIndex) {
+    if (activeReplay && (stepIndex < windowStart || stepIndex - windowStart >= simulationHistory.size())) {
+        windowStart = activeReplay->loadWindow(stepIndex);
+    }
+    if (state.trace != traceGeneration) {
+        state.step = SIZE_MAX;
+        state.trace = traceGeneration;
+    }
+    const size_t localIndex = stepIndex - windowStart;
+    seekSimulationState(state, localIndex);
+    return simulationHistory[localIndex];
+}
+
+void saveRecordingState(TraceKeyframe& checkpoint) {
+    checkpoint.stack.clear();
+    packStackFrames(currentStackFrames, checkpoint.stack);
+    checkpoint.heap = currentHeapObjects;
+    checkpoint.traceHash = getSimulationTraceHash();
+}
+
+void restoreRecordingState(const TraceKeyframe& checkpoint) {
+    clearSimulationTrace();
+    unpackStackFrames(checkpoint.stack, currentStackFrames);
+    currentHeapObjects = checkpoint.heap;
+    resetSimulationStateHash(currentStackFrames, currentHeapObjects, checkpoint.traceHash);
+}
+
+// Copia la traza embebida y reconstruye los keyframes reproduciendo sus deltas
+void loadPrecomputedTrace(const PrecomputedTrace& trace) {
+    clearSimulationTrace();
+    simulationHistory.assign(trace.steps, trace.steps + trace.stepCount);
+    simulationArgs.assign(trace.args, trace.args + trace.argCount);
+    simulationDeltas.assign(trace.deltas, trace.deltas + trace.deltaCount);
+    for (size_t i = 0; i < trace.heapWriteCount; ++i) {
+        HeapObject object;
+        object.value = trace.heapWrites[i].value;
+        simulationHeapWrites.emplace_back(trace.heapWrites[i].address, object);
+    }
+
+    rebuildSimulationKeyframes(TraceKeyframe());
+    rehashLoadedSimulationTrace();
+    indexLoadedSimulationTrace();
+    writeOutput(trace.output, trace.outputLength);
+}
+
+void rebuildSimulationKeyframes(const TraceKeyframe& initial) {
+    simulationKeyframes.clear();
+    keyframeStackWords = 0;
+    std::vector<StackFrame> frames;
+    unpackStackFrames(initial.stack, frames);
+    HeapObjectMap heap = initial.heap;
+    size_t deltaPosition = 0;
+    for (size_t step = 0; step < simulationHistory.size(); step += SIM_KEYFRAME_INTERVAL) {
+        for (; deltaPosition < simulationHistory[step].deltaEnd; ++deltaPosition) {
+            applyDelta(simulationDeltas[deltaPosition], frames, heap);
+        }
+        captureKeyframe(frames, heap, deltaPosition);
+    }
+}
+
+void pushStackFrame(int layout) {
+    hashPushedStackFrame(currentStackFrames.size(), layout);
+    StackFrame& frame = currentStackFrames.emplace_back();
+    frame.layout = static_cast<unsigned short>(layout);
+    simulationDeltas.push_back({DELTA_PUSH_FRAME, 0, static_cast<unsigned short>(layout), 0, 0});
+}
+
+void popStackFrame() {
+    if (!currentStackFrames.empty()) {
+        hashPoppedStackFrame(currentStackFrames.size() - 1, currentStackFrames.back());
+        currentStackFrames.pop_back();
+        simulationDeltas.push_back({DELTA_POP_FRAME, 0, 0, 0, 0});
+        while (!boundStackSlots.empty() && boundStackSlots.back().depth >= currentStackFrames.size()) {
+            boundStackSlots.pop_back();
+        }
+    }
+}
+
+void bindStackSlotAddress(int slot, const void* address) {
+    if (currentStackFrames.empty()) {
+        return;
+    }
+    // Una declaración dentro de un bucle se repite con la misma dirección: no se acumula
+    const size_t depth = currentStackFrames.size() - 1;
+    for (auto it = boundStackSlots.rbegin(); it != boundStackSlots.rend() && it->depth == depth; ++it) {
+        if (it->address == address) {
+            it->slot = slot;
+            return;
+        }
+    }
+    boundStackSlots.push_back({address, depth, slot});
+}
+
+bool updateStackSlotAtAddress(const void* address) {
+    for (auto it = boundStackSlots.rbegin(); it != boundStackSlots.rend(); ++it) {
+        if (it->address != address) {
+            continue;
+        }
+        // Como updateStackFrame, pero en el marco de la variable, que puede no ser el último
+        StackFrame& frame = currentStackFrames[it->depth];
+        const long long value = *static_cast<const int*>(address);
+        const SlotHashKey& key = simulationHashKeys[frame.layout].slots[it->slot];
+        if (frame.live.test(it->slot)) {
+            simulationStateHash -= slotStateHash(it->depth, key, frame.slots[it->slot]);
+        }
+        simulationStateHash += slotStateHash(it->depth, key, value);
+        frame.slots[it->slot] = value;
+        frame.live.set(it->slot);
+        const unsigned short frameOffset = static_cast<unsigned short>(currentStackFrames.size() - 1 - it->depth);
+        simulationDeltas.push_back({DELTA_SLOT_WRITE, static_cast<unsigned char>(it->slot), 0, frameOffset, value});
+        return true;
+    }
+    return false;
+}
+
+void updateHeapObject(const std::string& address, const HeapObject& object) {
+    auto previous = currentHeapObjects.find(address);
+    hashHeapWrite(address, previous == currentHeapObjects.end() ? nullptr : &previous->second.value, object.value);
+    currentHeapObjects[address] = object;
+    ++simulationStoreVersion;
+    simulationDeltas.push_back({DELTA_HEAP_WRITE, 0, 0, 0, static_cast<long long>(simulationHeapWrites.size())});
+    simulationHeapWrites.emplace_back(address, object);
+}
+
+std::string formatSlotValue(SlotType type, long long value) {
+    if (type == SLOT_POINTER) {
+        return formatPointer(reinterpret_cast<const void*>(static_cast<std::intptr_t>(value)));
+    }
+    return std::to_string(value);
+}
+
+std::string formatPointer(const void* value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+// --- Salida bufferizada de printf ---
+
+void flushOutput() {
+    if (outputLength > 0) {
+        emitOutput(outputBuffer, outputLength);
+        outputLength = 0;
+    }
+}
+
+void setOutputCapture(std::string* capture) {
+    flushOutput();
+    outputCapture = capture;
+}
+
+void writeOutput(const char* data, size_t length) {
+    if (outputLength + length > OUTPUT_BUFFER_SIZE) {
+        flushOutput();
+        if (length > OUTPUT_BUFFER_SIZE) { // Demasiado grande para el buffer: escribir directamente
+            emitOutput(data, length);
+            return;
+        }
+    }
+    std::copy(data, data + length, outputBuffer + outputLength);
+    outputLength += length;
+}
+
+void writeOutputInt(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    writeOutput(digits, result.ptr - digits);
+}
+
+void writeOutputString(const char* value) {
+    writeOutput(value, std::char_traits<char>::length(value));
+}
+
+void writeOutputPointer(const void* value) {
+    char digits[2 + 2 * sizeof(void*)] = {'0', 'x'};
+    auto result = std::to_chars(digits + 2, digits + sizeof(digits), reinterpret_cast<std::uintptr_t>(value), 16);
+    writeOutput(digits, result.ptr - digits);
+}
@@ -0,0 +1,562 @@
+// src/runtime/SimulationRuntime.h
+#ifndef SIMULATIONRUNTIME_H
+#define SIMULATIONRUNTIME_H
+
+// Runtime de la simulación enlazado por los programas generados (output_sfml.cpp, output_trace.cpp).
+// El programa generado solo aporta sus tablas estáticas y run_c_program_simulation();
+// el registro de pasos vive en sim_runtime y el visor SFML en sim_viewer.
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "SimulationLimits.h"
+
+// --- Descriptores estáticos de pasos (la tabla se genera en tiempo de compilación) ---
+enum StepKind : unsigned char { STEP_PROGRAM, STEP_DECLARATION, STEP_ASSIGNMENT, STEP_CONDITION, STEP_LOOP, STEP_CALL, STEP_RETURN, STEP_PRINT };
+enum StepColor : unsigned char { STEP_COLOR_DEFAULT, STEP_COLOR_HIGHLIGHT, STEP_COLOR_VARIABLE_DECL, STEP_COLOR_ASSIGNMENT, STEP_COLOR_FUNCTION_CALL, STEP_COLOR_RETURN, STEP_COLOR_PRINT };
+
+struct StepDescriptor {
+    StepKind kind;
+    int line;           // Línea en el fuente C (0 si se desconoce)
+    const char* format; // Plantilla con %d, %p, %s y %%; se formatea solo al mostrar el paso
+    StepColor color;
+};
+
+// --- Marcos de pila por índice de slot (el diseño de cada función se fija en tiempo de compilación) ---
+enum SlotType : unsigned char { SLOT_INT, SLOT_POINTER };
+
+struct FrameSlotInfo {
+    const char* name;
+    SlotType type;
+};
+
+struct FrameLayout {
+    const char* functionName;
+    const FrameSlotInfo* slots;
+    int slotCount;
+};
+
+// Marco en ejecución con capacidad fija; en los keyframes se guarda empaquetado
+struct StackFrame {
+    unsigned short layout;                 // Índice en la tabla de layouts del programa
+    std::bitset<SIM_MAX_FRAME_SLOTS> live; // Slots ya declarados/escritos
+    long long slots[SIM_MAX_FRAME_SLOTS];  // Enteros o punteros, según FrameSlotInfo::type
+};
+
+// --- Traza: pasos, cambios de estado (deltas) y keyframes periódicos ---
+// Un paso no copia la pila ni el heap: guarda hasta dónde llega la lista de deltas en el momento
+// de registrarlo. El estado de un paso se reconstruye desde el keyframe anterior más cercano.
+constexpr size_t SIM_KEYFRAME_INTERVAL = 64; // Pasos entre keyframes: coste máximo de un salto
+
+enum TraceDeltaKind : unsigned char { DELTA_PUSH_FRAME, DELTA_POP_FRAME, DELTA_SLOT_WRITE, DELTA_HEAP_WRITE };
+
+struct TraceDelta {
+    TraceDeltaKind kind;
+    unsigned char slot;    // DELTA_SLOT_WRITE
+    unsigned short layout; // DELTA_PUSH_FRAME
+    unsigned short frame;  // DELTA_SLOT_WRITE: marcos por debajo del último (0: el marco en curso; otro: '*p = v' sobre una variable de quien llama)
+    long long value;       // DELTA_SLOT_WRITE: valor; DELTA_HEAP_WRITE: índice en simulationHeapWrites
+};
+
+struct SimulationStep {
+    unsigned short descriptor; // Índice en la tabla de descriptores del programa
+    unsigned char argCount;
+    uint32_t argOffset;        // Sus valores (enteros o punteros) en simulationArgs
+    uint32_t deltaEnd;         // Deltas [0, deltaEnd) aplicados al registrar el paso
+};
+
+// Objeto del heap en la traza, por dirección. 'value' es solo el texto que se muestra; un bloque del heap
+// simulado (malloc) lleva además su estado y sus tamaños en campos propios, de los que salen las
+// estadísticas y el color del visor.
+enum HeapObjectKind : unsigned char { HEAP_VALUE, HEAP_BLOCK_LIVE, HEAP_BLOCK_FREED };
+
+struct HeapObject {
+    std::string value;
+    HeapObjectKind kind = HEAP_VALUE; // HEAP_VALUE: sin bloque del heap simulado (trazas precalculadas)
+    uint32_t handle = 0;    // Índice del bloque en la tabla del asignador
+    uint64_t requested = 0; // Bytes pedidos en el último malloc del bloque
+    uint64_t size = 0;      // Bytes del bloque (su clase de tamaño o sus páginas)
+
+    bool operator==(const HeapObject& other) const {
+        return value == other.value && kind == other.kind && handle == other.handle && requested == other.requested && size == other.size;
+    }
+    bool operator!=(const HeapObject& other) const { return !(*this == other); }
+};
+
+using HeapObjectMap = std::map<std::string, HeapObject>;
+
+// Estado completo en el paso de un keyframe
+struct TraceKeyframe {
+    uint32_t deltaPosition;
+    // Pila empaquetada: por cada marco [layout, máscara de slots vivos, valores de sus slotCount slots]
+    std::vector<long long> stack;
+    HeapObjectMap heap;
+    uint64_t traceHash = 0; // Checkpoints de la VM: hash encadenado del último paso registrado
+};
+
+// Estado reconstruido de un paso (lo mantienen el visor y la exportación mientras recorren la traza)
+struct SimulationState {
+    std::vector<StackFrame> frames;
+    HeapObjectMap heap;
+    size_t step = SIZE_MAX; // Paso reconstruido (SIZE_MAX: ninguno todavía)
+    size_t deltaPosition = 0;
+    size_t trace = SIZE_MAX; // Traza a la que se refiere 'step' (cambia al vaciarla o al cargar otra ventana)
+};
+
+// --- Traza por checkpoints (opción --checkpoint-interval de la VM) ---
+// Solo hay en memoria una ventana de pasos. Al pedir un paso de fuera, loadWindow vuelve a ejecutar
+// el programa desde el checkpoint anterior a él y deja la ventana en simulationHistory.
+struct SimulationReplay {
+    size_t stepCount;                       // Pasos de la ejecución completa
+    size_t (*loadWindow)(size_t stepIndex); // Devuelve el índice global del primer paso de la ventana
+    size_t firstStep = 0;                   // Primer paso que se puede mostrar (el visor del flujo descarta los antiguos)
+};
+
+// Tablas y punto de entrada de un programa generado
+struct SimulationProgram {
+    const StepDescriptor* stepDescriptors;
+    int stepDescriptorCount;
+    const FrameLayout* frameLayouts;
+    int frameLayoutCount;
+    void (*run)(); // run_c_program_simulation
+};
+
+// Estado global de la simulación (usado durante el registro)
+extern std::vector<StackFrame> currentStackFrames;
+extern HeapObjectMap currentHeapObjects;
+// La traza en memoria es de cada hilo: con el registro en segundo plano, el visor muestra los bloques ya
+// publicados mientras el hilo del programa sigue llenando la suya
+extern thread_local std::vector<SimulationStep> simulationHistory;
+extern thread_local std::vector<long long> simulationArgs;
+extern thread_local std::vector<TraceDelta> simulationDeltas;
+extern thread_local std::vector<std::pair<std::string, HeapObject>> simulationHeapWrites; // (dirección, objeto)
+extern thread_local std::vector<TraceKeyframe> simulationKeyframes; // Uno cada SIM_KEYFRAME_INTERVAL pasos
+extern thread_local std::vector<uint64_t> simulationStateHashes; // Hash encadenado de cada paso, paralelo a simulationHistory
+
+// Registra las tablas del programa y lo ejecuta, llenando simulationHistory
+void runSimulationProgram(const SimulationProgram& program);
+// runSimulationProgram por partes, para quien ejecuta el programa por su cuenta (modo --lazy)
+void beginSimulationRun(const SimulationProgram& program);
+void finishSimulationRun();
+void attachSimulationProgram(const SimulationProgram& program); // Solo registra las tablas (trazas cargadas de archivo)
+const SimulationProgram& getActiveSimulationProgram();
+const StepDescriptor& getStepDescriptor(int id);
+const FrameLayout& getFrameLayout(int id);
+
+// Puntos de entrada para el main generado
+int runSimulationBenchmark(const SimulationProgram& program); // sim_runtime: solo registra (sin ventana)
+// sim_runtime: con argumentos, sin ventana: 'traza.simtrace' la graba, '--stream=NOMBRE [--backpressure=...]' la
+// publica y '--headless [--format=...] [--output=...]' la escribe
+int runSimulationCommand(const SimulationProgram& program, int argc, char** argv);
+int runSimulationViewer(const SimulationProgram& program);    // sim_viewer: registra y abre el visor SFML
+// sim_runtime (TraceExport.cpp): registra y escribe <outputBase>.json y <outputBase>.js para el visor HTML
+int runSimulationTraceExport(const SimulationProgram& program, const std::string& outputBase);
+std::string formatSimulationTraceJson();
+
+// Variantes sobre una simulación ya registrada (la VM de --vm ejecuta el programa por su cuenta)
+int showSimulationViewer();                          // sim_viewer
+int writeSimulationTrace(const std::string& outputBase); // sim_runtime
+
+// --- Archivo binario de la traza (.simtrace, TraceFile.cpp en sim_runtime) ---
+// Cabecera versionada, tablas de descriptores y layouts, tabla de cadenas, índice de bloques y los
+// bloques de pasos. Cada bloque empieza con el estado completo, así que se decodifica por separado y
+// puede ir comprimido. Se graba sin ventana (en un nodo sin pantalla) y el visor lo proyecta en memoria
+// con mmap: solo decodifica el bloque del paso que muestra, sin volver a ejecutar el programa.
+// La versión 2 añade a cada bloque el hash encadenado del estado de sus pasos; la 3, el estado y los
+// tamaños de los bloques del heap simulado en cada objeto del heap; la 4, el marco de cada escritura de un slot
+// (las de '*p = v' pueden ir a un marco anterior al último).
+const uint32_t SIM_TRACE_FILE_VERSION = 4;
+int writeSimulationTraceFile(const std::string& path, bool compress = true);
+int runSimulationRecorder(const SimulationProgram& program, const std::string& path); // Registra y graba el archivo
+bool openSimulationTraceFile(const std::string& path); // La traza del archivo sustituye a la registrada
+int runSimulationTraceFileViewer(const std::string& path); // sim_viewer
+// sim_trace_diff: primer paso en que difieren los estados de dos trazas grabadas y sus variables distintas.
+// Busca por bisección en los hashes de los pasos. 0 si coinciden, 1 si difieren, 2 si no se pudieron leer.
+int runSimulationTraceDiff(const std::string& firstPath, const std::string& secondPath);
+
+// --- Salida sin ventana (--headless, TraceExport.cpp en sim_runtime) ---
+// Para agentes de CI sin pantalla: registra el programa y escribe la traza en un archivo o en la salida
+// estándar ("-"; la salida del programa pasa entonces a la de errores) en escrituras grandes y secuenciales.
+// NDJSON: un objeto por línea y por paso, con su índice ("step") y los campos de los pasos del visor HTML.
+// Binario: la firma "SIMSTRM2" y los registros del flujo en vivo (tablas del programa, bloques de hasta
+// 4096 pasos sin comprimir y total de pasos). Chrome: formato Trace Event (chrome://tracing, Perfetto),
+// con un instante por paso, un tramo por llamada y un contador por variable entera. Compilado con
+// -DSIMULATION_HEADLESS, el main generado no llama al visor y el programa se enlaza solo con sim_runtime.
+enum SimHeadlessFormat : unsigned char { SIM_HEADLESS_NDJSON, SIM_HEADLESS_BINARY, SIM_HEADLESS_CHROME };
+int runSimulationHeadless(const SimulationProgram& program, SimHeadlessFormat format, const std::string& path);
+
+// --- Presupuesto de memoria del registro (TraceBudget.cpp en sim_runtime) ---
+// Un bucle sin fin no debe agotar la memoria. Con presupuesto, la traza en memoria se sella por tramos
+// (bloques como los del .simtrace): los recientes quedan en un anillo en memoria y los antiguos se
+// vuelcan a un archivo temporal desde un hilo de fondo o se descartan, según 'overflow'. Al terminar
+// el programa, el visor y la exportación recorren los tramos como ventanas de la traza.
+void setSimulationTraceBudget(size_t maxBytes, SimTraceOverflow overflow); // 0: sin límite
+size_t getSimulationTraceBudget();
+size_t getSimulationDroppedSteps();
+// Los llama runSimulationProgram alrededor de program.run() y recordStepValues en cada keyframe
+void beginSimulationTraceSegments();
+bool simulationTraceSegmentFull();
+void sealSimulationTraceSegment(); // Vacía la traza en memoria
+void finishSimulationTraceSegments();
+
+// --- Límites de ejecución (ExecutionLimits.cpp en sim_runtime) ---
+// run_c_program_simulation() termina antes de abrir la ventana, así que un bucle sin fin la dejaría
+// colgada. Con límites, el código generado los comprueba en la entrada a cada función y en el salto
+// de vuelta de cada for; al superarse, registra un paso final con el motivo y la línea y abandona el
+// programa. Lo registrado hasta ese paso se puede ver como cualquier otra traza.
+struct SimulationExecutionLimits {
+    size_t maxSteps;    // 0: sin límite
+    unsigned maxMillis; // 0: sin límite
+    bool detectLoops;   // Estado del marco repetido en el salto de vuelta de un for
+    int stopDescriptors[SIM_STOP_REASON_COUNT]; // Paso final de cada motivo; su plantilla recibe la línea (%d)
+};
+
+void setSimulationExecutionLimits(const SimulationExecutionLimits& limits);
+// Ejecuta el programa; false si un límite lo detuvo (el paso final ya está registrado)
+bool runWithinExecutionLimits(void (*run)());
+void resetExecutionLimits(); // Contadores y reloj a cero (runWithinExecutionLimits ya lo hace)
+// Modo --lazy: ejecuta un tramo del programa; false si terminó o un límite lo detuvo
+bool resumeWithinExecutionLimits(bool (*resume)());
+[[noreturn]] void stopSimulation(SimStopReason reason, int line);
+const char* simulationStopReasonText(SimStopReason reason); // "step budget exceeded"... (mensaje por stderr)
+[[noreturn]] void abandonSimulation(); // Sin paso final ni mensaje: el visor se cerró durante el registro
+void checkSimulationLimitsSlow(int line);
+
+extern size_t simulationRecordedSteps; // Pasos registrados en la ejecución (no se reinicia al sellar tramos)
+// Escrituras fuera del marco en curso: el heap simulado y todo '*p = v' (aunque vaya a una variable de
+// otro marco). Cualquier camino de escritura que no sea updateStackFrame debe incrementarla, porque la
+// detección de bucles solo compara el último marco y este contador.
+extern size_t simulationStoreVersion;
+extern size_t simulationStepLimit;     // SIZE_MAX: sin límite
+extern unsigned simulationClockCountdown; // Comprobaciones hasta la próxima lectura del reloj
+extern bool simulationDetectLoops;
+
+inline void checkSimulationLimits(int line) {
+    if (simulationRecordedSteps >= simulationStepLimit || --simulationClockCountdown == 0) {
+        checkSimulationLimitsSlow(line);
+    }
+}
+
+// Detección de ciclos de un for (algoritmo de Brent): guarda el estado en las iteraciones 1, 2, 4, 8...
+// y lo compara en cada salto de vuelta. Como el programa no lee entrada, volver al mismo estado (marco
+// de la función, profundidad de la pila y simulationStoreVersion, que cubre el resto) en el mismo punto
+// implica que el bucle no termina.
+class SimulationLoopGuard {
+public:
+    explicit SimulationLoopGuard(int line) : line(line) {}
+
+    void backEdge() {
+        checkSimulationLimits(line);
+        if (simulationDetectLoops && repeatsState()) {
+            stopSimulation(SIM_STOP_LOOP, line);
+        }
+    }
+
+    // Solo la comparación, sin los límites ni la excepción (la VM se detiene por su cuenta)
+    bool repeatsState() {
+        if (currentStackFrames.empty()) {
+            return false;
+        }
+        if (++iterations == nextSnapshot) {
+            takeSnapshot();
+            return false;
+        }
+        return matchesSnapshot();
+    }
+
+private:
+    void takeSnapshot();
+    bool matchesSnapshot() const;
+
+    int line;
+    size_t iterations = 0;
+    size_t nextSnapshot = 1;
+    size_t snapshotDepth = 0;
+    size_t snapshotStoreVersion = 0;
+    int snapshotSlotCount = 0;
+    StackFrame snapshot{};
+};
+
+// --- Registro en un hilo de fondo (BackgroundRecorder.cpp en sim_runtime) ---
+// runSimulationViewer no espera a que termine el programa: lo ejecuta en un hilo de fondo que publica
+// los pasos por bloques en una cola sin cerrojos (un productor, un consumidor). El visor recorre los
+// bloques recibidos como ventanas de la traza en cuanto existe el primer paso y muestra el progreso.
+// La traza en memoria (simulationHistory y demás) es de cada hilo: el programa registra en la suya y el
+// visor decodifica los bloques en la propia. El índice de cambios solo se consulta al terminar.
+struct SimulationProgress {
+    bool active;    // El programa sigue ejecutándose
+    size_t steps;   // Pasos registrados hasta ahora
+    double seconds; // Desde que empezó el registro
+    size_t droppedSteps; // Flujo en vivo: pasos que no llegaron al visor (anillo lleno)
+    size_t evictedSteps; // Flujo en vivo: primeros pasos recibidos que el visor ya no conserva
+};
+
+bool startSimulationRecording(const SimulationProgram& program); // false: con presupuesto, se registra antes de abrir el visor
+void publishSimulationStepsIfDue(); // recordStepValues: publica la traza en memoria cuando toca y la vacía
+bool pollSimulationRecording(SimulationProgress& progress); // Hilo del visor: recibe los bloques; false si no hay registro
+void stopSimulationRecording(); // Abandona el programa si sigue en marcha y espera al hilo
+
+// --- Flujo en vivo de la traza (--stream, TraceStream.cpp en sim_runtime; solo POSIX) ---
+// Con '--stream=NOMBRE', el programa generado no abre ventana: publica sus pasos por bloques (los del
+// registro en segundo plano, sin comprimir) en un anillo de memoria compartida (shm_open) que crea el
+// visor de larga duración sim_stream_viewer. Cada ejecución empieza con las tablas del programa y acaba
+// con su total de pasos, así que el mismo visor muestra una tras otra las ejecuciones de varios programas
+// (un anillo admite un programa a la vez; los demás esperan turno). Si el anillo se llena, la política de
+// contrapresión decide: esperar a que el visor haga sitio, descartar el bloque o, desde la mitad de
+// ocupación, publicar solo uno de cada pocos bloques. Cada bloque lleva el estado completo de su primer
+// paso, así que los descartes dejan huecos pero no corrompen los pasos recibidos. El visor conserva de cada
+// ejecución los bloques más recientes hasta SIM_STREAM_RUN_BYTES: los anteriores se descartan y quedan
+// como un hueco al principio de la ejecución.
+enum SimStreamBackpressure : unsigned char { SIM_STREAM_BLOCK, SIM_STREAM_DROP, SIM_STREAM_SAMPLE };
+const size_t SIM_STREAM_DEFAULT_RING_BYTES = size_t(16) << 20;
+const size_t SIM_STREAM_RUN_BYTES = size_t(32) << 20;
+
+int runSimulationStreamer(const SimulationProgram& program, const std::string& ringName, SimStreamBackpressure backpressure);
+int runSimulationStreamViewer(const std::string& ringName, size_t ringBytes); // sim_viewer
+bool openSimulationStream(const std::string& ringName, size_t ringBytes); // Crea el anillo y empieza a recibir en un hilo
+// Hilo del visor: recoge lo recibido y muestra la ejecución más reciente en cuanto empieza (runStarted).
+// 'progress' es el de la ejecución mostrada; false si no hay flujo abierto.
+bool pollSimulationStream(SimulationProgress& progress, bool& runStarted);
+bool showSimulationStreamRun(int offset, std::string& message); // Ejecución anterior (-1) o siguiente (+1) de las recibidas
+void closeSimulationStream(); // Deja de recibir y borra el anillo
+// sim_stream_check: consumidor de prueba sin SFML. Crea el anillo como sim_stream_viewer, lee los registros
+// sin decodificar los bloques y comprueba que el firstStep de cada bloque siga al anterior sin solaparse y que
+// los pasos recibidos y los descartados sumen el total de la ejecución. Informa de los pasos por segundo de
+// cada una. 0 si todo cuadra, 1 si no, 2 si no se pudo crear el anillo.
+struct SimStreamCheckOptions {
+    size_t ringBytes;
+    size_t runCount;      // Ejecuciones que espera antes de terminar (0: sin fin)
+    unsigned stallMillis; // Pausa al empezar cada ejecución, para que el programa llene el anillo
+    bool expectNoGaps;    // --backpressure=block: ningún bloque se descarta
+    bool expectGaps;      // drop y sample con la pausa: alguno se descarta
+};
+int runSimulationStreamCheck(const std::string& ringName, const SimStreamCheckOptions& options);
+
+// --- Ejecución paso a paso (--lazy, LazySimulation.cpp en sim_runtime) ---
+// run_c_program_simulation() es una corrutina (SimulationCoroutine.h, C++20) que se suspende tras
+// registrar cada paso. El visor la reanuda solo para registrar el paso siguiente al que muestra, así que
+// la ventana se abre sin ejecutar el programa. Para volver atrás se conservan los últimos 'window' pasos
+// (con sus keyframes); los anteriores se descartan, de modo que la memoria no crece con la ejecución.
+// No hay índice de cambios: abarcaría la ejecución entera.
+struct SimulationStepper {
+    void (*start)();   // Crea la corrutina sin ejecutar nada
+    bool (*resume)();  // Ejecuta hasta el próximo paso; false si el programa terminó
+    void (*destroy)(); // Destruye la corrutina aunque no haya terminado
+};
+
+int runLazySimulationViewer(const SimulationProgram& program, const SimulationStepper& stepper, size_t window); // sim_viewer
+void beginLazySimulation(const SimulationProgram& program, const SimulationStepper& stepper, size_t window);
+void advanceLazySimulation(size_t stepIndex); // Registra hasta el paso siguiente a stepIndex y descarta los que salen de la ventana
+bool isLazySimulationRunning();
+void stopLazySimulation(); // El visor se cerró: el programa no sigue
+size_t getSimulationFirstStep(); // Primer paso que se puede mostrar (0 salvo que se hayan descartado pasos)
+void discardSimulationStepsBefore(size_t stepIndex); // Redondea hacia abajo al keyframe anterior
+
+// --- Índice de cambios (TraceIndex.cpp en sim_runtime) ---
+// El registro guarda, para cada variable (llamada a función, slot) y cada dirección del heap, los pasos
+// en que cambió su valor, en orden: "¿cuándo cambió x?" es una búsqueda binaria, sin recorrer
+// simulationHistory. Crece con la ejecución, así que solo se construye cuando el visor muestra la traza
+// entera en memoria (lo pide antes de ejecutar el programa) y al cargar una traza precalculada. Con
+// --trace-budget, --checkpoint, --stream, --headless o al grabar un .simtrace no hay índice.
+const size_t SIM_NO_STEP = SIZE_MAX;
+void requestSimulationChangeIndex(); // Para la próxima ejecución (beginSimulationRun); no se reutiliza
+void beginSimulationChangeIndex();
+void indexSimulationStepDeltas(); // recordStepValues, antes de registrar cada paso
+void resetSimulationChangeIndexCursor(); // clearSimulationTrace
+void finishSimulationChangeIndex();
+void discardSimulationChangeIndex();
+void indexLoadedSimulationTrace(); // Traza completa ya en memoria
+bool hasSimulationChangeIndex();
+// La variable se identifica por la profundidad de su marco en el paso 'stepIndex' (posición en
+// SimulationState::frames) y su slot. SIM_NO_STEP si no hay cambio en esa dirección.
+size_t findNextVariableChange(size_t stepIndex, size_t frameDepth, int slot);
+size_t findPreviousVariableChange(size_t stepIndex, size_t frameDepth, int slot);
+size_t findNextHeapChange(size_t stepIndex, const std::string& address);
+size_t findPreviousHeapChange(size_t stepIndex, const std::string& address);
+// Primer paso desde 'stepIndex' en que se cumple una condición como 'x > 10' (<, <=, >, >=, ==, !=). 'x' es la
+// variable visible en el marco más interno de 'state'; solo se evalúa en los pasos en que cambia.
+size_t findConditionStep(size_t stepIndex, const SimulationState& state, const std::string& condition, std::string& error);
+
+// --- Registro de pasos ---
+void recordStepValues(int descriptorId, const long long* values, int count);
+std::string formatStepDescription(const SimulationStep& step);
+// Lleva 'state' al paso indicado: avanza aplicando deltas o parte del keyframe más cercano
+void seekSimulationState(SimulationState& state, size_t stepIndex);
+void clearSimulationTrace();
+
+// Recorrido de la ejecución completa, con o sin checkpoints: índices globales de paso
+void setSimulationReplay(const SimulationReplay* replay); // nullptr: la traza completa está en memoria
+size_t getSimulationStepCount();
+size_t getSimulationWindowStart(); // Índice global de simulationHistory[0]
+const SimulationStep& loadSimulationStep(SimulationState& state, size_t stepIndex); // También lleva 'state' al paso
+// Pila y heap en curso de un checkpoint; restaurarlos vacía la traza para registrar la nueva ventana
+void saveRecordingState(TraceKeyframe& checkpoint);
+void restoreRecordingState(const TraceKeyframe& checkpoint);
+// Pila empaquetada de los keyframes: por cada marco [layout, máscara de slots vivos, valores de sus slots]
+void packStackFrames(const std::vector<StackFrame>& frames, std::vector<long long>& packed);
+void unpackStackFrames(const std::vector<long long>& packed, std::vector<StackFrame>& frames);
+// Vuelve a calcular los keyframes de la traza en memoria a partir del estado anterior a su primer delta
+void rebuildSimulationKeyframes(const TraceKeyframe& initial);
+size_t getSimulationTraceBytes(); // Memoria aproximada de la traza registrada
+void pushStackFrame(int layout);
+void popStackFrame();
+std::string formatSlotValue(SlotType type, long long value);
+void updateHeapObject(const std::string& address, const HeapObject& object);
+std::string formatPointer(const void* value);
+
+// Cada sitio instrumentado registra solo (descriptor, valores); sin cadenas ni reservas de memoria
+inline long long stepArg(long long value) { return value; }
+inline long long stepArg(const void* value) { return static_cast<long long>(reinterpret_cast<std::intptr_t>(value)); }
+
+template <typename... Args>
+inline void recordStep(int descriptorId, Args... args) {
+    static_assert(sizeof...(Args) <= SIM_MAX_STEP_ARGS, "Demasiados argumentos para un paso");
+    const long long values[] = {stepArg(args)..., 0};
+    recordStepValues(descriptorId, values, static_cast<int>(sizeof...(Args)));
+}
+
+// --- Hash del estado (TraceHash.cpp en sim_runtime) ---
+// El hash del estado es una suma de un término por marco, por variable viva y por objeto del heap: cada
+// escritura resta el término del valor anterior y suma el del nuevo, sin recorrer el estado. Cada paso
+// registrado guarda ese hash encadenado con el del paso anterior, así que dos trazas con el mismo hash en
+// un paso coinciden en todos los anteriores y sim_trace_diff busca por bisección el primero que difiere.
+// Las variables se identifican por profundidad, función y nombre, no por slot, para poder comparar
+// programas distintos; de un puntero solo cuenta si es nulo, porque las direcciones cambian entre ejecuciones.
+struct SlotHashKey {
+    uint64_t key; // Función y nombre de la variable
+    bool pointer;
+};
+
+struct LayoutHashKeys {
+    uint64_t function;
+    std::vector<SlotHashKey> slots;
+};
+
+extern uint64_t simulationStateHash; // Hash del estado en curso (sin encadenar)
+extern std::vector<LayoutHashKeys> simulationHashKeys; // Por layout del programa activo
+
+void buildSimulationHashKeys(const SimulationProgram& program);
+// Parte del estado dado; traceHash es el hash encadenado del último paso (0 al empezar el programa)
+void resetSimulationStateHash(const std::vector<StackFrame>& frames, const HeapObjectMap& heap, uint64_t traceHash);
+uint64_t getSimulationTraceHash();
+void recordSimulationStateHash(); // recordStepValues, al registrar cada paso
+void hashPushedStackFrame(size_t depth, int layout);
+void hashPoppedStackFrame(size_t depth, const StackFrame& frame);
+void hashHeapWrite(const std::string& address, const std::string* previous, const std::string& value);
+void rehashLoadedSimulationTrace(); // Traza completa ya en memoria, sin hashes
+
+inline uint64_t mixStateHash(uint64_t x) {
+    // Finalizador de splitmix64: cada bit de la entrada afecta a todos los de la salida
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t slotStateHash(size_t depth, const SlotHashKey& key, long long value) {
+    const uint64_t hashedValue = key.pointer ? value != 0 : static_cast<uint64_t>(value);
+    return mixStateHash(key.key + depth * 0x9e3779b97f4a7c15ULL + mixStateHash(hashedValue));
+}
+
+// Escritura de una variable local por índice de slot: sin conversión a texto; solo añade un delta
+inline void updateStackFrame(int slot, long long value) {
+    if (currentStackFrames.empty()) return;
+    StackFrame& frame = currentStackFrames.back();
+    const SlotHashKey& key = simulationHashKeys[frame.layout].slots[slot];
+    const size_t depth = currentStackFrames.size() - 1;
+    if (frame.live.test(slot)) {
+        simulationStateHash -= slotStateHash(depth, key, frame.slots[slot]);
+    }
+    simulationStateHash += slotStateHash(depth, key, value);
+    frame.slots[slot] = value;
+    frame.live.set(slot);
+    simulationDeltas.push_back({DELTA_SLOT_WRITE, static_cast<unsigned char>(slot), 0, 0, value});
+}
+inline void updateStackFrame(int slot, const void* value) { updateStackFrame(slot, stepArg(value)); }
+
+// Variables locales cuya dirección toma el programa (&x). El código generado las registra al declararlas
+// y se olvidan al sacar su marco; con ellas, una escritura '*p = v' fuera del heap simulado se lleva al
+// slot de la variable, aunque sea de un marco anterior (simHeapStore).
+void bindStackSlotAddress(int slot, const void* address);
+bool updateStackSlotAtAddress(const void* address); // false si la dirección no es de una variable registrada
+
+// Empuja el marco de la función al entrar y lo saca en cualquier salida (incluido return)
+struct StackFrameScope {
+    explicit StackFrameScope(int layout) { pushStackFrame(layout); }
+    ~StackFrameScope() { popStackFrame(); }
+};
+
+// --- Heap simulado: malloc y free del programa C (SimulationHeap.cpp en sim_runtime) ---
+// Asignador por clases de tamaño sobre un arena propio: los bloques de hasta 2048 bytes se redondean a la
+// potencia de dos siguiente (desde 16) y se cortan de tramos de 64 KB de una sola clase; los mayores se
+// redondean a páginas de 4 KB y ocupan un tramo propio. Cada clase reutiliza primero sus bloques
+// liberados (lista LIFO) y los grandes se reutilizan por el mejor ajuste. El arena se reserva en una
+// dirección fija si el sistema la concede, así que las direcciones se repiten entre ejecuciones.
+// Cada bloque tiene un handle (su índice en la tabla de bloques) que se obtiene en O(1) de cualquier
+// dirección de su interior (página del arena -> tramo -> bloque); con él free detecta las dobles
+// liberaciones y las direcciones que no devolvió malloc, y al terminar el programa los bloques sin
+// liberar se registran como fugas.
+// En la traza, cada bloque usado es un objeto del heap con su dirección, su handle, su estado (en uso o
+// liberado) y sus bytes pedidos y reservados; su texto es "[12 of 16 B, line 7] {1, 2, 3}" (con la línea
+// del malloc y el contenido como int) o "[free, 16 B]". Así cada instantánea lleva el estado del asignador.
+enum SimFreeResult : unsigned char { SIM_FREE_OK, SIM_FREE_DOUBLE, SIM_FREE_INVALID };
+
+struct SimHeapStats {
+    size_t liveBlocks;
+    size_t requestedBytes; // Pedidos por los bloques en uso
+    size_t liveBytes;      // Ocupados por los bloques en uso (la diferencia es fragmentación interna)
+    size_t freeBlocks;
+    size_t freeBytes;      // Bloques liberados aún sin reutilizar (fragmentación externa)
+};
+
+void* simMalloc(long long size, int line); // nullptr si size <= 0 o si el arena se agota
+SimFreeResult simFree(const void* address, int line); // free(NULL) no hace nada
+// '*p = v': simHeapCheckStore antes de escribir (false, con un aviso por la salida de errores, si p está en
+// un bloque liberado o pasado el final de los bytes pedidos; entonces no se escribe) y simHeapStore después
+// (actualiza en la traza el bloque o la variable local de p)
+bool simHeapCheckStore(const void* address, int line);
+void simHeapStore(const void* address);
+void reportSimulationHeapLeaks(int leakDescriptor); // Un paso (bytes, dirección, línea) por bloque sin liberar
+void resetSimulationHeap(); // beginSimulationRun
+// Estadísticas de una instantánea del heap (las de SimulationState::heap en cualquier paso)
+SimHeapStats computeSimulationHeapStats(const HeapObjectMap& heap);
+
+// --- Traza precalculada por el compilador (--precompute) ---
+// El compilador ejecuta el programa en su VM y emite la traza (pasos, valores y deltas) como tablas
+// constexpr; el programa generado solo la copia al runtime y reconstruye los keyframes.
+struct PrecomputedHeapWrite {
+    const char* address;
+    const char* value;
+};
+
+struct PrecomputedTrace {
+    const SimulationStep* steps;
+    size_t stepCount;
+    const long long* args;
+    size_t argCount;
+    const TraceDelta* deltas;
+    size_t deltaCount;
+    const PrecomputedHeapWrite* heapWrites;
+    size_t heapWriteCount;
+    const char* output; // Salida de printf del programa, ya calculada
+    size_t outputLength;
+};
+
+void loadPrecomputedTrace(const PrecomputedTrace& trace);
+
+// --- Salida bufferizada de printf (se vacía al llenarse y al final del programa) ---
+void flushOutput();
+void writeOutput(const char* data, size_t length);
+template <size_t N> inline void writeOutputLiteral(const char (&text)[N]) { writeOutput(text, N - 1); }
+void writeOutputInt(long long value);
+void writeOutputString(const char* value);
+void writeOutputPointer(const void* value);
+// Redirige la salida a 'capture' en lugar de stdout (nullptr la restaura); la usa --precompute
+void setOutputCapture(std::string* capture);
+
+#endif // SIMULATIONRUNTIME_H
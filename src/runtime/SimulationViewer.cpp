@@ -0,0 +1,547 @@
+// src/runtime/SimulationViewer.cpp
+// Visor SFML de la simulación: dibuja el heap, la pila y los botones de navegación.
+#include "SimulationRuntime.h"
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+// Objetos y constantes globales de SFML
+sf::RenderWindow* globalWindow = nullptr;
+sf::Font globalFont;
+size_t currentStepIndex = 0;
+SimulationState viewerState; // Estado del paso mostrado, reconstruido desde los deltas
+
+// Variable o dirección del heap seleccionada con Tab; N/P saltan a su siguiente/anterior cambio
+struct ViewerSelection {
+    bool valid = false;
+    bool heap = false;
+    size_t frameDepth = 0; // Posición del marco en la pila
+    int slot = 0;
+    std::string address;
+
+    bool operator==(const ViewerSelection& other) const {
+        return valid == other.valid && heap == other.heap && (heap ? address == other.address : frameDepth == other.frameDepth && slot == other.slot);
+    }
+};
+ViewerSelection selection;
+bool editingCondition = false; // '/' abre la búsqueda de una condición (p. ej. x > 10)
+std::string conditionText;
+std::string statusMessage;
+SimulationProgress recordingProgress = {false, 0, 0, 0, 0}; // Programa que sigue registrando en segundo plano o publicando en el flujo
+std::string streamName; // sim_stream_viewer: anillo del que se reciben las ejecuciones
+
+// Posiciones y tamaños ajustados para el diseño basado en la imagen
+const float PADDING = 20.f;
+const float BAR_HEIGHT = 100.f;
+const float HEAP_BAR_Y = 50.f;
+const float STACK_BAR_Y = HEAP_BAR_Y + BAR_HEIGHT + PADDING;
+const float MEMORY_BAR_WIDTH = 1000.f - (2 * PADDING);
+const float BOX_HEIGHT = 50.f;
+const float BOX_PADDING = 10.f;
+const size_t SEEK_PAGE_STEPS = 1000;
+const float BUTTON_WIDTH = 100.f;
+const float BUTTON_HEIGHT = 40.f;
+
+void setupSFML(sf::RenderWindow& window) {
+    globalWindow = &window;
+    // Ruta fijada al construir la biblioteca; la relativa se mantiene para ejecutables copiados
+#ifdef SIM_FONT_PATH
+    if (globalFont.loadFromFile(SIM_FONT_PATH)) {
+        return;
+    }
+#endif
+    if (!globalFont.loadFromFile("../../resources/arial.ttf")) {
+        std::cerr << "Error loading font: ../../resources/arial.ttf" << std::endl;
+    }
+}
+
+void displayText(const std::string& text_str, float x, float y, sf::Color color, unsigned int characterSize = 18) {
+    if (!globalWindow) return;
+    sf::Text text(text_str, globalFont, characterSize);
+    text.setPosition(x, y);
+    text.setFillColor(color);
+    globalWindow->draw(text);
+}
+
+void drawRectangle(float x, float y, float width, float height, sf::Color color, bool filled, float outlineThickness, sf::Color outlineColor) {
+    if (!globalWindow) return;
+    sf::RectangleShape rectangle(sf::Vector2f(width, height));
+    rectangle.setPosition(x, y);
+    if (filled) {
+        rectangle.setFillColor(color);
+    } else {
+        rectangle.setFillColor(sf::Color::Transparent);
+        rectangle.setOutlineThickness(outlineThickness);
+        rectangle.setOutlineColor(outlineColor);
+    }
+    globalWindow->draw(rectangle);
+}
+
+// Pasos registrados y ritmo mientras el programa sigue en marcha
+std::string recordingText() {
+    const double rate = recordingProgress.seconds > 0 ? recordingProgress.steps / recordingProgress.seconds : 0;
+    std::string text = "Recording: " + std::to_string(recordingProgress.steps) + " steps, " + std::to_string(static_cast<long long>(rate)) + " steps/s";
+    if (recordingProgress.droppedSteps > 0) {
+        text += ", " + std::to_string(recordingProgress.droppedSteps) + " dropped";
+    }
+    if (recordingProgress.evictedSteps > 0) {
+        text += ", first " + std::to_string(recordingProgress.evictedSteps) + " evicted";
+    }
+    return text;
+}
+
+// Antes de que se publique el primer paso (o, en sim_stream_viewer, antes de que empiece una ejecución)
+void displayRecordingScreen() {
+    if (!globalWindow || !globalWindow->isOpen()) return;
+    globalWindow->clear(sf::Color(240, 240, 240));
+    if (recordingProgress.active) {
+        displayText("Running the program...", PADDING, PADDING / 2, sf::Color::Black, 18);
+        displayText(recordingText(), PADDING, globalWindow->getSize().y - BUTTON_HEIGHT - PADDING - 30, sf::Color(60, 60, 60), 16);
+    } else {
+        displayText("Waiting for a program: run it with --stream=" + streamName, PADDING, PADDING / 2, sf::Color::Black, 18);
+    }
+    globalWindow->display();
+}
+
+// Resumen del asignador en el paso mostrado; se recalcula solo al cambiar de paso
+std::string heapStatsText(const SimulationState& state) {
+    static size_t cachedTrace = SIZE_MAX;
+    static size_t cachedStep = SIZE_MAX;
+    static std::string cachedText;
+    if (state.trace == cachedTrace && state.step == cachedStep) {
+        return cachedText;
+    }
+    cachedTrace = state.trace;
+    cachedStep = state.step;
+    const SimHeapStats stats = computeSimulationHeapStats(state.heap);
+    if (stats.liveBlocks == 0 && stats.freeBlocks == 0) {
+        cachedText.clear();
+        return cachedText;
+    }
+    auto percent = [](size_t part, size_t whole) { return std::to_string(whole != 0 ? part * 100 / whole : 0) + "%"; };
+    cachedText = std::to_string(stats.liveBlocks) + " blocks in use: " + std::to_string(stats.requestedBytes) + " of " +
+                 std::to_string(stats.liveBytes) + " B requested (" + percent(stats.liveBytes - stats.requestedBytes, stats.liveBytes) +
+                 " internal fragmentation); " + std::to_string(stats.freeBlocks) + " free blocks, " + std::to_string(stats.freeBytes) + " B (" +
+                 percent(stats.freeBytes, stats.liveBytes + stats.freeBytes) + " external fragmentation)";
+    return cachedText;
+}
+
+void displaySpecificStep(const SimulationStep& step, const SimulationState& state) {
+    if (!globalWindow || !globalWindow->isOpen()) return;
+    globalWindow->clear(sf::Color(240, 240, 240)); // Fondo gris muy claro para el nuevo diseño
+    displayText(formatStepDescription(step), PADDING, PADDING / 2, sf::Color::Black, 18);
+
+    // --- Dibujar Área del Heap ---
+    displayText("Heap", PADDING, HEAP_BAR_Y - 25, sf::Color::Black, 20);
+    displayText(heapStatsText(state), PADDING + 60, HEAP_BAR_Y - 20, sf::Color(60, 60, 60), 14);
+    drawRectangle(PADDING, HEAP_BAR_Y, MEMORY_BAR_WIDTH, BAR_HEIGHT, sf::Color(210, 210, 210), true, 2.f, sf::Color::Black);
+    // Un solo sf::Text mide y dibuja cada bloque; se deja de recorrer el heap al llenarse la barra
+    const float heapBoxY = HEAP_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2;
+    const float heapEndX = PADDING + MEMORY_BAR_WIDTH - BOX_PADDING;
+    float currentHeapX = PADDING + BOX_PADDING;
+    sf::Text blockText("", globalFont, 16);
+    size_t drawnBlocks = 0;
+    for (const auto& objPair : state.heap) {
+        const bool selected = selection.valid && selection.heap && selection.address == objPair.first;
+        const bool freed = objPair.second.kind == HEAP_BLOCK_FREED;
+        blockText.setString(objPair.first + ": " + objPair.second.value);
+        float boxWidth = std::max(80.f, blockText.getLocalBounds().width + (BOX_PADDING * 2));
+        // Verificar si la caja se sale del área del heap (se reserva sitio para el recuento de los que faltan)
+        if (currentHeapX + boxWidth > heapEndX - (drawnBlocks + 1 < state.heap.size() ? 80.f : 0.f)) {
+            break;
+        }
+        // Amarillo claro para los bloques en uso; gris para los liberados, que siguen en su clase de tamaño
+        sf::Color boxColor = freed ? sf::Color(185, 185, 185) : sf::Color(255, 255, 150);
+        drawRectangle(currentHeapX, heapBoxY, boxWidth, BOX_HEIGHT, boxColor, true, 1.f, sf::Color::Black);
+        if (selected) {
+            drawRectangle(currentHeapX, heapBoxY, boxWidth, BOX_HEIGHT, boxColor, false, 3.f, sf::Color::Red);
+        }
+        blockText.setPosition(currentHeapX + BOX_PADDING, heapBoxY + BOX_PADDING);
+        blockText.setFillColor(freed ? sf::Color(80, 80, 80) : sf::Color::Black);
+        globalWindow->draw(blockText);
+        currentHeapX += boxWidth + BOX_PADDING;
+        ++drawnBlocks;
+    }
+    if (drawnBlocks < state.heap.size()) {
+        displayText("+" + std::to_string(state.heap.size() - drawnBlocks) + " more", currentHeapX, heapBoxY + BOX_PADDING, sf::Color(60, 60, 60), 16);
+    }
+
+    // --- Dibujar Área de la Pila ---
+    displayText("Stack", PADDING, STACK_BAR_Y - 25, sf::Color::Black, 20);
+    drawRectangle(PADDING, STACK_BAR_Y, MEMORY_BAR_WIDTH, BAR_HEIGHT, sf::Color(210, 210, 210), true, 2.f, sf::Color::Black);
+    float currentStackX = PADDING + BOX_PADDING;
+    // Dibujar los marcos de la pila de izquierda a derecha (orden de llamada)
+    for (size_t depth = 0; depth < state.frames.size(); ++depth) {
+        const StackFrame& frame = state.frames[depth];
+        const FrameLayout& layout = getFrameLayout(frame.layout);
+        std::string frameLabel = layout.functionName;
+        // Dibujar el label del marco (nombre de la función)
+        sf::Color frameLabelColor = sf::Color(150, 255, 150); // Verde claro para 'main' y otros labels
+        sf::Text tempFrameText(frameLabel, globalFont, 16);
+        float frameLabelWidth = std::max(80.f, tempFrameText.getLocalBounds().width + (BOX_PADDING * 2));
+        if (currentStackX + frameLabelWidth > PADDING + MEMORY_BAR_WIDTH - BOX_PADDING) break;
+        drawRectangle(currentStackX, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2, frameLabelWidth, BOX_HEIGHT, frameLabelColor, true, 1.f, sf::Color::Black);
+        displayText(frameLabel, currentStackX + BOX_PADDING, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);
+        currentStackX += frameLabelWidth + BOX_PADDING;
+        // Dibujar las variables dentro del marco de la pila
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            if (!frame.live.test(slot)) continue;
+            const FrameSlotInfo& slotInfo = layout.slots[slot];
+            std::string varName = slotInfo.name;
+            std::string varValue = formatSlotValue(slotInfo.type, frame.slots[slot]); // Se formatea solo al mostrar
+            sf::Text tempVarNameText(varName, globalFont, 16);
+            sf::Text tempVarValueText(varValue, globalFont, 16);
+            float nameWidth = tempVarNameText.getLocalBounds().width;
+            float valueWidth = tempVarValueText.getLocalBounds().width;
+            float boxWidth = std::max(80.f, nameWidth + valueWidth + (BOX_PADDING * 3));
+            if (currentStackX + boxWidth > PADDING + MEMORY_BAR_WIDTH - BOX_PADDING) {
+                break;
+            }
+            sf::Color varCellColor;
+            if (slotInfo.type == SLOT_POINTER) {
+                varCellColor = sf::Color(255, 255, 150); // Amarillo claro para punteros
+            } else {
+                varCellColor = sf::Color(150, 255, 150); // Verde claro para valores
+            }
+            drawRectangle(currentStackX, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2, boxWidth, BOX_HEIGHT, varCellColor, true, 1.f, sf::Color::Black);
+            if (selection.valid && !selection.heap && selection.frameDepth == depth && selection.slot == slot) {
+                drawRectangle(currentStackX, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2, boxWidth, BOX_HEIGHT, varCellColor, false, 3.f, sf::Color::Red);
+            }
+            displayText(varName, currentStackX + BOX_PADDING, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);
+            displayText(varValue, currentStackX + BOX_PADDING + nameWidth + BOX_PADDING, STACK_BAR_Y + (BAR_HEIGHT - BOX_HEIGHT) / 2 + BOX_PADDING, sf::Color::Black, 16);
+            currentStackX += boxWidth + BOX_PADDING;
+        }
+    }
+
+    // --- Dibujar botones "Previous" y "Next" ---
+    const float BUTTON_Y = globalWindow->getSize().y - BUTTON_HEIGHT - PADDING;
+
+    // Línea de estado: paso actual, búsqueda en curso o resultado de la última
+    // Con --lazy, el total solo cuenta los pasos ya ejecutados ('+': el programa sigue en pausa)
+    std::string status = "Step " + std::to_string(currentStepIndex + 1) + " / " + std::to_string(getSimulationStepCount()) +
+                         (isLazySimulationRunning() ? "+" : "");
+    if (recordingProgress.active) {
+        status += "   " + recordingText();
+    }
+    if (editingCondition) {
+        status += "   Find: " + conditionText + "_";
+    } else if (!statusMessage.empty()) {
+        status += "   " + statusMessage;
+    } else if (isLazySimulationRunning()) {
+        status += "   Next: run the program one more step";
+    } else {
+        status += "   Tab: select  N/P: next/previous change  /: find condition";
+    }
+    displayText(status, PADDING, BUTTON_Y - 30, sf::Color(60, 60, 60), 16);
+
+    // Botón Anterior
+    const float PREV_BUTTON_X = (globalWindow->getSize().x / 2) - BUTTON_WIDTH - (BOX_PADDING * 2);
+    sf::RectangleShape prevButton(sf::Vector2f(BUTTON_WIDTH, BUTTON_HEIGHT));
+    prevButton.setPosition(PREV_BUTTON_X, BUTTON_Y);
+    prevButton.setFillColor(currentStepIndex > getSimulationFirstStep() ? sf::Color(70, 70, 70) : sf::Color(30, 30, 30));
+    prevButton.setOutlineThickness(2);
+    prevButton.setOutlineColor(sf::Color::Black);
+    globalWindow->draw(prevButton);
+    displayText("Previous", PREV_BUTTON_X + (BUTTON_WIDTH - sf::Text("Previous", globalFont, 18).getLocalBounds().width) / 2, BUTTON_Y + (BUTTON_HEIGHT - 18) / 2, sf::Color::White);
+
+    // Botón Siguiente
+    const float NEXT_BUTTON_X = (globalWindow->getSize().x / 2) + (BOX_PADDING * 2);
+    sf::RectangleShape nextButton(sf::Vector2f(BUTTON_WIDTH, BUTTON_HEIGHT));
+    nextButton.setPosition(NEXT_BUTTON_X, BUTTON_Y);
+    nextButton.setFillColor(currentStepIndex + 1 < getSimulationStepCount() ? sf::Color(70, 70, 70) : sf::Color(30, 30, 30));
+    nextButton.setOutlineThickness(2);
+    nextButton.setOutlineColor(sf::Color::Black);
+    globalWindow->draw(nextButton);
+    displayText("Next", NEXT_BUTTON_X + (BUTTON_WIDTH - sf::Text("Next", globalFont, 18).getLocalBounds().width) / 2, BUTTON_Y + (BUTTON_HEIGHT - 18) / 2, sf::Color::White);
+    globalWindow->display();
+}
+
+// Con --lazy, los pasos anteriores a la ventana ya no están
+void seekBackTo(size_t stepIndex) {
+    const size_t firstStep = getSimulationFirstStep();
+    if (stepIndex < firstStep && currentStepIndex == firstStep) {
+        statusMessage = "Steps before " + std::to_string(firstStep + 1) + " were discarded" +
+                        (streamName.empty() ? " (--lazy-window)" : " (the viewer keeps the latest blocks of each run)");
+    }
+    currentStepIndex = std::max(stepIndex, firstStep);
+}
+
+// Flechas: un paso; Re Pág/Av Pág: SEEK_PAGE_STEPS pasos; Inicio/Fin: primer y último paso
+void seekWithKeyboard(sf::Keyboard::Key key) {
+    const size_t lastStep = getSimulationStepCount() == 0 ? 0 : getSimulationStepCount() - 1;
+    switch (key) {
+        case sf::Keyboard::Right: currentStepIndex = std::min(currentStepIndex + 1, lastStep); break;
+        case sf::Keyboard::Left: seekBackTo(currentStepIndex > 0 ? currentStepIndex - 1 : 0); break;
+        case sf::Keyboard::PageDown: currentStepIndex = std::min(currentStepIndex + SEEK_PAGE_STEPS, lastStep); break;
+        case sf::Keyboard::PageUp: seekBackTo(currentStepIndex > SEEK_PAGE_STEPS ? currentStepIndex - SEEK_PAGE_STEPS : 0); break;
+        case sf::Keyboard::Home: seekBackTo(0); break;
+        case sf::Keyboard::End: currentStepIndex = lastStep; break;
+        default: break;
+    }
+}
+
+// Variables vivas de la pila y direcciones del heap del paso mostrado, en el orden en que se dibujan
+std::vector<ViewerSelection> selectableItems(const SimulationState& state) {
+    std::vector<ViewerSelection> items;
+    for (const auto& object : state.heap) {
+        ViewerSelection item;
+        item.valid = true;
+        item.heap = true;
+        item.address = object.first;
+        items.push_back(item);
+    }
+    for (size_t depth = 0; depth < state.frames.size(); ++depth) {
+        const FrameLayout& layout = getFrameLayout(state.frames[depth].layout);
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            if (state.frames[depth].live.test(slot)) {
+                ViewerSelection item;
+                item.valid = true;
+                item.frameDepth = depth;
+                item.slot = slot;
+                items.push_back(item);
+            }
+        }
+    }
+    return items;
+}
+
+std::string selectionName(const SimulationState& state) {
+    if (selection.heap) {
+        return selection.address;
+    }
+    if (selection.frameDepth >= state.frames.size()) {
+        return "variable";
+    }
+    return getFrameLayout(state.frames[selection.frameDepth].layout).slots[selection.slot].name;
+}
+
+void cycleSelection(bool backwards) {
+    const std::vector<ViewerSelection> items = selectableItems(viewerState);
+    if (items.empty()) {
+        selection = ViewerSelection();
+        return;
+    }
+    auto current = std::find(items.begin(), items.end(), selection);
+    if (current == items.end()) {
+        selection = backwards ? items.back() : items.front();
+    } else if (backwards) {
+        selection = current == items.begin() ? items.back() : *(current - 1);
+    } else {
+        selection = current + 1 == items.end() ? items.front() : *(current + 1);
+    }
+    statusMessage = "Selected " + selectionName(viewerState);
+}
+
+// N/P: siguiente o anterior cambio de la selección, por búsqueda binaria en el índice de cambios
+void seekSelectionChange(bool forward) {
+    if (recordingProgress.active) {
+        statusMessage = "The change index is ready when recording finishes";
+        return;
+    }
+    if (!hasSimulationChangeIndex()) {
+        statusMessage = "This trace has no change index";
+        return;
+    }
+    if (!selection.valid) {
+        statusMessage = "Press Tab to select a variable";
+        return;
+    }
+    size_t target;
+    if (selection.heap) {
+        target = forward ? findNextHeapChange(currentStepIndex, selection.address) : findPreviousHeapChange(currentStepIndex, selection.address);
+    } else {
+        target = forward ? findNextVariableChange(currentStepIndex, selection.frameDepth, selection.slot)
+                         : findPreviousVariableChange(currentStepIndex, selection.frameDepth, selection.slot);
+    }
+    const std::string name = selectionName(viewerState);
+    if (target == SIM_NO_STEP) {
+        statusMessage = std::string("No ") + (forward ? "later" : "earlier") + " change of " + name;
+        return;
+    }
+    currentStepIndex = target;
+    statusMessage = name + " changed at step " + std::to_string(target + 1);
+}
+
+void findCondition() {
+    if (recordingProgress.active) {
+        statusMessage = "The change index is ready when recording finishes";
+        return;
+    }
+    std::string error;
+    const size_t target = findConditionStep(currentStepIndex, viewerState, conditionText, error);
+    if (target == SIM_NO_STEP) {
+        statusMessage = error;
+        return;
+    }
+    currentStepIndex = target;
+    statusMessage = conditionText + " holds at step " + std::to_string(target + 1);
+}
+
+// Edición de la condición: Enter busca, Escape cancela
+void handleConditionKey(sf::Keyboard::Key key) {
+    if (key == sf::Keyboard::Enter) {
+        editingCondition = false;
+        findCondition();
+    } else if (key == sf::Keyboard::Escape) {
+        editingCondition = false;
+        statusMessage.clear();
+    } else if (key == sf::Keyboard::BackSpace && !conditionText.empty()) {
+        conditionText.pop_back();
+    }
+}
+
+void handleViewerKey(const sf::Event::KeyEvent& key) {
+    if (editingCondition) {
+        handleConditionKey(key.code);
+        return;
+    }
+    switch (key.code) {
+        case sf::Keyboard::Tab: cycleSelection(key.shift); break;
+        case sf::Keyboard::N: seekSelectionChange(true); break;
+        case sf::Keyboard::P: seekSelectionChange(false); break;
+        default:
+            statusMessage.clear();
+            seekWithKeyboard(key.code);
+            break;
+    }
+}
+
+void handleViewerText(sf::Uint32 character) {
+    if (!editingCondition) {
+        if (character == '/') {
+            editingCondition = true;
+            conditionText.clear();
+        } else if ((character == '[' || character == ']') && !streamName.empty()) {
+            // Ejecución anterior o siguiente de las recibidas por el flujo
+            if (showSimulationStreamRun(character == '[' ? -1 : 1, statusMessage)) {
+                currentStepIndex = 0;
+                selection = ViewerSelection();
+            }
+        }
+        return;
+    }
+    if (character >= ' ' && character < 127) {
+        conditionText += static_cast<char>(character);
+    }
+}
+
+} // namespace
+
+int runSimulationViewer(const SimulationProgram& program) {
+    // El programa se registra en un hilo de fondo: la ventana se abre al instante y muestra los pasos
+    // a medida que se publican. Con presupuesto de memoria se registra entero antes de abrirla, y sin
+    // índice de cambios: este crecería con la ejecución aunque la traza no lo haga.
+    if (getSimulationTraceBudget() == 0) {
+        requestSimulationChangeIndex();
+    }
+    if (!startSimulationRecording(program)) {
+        runSimulationProgram(program);
+    }
+    return showSimulationViewer();
+}
+
+int runLazySimulationViewer(const SimulationProgram& program, const SimulationStepper& stepper, size_t window) {
+    // El programa no se ejecuta antes de abrir la ventana: cada paso se registra cuando se va a mostrar
+    beginLazySimulation(program, stepper, window);
+    return showSimulationViewer();
+}
+
+int runSimulationTraceFileViewer(const std::string& path) {
+    // Sin ejecutar el programa: los pasos se decodifican del archivo a medida que se muestran
+    if (!openSimulationTraceFile(path)) {
+        return 1;
+    }
+    return showSimulationViewer();
+}
+
+int runSimulationStreamViewer(const std::string& ringName, size_t ringBytes) {
+    // Sin programa propio: muestra las ejecuciones que publican en el anillo los programas con --stream
+    if (!openSimulationStream(ringName, ringBytes)) {
+        return 1;
+    }
+    streamName = ringName;
+    const int exitCode = showSimulationViewer();
+    closeSimulationStream();
+    return exitCode;
+}
+
+int showSimulationViewer() {
+    currentStepIndex = 0; // Comienza en el primer paso registrado
+
+    sf::RenderWindow window(sf::VideoMode(1000, 500), "C to SFML Compiler Visualization");
+    setupSFML(window);
+    window.setFramerateLimit(60);
+
+    // --- Bucle principal de eventos SFML para la navegación ---
+    while (window.isOpen()) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                window.close();
+                stopSimulationRecording(); // No se espera a que termine un programa que ya no se va a ver
+                stopLazySimulation();
+            }
+            if (event.type == sf::Event::KeyPressed) {
+                handleViewerKey(event.key);
+            }
+            if (event.type == sf::Event::TextEntered) {
+                handleViewerText(event.text.unicode);
+            }
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                sf::Vector2i mousePos = sf::Mouse::getPosition(window);
+                const float BUTTON_Y = window.getSize().y - BUTTON_HEIGHT - PADDING;
+
+                // Botón Siguiente
+                const float NEXT_BUTTON_X = window.getSize().x / 2 + (BOX_PADDING * 2);
+                sf::FloatRect nextButtonBounds(NEXT_BUTTON_X, BUTTON_Y, BUTTON_WIDTH, BUTTON_HEIGHT);
+                if (nextButtonBounds.contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
+                    if (currentStepIndex + 1 < getSimulationStepCount()) {
+                        currentStepIndex++;
+                    }
+                }
+
+                // Botón Anterior
+                const float PREV_BUTTON_X = window.getSize().x / 2 - BUTTON_WIDTH - (BOX_PADDING * 2);
+                sf::FloatRect prevButtonBounds(PREV_BUTTON_X, BUTTON_Y, BUTTON_WIDTH, BUTTON_HEIGHT);
+                if (prevButtonBounds.contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
+                    if (currentStepIndex > 0) {
+                        statusMessage.clear();
+                        seekBackTo(currentStepIndex - 1);
+                    }
+                }
+            }
+        }
+        const bool wasRecording = recordingProgress.active;
+        bool runStarted = false;
+        if ((pollSimulationRecording(recordingProgress) || pollSimulationStream(recordingProgress, runStarted)) && wasRecording &&
+            !recordingProgress.active && !runStarted) {
+            statusMessage = "Recorded " + std::to_string(recordingProgress.steps) + " steps";
+            if (recordingProgress.droppedSteps > 0) {
+                statusMessage += " (" + std::to_string(recordingProgress.droppedSteps) + " dropped)";
+            }
+            if (recordingProgress.evictedSteps > 0) {
+                statusMessage += " (first " + std::to_string(recordingProgress.evictedSteps) + " evicted)";
+            }
+        }
+        if (runStarted) {
+            // Una nueva ejecución en el flujo: se pasa a mostrarla desde su primer paso
+            currentStepIndex = 0;
+            selection = ViewerSelection();
+            statusMessage = "New run on " + streamName + "   [ ]: previous/next run";
+        }
+        currentStepIndex = std::max(currentStepIndex, getSimulationFirstStep()); // El flujo pudo descartar el paso mostrado
+        advanceLazySimulation(currentStepIndex); // --lazy: ejecuta el programa hasta el paso siguiente al mostrado
+        if (getSimulationStepCount() > 0) {
+            const SimulationStep& step = loadSimulationStep(viewerState, currentStepIndex);
+            displaySpecificStep(step, viewerState);
+        } else if (recordingProgress.active || !streamName.empty()) {
+            displayRecordingScreen();
+        }
+        sf::sleep(sf::milliseconds(10)); // Pequeño sleep para reducir el uso de CPU
+    }
+    return 0;
+}
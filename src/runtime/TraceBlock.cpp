@@ -0,0 +1,524 @@
+// src/runtime/TraceBlock.cpp
+// Codificación de los bloques de pasos: formato, compresión y decodificación validada.
+#include "TraceBlock.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Lectura acotada de un bloque: al pasarse del final devuelve ceros y lo recuerda
+class ByteReader {
+public:
+    ByteReader(const unsigned char* data, size_t size) : position(data), end(data + size), overrun(false) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (static_cast<size_t>(end - position) < sizeof(T)) {
+            overrun = true;
+            position = end;
+            return value;
+        }
+        std::memcpy(&value, position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    // Un recuento dañado no debe provocar una reserva enorme
+    bool fits(uint32_t count, size_t elementSize) {
+        if (count > static_cast<size_t>(end - position) / elementSize) {
+            overrun = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool failed() const { return overrun; }
+    bool finished() const { return !overrun && position == end; }
+
+private:
+    const unsigned char* position;
+    const unsigned char* end;
+    bool overrun;
+};
+
+// LZ77 sencillo con secuencias [literales, copia] al estilo de LZ4: un bucle repite casi los mismos
+// pasos y deltas en cada iteración, así que las copias cubren la mayor parte del bloque.
+const size_t LZ_MIN_MATCH = 4;
+const int LZ_HASH_BITS = 14;
+const size_t LZ_MAX_OFFSET = 0xFFFF;
+
+void putLzLength(std::string& out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(static_cast<char>(255));
+    }
+    out.push_back(static_cast<char>(length));
+}
+
+// Token: 4 bits de longitud de literales y 4 de longitud de copia (15 = continúa en bytes de 255)
+void putLzSequence(std::string& out, const unsigned char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    const size_t matchCode = matchLength == 0 ? 0 : matchLength - LZ_MIN_MATCH;
+    out.push_back(static_cast<char>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalLength >= 15) {
+        putLzLength(out, literalLength - 15);
+    }
+    out.append(reinterpret_cast<const char*>(literals), literalLength);
+    if (matchLength == 0) {
+        return; // Última secuencia: solo literales
+    }
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) {
+        putLzLength(out, matchCode - 15);
+    }
+}
+
+bool validPackedStack(const std::vector<long long>& packed, const TraceBlockContext& context) {
+    size_t position = 0;
+    while (position + 2 <= packed.size()) {
+        const long long layout = packed[position];
+        if (layout < 0 || static_cast<size_t>(layout) >= context.layoutCount) {
+            return false;
+        }
+        position += 2 + context.layouts[layout].slotCount;
+    }
+    return position == packed.size();
+}
+
+// Objeto del heap: dirección y texto en la tabla de cadenas, y los campos de su bloque
+const size_t HEAP_OBJECT_BYTES = 32;
+
+void putHeapObject(std::string& out, const std::string& address, const HeapObject& object, TraceStringTable& strings) {
+    put<uint32_t>(out, strings.add(address));
+    put<uint32_t>(out, strings.add(object.value));
+    put<uint32_t>(out, object.kind);
+    put<uint32_t>(out, object.handle);
+    put<uint64_t>(out, object.requested);
+    put<uint64_t>(out, object.size);
+}
+
+bool getHeapObject(ByteReader& reader, const TraceBlockContext& context, std::string& address, HeapObject& object) {
+    const char* addressText = context.string(reader.get<uint32_t>());
+    const char* value = context.string(reader.get<uint32_t>());
+    const uint32_t kind = reader.get<uint32_t>();
+    address = addressText ? addressText : "";
+    object.value = value ? value : "";
+    object.kind = static_cast<HeapObjectKind>(kind);
+    object.handle = reader.get<uint32_t>();
+    object.requested = reader.get<uint64_t>();
+    object.size = reader.get<uint64_t>();
+    return kind <= HEAP_BLOCK_FREED;
+}
+
+} // namespace
+
+uint32_t TraceStringTable::add(const std::string& text) {
+    auto [entry, inserted] = offsets.emplace(text, static_cast<uint32_t>(blob.size()));
+    if (inserted) {
+        blob.append(text);
+        blob.push_back('\0');
+    }
+    return entry->second;
+}
+
+void TraceStringTable::clear() {
+    offsets.clear();
+    blob.clear();
+}
+
+unsigned stringArgumentMask(const char* format) {
+    unsigned mask = 0;
+    int argIndex = 0;
+    for (const char* c = format; *c; ++c) {
+        if (*c != '%' || c[1] == '\0') {
+            continue;
+        }
+        ++c;
+        if (*c == '%') {
+            continue;
+        }
+        if (*c == 's') {
+            mask |= 1u << argIndex;
+        }
+        argIndex++;
+    }
+    return mask;
+}
+
+std::vector<unsigned> stringArgumentMasks(const SimulationProgram& program) {
+    std::vector<unsigned> masks;
+    for (int i = 0; i < program.stepDescriptorCount; ++i) {
+        masks.push_back(stringArgumentMask(program.stepDescriptors[i].format));
+    }
+    return masks;
+}
+
+// Posición de la tabla de cadenas; fuera de ella, cadena vacía (o nula para TRACE_NULL_STRING)
+const char* TraceBlockContext::string(uint32_t offset) const {
+    if (offset >= stringsSize) {
+        return offset == TRACE_NULL_STRING ? nullptr : "";
+    }
+    return strings + offset;
+}
+
+void encodeRecordedTraceBlocks(size_t maxSteps, const std::vector<unsigned>& stringArgs, TraceStringTable& strings,
+                               const std::function<void(size_t firstStep, size_t stepCount, std::string& raw)>& emit) {
+    std::string raw;
+    SimulationState state;
+    std::vector<long long> stack;
+    const size_t stepCount = getSimulationStepCount();
+    for (size_t first = 0; first < stepCount;) {
+        // Un bloque no cruza las ventanas de la traza por checkpoints
+        loadSimulationStep(state, first);
+        const size_t local = first - getSimulationWindowStart();
+        const size_t count = std::min({maxSteps, simulationHistory.size() - local, stepCount - first});
+        raw.clear();
+        stack.clear();
+        packStackFrames(state.frames, stack);
+        encodeTraceBlock(raw, local, count, stack, state.heap, stringArgs, strings);
+        emit(first, count, raw);
+        first += count;
+    }
+}
+
+// --- Tablas del programa ---
+
+TraceProgramTables encodeProgramTables(const SimulationProgram& program, TraceStringTable& strings) {
+    TraceProgramTables tables;
+    for (int i = 0; i < program.stepDescriptorCount; ++i) {
+        const StepDescriptor& descriptor = program.stepDescriptors[i];
+        tables.descriptors.push_back({strings.add(descriptor.format), descriptor.line, descriptor.kind, descriptor.color, 0});
+    }
+    for (int i = 0; i < program.frameLayoutCount; ++i) {
+        const FrameLayout& layout = program.frameLayouts[i];
+        tables.layouts.push_back({strings.add(layout.functionName), static_cast<uint32_t>(tables.slots.size()), static_cast<uint32_t>(layout.slotCount)});
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            tables.slots.push_back({strings.add(layout.slots[slot].name), layout.slots[slot].type});
+        }
+    }
+    return tables;
+}
+
+const char* decodeProgramTables(const TraceProgramTables& tables, const char* strings, uint64_t stringsSize, LoadedTraceProgram& loaded) {
+    const std::vector<unsigned> noMasks;
+    const TraceBlockContext context = {noMasks, nullptr, 0, strings, stringsSize};
+    for (const TraceFileDescriptor& descriptor : tables.descriptors) {
+        if (descriptor.kind > STEP_PRINT || descriptor.color > STEP_COLOR_PRINT) {
+            return "descriptor de paso dañado";
+        }
+        const char* format = context.string(descriptor.format);
+        loaded.descriptors.push_back({static_cast<StepKind>(descriptor.kind), descriptor.line, format ? format : "",
+                                      static_cast<StepColor>(descriptor.color)});
+        loaded.stringArgs.push_back(stringArgumentMask(loaded.descriptors.back().format));
+    }
+    for (const TraceFileSlot& slot : tables.slots) {
+        loaded.slots.push_back({context.string(slot.name), slot.type == SLOT_POINTER ? SLOT_POINTER : SLOT_INT});
+    }
+    for (const TraceFileLayout& layout : tables.layouts) {
+        if (layout.slotCount > SIM_MAX_FRAME_SLOTS || layout.firstSlot > tables.slots.size() || layout.slotCount > tables.slots.size() - layout.firstSlot) {
+            return "layout de marco dañado";
+        }
+        loaded.layouts.push_back({context.string(layout.name), loaded.slots.data() + layout.firstSlot, static_cast<int>(layout.slotCount)});
+    }
+    loaded.program = {loaded.descriptors.data(), static_cast<int>(loaded.descriptors.size()),
+                      loaded.layouts.data(), static_cast<int>(loaded.layouts.size()), nullptr};
+    return nullptr;
+}
+
+// --- Compresión ---
+
+std::string compressTraceBlock(const std::string& input) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(input.data());
+    const size_t size = input.size();
+    auto read32 = [data](size_t position) {
+        uint32_t word;
+        std::memcpy(&word, data + position, sizeof(word));
+        return word;
+    };
+
+    std::string out;
+    std::vector<size_t> table(size_t(1) << LZ_HASH_BITS, SIZE_MAX);
+    size_t anchor = 0;
+    size_t position = 0;
+    while (position + LZ_MIN_MATCH <= size) {
+        const uint32_t word = read32(position);
+        const size_t hash = (word * 2654435761u) >> (32 - LZ_HASH_BITS);
+        const size_t candidate = table[hash];
+        table[hash] = position;
+        if (candidate == SIZE_MAX || position - candidate > LZ_MAX_OFFSET || read32(candidate) != word) {
+            ++position;
+            continue;
+        }
+        size_t length = LZ_MIN_MATCH;
+        while (position + length < size && data[candidate + length] == data[position + length]) {
+            ++length;
+        }
+        putLzSequence(out, data + anchor, position - anchor, position - candidate, length);
+        position += length;
+        anchor = position;
+    }
+    putLzSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool decompressTraceBlock(const unsigned char* input, size_t inputSize, size_t rawSize, std::string& out) {
+    const unsigned char* position = input;
+    const unsigned char* const end = input + inputSize;
+    auto readLength = [&position, end](size_t& length) {
+        unsigned char byte;
+        do {
+            if (position == end) {
+                return false;
+            }
+            byte = *position++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    out.clear();
+    out.reserve(rawSize);
+    while (position < end) {
+        const unsigned char token = *position++;
+        size_t literalLength = token >> 4;
+        if ((literalLength == 15 && !readLength(literalLength)) || static_cast<size_t>(end - position) < literalLength) {
+            return false;
+        }
+        out.append(reinterpret_cast<const char*>(position), literalLength);
+        position += literalLength;
+        if (position == end) {
+            break;
+        }
+        if (end - position < 2) {
+            return false;
+        }
+        const size_t offset = position[0] | (static_cast<size_t>(position[1]) << 8);
+        position += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength)) {
+            return false;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > out.size() || out.size() + matchLength > rawSize) {
+            return false;
+        }
+        // Byte a byte: la copia puede solaparse con lo que está escribiendo
+        for (size_t from = out.size() - offset, copied = 0; copied < matchLength; ++copied) {
+            out.push_back(out[from + copied]);
+        }
+    }
+    return out.size() == rawSize;
+}
+// --- Codificación ---
+
+// [pila empaquetada][heap][pasos][argumentos][deltas][escrituras del heap][hashes de los pasos]
+void encodeTraceBlock(std::string& raw, size_t local, size_t count, const std::vector<long long>& stack,
+                      const HeapObjectMap& heap, const std::vector<unsigned>& stringArgs,
+                      TraceStringTable& strings) {
+    put<uint32_t>(raw, static_cast<uint32_t>(stack.size()));
+    for (long long word : stack) {
+        put<int64_t>(raw, word);
+    }
+    put<uint32_t>(raw, static_cast<uint32_t>(heap.size()));
+    for (const auto& [address, object] : heap) {
+        putHeapObject(raw, address, object, strings);
+    }
+
+    // Los deltas del bloque empiezan después de los ya aplicados en el estado inicial
+    const uint32_t deltaBegin = simulationHistory[local].deltaEnd;
+    const uint32_t deltaEnd = simulationHistory[local + count - 1].deltaEnd;
+    // Por paso solo se guardan recuentos (las posiciones se acumulan al leer): así las iteraciones
+    // de un bucle producen los mismos bytes y la compresión las reduce a copias
+    std::string args;
+    uint32_t argCount = 0;
+    uint32_t previousDeltaEnd = deltaBegin;
+    put<uint32_t>(raw, static_cast<uint32_t>(count));
+    for (size_t i = local; i < local + count; ++i) {
+        const SimulationStep& step = simulationHistory[i];
+        put<uint16_t>(raw, step.descriptor);
+        put<uint8_t>(raw, step.argCount);
+        put<uint8_t>(raw, 0);
+        put<uint32_t>(raw, step.deltaEnd - previousDeltaEnd);
+        previousDeltaEnd = step.deltaEnd;
+        for (int arg = 0; arg < step.argCount; ++arg) {
+            long long value = simulationArgs[step.argOffset + arg];
+            if (stringArgs[step.descriptor] & (1u << arg)) {
+                const char* text = reinterpret_cast<const char*>(static_cast<std::intptr_t>(value));
+                value = text ? strings.add(text) : TRACE_NULL_STRING;
+            }
+            put<int64_t>(args, value);
+        }
+        argCount += step.argCount;
+    }
+    put<uint32_t>(raw, argCount);
+    raw += args;
+
+    std::string heapWrites;
+    uint32_t heapWriteCount = 0;
+    put<uint32_t>(raw, deltaEnd - deltaBegin);
+    for (uint32_t i = deltaBegin; i < deltaEnd; ++i) {
+        TraceDelta delta = simulationDeltas[i];
+        if (delta.kind == DELTA_HEAP_WRITE) {
+            const auto& write = simulationHeapWrites[static_cast<size_t>(delta.value)];
+            putHeapObject(heapWrites, write.first, write.second, strings);
+            delta.value = heapWriteCount++; // Índice dentro del bloque
+        }
+        put<uint8_t>(raw, delta.kind);
+        put<uint8_t>(raw, delta.slot);
+        put<uint16_t>(raw, delta.layout);
+        put<uint16_t>(raw, delta.frame);
+        put<uint16_t>(raw, 0);
+        put<int64_t>(raw, delta.value);
+    }
+    put<uint32_t>(raw, heapWriteCount);
+    raw += heapWrites;
+    // Al final y de tamaño fijo: sim_trace_diff los lee sin decodificar el resto del bloque
+    for (size_t i = local; i < local + count; ++i) {
+        put<uint64_t>(raw, simulationStateHashes[i]);
+    }
+}
+
+// --- Decodificación ---
+
+bool decodeTraceBlock(const unsigned char* stored, size_t storedSize, uint32_t encoding, size_t rawSize, uint32_t stepCount,
+                      const TraceBlockContext& context, std::string& decoded, TraceKeyframe& initial) {
+    clearSimulationTrace();
+    const unsigned char* raw = stored;
+    if (encoding == TRACE_BLOCK_LZ) {
+        if (!decompressTraceBlock(stored, storedSize, rawSize, decoded)) {
+            return false;
+        }
+        raw = reinterpret_cast<const unsigned char*>(decoded.data());
+    } else if (encoding != TRACE_BLOCK_RAW || storedSize != rawSize) {
+        return false;
+    }
+
+    ByteReader reader(raw, rawSize);
+    const uint32_t stackWords = reader.get<uint32_t>();
+    if (!reader.fits(stackWords, sizeof(int64_t))) {
+        return false;
+    }
+    initial.stack.resize(stackWords);
+    for (long long& word : initial.stack) {
+        word = reader.get<int64_t>();
+    }
+    const uint32_t heapObjectCount = reader.get<uint32_t>();
+    if (!reader.fits(heapObjectCount, HEAP_OBJECT_BYTES)) {
+        return false;
+    }
+    std::string address;
+    HeapObject object;
+    for (uint32_t i = 0; i < heapObjectCount; ++i) {
+        if (!getHeapObject(reader, context, address, object)) {
+            return false;
+        }
+        initial.heap[address] = object;
+    }
+
+    if (reader.get<uint32_t>() != stepCount || !reader.fits(stepCount, 8)) {
+        return false;
+    }
+    simulationHistory.resize(stepCount);
+    uint64_t argOffset = 0;
+    uint64_t deltaEnd = 0;
+    for (SimulationStep& step : simulationHistory) {
+        step.descriptor = reader.get<uint16_t>();
+        step.argCount = reader.get<uint8_t>();
+        reader.get<uint8_t>();
+        deltaEnd += reader.get<uint32_t>();
+        if (argOffset > UINT32_MAX || deltaEnd > UINT32_MAX) {
+            return false;
+        }
+        step.argOffset = static_cast<uint32_t>(argOffset);
+        step.deltaEnd = static_cast<uint32_t>(deltaEnd);
+        argOffset += step.argCount;
+    }
+    const uint32_t argCount = reader.get<uint32_t>();
+    if (!reader.fits(argCount, sizeof(int64_t))) {
+        return false;
+    }
+    simulationArgs.resize(argCount);
+    for (long long& value : simulationArgs) {
+        value = reader.get<int64_t>();
+    }
+    const uint32_t deltaCount = reader.get<uint32_t>();
+    if (!reader.fits(deltaCount, 16)) {
+        return false;
+    }
+    simulationDeltas.resize(deltaCount);
+    for (TraceDelta& delta : simulationDeltas) {
+        delta.kind = static_cast<TraceDeltaKind>(reader.get<uint8_t>());
+        delta.slot = reader.get<uint8_t>();
+        delta.layout = reader.get<uint16_t>();
+        delta.frame = reader.get<uint16_t>();
+        reader.get<uint16_t>();
+        delta.value = reader.get<int64_t>();
+    }
+    const uint32_t heapWriteCount = reader.get<uint32_t>();
+    if (!reader.fits(heapWriteCount, HEAP_OBJECT_BYTES)) {
+        return false;
+    }
+    simulationHeapWrites.resize(heapWriteCount);
+    for (auto& write : simulationHeapWrites) {
+        if (!getHeapObject(reader, context, write.first, write.second)) {
+            return false;
+        }
+    }
+    simulationStateHashes.resize(stepCount);
+    for (uint64_t& hash : simulationStateHashes) {
+        hash = reader.get<uint64_t>();
+    }
+    if (!reader.finished() || !validPackedStack(initial.stack, context)) {
+        return false;
+    }
+
+    // Índices dentro de rango antes de que el visor los use; los %s pasan a apuntar a la tabla de cadenas
+    for (SimulationStep& step : simulationHistory) {
+        if (step.descriptor >= context.stringArgs.size() || step.argCount > SIM_MAX_STEP_ARGS ||
+            step.argOffset > simulationArgs.size() || step.argCount > simulationArgs.size() - step.argOffset ||
+            step.deltaEnd > simulationDeltas.size()) {
+            return false;
+        }
+        for (int arg = 0; arg < step.argCount; ++arg) {
+            if (context.stringArgs[step.descriptor] & (1u << arg)) {
+                long long& value = simulationArgs[step.argOffset + arg];
+                value = static_cast<long long>(reinterpret_cast<std::intptr_t>(context.string(static_cast<uint32_t>(value))));
+            }
+        }
+    }
+    for (const TraceDelta& delta : simulationDeltas) {
+        const bool valid = (delta.kind == DELTA_PUSH_FRAME && delta.layout < context.layoutCount) ||
+                           delta.kind == DELTA_POP_FRAME ||
+                           (delta.kind == DELTA_SLOT_WRITE && delta.slot < SIM_MAX_FRAME_SLOTS) ||
+                           (delta.kind == DELTA_HEAP_WRITE && delta.value >= 0 && static_cast<size_t>(delta.value) < simulationHeapWrites.size());
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decodeTraceBlockHashes(const unsigned char* stored, size_t storedSize, uint32_t encoding, size_t rawSize, uint32_t stepCount,
+                            std::string& decoded, std::vector<uint64_t>& hashes) {
+    const unsigned char* raw = stored;
+    if (encoding == TRACE_BLOCK_LZ) {
+        if (!decompressTraceBlock(stored, storedSize, rawSize, decoded)) {
+            return false;
+        }
+        raw = reinterpret_cast<const unsigned char*>(decoded.data());
+    } else if (encoding != TRACE_BLOCK_RAW || storedSize != rawSize) {
+        return false;
+    }
+    if (rawSize < stepCount * sizeof(uint64_t)) {
+        return false;
+    }
+    hashes.resize(stepCount);
+    std::memcpy(hashes.data(), raw + rawSize - stepCount * sizeof(uint64_t), stepCount * sizeof(uint64_t));
+    return true;
+}
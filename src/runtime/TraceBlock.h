@@ -0,0 +1,133 @@
+// src/runtime/TraceBlock.h
+#ifndef TRACEBLOCK_H
+#define TRACEBLOCK_H
+
+// Bloques de pasos codificados (uso interno de sim_runtime). Los comparten el archivo .simtrace
+// (TraceFile.cpp), el registro con presupuesto de memoria (TraceBudget.cpp), el registro en segundo
+// plano (BackgroundRecorder.cpp) y el flujo en vivo (TraceStream.cpp): cada bloque lleva el estado
+// completo de su primer paso, así que se decodifica sin los anteriores.
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SimulationRuntime.h"
+
+const uint32_t TRACE_NULL_STRING = UINT32_MAX; // Argumento %s nulo
+
+enum TraceBlockEncoding : uint32_t { TRACE_BLOCK_RAW, TRACE_BLOCK_LZ };
+
+// Cadenas deduplicadas (plantillas, nombres, valores del heap y argumentos %s), terminadas en '\0'
+class TraceStringTable {
+public:
+    uint32_t add(const std::string& text);
+    const std::string& data() const { return blob; }
+    void clear();
+
+private:
+    std::unordered_map<std::string, uint32_t> offsets;
+    std::string blob;
+};
+
+// Posiciones de los argumentos %s de una plantilla (mismo recorrido que formatStepDescription()):
+// en memoria son punteros del programa, en un bloque son posiciones de la tabla de cadenas
+unsigned stringArgumentMask(const char* format);
+std::vector<unsigned> stringArgumentMasks(const SimulationProgram& program);
+
+// Lo que necesita la decodificación de un bloque: tablas del programa y la tabla de cadenas
+struct TraceBlockContext {
+    const std::vector<unsigned>& stringArgs; // Máscara de %s por descriptor
+    const FrameLayout* layouts;
+    size_t layoutCount;
+    const char* strings; // Quien la aporta comprueba que termina en '\0'
+    uint64_t stringsSize;
+
+    const char* string(uint32_t offset) const;
+};
+
+// Añade a 'raw' el bloque con los pasos [local, local + count) de la traza en memoria. 'stack' (empaquetada)
+// y 'heap' son el estado del primer de ellos, ya aplicados sus deltas.
+void encodeTraceBlock(std::string& raw, size_t local, size_t count, const std::vector<long long>& stack,
+                      const HeapObjectMap& heap, const std::vector<unsigned>& stringArgs,
+                      TraceStringTable& strings);
+
+// Recorre la traza registrada (también por ventanas) en bloques de hasta maxSteps pasos que no cruzan
+// ventanas y entrega cada uno codificado con 'strings'. Lo usan el .simtrace y --headless --format=binary.
+void encodeRecordedTraceBlocks(size_t maxSteps, const std::vector<unsigned>& stringArgs, TraceStringTable& strings,
+                               const std::function<void(size_t firstStep, size_t stepCount, std::string& raw)>& emit);
+
+// Publicación de la traza por bloques mientras se ejecuta el programa (BackgroundRecorder.cpp): con
+// el visor en el mismo proceso van a su cola; con --stream, al anillo de memoria compartida.
+// 'strings' y 'block' (sin comprimir) se pueden mover. firstStep cuenta desde el principio del programa.
+using TraceChunkPublisher = void (*)(size_t firstStep, uint32_t stepCount, std::string& strings, std::string& block);
+void beginTraceChunkPublishing(const SimulationProgram& program, TraceChunkPublisher publisher);
+void finishTraceChunkPublishing(); // Publica lo que quede en la traza en memoria
+
+// --- Tablas del programa (.simtrace y flujo en vivo) ---
+// Posiciones en la tabla de cadenas en lugar de punteros. Se escriben tal cual (little-endian) y se leen
+// con memcpy: sin requisitos de alineación.
+struct TraceFileDescriptor {
+    uint32_t format; // Posición en la tabla de cadenas
+    int32_t line;
+    uint8_t kind;
+    uint8_t color;
+    uint16_t reserved;
+};
+
+struct TraceFileLayout {
+    uint32_t name;
+    uint32_t firstSlot;
+    uint32_t slotCount;
+};
+
+struct TraceFileSlot {
+    uint32_t name;
+    uint32_t type;
+};
+
+static_assert(sizeof(TraceFileDescriptor) == 12 && sizeof(TraceFileLayout) == 12 && sizeof(TraceFileSlot) == 8,
+              "Tablas del archivo de traza con relleno inesperado");
+
+struct TraceProgramTables {
+    std::vector<TraceFileDescriptor> descriptors;
+    std::vector<TraceFileLayout> layouts;
+    std::vector<TraceFileSlot> slots;
+};
+
+TraceProgramTables encodeProgramTables(const SimulationProgram& program, TraceStringTable& strings);
+
+// Programa reconstruido de sus tablas, sin run(): sus cadenas apuntan a la tabla de cadenas leída
+struct LoadedTraceProgram {
+    std::vector<StepDescriptor> descriptors;
+    std::vector<unsigned> stringArgs;
+    std::vector<FrameSlotInfo> slots;
+    std::vector<FrameLayout> layouts;
+    SimulationProgram program;
+};
+
+// 'strings' termina en '\0' (lo comprueba quien la aporta). Devuelve el problema, o nullptr si son válidas.
+const char* decodeProgramTables(const TraceProgramTables& tables, const char* strings, uint64_t stringsSize, LoadedTraceProgram& loaded);
+
+// --- Registros del flujo en vivo (TraceStream.cpp) ---
+// Cabecera de 8 bytes (tamaño y tipo) y contenido, redondeado a 8 bytes. Una ejecución es su comienzo, con
+// las tablas del programa, un registro por bloque (con sus propias cadenas) y su final, con el total de
+// pasos. Los publica --stream en el anillo y los escribe --headless --format=binary en un archivo.
+void appendStreamRunBegin(std::string& out, const SimulationProgram& program, int32_t pid);
+void appendStreamBlock(std::string& out, size_t firstStep, uint32_t stepCount, const std::string& strings, const std::string& block);
+void appendStreamRunEnd(std::string& out, size_t stepCount, size_t droppedSteps);
+
+// Compresión LZ77 de un bloque; el resultado solo compensa si es más corto que la entrada
+std::string compressTraceBlock(const std::string& input);
+bool decompressTraceBlock(const unsigned char* input, size_t inputSize, size_t rawSize, std::string& out);
+
+// Sustituye la traza en memoria por los pasos del bloque y deja en 'initial' el estado de su primer
+// paso. 'decoded' guarda el bloque descomprimido: los %s apuntan a 'context.strings'. False si está dañado.
+bool decodeTraceBlock(const unsigned char* stored, size_t storedSize, uint32_t encoding, size_t rawSize, uint32_t stepCount,
+                      const TraceBlockContext& context, std::string& decoded, TraceKeyframe& initial);
+// Solo los hashes encadenados de los pasos del bloque (al final del bloque descomprimido)
+bool decodeTraceBlockHashes(const unsigned char* stored, size_t storedSize, uint32_t encoding, size_t rawSize, uint32_t stepCount,
+                            std::string& decoded, std::vector<uint64_t>& hashes);
+
+#endif // TRACEBLOCK_H
@@ -0,0 +1,308 @@
+// src/runtime/TraceBudget.cpp
+// Registro con presupuesto de memoria: la traza se sella por tramos en un anillo en memoria y lo que
+// no cabe se vuelca a un archivo temporal (hilo de fondo) o se descarta.
+#include "TraceBlock.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const size_t MIN_SEGMENT_BYTES = 64 << 10;
+const size_t MAX_SEGMENT_BYTES = 8 << 20; // Tramos mayores harían lento cada salto del visor
+
+// Tramo sellado: un bloque con su propia tabla de cadenas, para que la memoria no crezca con la ejecución
+struct TraceSegment {
+    size_t firstStep; // Índice desde el inicio del programa, contando los pasos descartados
+    uint32_t stepCount;
+    bool inMemory = true;
+    std::string strings; // En memoria mientras el tramo está en el anillo
+    std::string block;   // Sin comprimir
+    // Tramo volcado: [tabla de cadenas][bloque] en 'offset' del archivo temporal
+    bool spilled = false;
+    uint64_t offset = 0;
+    uint32_t stringsSize = 0;
+    uint32_t encoding = TRACE_BLOCK_RAW;
+    uint32_t storedSize = 0;
+    uint32_t rawSize = 0;
+};
+
+// Tramo en la cola del hilo de fondo
+struct SpillRequest {
+    size_t segment;
+    std::string strings;
+    std::string block;
+};
+
+struct TraceBudget {
+    size_t maxBytes = 0; // 0: sin presupuesto
+    SimTraceOverflow overflow = SIM_TRACE_SPILL;
+    bool recording = false;
+    size_t segmentBytes = 0; // Traza en memoria que dispara el sellado
+    std::deque<TraceSegment> segments;
+    size_t ringBegin = 0; // Primer tramo que sigue en memoria
+    size_t ringBytes = 0;
+    size_t sealedSteps = 0;
+    size_t droppedSteps = 0;
+    std::vector<unsigned> stringArgs;
+    TraceStringTable strings;
+
+    // Volcado: el hilo de fondo comprime y escribe; el registro solo espera si la cola se llena
+    std::FILE* spillFile = nullptr;
+    uint64_t spillBytes = 0;
+    bool spillFailed = false;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<SpillRequest> queue;
+    size_t queuedBytes = 0;
+    bool stopping = false;
+
+    // Ventana cargada por el visor: los %s apuntan a su tabla de cadenas
+    SimulationReplay replay;
+    std::string windowStrings;
+    std::string windowBlock;
+    std::string decoded;
+
+    ~TraceBudget() {
+        stopWriter();
+        if (spillFile) {
+            std::fclose(spillFile);
+        }
+    }
+
+    size_t ringLimit() const { return maxBytes / 2; }
+    size_t queueLimit() const { return maxBytes / 4; }
+
+    void writeSegments();
+    void stopWriter();
+    void evictOldestSegment();
+};
+
+TraceBudget budget;
+
+void TraceBudget::writeSegments() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return; // stopping y sin nada pendiente
+        }
+        SpillRequest request = std::move(queue.front());
+        queue.pop_front();
+        const size_t requestBytes = request.strings.size() + request.block.size();
+        lock.unlock();
+
+        // Compresión y escritura fuera del cerrojo: el registro sigue mientras tanto
+        std::string compressed = compressTraceBlock(request.block);
+        const bool useCompressed = compressed.size() < request.block.size();
+        const std::string& payload = useCompressed ? compressed : request.block;
+        const bool written = !spillFailed &&
+                             std::fwrite(request.strings.data(), 1, request.strings.size(), spillFile) == request.strings.size() &&
+                             std::fwrite(payload.data(), 1, payload.size(), spillFile) == payload.size();
+
+        lock.lock();
+        TraceSegment& segment = segments[request.segment];
+        if (written) {
+            segment.spilled = true;
+            segment.offset = spillBytes;
+            segment.stringsSize = static_cast<uint32_t>(request.strings.size());
+            segment.encoding = useCompressed ? TRACE_BLOCK_LZ : TRACE_BLOCK_RAW;
+            segment.storedSize = static_cast<uint32_t>(payload.size());
+            segment.rawSize = static_cast<uint32_t>(request.block.size());
+            spillBytes += request.strings.size() + payload.size();
+        } else {
+            spillFailed = true;
+        }
+        queuedBytes -= requestBytes;
+        changed.notify_all();
+    }
+}
+
+void TraceBudget::stopWriter() {
+    if (!writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    writer.join();
+    stopping = false;
+}
+
+// Saca del anillo el tramo más antiguo: a la cola del volcado o, con SIM_TRACE_DROP, fuera de la traza
+void TraceBudget::evictOldestSegment() {
+    TraceSegment& oldest = segments[ringBegin];
+    const size_t bytes = oldest.strings.size() + oldest.block.size();
+    ringBytes -= bytes;
+    if (overflow == SIM_TRACE_DROP) {
+        droppedSteps += oldest.stepCount;
+        segments.pop_front();
+        return;
+    }
+
+    if (!spillFile && !spillFailed) {
+        spillFile = std::tmpfile();
+        if (!spillFile) {
+            std::fprintf(stderr, "Error: no se pudo crear el archivo temporal de la traza\n");
+            spillFailed = true;
+        }
+    }
+    if (spillFile && !writer.joinable()) {
+        writer = std::thread(&TraceBudget::writeSegments, this);
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    oldest.inMemory = false;
+    if (spillFailed) {
+        // Sin archivo el tramo se pierde, pero la ejecución sigue dentro del presupuesto
+        oldest.strings.clear();
+        oldest.block.clear();
+        ringBegin++;
+        return;
+    }
+    // Contrapresión: si el disco no da abasto, el registro espera en lugar de acumular tramos
+    changed.wait(lock, [this, bytes] { return queuedBytes == 0 || queuedBytes + bytes <= queueLimit(); });
+    queue.push_back({ringBegin, std::move(oldest.strings), std::move(oldest.block)});
+    queuedBytes += bytes;
+    ringBegin++;
+    changed.notify_all();
+}
+
+const char* spilledSegmentData(const TraceSegment& segment) {
+    budget.windowStrings.resize(segment.stringsSize);
+    budget.windowBlock.resize(segment.storedSize);
+    if (std::fseek(budget.spillFile, static_cast<long>(segment.offset), SEEK_SET) != 0 ||
+        std::fread(&budget.windowStrings[0], 1, segment.stringsSize, budget.spillFile) != segment.stringsSize ||
+        std::fread(&budget.windowBlock[0], 1, segment.storedSize, budget.spillFile) != segment.storedSize) {
+        return nullptr;
+    }
+    return budget.windowBlock.data();
+}
+
+size_t loadSegmentWindow(size_t stepIndex) {
+    const size_t recordedIndex = stepIndex + budget.droppedSteps;
+    const auto found = std::upper_bound(budget.segments.begin(), budget.segments.end(), recordedIndex,
+                                        [](size_t step, const TraceSegment& candidate) { return step < candidate.firstStep; }) - 1;
+    const TraceSegment& segment = *found;
+    const SimulationProgram& program = getActiveSimulationProgram();
+
+    bool loaded = false;
+    TraceKeyframe initial;
+    if (segment.inMemory) {
+        const TraceBlockContext context = {budget.stringArgs, program.frameLayouts, static_cast<size_t>(program.frameLayoutCount),
+                                           segment.strings.data(), segment.strings.size()};
+        loaded = decodeTraceBlock(reinterpret_cast<const unsigned char*>(segment.block.data()), segment.block.size(), TRACE_BLOCK_RAW,
+                                  segment.block.size(), segment.stepCount, context, budget.decoded, initial);
+    } else if (segment.spilled) {
+        const char* stored = spilledSegmentData(segment);
+        const TraceBlockContext context = {budget.stringArgs, program.frameLayouts, static_cast<size_t>(program.frameLayoutCount),
+                                           budget.windowStrings.data(), budget.windowStrings.size()};
+        loaded = stored && decodeTraceBlock(reinterpret_cast<const unsigned char*>(stored), segment.storedSize, segment.encoding,
+                                            segment.rawSize, segment.stepCount, context, budget.decoded, initial);
+    }
+    if (!loaded) {
+        // Tramo perdido (fallo al escribir o leer el archivo temporal): sus pasos se muestran vacíos
+        std::fprintf(stderr, "Error: no se pudieron recuperar los pasos %zu-%zu de la traza\n",
+                     segment.firstStep - budget.droppedSteps, segment.firstStep - budget.droppedSteps + segment.stepCount - 1);
+        clearSimulationTrace();
+        initial = TraceKeyframe();
+        simulationHistory.assign(segment.stepCount, SimulationStep{0, 0, 0, 0});
+        simulationStateHashes.assign(segment.stepCount, 0);
+    }
+    rebuildSimulationKeyframes(initial);
+    return segment.firstStep - budget.droppedSteps;
+}
+
+} // namespace
+
+void setSimulationTraceBudget(size_t maxBytes, SimTraceOverflow overflow) {
+    budget.maxBytes = maxBytes;
+    budget.overflow = overflow;
+    // La traza en memoria, el anillo (la mitad) y la cola del volcado (un cuarto) caben en el presupuesto
+    budget.segmentBytes = std::clamp(maxBytes / 8, MIN_SEGMENT_BYTES, MAX_SEGMENT_BYTES);
+}
+
+size_t getSimulationTraceBudget() {
+    return budget.maxBytes;
+}
+
+size_t getSimulationDroppedSteps() {
+    return budget.droppedSteps;
+}
+
+void beginSimulationTraceSegments() {
+    budget.stopWriter();
+    budget.segments.clear();
+    budget.ringBegin = 0;
+    budget.ringBytes = 0;
+    budget.sealedSteps = 0;
+    budget.droppedSteps = 0;
+    budget.queue.clear();
+    budget.queuedBytes = 0;
+    if (budget.spillFile) {
+        std::fclose(budget.spillFile);
+        budget.spillFile = nullptr;
+    }
+    budget.spillBytes = 0;
+    budget.spillFailed = false;
+    budget.recording = budget.maxBytes != 0;
+    if (budget.recording) {
+        budget.stringArgs = stringArgumentMasks(getActiveSimulationProgram());
+    }
+}
+
+bool simulationTraceSegmentFull() {
+    return budget.recording && getSimulationTraceBytes() >= budget.segmentBytes;
+}
+
+void sealSimulationTraceSegment() {
+    if (simulationHistory.empty()) {
+        return;
+    }
+    TraceSegment segment;
+    segment.firstStep = budget.sealedSteps;
+    segment.stepCount = static_cast<uint32_t>(simulationHistory.size());
+    const TraceKeyframe& first = simulationKeyframes.front(); // Estado del primer paso del tramo
+    budget.strings.clear();
+    encodeTraceBlock(segment.block, 0, simulationHistory.size(), first.stack, first.heap, budget.stringArgs, budget.strings);
+    segment.strings = budget.strings.data();
+    budget.ringBytes += segment.strings.size() + segment.block.size();
+    budget.sealedSteps += simulationHistory.size();
+    clearSimulationTrace();
+    {
+        // El hilo de fondo consulta 'segments' al terminar cada escritura
+        std::lock_guard<std::mutex> lock(budget.mutex);
+        budget.segments.push_back(std::move(segment));
+    }
+    while (budget.ringBytes > budget.ringLimit() && budget.ringBegin + 1 < budget.segments.size()) {
+        budget.evictOldestSegment();
+    }
+}
+
+void finishSimulationTraceSegments() {
+    if (!budget.recording) {
+        return;
+    }
+    budget.recording = false;
+    if (budget.segments.empty() && budget.droppedSteps == 0) {
+        return; // La traza completa cupo en memoria: queda tal cual
+    }
+    sealSimulationTraceSegment();
+    budget.stopWriter();
+
+    const size_t inMemory = std::count_if(budget.segments.begin(), budget.segments.end(), [](const TraceSegment& segment) { return segment.inMemory; });
+    std::fprintf(stderr, "trace budget: %zu steps in %zu segments (%zu in memory, %llu KB spilled), %zu dropped\n",
+                 budget.sealedSteps - budget.droppedSteps, budget.segments.size(), inMemory,
+                 static_cast<unsigned long long>(budget.spillBytes / 1024), budget.droppedSteps);
+    if (budget.spillFailed) {
+        std::fprintf(stderr, "Error: no se pudo volcar parte de la traza al archivo temporal\n");
+    }
+    budget.replay = {budget.sealedSteps - budget.droppedSteps, loadSegmentWindow};
+    setSimulationReplay(&budget.replay);
+}
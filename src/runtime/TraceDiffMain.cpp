@@ -0,0 +1,13 @@
+// src/runtime/TraceDiffMain.cpp
+// sim_trace_diff: primer paso en que difieren dos trazas grabadas (.simtrace), p. ej. la de un alumno y la de la solución.
+#include "SimulationRuntime.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::fprintf(stderr, "Usage: %s <first.simtrace> <second.simtrace>\n", argv[0]);
+        return 2;
+    }
+    return runSimulationTraceDiff(argv[1], argv[2]);
+}
@@ -0,0 +1,377 @@
+// src/runtime/TraceExport.cpp
+// Exportación de la simulación registrada para el visor HTML/JS (backend --backend=html) y salida sin
+// ventana (--headless). No depende de SFML: el programa generado se enlaza solo con sim_runtime.
+#include "TraceBlock.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+const char* STEP_COLOR_NAMES[] = {"default", "highlight", "declaration", "assignment", "call", "return", "print"};
+const size_t HEADLESS_BLOCK_STEPS = 4096; // --headless --format=binary: pasos por bloque, como en el .simtrace
+
+const size_t HEADLESS_WRITE_BYTES = size_t(1) << 20; // --headless: tamaño de cada escritura
+const char HEADLESS_BINARY_MAGIC[8] = {'S', 'I', 'M', 'S', 'T', 'R', 'M', '2'};
+
+void writeJsonString(std::string& out, const std::string& text) {
+    out += '"';
+    for (unsigned char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            case '\r': out += "\\r"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+// Campos de un paso: texto ya formateado, color, línea y el estado completo de pila y heap (ya reconstruido en 'state')
+void writeStepFields(std::string& out, const SimulationStep& step, const SimulationState& state) {
+    const StepDescriptor& descriptor = getStepDescriptor(step.descriptor);
+    out += "\"text\":";
+    writeJsonString(out, formatStepDescription(step));
+    out += ",\"color\":\"";
+    out += STEP_COLOR_NAMES[descriptor.color];
+    out += "\",\"line\":" + std::to_string(descriptor.line);
+
+    out += ",\"stack\":[";
+    bool firstFrame = true;
+    for (const StackFrame& frame : state.frames) {
+        const FrameLayout& layout = getFrameLayout(frame.layout);
+        out += firstFrame ? "{\"function\":" : ",{\"function\":";
+        writeJsonString(out, layout.functionName);
+        out += ",\"variables\":[";
+        bool firstVariable = true;
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            if (!frame.live.test(slot)) {
+                continue;
+            }
+            const FrameSlotInfo& info = layout.slots[slot];
+            out += firstVariable ? "{\"name\":" : ",{\"name\":";
+            writeJsonString(out, info.name);
+            out += ",\"value\":";
+            writeJsonString(out, formatSlotValue(info.type, frame.slots[slot]));
+            out += info.type == SLOT_POINTER ? ",\"pointer\":true}" : ",\"pointer\":false}";
+            firstVariable = false;
+        }
+        out += "]}";
+        firstFrame = false;
+    }
+
+    out += "],\"heap\":[";
+    bool firstObject = true;
+    for (const auto& [address, object] : state.heap) {
+        out += firstObject ? "{\"address\":" : ",{\"address\":";
+        writeJsonString(out, address);
+        out += ",\"value\":";
+        writeJsonString(out, object.value);
+        out += "}";
+        firstObject = false;
+    }
+    out += "]";
+}
+
+// Salida de --headless: acumula lo escrito y lo vuelca en escrituras grandes y secuenciales
+class HeadlessWriter {
+public:
+    ~HeadlessWriter() {
+        if (file && file != stdout) {
+            std::fclose(file);
+        }
+    }
+
+    bool open(const std::string& path) {
+        file = path == "-" ? stdout : std::fopen(path.c_str(), "wb");
+        buffer.reserve(HEADLESS_WRITE_BYTES + HEADLESS_WRITE_BYTES / 4);
+        return file != nullptr;
+    }
+
+    std::string& data() { return buffer; }
+
+    void flushIfFull() {
+        if (buffer.size() >= HEADLESS_WRITE_BYTES) {
+            flush();
+        }
+    }
+
+    bool close() {
+        flush();
+        bool ok = std::fflush(file) == 0 && !std::ferror(file);
+        if (file != stdout) {
+            ok = std::fclose(file) == 0 && ok;
+        }
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    void flush() {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+
+    std::FILE* file = nullptr;
+    std::string buffer;
+};
+
+// Un objeto JSON por línea y por paso; se recorre en orden: cada paso solo aplica sus propios deltas
+void writeHeadlessNdjson(HeadlessWriter& writer) {
+    SimulationState state;
+    const size_t stepCount = getSimulationStepCount();
+    for (size_t i = getSimulationFirstStep(); i < stepCount; ++i) {
+        const SimulationStep& step = loadSimulationStep(state, i);
+        std::string& out = writer.data();
+        out += "{\"step\":" + std::to_string(i) + ",";
+        writeStepFields(out, step, state);
+        out += "}\n";
+        writer.flushIfFull();
+    }
+}
+
+// --format=chrome: formato Trace Event de Chrome (chrome://tracing, Perfetto). Cada paso es un instante
+// (1 µs por paso), cada llamada un tramo B/E y cada variable entera un contador "función.variable".
+// Los tramos y contadores salen de los deltas entre un paso y el siguiente; si no son contiguos (el
+// primer paso conservado con --trace-budget), se comparan con el estado reconstruido.
+class ChromeTraceWriter {
+public:
+    explicit ChromeTraceWriter(HeadlessWriter& writer) : writer(writer) {
+        const SimulationProgram& program = getActiveSimulationProgram();
+        counterNames.resize(program.frameLayoutCount);
+        for (int layout = 0; layout < program.frameLayoutCount; ++layout) {
+            const FrameLayout& frameLayout = program.frameLayouts[layout];
+            for (int slot = 0; slot < frameLayout.slotCount; ++slot) {
+                std::string name;
+                writeJsonString(name, std::string(frameLayout.functionName) + "." + frameLayout.slots[slot].name);
+                counterNames[layout].push_back(name);
+            }
+        }
+        lastValues.resize(program.frameLayoutCount * SIM_MAX_FRAME_SLOTS);
+        hasValue.resize(lastValues.size());
+    }
+
+    void begin() {
+        writer.data() += "{\"traceEvents\":[\n"
+                         "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"simulation\"}},\n"
+                         "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"main\"}}";
+    }
+
+    void step(size_t index, const SimulationStep& step, const SimulationState& state, size_t previousPosition, bool contiguous) {
+        timestamp = std::to_string(index);
+        if (contiguous) {
+            for (size_t i = previousPosition; i < state.deltaPosition; ++i) {
+                applyDelta(simulationDeltas[i]);
+            }
+        } else {
+            resync(state);
+        }
+        const StepDescriptor& descriptor = getStepDescriptor(step.descriptor);
+        std::string& out = writer.data();
+        out += ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":" + timestamp + ",\"cat\":\"";
+        out += STEP_COLOR_NAMES[descriptor.color];
+        out += "\",\"name\":";
+        writeJsonString(out, formatStepDescription(step));
+        out += ",\"args\":{\"step\":" + timestamp + ",\"line\":" + std::to_string(descriptor.line) + "}}";
+        writer.flushIfFull();
+    }
+
+    // Cierra los tramos que siguen abiertos (programa detenido por un límite)
+    void finish() {
+        while (!openLayouts.empty()) {
+            endSlice();
+        }
+        writer.data() += "\n]}\n";
+    }
+
+private:
+    void applyDelta(const TraceDelta& delta) {
+        switch (delta.kind) {
+            case DELTA_PUSH_FRAME:
+                beginSlice(delta.layout);
+                break;
+            case DELTA_POP_FRAME:
+                if (!openLayouts.empty()) {
+                    endSlice();
+                }
+                break;
+            case DELTA_SLOT_WRITE:
+                if (delta.frame < openLayouts.size()) {
+                    writeCounter(openLayouts[openLayouts.size() - 1 - delta.frame], delta.slot, delta.value);
+                }
+                break;
+            case DELTA_HEAP_WRITE:
+                break;
+        }
+    }
+
+    // Mantiene los tramos de los marcos que siguen en la pila (mismo layout a la misma profundidad)
+    void resync(const SimulationState& state) {
+        size_t common = 0;
+        while (common < openLayouts.size() && common < state.frames.size() && openLayouts[common] == state.frames[common].layout) {
+            ++common;
+        }
+        while (openLayouts.size() > common) {
+            endSlice();
+        }
+        for (size_t i = common; i < state.frames.size(); ++i) {
+            beginSlice(state.frames[i].layout);
+        }
+        for (const StackFrame& frame : state.frames) {
+            const FrameLayout& layout = getFrameLayout(frame.layout);
+            for (int slot = 0; slot < layout.slotCount; ++slot) {
+                if (frame.live.test(slot)) {
+                    writeCounter(frame.layout, slot, frame.slots[slot]);
+                }
+            }
+        }
+    }
+
+    void beginSlice(unsigned short layout) {
+        openLayouts.push_back(layout);
+        std::string& out = writer.data();
+        out += ",\n{\"ph\":\"B\",\"pid\":1,\"tid\":1,\"ts\":" + timestamp + ",\"cat\":\"call\",\"name\":";
+        writeJsonString(out, getFrameLayout(layout).functionName);
+        out += "}";
+    }
+
+    void endSlice() {
+        openLayouts.pop_back();
+        writer.data() += ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":1,\"ts\":" + timestamp + "}";
+    }
+
+    // Solo los cambios de valor; los punteros no son contadores
+    void writeCounter(unsigned short layout, int slot, long long value) {
+        const FrameLayout& frameLayout = getFrameLayout(layout);
+        if (slot >= frameLayout.slotCount || frameLayout.slots[slot].type != SLOT_INT) {
+            return;
+        }
+        const size_t key = layout * SIM_MAX_FRAME_SLOTS + slot;
+        if (hasValue[key] && lastValues[key] == value) {
+            return;
+        }
+        hasValue[key] = true;
+        lastValues[key] = value;
+        std::string& out = writer.data();
+        out += ",\n{\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":" + timestamp + ",\"name\":";
+        out += counterNames[layout][slot];
+        out += ",\"args\":{\"value\":" + std::to_string(value) + "}}";
+    }
+
+    HeadlessWriter& writer;
+    std::string timestamp; // Del paso en curso: los deltas anteriores a él comparten su instante
+    std::vector<unsigned short> openLayouts;          // Tramos abiertos, uno por marco de la pila
+    std::vector<std::vector<std::string>> counterNames; // Por layout y slot, ya en JSON
+    std::vector<long long> lastValues;                // Último valor emitido por (layout, slot)
+    std::vector<bool> hasValue;
+};
+
+void writeHeadlessChrome(HeadlessWriter& writer) {
+    ChromeTraceWriter chrome(writer);
+    chrome.begin();
+    SimulationState state;
+    const size_t stepCount = getSimulationStepCount();
+    for (size_t i = getSimulationFirstStep(); i < stepCount; ++i) {
+        const size_t previousStep = state.step;
+        const size_t previousTrace = state.trace;
+        const size_t previousPosition = state.deltaPosition;
+        const SimulationStep& step = loadSimulationStep(state, i);
+        const bool contiguous = previousStep != SIZE_MAX && state.trace == previousTrace && state.step == previousStep + 1;
+        chrome.step(i, step, state, previousPosition, contiguous);
+    }
+    chrome.finish();
+}
+
+// Firma y registros del flujo en vivo: tablas del programa, bloques sin comprimir y total de pasos
+void writeHeadlessBinary(HeadlessWriter& writer) {
+    const SimulationProgram& program = getActiveSimulationProgram();
+    writer.data().append(HEADLESS_BINARY_MAGIC, sizeof(HEADLESS_BINARY_MAGIC));
+    appendStreamRunBegin(writer.data(), program, 0);
+    TraceStringTable strings;
+    std::string stringData;
+    encodeRecordedTraceBlocks(HEADLESS_BLOCK_STEPS, stringArgumentMasks(program), strings, [&](size_t first, size_t count, std::string& raw) {
+        stringData = strings.data();
+        appendStreamBlock(writer.data(), first, static_cast<uint32_t>(count), stringData, raw);
+        strings.clear(); // Cada bloque lleva sus propias cadenas
+        writer.flushIfFull();
+    });
+    appendStreamRunEnd(writer.data(), getSimulationStepCount(), getSimulationDroppedSteps());
+}
+
+} // namespace
+
+std::string formatSimulationTraceJson() {
+    std::string out = "{\"steps\":[\n";
+    SimulationState state; // Se recorre en orden: cada paso solo aplica sus propios deltas
+    const size_t stepCount = getSimulationStepCount();
+    for (size_t i = 0; i < stepCount; ++i) {
+        const SimulationStep& step = loadSimulationStep(state, i);
+        out += "{";
+        writeStepFields(out, step, state);
+        out += i + 1 < stepCount ? "},\n" : "}\n";
+    }
+    out += "]}\n";
+    return out;
+}
+
+int runSimulationTraceExport(const SimulationProgram& program, const std::string& outputBase) {
+    runSimulationProgram(program);
+    return writeSimulationTrace(outputBase);
+}
+
+int writeSimulationTrace(const std::string& outputBase) {
+    const std::string json = formatSimulationTraceJson();
+
+    std::ofstream jsonFile(outputBase + ".json");
+    // trace.js permite abrir el visor con file:// sin servidor (los navegadores bloquean fetch() local)
+    std::ofstream scriptFile(outputBase + ".js");
+    if (!jsonFile.is_open() || !scriptFile.is_open()) {
+        std::fprintf(stderr, "Error: no se pudo escribir %s.json / %s.js\n", outputBase.c_str(), outputBase.c_str());
+        return 1;
+    }
+    jsonFile << json;
+    scriptFile << "window.SIMULATION_TRACE = " << json << ";" << std::endl;
+    std::fprintf(stderr, "steps: %zu, trace written to %s.json and %s.js\n",
+                 getSimulationStepCount(), outputBase.c_str(), outputBase.c_str());
+    return 0;
+}
+
+int runSimulationHeadless(const SimulationProgram& program, SimHeadlessFormat format, const std::string& path) {
+    HeadlessWriter writer;
+    if (!writer.open(path)) {
+        std::fprintf(stderr, "Error: no se pudo escribir %s\n", path.c_str());
+        return 1;
+    }
+    // Con la traza en la salida estándar, la del programa va a la de errores
+    std::string programOutput;
+    if (path == "-") {
+        setOutputCapture(&programOutput);
+    }
+    runSimulationProgram(program);
+    if (path == "-") {
+        setOutputCapture(nullptr);
+        std::fwrite(programOutput.data(), 1, programOutput.size(), stderr);
+    }
+    if (format == SIM_HEADLESS_BINARY) {
+        writeHeadlessBinary(writer);
+    } else if (format == SIM_HEADLESS_CHROME) {
+        writeHeadlessChrome(writer);
+    } else {
+        writeHeadlessNdjson(writer);
+    }
+    if (!writer.close()) {
+        std::fprintf(stderr, "Error: no se pudo escribir %s\n", path.c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "steps: %zu, trace written to %s\n", getSimulationStepCount(), path == "-" ? "stdout" : path.c_str());
+    return 0;
+}
@@ -0,0 +1,485 @@
+// src/runtime/TraceFile.cpp
+// Archivo binario de la traza (.simtrace): el grabador lo escribe por bloques y el visor lo proyecta
+// en memoria y decodifica solo el bloque del paso que muestra. No depende de SFML.
+#include "TraceBlock.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char TRACE_FILE_MAGIC[8] = {'S', 'I', 'M', 'T', 'R', 'A', 'C', 'E'};
+const size_t TRACE_FILE_BLOCK_STEPS = 4096; // Pasos por bloque: lo que decodifica el visor al saltar
+
+// Todas las estructuras se escriben tal cual (little-endian) y se leen con memcpy: sin requisitos de alineación
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockCount;
+    uint64_t stepCount;
+    uint32_t descriptorCount;
+    uint32_t layoutCount;
+    uint32_t slotCount;
+    uint32_t reserved;
+    uint64_t descriptorsOffset;
+    uint64_t layoutsOffset;
+    uint64_t slotsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+    uint64_t blockIndexOffset;
+};
+
+// Índice de bloques: el visor busca el bloque de un paso sin leer los anteriores
+struct TraceFileBlock {
+    uint64_t firstStep;
+    uint64_t offset;
+    uint32_t stepCount;
+    uint32_t encoding;
+    uint32_t storedSize;
+    uint32_t rawSize;
+};
+
+static_assert(sizeof(TraceFileHeader) == 88, "Cabecera del archivo de traza con relleno inesperado");
+static_assert(sizeof(TraceFileBlock) == 32, "Índice de bloques con relleno inesperado");
+
+template <typename T>
+void putTable(std::ofstream& file, const std::vector<T>& table) {
+    file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(T)));
+}
+
+// --- Lectura ---
+
+// Archivo abierto: su proyección en memoria y las tablas del programa, que apuntan a sus cadenas
+struct OpenTraceFile {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    std::string contents; // Sin mmap: el archivo se lee entero
+#endif
+    TraceFileHeader header;
+    LoadedTraceProgram tables;
+    std::vector<TraceFileBlock> blocks;
+    SimulationReplay replay;
+    std::string decoded; // Bloque descomprimido en curso
+
+    ~OpenTraceFile() {
+#ifndef _WIN32
+        if (data) {
+            munmap(const_cast<unsigned char*>(data), size);
+        }
+#endif
+    }
+
+    TraceBlockContext blockContext() const {
+        return {tables.stringArgs, tables.layouts.data(), tables.layouts.size(), reinterpret_cast<const char*>(data + header.stringsOffset), header.stringsSize};
+    }
+
+    template <typename T>
+    bool readTable(uint64_t offset, uint64_t count, std::vector<T>& table) const {
+        if (offset > size || count > (size - offset) / sizeof(T)) {
+            return false;
+        }
+        table.resize(count);
+        std::memcpy(table.data(), data + offset, count * sizeof(T));
+        return true;
+    }
+};
+
+std::unique_ptr<OpenTraceFile> openTraceFile;
+
+bool mapTraceFile(const std::string& path, OpenTraceFile& trace) {
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    trace.contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    trace.data = reinterpret_cast<const unsigned char*>(trace.contents.data());
+    trace.size = trace.contents.size();
+    return true;
+#else
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(descriptor, &info) == 0 && info.st_size > 0) {
+        mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    }
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    trace.data = static_cast<const unsigned char*>(mapping);
+    trace.size = static_cast<size_t>(info.st_size);
+    return true;
+#endif
+}
+
+// Cabecera y tablas; los bloques se validan al decodificarlos
+const char* readTraceTables(OpenTraceFile& trace) {
+    if (trace.size < sizeof(TraceFileHeader)) {
+        return "archivo demasiado corto";
+    }
+    TraceFileHeader& header = trace.header;
+    std::memcpy(&header, trace.data, sizeof(header));
+    if (std::memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        return "no es un archivo de traza";
+    }
+    if (header.version != SIM_TRACE_FILE_VERSION) {
+        return "versión del formato no soportada";
+    }
+    if (header.stringsOffset > trace.size || header.stringsSize > trace.size - header.stringsOffset ||
+        (header.stringsSize > 0 && trace.data[header.stringsOffset + header.stringsSize - 1] != '\0')) {
+        return "tabla de cadenas dañada";
+    }
+
+    TraceProgramTables tables;
+    if (!trace.readTable(header.descriptorsOffset, header.descriptorCount, tables.descriptors) ||
+        !trace.readTable(header.layoutsOffset, header.layoutCount, tables.layouts) ||
+        !trace.readTable(header.slotsOffset, header.slotCount, tables.slots) ||
+        !trace.readTable(header.blockIndexOffset, header.blockCount, trace.blocks)) {
+        return "tablas fuera del archivo";
+    }
+    if (header.stepCount > 0 && tables.descriptors.empty()) {
+        return "faltan los descriptores de los pasos";
+    }
+    if (const char* problem = decodeProgramTables(tables, reinterpret_cast<const char*>(trace.data + header.stringsOffset), header.stringsSize, trace.tables)) {
+        return problem;
+    }
+
+    uint64_t nextStep = 0;
+    for (const TraceFileBlock& block : trace.blocks) {
+        if (block.firstStep != nextStep || block.stepCount == 0 || block.offset > trace.size || block.storedSize > trace.size - block.offset) {
+            return "índice de bloques dañado";
+        }
+        nextStep += block.stepCount;
+    }
+    if (nextStep != header.stepCount) {
+        return "índice de bloques incompleto";
+    }
+    return nullptr;
+}
+
+size_t loadTraceFileWindow(size_t stepIndex) {
+    OpenTraceFile& trace = *openTraceFile;
+    const auto block = std::upper_bound(trace.blocks.begin(), trace.blocks.end(), stepIndex,
+                                        [](size_t step, const TraceFileBlock& candidate) { return step < candidate.firstStep; }) - 1;
+    TraceKeyframe initial;
+    if (!decodeTraceBlock(trace.data + block->offset, block->storedSize, block->encoding, block->rawSize, block->stepCount,
+                          trace.blockContext(), trace.decoded, initial)) {
+        // Un bloque dañado no impide ver el resto: sus pasos se muestran vacíos
+        std::fprintf(stderr, "Error: bloque dañado en el archivo de traza (pasos %llu-%llu)\n",
+                     static_cast<unsigned long long>(block->firstStep), static_cast<unsigned long long>(block->firstStep + block->stepCount - 1));
+        clearSimulationTrace();
+        initial = TraceKeyframe();
+        simulationHistory.assign(block->stepCount, SimulationStep{0, 0, 0, 0});
+        simulationStateHashes.assign(block->stepCount, 0);
+    }
+    rebuildSimulationKeyframes(initial);
+    return block->firstStep;
+}
+
+} // namespace
+
+int writeSimulationTraceFile(const std::string& path, bool compress) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        std::fprintf(stderr, "Error: no se pudo escribir %s\n", path.c_str());
+        return 1;
+    }
+    const SimulationProgram& program = getActiveSimulationProgram();
+    const std::vector<unsigned> stringArgs = stringArgumentMasks(program);
+
+    // La cabecera se reescribe al final, cuando se conocen las posiciones de las tablas
+    TraceFileHeader header = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    TraceStringTable strings;
+    std::vector<TraceFileBlock> blocks;
+    encodeRecordedTraceBlocks(TRACE_FILE_BLOCK_STEPS, stringArgs, strings, [&](size_t first, size_t count, std::string& raw) {
+        TraceFileBlock block = {first, offset, static_cast<uint32_t>(count), TRACE_BLOCK_RAW, static_cast<uint32_t>(raw.size()), static_cast<uint32_t>(raw.size())};
+        std::string compressed;
+        if (compress) {
+            compressed = compressTraceBlock(raw);
+        }
+        const bool useCompressed = compress && compressed.size() < raw.size();
+        const std::string& payload = useCompressed ? compressed : raw;
+        block.encoding = useCompressed ? TRACE_BLOCK_LZ : TRACE_BLOCK_RAW;
+        block.storedSize = static_cast<uint32_t>(payload.size());
+        file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        offset += payload.size();
+        blocks.push_back(block);
+    });
+
+    const TraceProgramTables tables = encodeProgramTables(program, strings);
+
+    std::memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+    header.version = SIM_TRACE_FILE_VERSION;
+    header.blockCount = static_cast<uint32_t>(blocks.size());
+    header.stepCount = getSimulationStepCount();
+    header.descriptorCount = static_cast<uint32_t>(tables.descriptors.size());
+    header.layoutCount = static_cast<uint32_t>(tables.layouts.size());
+    header.slotCount = static_cast<uint32_t>(tables.slots.size());
+    header.descriptorsOffset = offset;
+    header.layoutsOffset = header.descriptorsOffset + tables.descriptors.size() * sizeof(TraceFileDescriptor);
+    header.slotsOffset = header.layoutsOffset + tables.layouts.size() * sizeof(TraceFileLayout);
+    header.stringsOffset = header.slotsOffset + tables.slots.size() * sizeof(TraceFileSlot);
+    header.stringsSize = strings.data().size();
+    header.blockIndexOffset = header.stringsOffset + header.stringsSize;
+    putTable(file, tables.descriptors);
+    putTable(file, tables.layouts);
+    putTable(file, tables.slots);
+    file.write(strings.data().data(), static_cast<std::streamsize>(strings.data().size()));
+    putTable(file, blocks);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!file) {
+        std::fprintf(stderr, "Error: no se pudo escribir %s\n", path.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+int runSimulationRecorder(const SimulationProgram& program, const std::string& path) {
+    runSimulationProgram(program);
+    const int exitCode = writeSimulationTraceFile(path);
+    if (exitCode == 0) {
+        std::fprintf(stderr, "steps: %zu, trace written to %s\n", getSimulationStepCount(), path.c_str());
+    }
+    return exitCode;
+}
+
+bool openSimulationTraceFile(const std::string& path) {
+    auto trace = std::make_unique<OpenTraceFile>();
+    if (!mapTraceFile(path, *trace)) {
+        std::fprintf(stderr, "Error: no se pudo abrir %s\n", path.c_str());
+        return false;
+    }
+    if (const char* problem = readTraceTables(*trace)) {
+        std::fprintf(stderr, "Error: %s: %s\n", path.c_str(), problem);
+        return false;
+    }
+    trace->replay = {static_cast<size_t>(trace->header.stepCount), loadTraceFileWindow};
+
+    openTraceFile = std::move(trace);
+    attachSimulationProgram(openTraceFile->tables.program);
+    setSimulationReplay(&openTraceFile->replay);
+    clearSimulationTrace(); // El primer paso que se pida carga su bloque
+    discardSimulationChangeIndex(); // El índice era de la traza registrada, no de la del archivo
+    return true;
+}
+
+// --- Comparación de trazas (sim_trace_diff) ---
+
+namespace {
+
+// Hashes de los pasos de un archivo: solo se descomprime el bloque del paso consultado
+struct TraceFileHashes {
+    OpenTraceFile trace;
+    size_t block = SIZE_MAX;
+    std::string decoded;
+    std::vector<uint64_t> hashes;
+
+    bool open(const std::string& path) {
+        if (!mapTraceFile(path, trace)) {
+            std::fprintf(stderr, "Error: no se pudo abrir %s\n", path.c_str());
+            return false;
+        }
+        if (const char* problem = readTraceTables(trace)) {
+            std::fprintf(stderr, "Error: %s: %s\n", path.c_str(), problem);
+            return false;
+        }
+        return true;
+    }
+
+    bool at(size_t step, uint64_t& hash) {
+        if (block == SIZE_MAX || step < trace.blocks[block].firstStep || step - trace.blocks[block].firstStep >= trace.blocks[block].stepCount) {
+            block = std::upper_bound(trace.blocks.begin(), trace.blocks.end(), step,
+                                     [](size_t value, const TraceFileBlock& candidate) { return value < candidate.firstStep; }) - trace.blocks.begin() - 1;
+            const TraceFileBlock& found = trace.blocks[block];
+            if (!decodeTraceBlockHashes(trace.data + found.offset, found.storedSize, found.encoding, found.rawSize, found.stepCount, decoded, hashes)) {
+                block = SIZE_MAX;
+                return false;
+            }
+        }
+        hash = hashes[step - trace.blocks[block].firstStep];
+        return true;
+    }
+};
+
+struct SnapshotVariable {
+    std::string name;
+    SlotType type;
+    long long value;
+};
+
+// Estado de un paso con nombres en lugar de índices: sus tablas son las de su propio archivo
+struct StepSnapshot {
+    std::string description;
+    int line = 0;
+    std::vector<std::string> functions; // Por profundidad
+    std::vector<std::vector<SnapshotVariable>> variables;
+    HeapObjectMap heap;
+};
+
+bool snapshotTraceFileStep(const std::string& path, size_t stepIndex, StepSnapshot& snapshot) {
+    if (!openSimulationTraceFile(path)) {
+        return false;
+    }
+    SimulationState state;
+    const SimulationStep& step = loadSimulationStep(state, stepIndex);
+    snapshot.description = formatStepDescription(step);
+    snapshot.line = getStepDescriptor(step.descriptor).line;
+    for (const StackFrame& frame : state.frames) {
+        const FrameLayout& layout = getFrameLayout(frame.layout);
+        snapshot.functions.push_back(layout.functionName);
+        auto& variables = snapshot.variables.emplace_back();
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            if (frame.live.test(slot)) {
+                variables.push_back({layout.slots[slot].name, layout.slots[slot].type, frame.slots[slot]});
+            }
+        }
+    }
+    snapshot.heap = state.heap;
+    return true;
+}
+
+const SnapshotVariable* findSnapshotVariable(const std::vector<SnapshotVariable>& variables, const std::string& name) {
+    for (const SnapshotVariable& variable : variables) {
+        if (variable.name == name) {
+            return &variable;
+        }
+    }
+    return nullptr;
+}
+
+// Igualdad del hash: de un puntero solo cuenta si es nulo
+bool sameSnapshotValue(const SnapshotVariable& first, const SnapshotVariable& second) {
+    if (first.type == SLOT_POINTER || second.type == SLOT_POINTER) {
+        return first.type == second.type && (first.value != 0) == (second.value != 0);
+    }
+    return first.value == second.value;
+}
+
+std::string snapshotValue(const SnapshotVariable* variable) {
+    return variable ? formatSlotValue(variable->type, variable->value) : "(undeclared)";
+}
+
+// Diferencias entre los estados de los dos pasos, una por línea
+std::vector<std::string> compareSnapshots(const StepSnapshot& first, const StepSnapshot& second) {
+    std::vector<std::string> differences;
+    const size_t depthCount = std::max(first.functions.size(), second.functions.size());
+    for (size_t depth = 0; depth < depthCount; ++depth) {
+        const std::string prefix = "[" + std::to_string(depth) + "] ";
+        if (depth >= first.functions.size() || depth >= second.functions.size()) {
+            const bool inFirst = depth < first.functions.size();
+            const std::string& function = inFirst ? first.functions[depth] : second.functions[depth];
+            differences.push_back(prefix + "call " + function + ": only in the " + (inFirst ? "first" : "second") + " trace");
+            continue;
+        }
+        if (first.functions[depth] != second.functions[depth]) {
+            differences.push_back(prefix + "call: " + first.functions[depth] + " vs " + second.functions[depth]);
+            continue;
+        }
+        const std::string scope = prefix + first.functions[depth] + ".";
+        for (const SnapshotVariable& variable : first.variables[depth]) {
+            const SnapshotVariable* other = findSnapshotVariable(second.variables[depth], variable.name);
+            if (!other || !sameSnapshotValue(variable, *other)) {
+                differences.push_back(scope + variable.name + ": " + snapshotValue(&variable) + " vs " + snapshotValue(other));
+            }
+        }
+        for (const SnapshotVariable& variable : second.variables[depth]) {
+            if (!findSnapshotVariable(first.variables[depth], variable.name)) {
+                differences.push_back(scope + variable.name + ": " + snapshotValue(nullptr) + " vs " + snapshotValue(&variable));
+            }
+        }
+    }
+    // Como en el hash, cuenta el texto del objeto (que incluye el estado y los tamaños de un bloque)
+    for (const auto& [address, object] : first.heap) {
+        auto other = second.heap.find(address);
+        if (other == second.heap.end() || other->second.value != object.value) {
+            differences.push_back("heap " + address + ": " + object.value + " vs " + (other == second.heap.end() ? "(none)" : other->second.value));
+        }
+    }
+    for (const auto& [address, object] : second.heap) {
+        if (first.heap.find(address) == first.heap.end()) {
+            differences.push_back("heap " + address + ": (none) vs " + object.value);
+        }
+    }
+    return differences;
+}
+
+} // namespace
+
+int runSimulationTraceDiff(const std::string& firstPath, const std::string& secondPath) {
+    TraceFileHashes first;
+    TraceFileHashes second;
+    if (!first.open(firstPath) || !second.open(secondPath)) {
+        return 2;
+    }
+    const size_t firstCount = static_cast<size_t>(first.trace.header.stepCount);
+    const size_t secondCount = static_cast<size_t>(second.trace.header.stepCount);
+    const size_t common = std::min(firstCount, secondCount);
+
+    // El hash encadenado del paso k coincide solo si coinciden los estados de todos los pasos hasta k:
+    // el primer paso distinto se encuentra por bisección, descomprimiendo unos pocos bloques
+    size_t low = 0;
+    size_t high = common;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        uint64_t firstHash = 0;
+        uint64_t secondHash = 0;
+        if (!first.at(middle, firstHash) || !second.at(middle, secondHash)) {
+            std::fprintf(stderr, "Error: bloque dañado en el archivo de traza (paso %zu)\n", middle);
+            return 2;
+        }
+        if (firstHash == secondHash) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if (low == common) {
+        if (firstCount == secondCount) {
+            std::printf("traces match: %zu steps\n", common);
+            return 0;
+        }
+        const bool firstLonger = firstCount > secondCount;
+        std::printf("traces match for the first %zu steps; %s continues for %zu more\n", common,
+                    (firstLonger ? firstPath : secondPath).c_str(), (firstLonger ? firstCount : secondCount) - common);
+        return 1;
+    }
+
+    StepSnapshot firstState;
+    StepSnapshot secondState;
+    if (!snapshotTraceFileStep(firstPath, low, firstState) || !snapshotTraceFileStep(secondPath, low, secondState)) {
+        return 2;
+    }
+    std::printf("traces diverge at step %zu (of %zu and %zu)\n", low, firstCount, secondCount);
+    std::printf("  %s: line %d: %s\n", firstPath.c_str(), firstState.line, firstState.description.c_str());
+    std::printf("  %s: line %d: %s\n", secondPath.c_str(), secondState.line, secondState.description.c_str());
+    const std::vector<std::string> differences = compareSnapshots(firstState, secondState);
+    if (differences.empty()) {
+        std::printf("  (the states hash differently but compare equal)\n"); // Colisión del hash
+    }
+    for (const std::string& difference : differences) {
+        std::printf("  %s\n", difference.c_str());
+    }
+    return 1;
+}
@@ -0,0 +1,13 @@
+// src/runtime/TraceFileViewerMain.cpp
+// sim_trace_viewer: abre en el visor SFML una traza grabada (.simtrace) sin volver a ejecutar el programa.
+#include "SimulationRuntime.h"
+
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <trace.simtrace>\n", argv[0]);
+        return 1;
+    }
+    return runSimulationTraceFileViewer(argv[1]);
+}
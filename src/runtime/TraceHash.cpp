@@ -0,0 +1,140 @@
+// src/runtime/TraceHash.cpp
+// Hash del estado de la simulación: se actualiza en cada escritura y cada paso guarda su valor encadenado
+#include "SimulationRuntime.h"
+
+uint64_t simulationStateHash = 0;
+std::vector<LayoutHashKeys> simulationHashKeys;
+
+namespace {
+
+uint64_t traceHash = 0; // Hash encadenado del último paso registrado
+
+// FNV-1a: los nombres de funciones y variables, y el contenido del heap
+uint64_t hashText(const char* text, uint64_t hash = 0xcbf29ce484222325ULL) {
+    for (; *text; ++text) {
+        hash = (hash ^ static_cast<unsigned char>(*text)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+uint64_t frameStateHash(size_t depth, int layout) {
+    return mixStateHash(simulationHashKeys[layout].function ^ (depth * 0x9e3779b97f4a7c15ULL));
+}
+
+uint64_t heapStateHash(const std::string& address, const std::string& value) {
+    return mixStateHash(hashText(address.c_str()) + mixStateHash(hashText(value.c_str())));
+}
+
+uint64_t stackFrameStateHash(size_t depth, const StackFrame& frame) {
+    const LayoutHashKeys& keys = simulationHashKeys[frame.layout];
+    uint64_t hash = frameStateHash(depth, frame.layout);
+    for (size_t slot = 0; slot < keys.slots.size(); ++slot) {
+        if (frame.live.test(slot)) {
+            hash += slotStateHash(depth, keys.slots[slot], frame.slots[slot]);
+        }
+    }
+    return hash;
+}
+
+// Aplica un delta a una copia del estado actualizando simulationStateHash, como lo haría el registro
+void hashDelta(const TraceDelta& delta, std::vector<StackFrame>& frames, HeapObjectMap& heap) {
+    switch (delta.kind) {
+        case DELTA_PUSH_FRAME: {
+            hashPushedStackFrame(frames.size(), delta.layout);
+            StackFrame& frame = frames.emplace_back();
+            frame.layout = delta.layout;
+            frame.live.reset();
+            break;
+        }
+        case DELTA_POP_FRAME:
+            if (!frames.empty()) {
+                hashPoppedStackFrame(frames.size() - 1, frames.back());
+                frames.pop_back();
+            }
+            break;
+        case DELTA_SLOT_WRITE:
+            if (delta.frame < frames.size()) {
+                const size_t depth = frames.size() - 1 - delta.frame;
+                StackFrame& frame = frames[depth];
+                const SlotHashKey& key = simulationHashKeys[frame.layout].slots[delta.slot];
+                if (frame.live.test(delta.slot)) {
+                    simulationStateHash -= slotStateHash(depth, key, frame.slots[delta.slot]);
+                }
+                simulationStateHash += slotStateHash(depth, key, delta.value);
+                frame.slots[delta.slot] = delta.value;
+                frame.live.set(delta.slot);
+            }
+            break;
+        case DELTA_HEAP_WRITE: {
+            const auto& write = simulationHeapWrites[static_cast<size_t>(delta.value)];
+            auto previous = heap.find(write.first);
+            hashHeapWrite(write.first, previous == heap.end() ? nullptr : &previous->second.value, write.second.value);
+            heap[write.first] = write.second;
+            break;
+        }
+    }
+}
+
+} // namespace
+
+void buildSimulationHashKeys(const SimulationProgram& program) {
+    simulationHashKeys.assign(program.frameLayoutCount, LayoutHashKeys());
+    for (int i = 0; i < program.frameLayoutCount; ++i) {
+        const FrameLayout& layout = program.frameLayouts[i];
+        LayoutHashKeys& keys = simulationHashKeys[i];
+        keys.function = hashText(layout.functionName);
+        for (int slot = 0; slot < layout.slotCount; ++slot) {
+            keys.slots.push_back({hashText(layout.slots[slot].name, hashText(".", keys.function)), layout.slots[slot].type == SLOT_POINTER});
+        }
+    }
+}
+
+void resetSimulationStateHash(const std::vector<StackFrame>& frames, const HeapObjectMap& heap, uint64_t lastTraceHash) {
+    simulationStateHash = 0;
+    for (size_t depth = 0; depth < frames.size(); ++depth) {
+        simulationStateHash += stackFrameStateHash(depth, frames[depth]);
+    }
+    for (const auto& [address, object] : heap) {
+        simulationStateHash += heapStateHash(address, object.value);
+    }
+    traceHash = lastTraceHash;
+}
+
+uint64_t getSimulationTraceHash() {
+    return traceHash;
+}
+
+void recordSimulationStateHash() {
+    traceHash = mixStateHash(mixStateHash(traceHash) + simulationStateHash);
+    simulationStateHashes.push_back(traceHash);
+}
+
+void hashPushedStackFrame(size_t depth, int layout) {
+    simulationStateHash += frameStateHash(depth, layout);
+}
+
+void hashPoppedStackFrame(size_t depth, const StackFrame& frame) {
+    simulationStateHash -= stackFrameStateHash(depth, frame);
+}
+
+void hashHeapWrite(const std::string& address, const std::string* previous, const std::string& value) {
+    if (previous) {
+        simulationStateHash -= heapStateHash(address, *previous);
+    }
+    simulationStateHash += heapStateHash(address, value);
+}
+
+void rehashLoadedSimulationTrace() {
+    resetSimulationStateHash({}, {}, 0);
+    simulationStateHashes.clear();
+    simulationStateHashes.reserve(simulationHistory.size());
+    std::vector<StackFrame> frames;
+    HeapObjectMap heap;
+    size_t deltaPosition = 0;
+    for (const SimulationStep& step : simulationHistory) {
+        for (; deltaPosition < step.deltaEnd; ++deltaPosition) {
+            hashDelta(simulationDeltas[deltaPosition], frames, heap);
+        }
+        recordSimulationStateHash();
+    }
+}
@@ -0,0 +1,289 @@
+// src/runtime/TraceIndex.cpp
+// Índice de cambios de la traza: para cada variable y cada dirección del heap, los pasos en que cambió
+#include "SimulationRuntime.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+
+namespace {
+
+struct VariableChange {
+    size_t step;
+    long long value; // Valor a partir de ese paso
+};
+
+// Una llamada a función: sus variables se indexan por (instancia, slot)
+struct FrameInstance {
+    size_t pushStep; // Primer paso en que el marco está en la pila
+    size_t popStep;  // Primer paso en que ya no está (SIM_NO_STEP si sigue al final de la traza)
+};
+
+struct ChangeIndex {
+    bool building = false;
+    bool available = false;
+    size_t nextStep = 0;    // Índice global del próximo paso registrado
+    size_t stepOffset = 0;  // Pasos descartados al principio (--trace-overflow=drop): no se pueden ver
+    std::vector<FrameInstance> instances;
+    std::vector<uint32_t> instanceStack;                    // Instancias de los marcos en curso
+    std::vector<std::vector<uint32_t>> instancesByDepth;    // Por profundidad, en orden de llamada
+    std::unordered_map<uint64_t, std::vector<VariableChange>> variables; // (instancia << 8 | slot)
+    std::unordered_map<std::string, std::vector<size_t>> heap;
+};
+
+ChangeIndex changeIndex;
+bool changeIndexRequested = false; // requestSimulationChangeIndex(): lo construye el próximo registro
+thread_local size_t deltaCursor = 0; // Deltas ya indexados de la traza en memoria (la de cada hilo)
+
+uint64_t variableKey(uint32_t instance, int slot) {
+    return static_cast<uint64_t>(instance) << 8 | static_cast<unsigned char>(slot);
+}
+
+void indexDelta(const TraceDelta& delta, size_t step) {
+    switch (delta.kind) {
+        case DELTA_PUSH_FRAME: {
+            const uint32_t instance = static_cast<uint32_t>(changeIndex.instances.size());
+            changeIndex.instances.push_back({step, SIM_NO_STEP});
+            if (changeIndex.instancesByDepth.size() <= changeIndex.instanceStack.size()) {
+                changeIndex.instancesByDepth.emplace_back();
+            }
+            changeIndex.instancesByDepth[changeIndex.instanceStack.size()].push_back(instance);
+            changeIndex.instanceStack.push_back(instance);
+            break;
+        }
+        case DELTA_POP_FRAME:
+            if (!changeIndex.instanceStack.empty()) {
+                changeIndex.instances[changeIndex.instanceStack.back()].popStep = step;
+                changeIndex.instanceStack.pop_back();
+            }
+            break;
+        case DELTA_SLOT_WRITE: {
+            if (delta.frame >= changeIndex.instanceStack.size()) {
+                break;
+            }
+            const uint32_t instance = changeIndex.instanceStack[changeIndex.instanceStack.size() - 1 - delta.frame];
+            auto& changes = changeIndex.variables[variableKey(instance, delta.slot)];
+            if (!changes.empty() && changes.back().value == delta.value) {
+                break; // Se reescribió el mismo valor
+            }
+            if (!changes.empty() && changes.back().step == step) {
+                changes.back().value = delta.value; // Varias escrituras antes del mismo paso
+                if (changes.size() > 1 && changes[changes.size() - 2].value == delta.value) {
+                    changes.pop_back(); // Volvió al valor que tenía
+                }
+            } else {
+                changes.push_back({step, delta.value});
+            }
+            break;
+        }
+        case DELTA_HEAP_WRITE: {
+            auto& changes = changeIndex.heap[simulationHeapWrites[static_cast<size_t>(delta.value)].first];
+            if (changes.empty() || changes.back() != step) {
+                changes.push_back(step);
+            }
+            break;
+        }
+    }
+}
+
+// Instancia del marco a esa profundidad en el paso: la última llamada a esa profundidad que empezó antes
+const FrameInstance* frameInstanceAt(size_t stepIndex, size_t frameDepth, uint32_t& instance) {
+    if (frameDepth >= changeIndex.instancesByDepth.size()) {
+        return nullptr;
+    }
+    const auto& calls = changeIndex.instancesByDepth[frameDepth];
+    auto it = std::upper_bound(calls.begin(), calls.end(), stepIndex,
+                               [](size_t step, uint32_t id) { return step < changeIndex.instances[id].pushStep; });
+    if (it == calls.begin()) {
+        return nullptr;
+    }
+    instance = *(it - 1);
+    const FrameInstance& frame = changeIndex.instances[instance];
+    return frame.popStep == SIM_NO_STEP || stepIndex < frame.popStep ? &frame : nullptr;
+}
+
+const std::vector<VariableChange>* variableChanges(size_t stepIndex, size_t frameDepth, int slot) {
+    uint32_t instance = 0;
+    if (!changeIndex.available || !frameInstanceAt(stepIndex, frameDepth, instance)) {
+        return nullptr;
+    }
+    auto it = changeIndex.variables.find(variableKey(instance, slot));
+    return it == changeIndex.variables.end() ? nullptr : &it->second;
+}
+
+// Índices del visor <-> índices del registro
+size_t recordedStep(size_t stepIndex) {
+    return stepIndex + changeIndex.stepOffset;
+}
+
+size_t viewerStep(size_t step) {
+    return step == SIM_NO_STEP || step < changeIndex.stepOffset ? SIM_NO_STEP : step - changeIndex.stepOffset;
+}
+
+bool compareValues(long long value, const std::string& op, long long operand) {
+    if (op == "<") return value < operand;
+    if (op == "<=") return value <= operand;
+    if (op == ">") return value > operand;
+    if (op == ">=") return value >= operand;
+    if (op == "==") return value == operand;
+    return value != operand;
+}
+
+} // namespace
+
+void beginSimulationChangeIndex() {
+    changeIndex = ChangeIndex();
+    deltaCursor = 0;
+    changeIndex.building = changeIndexRequested;
+    changeIndexRequested = false;
+}
+
+void requestSimulationChangeIndex() {
+    changeIndexRequested = true;
+}
+
+void indexSimulationStepDeltas() {
+    if (!changeIndex.building) {
+        return;
+    }
+    const size_t step = changeIndex.nextStep++;
+    for (; deltaCursor < simulationDeltas.size(); ++deltaCursor) {
+        indexDelta(simulationDeltas[deltaCursor], step);
+    }
+}
+
+void resetSimulationChangeIndexCursor() {
+    deltaCursor = 0;
+}
+
+void finishSimulationChangeIndex() {
+    if (!changeIndex.building) {
+        return;
+    }
+    changeIndex.stepOffset = getSimulationDroppedSteps();
+    changeIndex.building = false;
+    changeIndex.available = true;
+    changeIndex.instanceStack.clear();
+}
+
+void discardSimulationChangeIndex() {
+    changeIndex = ChangeIndex();
+}
+
+void indexLoadedSimulationTrace() {
+    changeIndex = ChangeIndex();
+    deltaCursor = 0;
+    for (size_t step = 0; step < simulationHistory.size(); ++step) {
+        for (; deltaCursor < simulationHistory[step].deltaEnd; ++deltaCursor) {
+            indexDelta(simulationDeltas[deltaCursor], step);
+        }
+    }
+    changeIndex.building = true;
+    finishSimulationChangeIndex();
+}
+
+bool hasSimulationChangeIndex() {
+    return changeIndex.available;
+}
+
+size_t findNextVariableChange(size_t stepIndex, size_t frameDepth, int slot) {
+    stepIndex = recordedStep(stepIndex);
+    const auto* changes = variableChanges(stepIndex, frameDepth, slot);
+    if (!changes) {
+        return SIM_NO_STEP;
+    }
+    auto it = std::upper_bound(changes->begin(), changes->end(), stepIndex,
+                               [](size_t step, const VariableChange& change) { return step < change.step; });
+    return it == changes->end() ? SIM_NO_STEP : viewerStep(it->step);
+}
+
+size_t findPreviousVariableChange(size_t stepIndex, size_t frameDepth, int slot) {
+    stepIndex = recordedStep(stepIndex);
+    const auto* changes = variableChanges(stepIndex, frameDepth, slot);
+    if (!changes) {
+        return SIM_NO_STEP;
+    }
+    auto it = std::lower_bound(changes->begin(), changes->end(), stepIndex,
+                               [](const VariableChange& change, size_t step) { return change.step < step; });
+    return it == changes->begin() ? SIM_NO_STEP : viewerStep((it - 1)->step);
+}
+
+size_t findNextHeapChange(size_t stepIndex, const std::string& address) {
+    stepIndex = recordedStep(stepIndex);
+    auto found = changeIndex.heap.find(address);
+    if (!changeIndex.available || found == changeIndex.heap.end()) {
+        return SIM_NO_STEP;
+    }
+    auto it = std::upper_bound(found->second.begin(), found->second.end(), stepIndex);
+    return it == found->second.end() ? SIM_NO_STEP : viewerStep(*it);
+}
+
+size_t findPreviousHeapChange(size_t stepIndex, const std::string& address) {
+    stepIndex = recordedStep(stepIndex);
+    auto found = changeIndex.heap.find(address);
+    if (!changeIndex.available || found == changeIndex.heap.end()) {
+        return SIM_NO_STEP;
+    }
+    auto it = std::lower_bound(found->second.begin(), found->second.end(), stepIndex);
+    return it == found->second.begin() ? SIM_NO_STEP : viewerStep(*(it - 1));
+}
+
+size_t findConditionStep(size_t stepIndex, const SimulationState& state, const std::string& condition, std::string& error) {
+    // Forma 'nombre op entero'; los espacios son opcionales
+    std::string text;
+    for (char c : condition) {
+        if (c != ' ') {
+            text += c;
+        }
+    }
+    const size_t opStart = text.find_first_of("<>=!");
+    const size_t opEnd = opStart == std::string::npos ? opStart : text.find_first_not_of("<>=!", opStart);
+    const std::string name = text.substr(0, opStart);
+    const std::string op = opStart == std::string::npos ? "" : text.substr(opStart, opEnd - opStart);
+    const std::string operandText = opEnd == std::string::npos ? "" : text.substr(opEnd);
+    char* operandEnd = nullptr;
+    const long long operand = std::strtoll(operandText.c_str(), &operandEnd, 10);
+    if (name.empty() || operandText.empty() || *operandEnd != '\0' ||
+        (op != "<" && op != "<=" && op != ">" && op != ">=" && op != "==" && op != "!=")) {
+        error = "expected 'variable op integer', e.g. x > 10";
+        return SIM_NO_STEP;
+    }
+    if (!changeIndex.available) {
+        error = "this trace has no change index";
+        return SIM_NO_STEP;
+    }
+
+    // La variable visible: la del marco más interno que la tenga declarada
+    stepIndex = recordedStep(stepIndex);
+    for (size_t depth = state.frames.size(); depth-- > 0;) {
+        const StackFrame& frame = state.frames[depth];
+        const FrameLayout& layout = getFrameLayout(frame.layout);
+        for (int slot = layout.slotCount - 1; slot >= 0; --slot) {
+            if (!frame.live.test(slot) || name != layout.slots[slot].name) {
+                continue;
+            }
+            uint32_t instance = 0;
+            const FrameInstance* call = frameInstanceAt(stepIndex, depth, instance);
+            const auto* changes = variableChanges(stepIndex, depth, slot);
+            if (!call || !changes) {
+                error = "'" + name + "' is not indexed at this step";
+                return SIM_NO_STEP;
+            }
+            // Solo puede empezar a cumplirse en el paso actual o en uno de sus cambios
+            auto it = std::upper_bound(changes->begin(), changes->end(), stepIndex,
+                                       [](size_t step, const VariableChange& change) { return step < change.step; });
+            if (it != changes->begin() && compareValues((it - 1)->value, op, operand)) {
+                return viewerStep(stepIndex);
+            }
+            for (; it != changes->end() && (call->popStep == SIM_NO_STEP || it->step < call->popStep); ++it) {
+                if (compareValues(it->value, op, operand)) {
+                    return viewerStep(it->step);
+                }
+            }
+            error = "'" + condition + "' does not hold again while " + name + " is in scope";
+            return SIM_NO_STEP;
+        }
+    }
+    error = "no variable '" + name + "' at this step";
+    return SIM_NO_STEP;
+}
@@ -0,0 +1,872 @@
+// src/runtime/TraceStream.cpp
+// Flujo en vivo de la traza (--stream): el programa publica sus bloques de pasos en un anillo de memoria
+// compartida POSIX y un visor de larga duración (sim_stream_viewer) los muestra mientras llegan. No depende de SFML.
+#include "TraceBlock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Cada registro: cabecera de 8 bytes y contenido, redondeado a 8 bytes
+enum StreamRecordKind : uint32_t { STREAM_RUN_BEGIN = 1, STREAM_BLOCK, STREAM_RUN_END };
+
+struct StreamRecordHeader {
+    uint32_t size; // Bytes del contenido
+    uint32_t kind;
+};
+
+// STREAM_RUN_BEGIN: tablas del programa (como en el .simtrace) y su tabla de cadenas
+struct StreamRunBegin {
+    uint32_t descriptorCount;
+    uint32_t layoutCount;
+    uint32_t slotCount;
+    uint32_t stringsSize;
+    int32_t pid;
+    uint32_t reserved;
+};
+
+// STREAM_BLOCK: sus cadenas y el bloque sin comprimir
+struct StreamBlock {
+    uint64_t firstStep; // Desde el principio del programa: un salto es un tramo descartado
+    uint32_t stepCount;
+    uint32_t stringsSize;
+};
+
+// STREAM_RUN_END
+struct StreamRunEnd {
+    uint64_t stepCount;
+    uint64_t droppedSteps;
+};
+
+static_assert(sizeof(StreamRecordHeader) == 8 && sizeof(StreamRunBegin) == 24 && sizeof(StreamBlock) == 16 && sizeof(StreamRunEnd) == 16,
+              "Registros del anillo con relleno inesperado");
+
+template <typename T>
+void putRecordPart(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void putRecordTable(std::string& out, const std::vector<T>& table) {
+    out.append(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(T));
+}
+
+size_t recordBytes(size_t payloadSize) {
+    return (sizeof(StreamRecordHeader) + payloadSize + 7) / 8 * 8;
+}
+
+// Empieza un registro: su cabecera se completa en finishRecord
+size_t beginRecord(std::string& out, StreamRecordKind kind) {
+    const size_t start = out.size();
+    putRecordPart(out, StreamRecordHeader{0, kind});
+    return start;
+}
+
+void finishRecord(std::string& out, size_t start) {
+    const uint32_t size = static_cast<uint32_t>(out.size() - start - sizeof(StreamRecordHeader));
+    std::memcpy(&out[start], &size, sizeof(size));
+    out.resize(start + recordBytes(size), '\0');
+}
+
+} // namespace
+
+void appendStreamRunBegin(std::string& out, const SimulationProgram& program, int32_t pid) {
+    TraceStringTable strings;
+    const TraceProgramTables tables = encodeProgramTables(program, strings);
+    const size_t start = beginRecord(out, STREAM_RUN_BEGIN);
+    putRecordPart(out, StreamRunBegin{static_cast<uint32_t>(tables.descriptors.size()), static_cast<uint32_t>(tables.layouts.size()),
+                                      static_cast<uint32_t>(tables.slots.size()), static_cast<uint32_t>(strings.data().size()), pid, 0});
+    putRecordTable(out, tables.descriptors);
+    putRecordTable(out, tables.layouts);
+    putRecordTable(out, tables.slots);
+    out += strings.data();
+    finishRecord(out, start);
+}
+
+void appendStreamBlock(std::string& out, size_t firstStep, uint32_t stepCount, const std::string& strings, const std::string& block) {
+    const size_t start = beginRecord(out, STREAM_BLOCK);
+    putRecordPart(out, StreamBlock{firstStep, stepCount, static_cast<uint32_t>(strings.size())});
+    out += strings;
+    out += block;
+    finishRecord(out, start);
+}
+
+void appendStreamRunEnd(std::string& out, size_t stepCount, size_t droppedSteps) {
+    const size_t start = beginRecord(out, STREAM_RUN_END);
+    putRecordPart(out, StreamRunEnd{stepCount, droppedSteps});
+    finishRecord(out, start);
+}
+
+#ifdef _WIN32
+
+int runSimulationStreamer(const SimulationProgram&, const std::string&, SimStreamBackpressure) {
+    std::fprintf(stderr, "Error: --stream needs POSIX shared memory\n");
+    return 1;
+}
+
+bool openSimulationStream(const std::string&, size_t) {
+    std::fprintf(stderr, "Error: the stream viewer needs POSIX shared memory\n");
+    return false;
+}
+
+bool pollSimulationStream(SimulationProgress&, bool&) {
+    return false;
+}
+
+bool showSimulationStreamRun(int, std::string&) {
+    return false;
+}
+
+void closeSimulationStream() {}
+
+int runSimulationStreamCheck(const std::string&, const SimStreamCheckOptions&) {
+    std::fprintf(stderr, "Error: the stream check needs POSIX shared memory\n");
+    return 2;
+}
+
+#else
+
+namespace {
+
+const char STREAM_RING_MAGIC[8] = {'S', 'I', 'M', 'R', 'I', 'N', 'G', '1'};
+const uint32_t STREAM_RING_VERSION = 3; // La 2 lleva los campos de los bloques del heap simulado; la 3, el marco de cada escritura de un slot
+const unsigned STREAM_SAMPLE_EVERY = 8; // --backpressure=sample: con el anillo a medias, uno de cada tantos bloques
+const size_t STREAM_KEPT_RUNS = 8;      // Ejecuciones que conserva el visor para volver a ellas con '[' y ']'
+const std::chrono::microseconds STREAM_WAIT(200); // Espera del programa con el anillo lleno y del visor con él vacío
+
+// Cabecera del objeto de memoria compartida; le siguen los datos del anillo. Las posiciones crecen sin
+// volver a cero: el productor solo escribe writePosition y el consumidor solo readPosition, así que cada
+// registro se publica escribiéndolo entero y avanzando la posición con release.
+struct StreamRingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity; // Bytes de datos, potencia de dos
+    std::atomic<uint32_t> ready;    // El visor terminó de preparar el anillo
+    std::atomic<int32_t> viewer;    // pid del visor
+    std::atomic<int32_t> producer;  // pid del programa que publica (0: libre)
+    uint32_t reserved;
+    alignas(64) std::atomic<uint64_t> writePosition;
+    alignas(64) std::atomic<uint64_t> readPosition;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int32_t>::is_always_lock_free,
+              "El anillo necesita atómicos sin cerrojos para compartirlos entre procesos");
+
+const size_t STREAM_DATA_OFFSET = (sizeof(StreamRingHeader) + 63) / 64 * 64;
+
+std::string ringObjectName(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+bool processAlive(int32_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+// Objeto de memoria compartida proyectado
+struct StreamRing {
+    StreamRingHeader* header = nullptr;
+    unsigned char* data = nullptr;
+    size_t mappedSize = 0;
+
+    ~StreamRing() {
+        if (header) {
+            munmap(header, mappedSize);
+        }
+    }
+
+    uint64_t used() const {
+        return header->writePosition.load(std::memory_order_relaxed) - header->readPosition.load(std::memory_order_acquire);
+    }
+
+    // Copia con la vuelta al principio del área de datos
+    void copyIn(uint64_t position, const void* source, size_t size) {
+        const size_t offset = position & (header->capacity - 1);
+        const size_t first = std::min<size_t>(size, header->capacity - offset);
+        std::memcpy(data + offset, source, first);
+        std::memcpy(data, static_cast<const unsigned char*>(source) + first, size - first);
+    }
+
+    void copyOut(uint64_t position, void* target, size_t size) const {
+        const size_t offset = position & (header->capacity - 1);
+        const size_t first = std::min<size_t>(size, header->capacity - offset);
+        std::memcpy(target, data + offset, first);
+        std::memcpy(static_cast<unsigned char*>(target) + first, data, size - first);
+    }
+};
+
+// --- Programa (productor) ---
+
+struct StreamProducer {
+    StreamRing ring;
+    std::string name;
+    SimStreamBackpressure backpressure = SIM_STREAM_BLOCK;
+    size_t droppedSteps = 0;
+    size_t publishedBlocks = 0; // Para el muestreo
+    bool running = false;       // Dentro de runSimulationProgram: se puede abandonar el programa
+    bool detached = false;      // El visor se cerró: no se publica nada más
+    std::string record;
+};
+
+StreamProducer producer;
+
+bool viewerGone() {
+    if (!producer.detached && !processAlive(producer.ring.header->viewer.load(std::memory_order_relaxed))) {
+        std::fprintf(stderr, "Error: the viewer of %s is gone; the program stops\n", producer.name.c_str());
+        producer.detached = true;
+    }
+    return producer.detached;
+}
+
+// Escribe el registro (completo, con su cabecera) si cabe; con 'wait', espera a que el visor haga sitio
+bool writeRecord(const std::string& record, bool wait) {
+    StreamRing& ring = producer.ring;
+    const size_t bytes = record.size();
+    if (bytes > ring.header->capacity) {
+        return false; // No cabría nunca: se descarta aunque la política sea esperar
+    }
+    while (ring.header->capacity - ring.used() < bytes) {
+        if (!wait || viewerGone()) {
+            return false;
+        }
+        std::this_thread::sleep_for(STREAM_WAIT);
+    }
+    const uint64_t position = ring.header->writePosition.load(std::memory_order_relaxed);
+    ring.copyIn(position, record.data(), bytes);
+    ring.header->writePosition.store(position + bytes, std::memory_order_release);
+    return true;
+}
+
+// TraceChunkPublisher del flujo: aplica la política de contrapresión
+void streamChunk(size_t firstStep, uint32_t stepCount, std::string& strings, std::string& block) {
+    if (viewerGone()) {
+        if (producer.running) {
+            abandonSimulation();
+        }
+        return;
+    }
+    const uint64_t used = producer.ring.used();
+    if (producer.backpressure == SIM_STREAM_SAMPLE && used > producer.ring.header->capacity / 2 &&
+        producer.publishedBlocks++ % STREAM_SAMPLE_EVERY != 0) {
+        producer.droppedSteps += stepCount;
+        return;
+    }
+    producer.record.clear();
+    appendStreamBlock(producer.record, firstStep, stepCount, strings, block);
+    if (!writeRecord(producer.record, producer.backpressure == SIM_STREAM_BLOCK)) {
+        producer.droppedSteps += stepCount;
+        if (producer.detached && producer.running) {
+            abandonSimulation();
+        }
+    }
+}
+
+bool attachStreamRing(const std::string& name) {
+    const std::string object = ringObjectName(name);
+    const int descriptor = shm_open(object.c_str(), O_RDWR, 0);
+    if (descriptor < 0) {
+        std::fprintf(stderr, "Error: no stream viewer on %s (start sim_stream_viewer %s first)\n", name.c_str(), name.c_str());
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    if (fstat(descriptor, &info) == 0 && static_cast<size_t>(info.st_size) > STREAM_DATA_OFFSET) {
+        mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        std::fprintf(stderr, "Error: could not map the stream %s\n", name.c_str());
+        return false;
+    }
+    StreamRing& ring = producer.ring;
+    ring.header = static_cast<StreamRingHeader*>(mapping);
+    ring.data = static_cast<unsigned char*>(mapping) + STREAM_DATA_OFFSET;
+    ring.mappedSize = static_cast<size_t>(info.st_size);
+    if (ring.header->ready.load(std::memory_order_acquire) == 0 || std::memcmp(ring.header->magic, STREAM_RING_MAGIC, sizeof(STREAM_RING_MAGIC)) != 0 ||
+        ring.header->version != STREAM_RING_VERSION || ring.mappedSize - STREAM_DATA_OFFSET < ring.header->capacity) {
+        std::fprintf(stderr, "Error: %s is not a stream of this runtime version\n", name.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Un anillo admite un programa a la vez: los demás esperan a que termine el que publica
+bool claimStreamRing() {
+    StreamRingHeader& header = *producer.ring.header;
+    const int32_t self = static_cast<int32_t>(getpid());
+    bool announced = false;
+    int32_t owner = 0;
+    while (!header.producer.compare_exchange_strong(owner, self)) {
+        if (!processAlive(owner)) {
+            continue; // Terminó sin soltarlo: 'owner' ya tiene su pid y el siguiente intento lo sustituye
+        }
+        if (viewerGone()) {
+            return false;
+        }
+        if (!announced) {
+            std::fprintf(stderr, "Waiting for the program streaming to %s to finish...\n", producer.name.c_str());
+            announced = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        owner = 0;
+    }
+    return true;
+}
+
+void streamRunBegin(const SimulationProgram& program) {
+    producer.record.clear();
+    appendStreamRunBegin(producer.record, program, static_cast<int32_t>(getpid()));
+    writeRecord(producer.record, true); // El comienzo y el final no se descartan
+}
+
+void streamRunEnd(size_t stepCount) {
+    producer.record.clear();
+    appendStreamRunEnd(producer.record, stepCount, producer.droppedSteps);
+    writeRecord(producer.record, true);
+}
+
+// --- Visor (consumidor) ---
+
+// Registro recibido: el hilo receptor vacía el anillo en esta cola (un productor, un consumidor, como la
+// de BackgroundRecorder.cpp) para que el programa no espere a que el visor dibuje
+struct ReceivedRecord {
+    uint32_t kind = 0;
+    std::string payload;
+    std::atomic<ReceivedRecord*> next{nullptr};
+};
+
+struct StreamChunk {
+    size_t firstStep; // Índice en los pasos recibidos de la ejecución, sin los descartados
+    uint32_t stepCount;
+    std::string strings;
+    std::string block;
+};
+
+struct StreamRun {
+    int32_t pid = 0;
+    std::string strings; // Las tablas del programa apuntan a ella: no se mueve
+    LoadedTraceProgram tables;
+    std::deque<StreamChunk> chunks;
+    size_t chunkBytes = 0;   // Cadenas y bloques de 'chunks': como mucho SIM_STREAM_RUN_BYTES
+    SimulationReplay replay = {0, nullptr}; // replay.firstStep: pasos recibidos ya descartados
+    size_t programSteps = 0; // Pasos del programa hasta el último bloque recibido, descartados incluidos
+    size_t droppedSteps = 0;
+    bool active = true;
+    std::chrono::steady_clock::time_point start;
+};
+
+struct StreamViewer {
+    StreamRing ring;
+    std::string object;
+    std::thread receiver;
+    std::atomic<bool> stopping{false};
+    ReceivedRecord* head = nullptr; // Último registro consumido (al empezar, uno vacío)
+    ReceivedRecord* tail = nullptr; // Solo lo usa el hilo receptor
+    std::deque<std::unique_ptr<StreamRun>> runs;
+    size_t shown = 0; // Ejecución mostrada
+    size_t firstRunNumber = 1; // Número de runs.front() (las más antiguas se descartan)
+    std::string decoded;
+};
+
+StreamViewer viewer;
+
+enum StreamReadResult { STREAM_READ_EMPTY, STREAM_READ_RECORD, STREAM_READ_DAMAGED };
+
+// Saca del anillo el siguiente registro publicado, si lo hay
+StreamReadResult readStreamRecord(StreamRing& ring, uint32_t& kind, std::string& payload) {
+    const uint64_t position = ring.header->readPosition.load(std::memory_order_relaxed);
+    const uint64_t published = ring.header->writePosition.load(std::memory_order_acquire) - position;
+    if (published == 0) {
+        return STREAM_READ_EMPTY;
+    }
+    StreamRecordHeader header;
+    ring.copyOut(position, &header, sizeof(header));
+    const size_t bytes = recordBytes(header.size);
+    // El productor publica registros enteros: uno que pase de lo publicado leería bytes viejos del anillo
+    if (published < sizeof(header) || bytes > published || bytes > ring.header->capacity) {
+        std::fprintf(stderr, "Error: damaged record in the stream; no longer receiving\n");
+        return STREAM_READ_DAMAGED;
+    }
+    kind = header.kind;
+    payload.resize(header.size);
+    ring.copyOut(position + sizeof(header), &payload[0], header.size);
+    ring.header->readPosition.store(position + bytes, std::memory_order_release);
+    return STREAM_READ_RECORD;
+}
+
+void receiveStreamRecords() {
+    uint32_t kind = 0;
+    std::string payload;
+    while (!viewer.stopping.load(std::memory_order_relaxed)) {
+        const StreamReadResult result = readStreamRecord(viewer.ring, kind, payload);
+        if (result == STREAM_READ_DAMAGED) {
+            return;
+        }
+        if (result == STREAM_READ_EMPTY) {
+            std::this_thread::sleep_for(STREAM_WAIT);
+            continue;
+        }
+        ReceivedRecord* record = new ReceivedRecord();
+        record->kind = kind;
+        record->payload = std::move(payload);
+        viewer.tail->next.store(record, std::memory_order_release);
+        viewer.tail = record;
+    }
+}
+
+void showStreamRun(size_t index) {
+    viewer.shown = index;
+    StreamRun& run = *viewer.runs[index];
+    attachSimulationProgram(run.tables.program);
+    setSimulationReplay(&run.replay);
+    clearSimulationTrace(); // El primer paso que se pida carga su bloque
+    discardSimulationChangeIndex(); // Los bloques del flujo no llevan índice de cambios
+}
+
+size_t loadStreamWindow(size_t stepIndex) {
+    StreamRun& run = *viewer.runs[viewer.shown];
+    const auto found = std::upper_bound(run.chunks.begin(), run.chunks.end(), stepIndex,
+                                        [](size_t step, const StreamChunk& candidate) { return step < candidate.firstStep; }) - 1;
+    const TraceBlockContext context = {run.tables.stringArgs, run.tables.layouts.data(), run.tables.layouts.size(),
+                                       found->strings.data(), found->strings.size()};
+    TraceKeyframe initial;
+    if (!decodeTraceBlock(reinterpret_cast<const unsigned char*>(found->block.data()), found->block.size(), TRACE_BLOCK_RAW,
+                          found->block.size(), found->stepCount, context, viewer.decoded, initial)) {
+        std::fprintf(stderr, "Error: damaged block in the stream (steps %zu-%zu)\n", found->firstStep, found->firstStep + found->stepCount - 1);
+        clearSimulationTrace();
+        initial = TraceKeyframe();
+        simulationHistory.assign(found->stepCount, SimulationStep{0, 0, 0, 0});
+        simulationStateHashes.assign(found->stepCount, 0);
+    }
+    rebuildSimulationKeyframes(initial);
+    return found->firstStep;
+}
+
+// Contenido con el tamaño justo para sus partes; false si no
+bool readRunBegin(const std::string& payload, StreamRun& run) {
+    StreamRunBegin begin;
+    if (payload.size() < sizeof(begin)) {
+        return false;
+    }
+    std::memcpy(&begin, payload.data(), sizeof(begin));
+    const size_t tablesSize = begin.descriptorCount * sizeof(TraceFileDescriptor) + begin.layoutCount * sizeof(TraceFileLayout) +
+                              begin.slotCount * sizeof(TraceFileSlot);
+    if (payload.size() != sizeof(begin) + tablesSize + begin.stringsSize) {
+        return false;
+    }
+    TraceProgramTables tables;
+    const char* position = payload.data() + sizeof(begin);
+    tables.descriptors.resize(begin.descriptorCount);
+    tables.layouts.resize(begin.layoutCount);
+    tables.slots.resize(begin.slotCount);
+    std::memcpy(tables.descriptors.data(), position, tables.descriptors.size() * sizeof(TraceFileDescriptor));
+    position += tables.descriptors.size() * sizeof(TraceFileDescriptor);
+    std::memcpy(tables.layouts.data(), position, tables.layouts.size() * sizeof(TraceFileLayout));
+    position += tables.layouts.size() * sizeof(TraceFileLayout);
+    std::memcpy(tables.slots.data(), position, tables.slots.size() * sizeof(TraceFileSlot));
+    position += tables.slots.size() * sizeof(TraceFileSlot);
+    run.strings.assign(position, begin.stringsSize);
+    if (!run.strings.empty() && run.strings.back() != '\0') {
+        return false;
+    }
+    run.pid = begin.pid;
+    return decodeProgramTables(tables, run.strings.data(), run.strings.size(), run.tables) == nullptr;
+}
+
+void receiveRunBegin(const std::string& payload) {
+    auto run = std::make_unique<StreamRun>();
+    if (!readRunBegin(payload, *run)) {
+        std::fprintf(stderr, "Error: damaged program tables in the stream\n");
+        return;
+    }
+    if (!viewer.runs.empty()) {
+        viewer.runs.back()->active = false; // Un programa que terminó sin avisar
+    }
+    run->replay = {0, loadStreamWindow};
+    run->start = std::chrono::steady_clock::now();
+    viewer.runs.push_back(std::move(run));
+    if (viewer.runs.size() > STREAM_KEPT_RUNS) {
+        viewer.runs.pop_front();
+        ++viewer.firstRunNumber;
+    }
+    showStreamRun(viewer.runs.size() - 1); // Se sigue siempre la ejecución más reciente
+}
+
+void receiveBlock(std::string& payload) {
+    StreamBlock header;
+    if (viewer.runs.empty() || !viewer.runs.back()->active || payload.size() < sizeof(header)) {
+        return;
+    }
+    std::memcpy(&header, payload.data(), sizeof(header));
+    StreamRun& run = *viewer.runs.back();
+    if (header.stepCount == 0 || header.firstStep < run.programSteps || header.stringsSize > payload.size() - sizeof(header)) {
+        std::fprintf(stderr, "Error: block out of order in the stream (step %llu)\n", static_cast<unsigned long long>(header.firstStep));
+        return;
+    }
+    run.droppedSteps += header.firstStep - run.programSteps;
+    run.programSteps = header.firstStep + header.stepCount;
+    StreamChunk chunk = {run.replay.stepCount, header.stepCount, payload.substr(sizeof(header), header.stringsSize), std::string()};
+    if (!chunk.strings.empty() && chunk.strings.back() != '\0') {
+        chunk.strings.clear(); // Los %s se mostrarán vacíos
+    }
+    payload.erase(0, sizeof(header) + header.stringsSize);
+    chunk.block = std::move(payload);
+    run.chunkBytes += chunk.strings.size() + chunk.block.size();
+    run.chunks.push_back(std::move(chunk));
+    run.replay.stepCount += header.stepCount;
+    // Un programa largo no debe agotar la memoria del visor: los bloques más antiguos dejan un hueco al principio
+    while (run.chunkBytes > SIM_STREAM_RUN_BYTES && run.chunks.size() > 1) {
+        const StreamChunk& oldest = run.chunks.front();
+        run.chunkBytes -= oldest.strings.size() + oldest.block.size();
+        run.replay.firstStep = oldest.firstStep + oldest.stepCount;
+        run.chunks.pop_front();
+    }
+}
+
+void receiveRunEnd(const std::string& payload) {
+    StreamRunEnd end;
+    if (viewer.runs.empty() || payload.size() != sizeof(end)) {
+        return;
+    }
+    std::memcpy(&end, payload.data(), sizeof(end));
+    StreamRun& run = *viewer.runs.back();
+    run.active = false;
+    if (end.stepCount > run.programSteps) {
+        run.droppedSteps += end.stepCount - run.programSteps; // Los últimos bloques no llegaron
+        run.programSteps = end.stepCount;
+    }
+}
+
+// Crea el anillo (o reclama el que dejó un visor que ya no está) y lo deja listo para los programas
+bool createStreamRing(const std::string& ringName, size_t ringBytes, StreamRing& ring, std::string& object) {
+    size_t capacity = 4096;
+    while (capacity < ringBytes && capacity < (size_t(1) << 31)) {
+        capacity *= 2;
+    }
+    object = ringObjectName(ringName);
+    int descriptor = shm_open(object.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (descriptor < 0 && errno == EEXIST) {
+        // Quedó de un visor que no lo borró; si ese visor sigue abierto, el nombre está ocupado
+        StreamRing existing;
+        const int old = shm_open(object.c_str(), O_RDONLY, 0);
+        struct stat info;
+        if (old >= 0 && fstat(old, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(StreamRingHeader)) {
+            void* mapping = mmap(nullptr, sizeof(StreamRingHeader), PROT_READ, MAP_SHARED, old, 0);
+            if (mapping != MAP_FAILED) {
+                existing.header = static_cast<StreamRingHeader*>(mapping);
+                existing.mappedSize = sizeof(StreamRingHeader);
+            }
+        }
+        if (old >= 0) {
+            close(old);
+        }
+        if (existing.header && processAlive(existing.header->viewer.load()) && existing.header->viewer.load() != getpid()) {
+            std::fprintf(stderr, "Error: another viewer is already attached to %s\n", ringName.c_str());
+            return false;
+        }
+        shm_unlink(object.c_str());
+        descriptor = shm_open(object.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (descriptor < 0) {
+        std::fprintf(stderr, "Error: could not create the stream %s: %s\n", ringName.c_str(), std::strerror(errno));
+        return false;
+    }
+    const size_t size = STREAM_DATA_OFFSET + capacity;
+    void* mapping = MAP_FAILED;
+    if (ftruncate(descriptor, static_cast<off_t>(size)) == 0) {
+        mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    close(descriptor);
+    if (mapping == MAP_FAILED) {
+        std::fprintf(stderr, "Error: could not create the stream %s: %s\n", ringName.c_str(), std::strerror(errno));
+        shm_unlink(object.c_str());
+        return false;
+    }
+    ring.header = new (mapping) StreamRingHeader();
+    ring.data = static_cast<unsigned char*>(mapping) + STREAM_DATA_OFFSET;
+    ring.mappedSize = size;
+    StreamRingHeader& header = *ring.header;
+    std::memcpy(header.magic, STREAM_RING_MAGIC, sizeof(header.magic));
+    header.version = STREAM_RING_VERSION;
+    header.capacity = static_cast<uint32_t>(capacity);
+    header.viewer.store(static_cast<int32_t>(getpid()));
+    header.ready.store(1, std::memory_order_release);
+    return true;
+}
+
+// El programa que espera sitio ve que el consumidor ya no está y se detiene
+void releaseStreamRing(StreamRing& ring, const std::string& object) {
+    ring.header->viewer.store(0);
+    shm_unlink(object.c_str());
+}
+
+// --- Consumidor de prueba (sim_stream_check) ---
+
+// Ejecución que se está recibiendo: solo las posiciones de sus bloques, sin decodificarlos
+struct CheckedRun {
+    size_t number = 0;
+    int32_t pid = 0;
+    size_t nextStep = 0; // Paso del programa que seguiría al último bloque recibido
+    size_t receivedSteps = 0;
+    size_t blocks = 0;
+    size_t gaps = 0;
+    bool active = false;
+    std::chrono::steady_clock::time_point start;
+};
+
+bool checkRunBegin(CheckedRun& run, const std::string& payload, const SimStreamCheckOptions& options) {
+    StreamRunBegin begin;
+    bool ok = true;
+    if (run.active) {
+        std::fprintf(stderr, "Error: run %zu ended without its final record\n", run.number);
+        ok = false;
+    }
+    const size_t number = run.number + 1;
+    run = CheckedRun();
+    run.number = number;
+    if (payload.size() < sizeof(begin)) {
+        std::fprintf(stderr, "Error: run %zu: damaged program tables\n", run.number);
+        return false;
+    }
+    std::memcpy(&begin, payload.data(), sizeof(begin));
+    run.pid = begin.pid;
+    run.active = true;
+    if (options.stallMillis > 0) {
+        // Un consumidor que se retrasa: el programa llena el anillo y aplica su política de contrapresión
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.stallMillis));
+    }
+    run.start = std::chrono::steady_clock::now();
+    return ok;
+}
+
+bool checkBlock(CheckedRun& run, const std::string& payload, const SimStreamCheckOptions& options) {
+    StreamBlock block;
+    if (!run.active || payload.size() < sizeof(block)) {
+        std::fprintf(stderr, "Error: block outside a run in the stream\n");
+        return false;
+    }
+    std::memcpy(&block, payload.data(), sizeof(block));
+    if (block.stepCount == 0 || block.firstStep < run.nextStep) {
+        std::fprintf(stderr, "Error: run %zu: block of steps %llu-%llu after step %zu\n", run.number,
+                     static_cast<unsigned long long>(block.firstStep), static_cast<unsigned long long>(block.firstStep + block.stepCount) - 1,
+                     run.nextStep);
+        return false;
+    }
+    bool ok = true;
+    if (block.firstStep > run.nextStep) {
+        ++run.gaps;
+        if (options.expectNoGaps) {
+            std::fprintf(stderr, "Error: run %zu: steps %zu-%llu are missing\n", run.number, run.nextStep,
+                         static_cast<unsigned long long>(block.firstStep) - 1);
+            ok = false;
+        }
+    }
+    run.nextStep = block.firstStep + block.stepCount;
+    run.receivedSteps += block.stepCount;
+    ++run.blocks;
+    return ok;
+}
+
+bool checkRunEnd(CheckedRun& run, const std::string& payload, const SimStreamCheckOptions& options) {
+    StreamRunEnd end;
+    if (!run.active || payload.size() != sizeof(end)) {
+        std::fprintf(stderr, "Error: damaged end of run in the stream\n");
+        return false;
+    }
+    std::memcpy(&end, payload.data(), sizeof(end));
+    run.active = false;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run.start).count();
+    if (end.stepCount > run.nextStep) {
+        ++run.gaps; // Los últimos bloques no llegaron
+    }
+    std::printf("run %zu (pid %d): %llu steps, %zu received in %zu blocks, %llu dropped in %zu gaps, %.0f steps/s\n", run.number,
+                static_cast<int>(run.pid), static_cast<unsigned long long>(end.stepCount), run.receivedSteps, run.blocks,
+                static_cast<unsigned long long>(end.droppedSteps), run.gaps, seconds > 0 ? run.receivedSteps / seconds : 0.0);
+    std::fflush(stdout);
+    bool ok = true;
+    if (end.stepCount < run.nextStep || run.receivedSteps + end.droppedSteps != end.stepCount) {
+        std::fprintf(stderr, "Error: run %zu: %zu steps received and %llu dropped do not add up to %llu\n", run.number, run.receivedSteps,
+                     static_cast<unsigned long long>(end.droppedSteps), static_cast<unsigned long long>(end.stepCount));
+        ok = false;
+    }
+    if (options.expectNoGaps && run.gaps > 0) {
+        ok = false; // Ya se informó del hueco, salvo si faltan los últimos pasos
+        if (end.stepCount > run.nextStep) {
+            std::fprintf(stderr, "Error: run %zu: its last %llu steps are missing\n", run.number,
+                         static_cast<unsigned long long>(end.stepCount - run.nextStep));
+        }
+    }
+    if (options.expectGaps && run.gaps == 0) {
+        std::fprintf(stderr, "Error: run %zu: no block was dropped\n", run.number);
+        ok = false;
+    }
+    return ok;
+}
+
+} // namespace
+
+int runSimulationStreamer(const SimulationProgram& program, const std::string& ringName, SimStreamBackpressure backpressure) {
+    producer.name = ringName;
+    producer.backpressure = backpressure;
+    if (!attachStreamRing(ringName) || !claimStreamRing()) {
+        return 1;
+    }
+    // Los bloques ya salen de la memoria al publicarse: el presupuesto sobra
+    setSimulationTraceBudget(0, SIM_TRACE_SPILL);
+    streamRunBegin(program);
+    beginTraceChunkPublishing(program, streamChunk);
+    producer.running = true;
+    runSimulationProgram(program);
+    producer.running = false;
+    finishTraceChunkPublishing();
+    streamRunEnd(simulationRecordedSteps);
+    producer.ring.header->producer.store(0, std::memory_order_release);
+    if (producer.detached) {
+        return 1;
+    }
+    std::fprintf(stderr, "steps: %zu, streamed to %s", simulationRecordedSteps, ringName.c_str());
+    if (producer.droppedSteps > 0) {
+        std::fprintf(stderr, " (%zu dropped)", producer.droppedSteps);
+    }
+    std::fprintf(stderr, "\n");
+    return 0;
+}
+
+bool openSimulationStream(const std::string& ringName, size_t ringBytes) {
+    if (!createStreamRing(ringName, ringBytes, viewer.ring, viewer.object)) {
+        return false;
+    }
+    viewer.head = viewer.tail = new ReceivedRecord();
+    viewer.stopping.store(false);
+    viewer.receiver = std::thread(receiveStreamRecords);
+    return true;
+}
+
+bool pollSimulationStream(SimulationProgress& progress, bool& runStarted) {
+    if (!viewer.receiver.joinable()) {
+        return false;
+    }
+    runStarted = false;
+    while (ReceivedRecord* next = viewer.head->next.load(std::memory_order_acquire)) {
+        delete viewer.head;
+        viewer.head = next;
+        if (next->kind == STREAM_RUN_BEGIN) {
+            receiveRunBegin(next->payload);
+            runStarted = true;
+        } else if (next->kind == STREAM_BLOCK) {
+            receiveBlock(next->payload);
+        } else if (next->kind == STREAM_RUN_END) {
+            receiveRunEnd(next->payload);
+        }
+    }
+    if (viewer.runs.empty()) {
+        progress = {false, 0, 0, 0, 0};
+        return true;
+    }
+    StreamRun& latest = *viewer.runs.back();
+    // Un programa que murió a medias no envía el final: ya no está y no queda nada suyo por recibir
+    if (latest.active && !processAlive(latest.pid) &&
+        viewer.ring.header->readPosition.load() == viewer.ring.header->writePosition.load(std::memory_order_acquire) &&
+        !viewer.head->next.load(std::memory_order_acquire)) {
+        latest.active = false;
+    }
+    const StreamRun& run = *viewer.runs[viewer.shown];
+    progress.active = run.active;
+    progress.steps = run.programSteps;
+    progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - run.start).count();
+    progress.droppedSteps = run.droppedSteps;
+    progress.evictedSteps = run.replay.firstStep;
+    return true;
+}
+
+bool showSimulationStreamRun(int offset, std::string& message) {
+    if (viewer.runs.empty()) {
+        return false;
+    }
+    const long long target = static_cast<long long>(viewer.shown) + offset;
+    if (target < 0 || target >= static_cast<long long>(viewer.runs.size())) {
+        message = std::string("No ") + (offset < 0 ? "earlier" : "later") + " run in the stream";
+        return false;
+    }
+    showStreamRun(static_cast<size_t>(target));
+    message = "Run " + std::to_string(viewer.firstRunNumber + target) + " of " + std::to_string(viewer.firstRunNumber + viewer.runs.size() - 1);
+    return true;
+}
+
+void closeSimulationStream() {
+    if (!viewer.receiver.joinable()) {
+        return;
+    }
+    viewer.stopping.store(true);
+    viewer.receiver.join();
+    releaseStreamRing(viewer.ring, viewer.object);
+    for (ReceivedRecord* record = viewer.head; record;) {
+        ReceivedRecord* next = record->next.load(std::memory_order_acquire);
+        delete record;
+        record = next;
+    }
+    viewer.head = viewer.tail = nullptr;
+}
+
+int runSimulationStreamCheck(const std::string& ringName, const SimStreamCheckOptions& options) {
+    StreamRing ring;
+    std::string object;
+    if (!createStreamRing(ringName, options.ringBytes, ring, object)) {
+        return 2;
+    }
+    std::printf("listening on %s\n", ringName.c_str());
+    std::fflush(stdout);
+    CheckedRun run;
+    size_t finishedRuns = 0;
+    bool ok = true;
+    uint32_t kind = 0;
+    std::string payload;
+    while (options.runCount == 0 || finishedRuns < options.runCount) {
+        const StreamReadResult result = readStreamRecord(ring, kind, payload);
+        if (result == STREAM_READ_DAMAGED) {
+            ok = false;
+            break;
+        }
+        if (result == STREAM_READ_EMPTY) {
+            if (run.active && !processAlive(run.pid) && ring.used() == 0) {
+                std::fprintf(stderr, "Error: run %zu ended without its final record\n", run.number);
+                run.active = false;
+                ok = false;
+                ++finishedRuns;
+            }
+            std::this_thread::sleep_for(STREAM_WAIT);
+            continue;
+        }
+        if (kind == STREAM_RUN_BEGIN) {
+            ok = checkRunBegin(run, payload, options) && ok;
+        } else if (kind == STREAM_BLOCK) {
+            ok = checkBlock(run, payload, options) && ok;
+        } else if (kind == STREAM_RUN_END) {
+            ok = checkRunEnd(run, payload, options) && ok;
+            ++finishedRuns;
+        } else {
+            std::fprintf(stderr, "Error: unknown record %u in the stream\n", static_cast<unsigned>(kind));
+            ok = false;
+        }
+    }
+    releaseStreamRing(ring, object);
+    return ok ? 0 : 1;
+}
+
+#endif
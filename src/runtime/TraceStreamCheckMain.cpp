@@ -0,0 +1,214 @@
+// src/runtime/TraceStreamCheckMain.cpp
+// sim_stream_check: consumidor de prueba del flujo en vivo (--stream), sin SFML. Comprueba el orden de los
+// bloques que recibe y mide los pasos por segundo; con --self-test lanza un programa sintético con cada
+// política de contrapresión (block, drop y sample) contra un consumidor que se retrasa.
+#include "SimulationRuntime.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Programa sintético que publica el modo --produce: un bucle que escribe una variable y registra un paso
+constexpr StepDescriptor checkDescriptors[] = {
+    {STEP_PROGRAM, 0, "Program Started", STEP_COLOR_DEFAULT},          // 0
+    {STEP_CALL, 1, "Entering function: main", STEP_COLOR_FUNCTION_CALL}, // 1
+    {STEP_ASSIGNMENT, 2, "Assigning to i = %d", STEP_COLOR_ASSIGNMENT},  // 2
+    {STEP_PROGRAM, 0, "Program Ended", STEP_COLOR_DEFAULT},            // 3
+};
+constexpr FrameSlotInfo checkSlots[] = {
+    {"i", SLOT_INT},
+};
+constexpr FrameLayout checkLayouts[] = {
+    {"main", checkSlots, 1},
+};
+
+long long checkProgramSteps = 200000;
+
+void runCheckProgram() {
+    recordStep(0);
+    {
+        StackFrameScope stackFrameScope(0);
+        recordStep(1);
+        for (long long i = 0; i < checkProgramSteps; ++i) {
+            updateStackFrame(0, i);
+            recordStep(2, i);
+        }
+    }
+    recordStep(3);
+}
+
+bool readNumber(const std::string& arg, const char* prefix, unsigned long long& value) {
+    const std::string name = prefix;
+    if (arg.rfind(name, 0) != 0 || arg.size() == name.size()) {
+        return false;
+    }
+    char* end = nullptr;
+    value = std::strtoull(arg.c_str() + name.size(), &end, 10);
+    return *end == '\0';
+}
+
+#ifndef _WIN32
+// Lanza este mismo ejecutable con otros argumentos; con 'output', su salida estándar va a esa tubería
+pid_t spawnSelf(const char* self, const std::vector<std::string>& args, int* output) {
+    int pipeEnds[2] = {-1, -1};
+    if (output && pipe(pipeEnds) != 0) {
+        return -1;
+    }
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (output) {
+            dup2(pipeEnds[1], STDOUT_FILENO);
+            close(pipeEnds[0]);
+            close(pipeEnds[1]);
+        }
+        std::vector<char*> argv = {const_cast<char*>(self)};
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execvp(self, argv.data());
+        _exit(127);
+    }
+    if (output) {
+        close(pipeEnds[1]);
+        *output = pipeEnds[0];
+    }
+    return pid;
+}
+
+int waitExitCode(pid_t pid) {
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+// Copia la salida del consumidor; false si acaba sin anunciar el anillo
+bool relayUntilListening(std::FILE* output) {
+    char line[512];
+    while (std::fgets(line, sizeof(line), output)) {
+        std::fputs(line, stdout);
+        if (std::string(line).rfind("listening on ", 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Cada política contra un consumidor que se retrasa 300 ms al empezar la ejecución, con un anillo de 1 MB
+// que el programa sintético llena de sobra: block no pierde nada y drop y sample tienen que descartar
+int runSelfTest(const char* self) {
+    const std::string ring = "sim_stream_check_" + std::to_string(getpid());
+    const char* const policies[] = {"block", "drop", "sample"};
+    int failures = 0;
+    for (const char* policy : policies) {
+        std::printf("--backpressure=%s\n", policy);
+        std::fflush(stdout);
+        const std::string expectation = std::string(policy) == "block" ? "--no-gaps" : "--expect-gaps";
+        int consumerOutput = -1;
+        const pid_t consumer = spawnSelf(self, {ring, "--ring-kb=1024", "--runs=1", "--stall-ms=300", expectation}, &consumerOutput);
+        std::FILE* output = consumer > 0 ? fdopen(consumerOutput, "r") : nullptr;
+        int producerCode = -1;
+        if (output && relayUntilListening(output)) {
+            producerCode = waitExitCode(spawnSelf(self, {"--produce=" + ring, std::string("--backpressure=") + policy}, nullptr));
+        } else if (consumer > 0) {
+            kill(consumer, SIGTERM);
+        }
+        char line[512];
+        while (output && std::fgets(line, sizeof(line), output)) {
+            std::fputs(line, stdout);
+        }
+        if (output) {
+            std::fclose(output);
+        }
+        const int consumerCode = waitExitCode(consumer);
+        if (producerCode != 0 || consumerCode != 0) {
+            std::printf("FAILED (program exited with %d, consumer with %d)\n", producerCode, consumerCode);
+            ++failures;
+        }
+        std::fflush(stdout);
+    }
+    std::printf(failures == 0 ? "all backpressure policies passed\n" : "%d backpressure policies failed\n", failures);
+    return failures == 0 ? 0 : 1;
+}
+#endif
+
+void printUsage(const char* self) {
+    std::fprintf(stderr,
+                 "Usage: %s <name> [--ring-kb=N] [--runs=N] [--stall-ms=N] [--no-gaps | --expect-gaps]\n"
+                 "       %s --self-test\n"
+                 "       %s --produce=<name> [--backpressure=block|drop|sample] [--steps=N]\n",
+                 self, self, self);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SimStreamCheckOptions options = {SIM_STREAM_DEFAULT_RING_BYTES, 0, 0, false, false};
+    std::string ringName;
+    std::string produceName;
+    std::vector<char*> produceArgs = {argv[0]};
+    bool selfTest = false;
+    bool valid = argc > 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        unsigned long long value = 0;
+        if (readNumber(arg, "--ring-kb=", value) && value > 0) {
+            options.ringBytes = static_cast<size_t>(value) << 10;
+        } else if (readNumber(arg, "--runs=", value)) {
+            options.runCount = static_cast<size_t>(value);
+        } else if (readNumber(arg, "--stall-ms=", value)) {
+            options.stallMillis = static_cast<unsigned>(value);
+        } else if (arg == "--no-gaps") {
+            options.expectNoGaps = true;
+        } else if (arg == "--expect-gaps") {
+            options.expectGaps = true;
+        } else if (arg == "--self-test") {
+            selfTest = true;
+        } else if (arg.rfind("--produce=", 0) == 0 && arg.size() > 10) {
+            produceName = arg.substr(10);
+        } else if (readNumber(arg, "--steps=", value)) {
+            checkProgramSteps = static_cast<long long>(value);
+        } else if (arg.rfind("--backpressure=", 0) == 0) {
+            produceArgs.push_back(argv[i]); // Los valida runSimulationCommand
+        } else if (arg[0] != '-' && ringName.empty()) {
+            ringName = arg;
+        } else {
+            valid = false;
+        }
+    }
+    if (!valid || selfTest + !produceName.empty() + !ringName.empty() != 1 || (options.expectGaps && options.expectNoGaps)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+    if (!produceName.empty()) {
+        const std::string stream = "--stream=" + produceName;
+        produceArgs.insert(produceArgs.begin() + 1, const_cast<char*>(stream.c_str()));
+        const SimulationProgram program = {
+            checkDescriptors, static_cast<int>(std::size(checkDescriptors)),
+            checkLayouts, static_cast<int>(std::size(checkLayouts)),
+            runCheckProgram
+        };
+        return runSimulationCommand(program, static_cast<int>(produceArgs.size()), produceArgs.data());
+    }
+    if (selfTest) {
+#ifdef _WIN32
+        std::fprintf(stderr, "Error: the stream check needs POSIX shared memory\n");
+        return 2;
+#else
+        return runSelfTest(argv[0]);
+#endif
+    }
+    return runSimulationStreamCheck(ringName, options);
+}
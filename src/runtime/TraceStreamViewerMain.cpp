@@ -0,0 +1,20 @@
+// src/runtime/TraceStreamViewerMain.cpp
+// sim_stream_viewer: visor de larga duración que muestra en vivo las ejecuciones de los programas lanzados con --stream.
+#include "SimulationRuntime.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+int main(int argc, char** argv) {
+    size_t ringBytes = SIM_STREAM_DEFAULT_RING_BYTES;
+    if (argc == 3) {
+        // Tamaño del anillo: con más sitio, el programa espera (o descarta) menos cuando el visor se retrasa
+        ringBytes = std::string(argv[2]).rfind("--ring-mb=", 0) == 0 ? static_cast<size_t>(std::strtoul(argv[2] + 10, nullptr, 10)) << 20 : 0;
+    }
+    if ((argc != 2 && argc != 3) || ringBytes == 0) {
+        std::fprintf(stderr, "Usage: %s <name> [--ring-mb=N]\n", argv[0]);
+        return 1;
+    }
+    return runSimulationStreamViewer(argv[1], ringBytes);
+}
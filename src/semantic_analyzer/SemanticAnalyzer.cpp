@@ -49,6 +49,12 @@ void SemanticAnalyzer::visit(ASTNode* node) {
         case ASTNodeType::PrintStatement:
             visitPrintStatementNode(static_cast<PrintStatementNode*>(node));
             break;
+        case ASTNodeType::FreeStatement:
+            visitFreeStatementNode(static_cast<FreeStatementNode*>(node));
+            break;
+        case ASTNodeType::PointerAssignmentStatement:
+            visitPointerAssignmentStatementNode(static_cast<PointerAssignmentStatementNode*>(node));
+            break;
         case ASTNodeType::BlockStatement:
             visitBlockStatementNode(static_cast<BlockStatementNode*>(node));
             break;
@@ -56,13 +62,14 @@ void SemanticAnalyzer::visit(ASTNode* node) {
         case ASTNodeType::UnaryExpression:
         case ASTNodeType::Literal:
         case ASTNodeType::Identifier:
+        case ASTNodeType::MallocExpression:
             // Estos son nodos de expresión, que deberían ser manejados por analyzeExpression.
             // Si llegan aquí directamente, significa un error en la traversía.
-            errorHandler.reportError("Error interno: Nodo de expresión visitado directamente en SemanticAnalyzer::visit().", -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Error interno: Nodo de expresión visitado directamente en SemanticAnalyzer::visit().", node->line, node->column);
             analyzeExpression(node); // Aún así, intentamos analizar la expresión
             break;
         default:
-            errorHandler.reportError("Nodo AST desconocido en SemanticAnalyzer::visit(): " + std::to_string(static_cast<int>(node->type)), -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Nodo AST desconocido en SemanticAnalyzer::visit(): " + std::to_string(static_cast<int>(node->type)), node->line, node->column);
             break;
     }
 }
@@ -76,7 +83,7 @@ void SemanticAnalyzer::visitProgramNode(ProgramNode* node) {
         // Crear un Symbol para la función y añadirlo a la tabla
         auto funcSymbol = std::make_unique<Symbol>(func->name, SymbolType::FUNCTION, func->returnType, func->parameters); // <--- ¡CONSTRUCTOR DE SYMBOL ACTUALIZADO!
         if (!symbolTable.addSymbol(std::move(funcSymbol))) { // <--- ¡LLAMADA A addSymbol MODIFICADA!
-            errorHandler.reportError("Redeclaración de función: " + func->name, -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Redeclaración de función: " + func->name, func->line, func->column);
         }
     }
 
@@ -104,7 +111,7 @@ void SemanticAnalyzer::visitFunctionDeclarationNode(FunctionDeclarationNode* nod
         // Crear un Symbol para el parámetro y añadirlo
         auto paramSymbol = std::make_unique<Symbol>(param.second, SymbolType::VARIABLE, param.first); // <--- ¡CONSTRUCTOR DE SYMBOL ACTUALIZADO!
         if (!symbolTable.addSymbol(std::move(paramSymbol))) { // <--- ¡LLAMADA A addSymbol MODIFICADA!
-            errorHandler.reportError("Redeclaración de parámetro: " + param.second, -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Redeclaración de parámetro: " + param.second, node->line, node->column);
         }
     }
 
@@ -112,7 +119,7 @@ void SemanticAnalyzer::visitFunctionDeclarationNode(FunctionDeclarationNode* nod
     if (node->body) {
         visitBlockStatementNode(static_cast<BlockStatementNode*>(node->body.get()));
     } else {
-        errorHandler.reportWarning("Cuerpo de función nulo para: " + node->name, -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportWarning("Cuerpo de función nulo para: " + node->name, node->line, node->column);
     }
 
     currentFunctionReturnType = ""; // Limpiar el tipo de retorno de la función actual al salir
@@ -122,7 +129,7 @@ void SemanticAnalyzer::visitFunctionDeclarationNode(FunctionDeclarationNode* nod
 void SemanticAnalyzer::visitVariableDeclarationNode(VariableDeclarationNode* node) {
     // Verificar si la variable ya existe en el ámbito actual
     if (symbolTable.lookupSymbolInCurrentScope(node->variableName)) {
-        errorHandler.reportError("Redeclaración de variable en el mismo ámbito: " + node->variableName, -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportError("Redeclaración de variable en el mismo ámbito: " + node->variableName, node->line, node->column);
     } else {
         // Añadir la variable a la tabla de símbolos
         auto varSymbol = std::make_unique<Symbol>(node->variableName, SymbolType::VARIABLE, node->typeName); // <--- ¡CONSTRUCTOR DE SYMBOL ACTUALIZADO!
@@ -132,43 +139,50 @@ void SemanticAnalyzer::visitVariableDeclarationNode(VariableDeclarationNode* nod
     // Si hay un inicializador, analizar la expresión
     if (node->initializer) {
         if (!analyzeExpression(node->initializer.get())) {
-            errorHandler.reportError("Error en la expresión inicializadora de la variable: " + node->variableName, -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Error en la expresión inicializadora de la variable: " + node->variableName, node->line, node->column);
         }
         // TODO: Verificar compatibilidad de tipos entre typeName y el tipo de la expresión inicializadora
+        if (node->initializer->type == ASTNodeType::MallocExpression && node->typeName.back() != '*') {
+            errorHandler.reportError("El resultado de malloc solo se puede guardar en un puntero: " + node->variableName, node->line, node->column);
+        }
     }
 }
 
 void SemanticAnalyzer::visitAssignmentStatementNode(AssignmentStatementNode* node) {
     // Verificar si el identificador ha sido declarado
     if (!symbolTable.lookupSymbol(node->identifierName)) {
-        errorHandler.reportError("Uso de variable no declarada: " + node->identifierName, -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportError("Uso de variable no declarada: " + node->identifierName, node->line, node->column);
     }
 
     // Analizar la expresión del lado derecho de la asignación
     if (!analyzeExpression(node->expression.get())) {
-        errorHandler.reportError("Error en la expresión de asignación para: " + node->identifierName, -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportError("Error en la expresión de asignación para: " + node->identifierName, node->line, node->column);
     }
     // TODO: Verificar compatibilidad de tipos entre la variable y la expresión
+    Symbol* symbol = symbolTable.lookupSymbol(node->identifierName);
+    if (symbol && node->expression && node->expression->type == ASTNodeType::MallocExpression && symbol->dataType.back() != '*') {
+        errorHandler.reportError("El resultado de malloc solo se puede guardar en un puntero: " + node->identifierName, node->line, node->column);
+    }
 }
 
 void SemanticAnalyzer::visitFunctionCallNode(FunctionCallNode* node) {
     // Buscar la función en la tabla de símbolos
     auto funcSymbol = symbolTable.lookupSymbol(node->functionName);
     if (!funcSymbol || funcSymbol->symbolType != SymbolType::FUNCTION) { // <--- ¡USO DE symbolType!
-        errorHandler.reportError("Función no declarada o no es una función: " + node->functionName, -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportError("Función no declarada o no es una función: " + node->functionName, node->line, node->column);
         return;
     }
 
     // Verificar el número de argumentos
     if (node->arguments.size() != funcSymbol->parameters.size()) { // <--- ¡USO DE parameters!
         errorHandler.reportError("Número incorrecto de argumentos para la función '" + node->functionName + "'. Se esperaban " +
-                                 std::to_string(funcSymbol->parameters.size()) + ", se obtuvieron " + std::to_string(node->arguments.size()) + ".", -1, -1); // <--- ¡ORDEN CORREGIDO!
+                                 std::to_string(funcSymbol->parameters.size()) + ", se obtuvieron " + std::to_string(node->arguments.size()) + ".", node->line, node->column);
     }
 
     // Analizar cada argumento y verificar tipos (simplificado)
     for (size_t i = 0; i < node->arguments.size(); ++i) {
         if (!analyzeExpression(node->arguments[i].get())) {
-            errorHandler.reportError("Error en el argumento " + std::to_string(i + 1) + " de la función " + node->functionName, -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Error en el argumento " + std::to_string(i + 1) + " de la función " + node->functionName, node->line, node->column);
         }
         // TODO: Comparar el tipo del argumento con el tipo del parámetro esperado
         // if (i < funcSymbol->parameters.size() && inferred_arg_type != funcSymbol->parameters[i].first) { ... }
@@ -179,7 +193,7 @@ void SemanticAnalyzer::visitReturnStatementNode(ReturnStatementNode* node) {
     if (node->expression) {
         // Si hay una expresión de retorno, analizarla
         if (!analyzeExpression(node->expression.get())) {
-            errorHandler.reportError("Error en la expresión de retorno.", -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Error en la expresión de retorno.", node->line, node->column);
         }
         // TODO: Verificar que el tipo de la expresión de retorno coincida con currentFunctionReturnType
         // Si currentFunctionReturnType es "void" y hay una expresión, reportar error.
@@ -187,7 +201,7 @@ void SemanticAnalyzer::visitReturnStatementNode(ReturnStatementNode* node) {
     } else {
         // No hay expresión de retorno (es un 'return;')
         if (currentFunctionReturnType != "void") {
-            errorHandler.reportError("La función '" + currentFunctionReturnType + "' espera un valor de retorno.", -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("La función '" + currentFunctionReturnType + "' espera un valor de retorno.", node->line, node->column);
         }
     }
 }
@@ -195,7 +209,7 @@ void SemanticAnalyzer::visitReturnStatementNode(ReturnStatementNode* node) {
 void SemanticAnalyzer::visitIfStatementNode(IfStatementNode* node) {
     // Analizar la condición del if
     if (!analyzeExpression(node->condition.get())) {
-        errorHandler.reportError("Error en la condición del 'if'.", -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportError("Error en la condición del 'if'.", node->line, node->column);
     }
     // TODO: La condición debe evaluarse a un tipo booleano o comparable a booleano.
 
@@ -225,16 +239,14 @@ void SemanticAnalyzer::visitForStatementNode(ForStatementNode* node) {
     // Analizar la condición
     if (node->condition) {
         if (!analyzeExpression(node->condition.get())) {
-            errorHandler.reportError("Error en la condición del bucle 'for'.", -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Error en la condición del bucle 'for'.", node->line, node->column);
         }
         // TODO: La condición debe evaluarse a un tipo booleano
     }
 
-    // Analizar el incremento
+    // Analizar el incremento (el parser lo produce como asignación o llamada a función)
     if (node->increment) {
-        if (!analyzeExpression(node->increment.get())) {
-            errorHandler.reportError("Error en la expresión de incremento del bucle 'for'.", -1, -1); // <--- ¡ORDEN CORREGIDO!
-        }
+        visit(node->increment.get());
     }
 
     // Analizar el cuerpo del bucle
@@ -246,18 +258,78 @@ void SemanticAnalyzer::visitForStatementNode(ForStatementNode* node) {
 }
 
 void SemanticAnalyzer::visitPrintStatementNode(PrintStatementNode* node) {
-    // Analizar la cadena de formato (no hay verificación de tipo real aquí)
-    // El formato en C es complejo, esto es solo un placeholder.
     if (node->formatString.empty()) {
-        errorHandler.reportWarning("printf sin cadena de formato.", -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportWarning("printf sin cadena de formato.", node->line, node->column);
+    }
+
+    // Analizar la cadena de formato en tiempo de compilación
+    std::string formatError;
+    if (!parseFormatString(node->formatString, node->segments, formatError)) {
+        errorHandler.reportError(formatError, node->line, node->column);
+        return;
+    }
+
+    size_t expectedArgs = countFormatConversions(node->segments);
+    if (expectedArgs != node->arguments.size()) {
+        errorHandler.reportError("printf espera " + std::to_string(expectedArgs) + " argumento(s) según su cadena de formato, se obtuvieron " +
+                                 std::to_string(node->arguments.size()) + ".", node->line, node->column);
     }
 
-    // Analizar los argumentos
-    for (const auto& arg : node->arguments) {
-        if (!analyzeExpression(arg.get())) {
-            errorHandler.reportError("Error en un argumento de printf.", -1, -1); // <--- ¡ORDEN CORREGIDO!
+    // Analizar los argumentos y verificar que concuerden con su conversión
+    size_t argIndex = 0;
+    for (const auto& segment : node->segments) {
+        if (segment.kind == FormatSegmentKind::Literal || argIndex >= node->arguments.size()) {
+            continue;
+        }
+        ASTNode* arg = node->arguments[argIndex++].get();
+        if (!analyzeExpression(arg)) {
+            errorHandler.reportError("Error en el argumento " + std::to_string(argIndex) + " de printf.", node->line, node->column);
+            continue;
+        }
+
+        std::string argType = inferExpressionType(arg);
+        if (argType.empty()) {
+            continue; // Tipo desconocido: no se puede verificar
+        }
+        bool matches = true;
+        switch (segment.kind) {
+            case FormatSegmentKind::Int:     matches = (argType == "int"); break;
+            case FormatSegmentKind::String:  matches = (argType == "char*"); break;
+            case FormatSegmentKind::Pointer: matches = (argType.back() == '*'); break;
+            default: break;
+        }
+        if (!matches) {
+            errorHandler.reportError("El argumento " + std::to_string(argIndex) + " de printf es de tipo '" + argType +
+                                     "', incompatible con su conversión de formato.", node->line, node->column);
         }
-        // TODO: Se podría intentar verificar la concordancia de tipos con los especificadores de formato en formatString.
+    }
+
+    // Argumentos sobrantes: se analizan igualmente para reportar sus errores
+    for (; argIndex < node->arguments.size(); ++argIndex) {
+        analyzeExpression(node->arguments[argIndex].get());
+    }
+}
+
+void SemanticAnalyzer::visitFreeStatementNode(FreeStatementNode* node) {
+    if (!analyzeExpression(node->pointer.get())) {
+        errorHandler.reportError("Error en el argumento de free.", node->line, node->column);
+        return;
+    }
+    const std::string pointerType = inferExpressionType(node->pointer.get());
+    if (!pointerType.empty() && pointerType.back() != '*') {
+        errorHandler.reportError("free espera un puntero, no '" + pointerType + "'.", node->line, node->column);
+    }
+}
+
+void SemanticAnalyzer::visitPointerAssignmentStatementNode(PointerAssignmentStatementNode* node) {
+    if (!analyzeExpression(node->target.get()) || !analyzeExpression(node->expression.get())) {
+        errorHandler.reportError("Error en la asignación a través de un puntero.", node->line, node->column);
+        return;
+    }
+    // Solo se escriben enteros: los literales de cadena (char*) no se pueden modificar
+    const std::string targetType = inferExpressionType(node->target.get());
+    if (!targetType.empty() && targetType != "int*") {
+        errorHandler.reportError("Solo se puede asignar a través de un 'int*', no de '" + targetType + "'.", node->line, node->column);
     }
 }
 
@@ -288,13 +360,15 @@ bool SemanticAnalyzer::analyzeExpression(ASTNode* node) {
             return visitBinaryExpressionNode(static_cast<BinaryExpressionNode*>(node));
         case ASTNodeType::UnaryExpression:
             return visitUnaryExpressionNode(static_cast<UnaryExpressionNode*>(node));
+        case ASTNodeType::MallocExpression:
+            return visitMallocExpressionNode(static_cast<MallocExpressionNode*>(node));
         case ASTNodeType::FunctionCall:
             // Si una llamada a función es una expresión (ej. int x = func();)
             visitFunctionCallNode(static_cast<FunctionCallNode*>(node));
             // TODO: Devolver el tipo de retorno de la función
             return true;
         default:
-            errorHandler.reportError("Tipo de nodo desconocido o no esperado como expresión: " + std::to_string(static_cast<int>(node->type)), -1, -1); // <--- ¡ORDEN CORREGIDO!
+            errorHandler.reportError("Tipo de nodo desconocido o no esperado como expresión: " + std::to_string(static_cast<int>(node->type)), node->line, node->column);
             return false;
     }
 }
@@ -302,7 +376,7 @@ bool SemanticAnalyzer::analyzeExpression(ASTNode* node) {
 bool SemanticAnalyzer::visitIdentifierNode(IdentifierNode* node) {
     // Verificar si el identificador ha sido declarado
     if (!symbolTable.lookupSymbol(node->name)) {
-        errorHandler.reportError("Uso de identificador no declarado: " + node->name, -1, -1); // <--- ¡ORDEN CORREGIDO!
+        errorHandler.reportError("Uso de identificador no declarado: " + node->name, node->line, node->column);
         return false;
     }
     // TODO: Devolver el tipo del identificador
@@ -335,4 +409,65 @@ bool SemanticAnalyzer::visitUnaryExpressionNode(UnaryExpressionNode* node) {
     }
     // TODO: Verificar que el operador unario sea aplicable al tipo del operando.
     return true;
+}
+
+bool SemanticAnalyzer::visitMallocExpressionNode(MallocExpressionNode* node) {
+    if (!analyzeExpression(node->size.get())) {
+        return false;
+    }
+    const std::string sizeType = inferExpressionType(node->size.get());
+    if (!sizeType.empty() && sizeType != "int") {
+        errorHandler.reportError("El tamaño de malloc debe ser un entero, no '" + sizeType + "'.", node->line, node->column);
+        return false;
+    }
+    return true;
+}
+
+std::string SemanticAnalyzer::inferExpressionType(ASTNode* node) {
+    if (!node) {
+        return "";
+    }
+
+    switch (node->type) {
+        case ASTNodeType::Identifier: {
+            Symbol* symbol = symbolTable.lookupSymbol(static_cast<IdentifierNode*>(node)->name);
+            return (symbol && symbol->symbolType == SymbolType::VARIABLE) ? symbol->dataType : "";
+        }
+        case ASTNodeType::Literal:
+            return static_cast<LiteralNode*>(node)->isString ? "char*" : "int";
+        case ASTNodeType::FunctionCall: {
+            Symbol* symbol = symbolTable.lookupSymbol(static_cast<FunctionCallNode*>(node)->functionName);
+            return (symbol && symbol->symbolType == SymbolType::FUNCTION) ? symbol->dataType : "";
+        }
+        case ASTNodeType::MallocExpression:
+            return "void*";
+        case ASTNodeType::UnaryExpression: {
+            auto unary = static_cast<UnaryExpressionNode*>(node);
+            std::string operandType = inferExpressionType(unary->operand.get());
+            if (unary->op == "&") {
+                return operandType.empty() ? "" : operandType + "*";
+            }
+            if (unary->op == "*") {
+                return (!operandType.empty() && operandType.back() == '*') ? operandType.substr(0, operandType.size() - 1) : "";
+            }
+            return "int";
+        }
+        case ASTNodeType::BinaryExpression: {
+            auto binary = static_cast<BinaryExpressionNode*>(node);
+            if (binary->op == "+" || binary->op == "-") {
+                // Aritmética de punteros: el resultado conserva el tipo puntero
+                std::string leftType = inferExpressionType(binary->left.get());
+                if (!leftType.empty() && leftType.back() == '*') {
+                    return leftType;
+                }
+                std::string rightType = inferExpressionType(binary->right.get());
+                if (!rightType.empty() && rightType.back() == '*') {
+                    return rightType;
+                }
+            }
+            return "int"; // Comparaciones y aritmética entera
+        }
+        default:
+            return "";
+    }
 }
\ No newline at end of file
@@ -45,6 +45,8 @@ public:
     void visitIfStatementNode(IfStatementNode* node);
     void visitForStatementNode(ForStatementNode* node);
     void visitPrintStatementNode(PrintStatementNode* node);
+    void visitFreeStatementNode(FreeStatementNode* node);
+    void visitPointerAssignmentStatementNode(PointerAssignmentStatementNode* node);
     void visitBlockStatementNode(BlockStatementNode* node);
 
     // Métodos para analizar expresiones y verificar tipos
@@ -55,6 +57,11 @@ public:
     bool visitLiteralNode(LiteralNode* node);
     bool visitBinaryExpressionNode(BinaryExpressionNode* node);
     bool visitUnaryExpressionNode(UnaryExpressionNode* node);
+    bool visitMallocExpressionNode(MallocExpressionNode* node);
+
+    // Infiere el tipo de una expresión ya analizada ("int", "int*", "char*").
+    // Devuelve "" si no se puede determinar.
+    std::string inferExpressionType(ASTNode* node);
 
 private:
     SymbolTable symbolTable;       // La tabla de símbolos para gestionar el ámbito.
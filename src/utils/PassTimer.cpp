@@ -0,0 +1,38 @@
+// src/utils/PassTimer.cpp
+#include "PassTimer.h"
+#include <iomanip>
+
+PassTimer::PassTimer(bool enabled) : enabled(enabled) {}
+
+void PassTimer::begin(const std::string& passName) {
+    if (!enabled) {
+        return;
+    }
+    currentPass = passName;
+    passStart = std::chrono::steady_clock::now();
+}
+
+void PassTimer::end() {
+    if (!enabled || currentPass.empty()) {
+        return;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - passStart;
+    timings.push_back({currentPass, elapsed.count()});
+    currentPass.clear();
+}
+
+void PassTimer::report(std::ostream& out) const {
+    if (!enabled) {
+        return;
+    }
+    double total = 0.0;
+    out << "=== TIEMPO POR FASE ===" << std::endl;
+    for (const auto& timing : timings) {
+        out << "  " << std::left << std::setw(24) << timing.name
+            << std::right << std::fixed << std::setprecision(3) << std::setw(10) << timing.milliseconds << " ms" << std::endl;
+        total += timing.milliseconds;
+    }
+    out << "  " << std::left << std::setw(24) << "total"
+        << std::right << std::fixed << std::setprecision(3) << std::setw(10) << total << " ms" << std::endl;
+    out << "=======================" << std::endl;
+}
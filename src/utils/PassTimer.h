@@ -0,0 +1,33 @@
+// src/utils/PassTimer.h
+#ifndef PASSTIMER_H
+#define PASSTIMER_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Mide el tiempo de cada fase del compilador (usado por --time-passes)
+class PassTimer {
+public:
+    explicit PassTimer(bool enabled);
+
+    void begin(const std::string& passName);
+    void end();
+
+    // Imprime una tabla con la duración de cada fase y el total
+    void report(std::ostream& out) const;
+
+private:
+    struct PassTiming {
+        std::string name;
+        double milliseconds;
+    };
+
+    bool enabled;
+    std::string currentPass;
+    std::chrono::steady_clock::time_point passStart;
+    std::vector<PassTiming> timings;
+};
+
+#endif // PASSTIMER_H
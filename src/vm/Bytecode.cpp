@@ -0,0 +1,85 @@
+// src/vm/Bytecode.cpp
+#include "Bytecode.h"
+#include <sstream>
+
+const char* opcodeName(OpCode opcode) {
+    static const char* const names[] = {
+#define BYTECODE_NAME_ENTRY(name) #name,
+        BYTECODE_OPCODES(BYTECODE_NAME_ENTRY)
+#undef BYTECODE_NAME_ENTRY
+    };
+    return names[static_cast<int>(opcode)];
+}
+
+namespace {
+
+bool isJump(OpCode opcode) {
+    switch (opcode) {
+        case OpCode::Jump:
+        case OpCode::LoopBack:
+        case OpCode::JumpIfFalse:
+        case OpCode::JumpIfNotLess:
+        case OpCode::JumpIfNotGreater:
+        case OpCode::JumpIfNotLessEqual:
+        case OpCode::JumpIfNotGreaterEqual:
+        case OpCode::JumpIfNotEqual:
+        case OpCode::JumpIfEqual:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+std::string printBytecode(const BytecodeProgram& program) {
+    std::stringstream ss;
+    for (size_t pc = 0; pc < program.code.size(); ++pc) {
+        for (const auto& function : program.functions) {
+            if (function.entry == static_cast<int>(pc)) {
+                ss << function.name << ":    ; frame " << function.frameSize << ", stack " << function.maxStackDepth << std::endl;
+            }
+        }
+
+        const Instruction& instruction = program.code[pc];
+        ss << "  " << pc << "\t" << opcodeName(instruction.opcode);
+        switch (instruction.opcode) {
+            case OpCode::PushConst:
+                ss << " " << program.constants[instruction.a];
+                break;
+            case OpCode::PushString:
+                ss << " \"" << program.strings[instruction.a] << "\"";
+                break;
+            case OpCode::LoadLocalConst:
+                ss << " " << instruction.a << ", " << program.constants[instruction.b];
+                break;
+            case OpCode::Call:
+                ss << " " << program.functions[instruction.a].name;
+                break;
+            case OpCode::RecordStep:
+            case OpCode::RecordStepKeep:
+            case OpCode::StoreLocalRecord:
+                ss << " " << instruction.a << ", " << instruction.b << "    ; \"" << program.stepDescriptors[instruction.opcode == OpCode::StoreLocalRecord ? instruction.b : instruction.a].format << "\"";
+                break;
+            case OpCode::LoadLocal:
+            case OpCode::StoreLocal:
+            case OpCode::AddressOfLocal:
+            case OpCode::SubtractPointer:
+            case OpCode::PointerDifference:
+                ss << " " << instruction.a;
+                break;
+            case OpCode::AddPointer:
+            case OpCode::Enter:
+            case OpCode::Print:
+                ss << " " << instruction.a << ", " << instruction.b;
+                break;
+            default:
+                if (isJump(instruction.opcode)) {
+                    ss << " -> " << instruction.a;
+                }
+                break;
+        }
+        ss << std::endl;
+    }
+    return ss.str();
+}
@@ -0,0 +1,100 @@
+// src/vm/Bytecode.h
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../parser/FormatString.h"
+#include "../runtime/SimulationRuntime.h" // StepDescriptor, FrameLayout
+
+// Bytecode de pila compilado desde el AST verificado (opción --vm). Lo ejecuta la VirtualMachine
+// dentro del propio compilador y registra los mismos pasos que el código generado con recordStep.
+//
+// Cada instrucción lleva dos operandos enteros (a, b). Los valores de la pila de operandos y de
+// las variables locales son long long: enteros de 32 bits (como los 'int' del código generado)
+// o direcciones reales (variables locales de la VM y literales de cadena).
+
+// Lista única de códigos de operación: genera el enum, los nombres y la tabla de despacho de la VM
+#define BYTECODE_OPCODES(X)                                                                     \
+    X(PushConst)         /* push constants[a] */                                                \
+    X(PushString)        /* push dirección de strings[a] */                                     \
+    X(LoadLocal)         /* push locals[a] */                                                   \
+    X(LoadLocalConst)    /* superinstrucción: push locals[a]; push constants[b] */              \
+    X(StoreLocal)        /* locals[a] = pop; actualiza el slot a del marco registrado */        \
+    X(StoreLocalRecord)  /* superinstrucción: StoreLocal a + paso b con el valor guardado */    \
+    X(AddressOfLocal)    /* push &locals[a] */                                                  \
+    X(LoadIndirect)      /* push *(long long*)pop */                                            \
+    X(Pop)               /* descarta el tope */                                                 \
+    X(Add) X(Subtract) X(Multiply) X(Divide) X(Negate)                                          \
+    X(AddPointer)        /* puntero + entero * a; b = 1 si el entero es el operando izquierdo */ \
+    X(SubtractPointer)   /* puntero - entero * a */                                             \
+    X(PointerDifference) /* (puntero - puntero) / a */                                          \
+    X(Less) X(Greater) X(LessEqual) X(GreaterEqual) X(Equal) X(NotEqual)                        \
+    X(Jump)              /* pc = a */                                                           \
+    X(LoopBack)          /* vuelta de un for: pc = a; límites con la línea b */                 \
+    X(JumpIfFalse)       /* if (!pop) pc = a */                                                 \
+    X(JumpIfNotLess)     /* superinstrucciones comparación + salto (condición de un for) */     \
+    X(JumpIfNotGreater) X(JumpIfNotLessEqual) X(JumpIfNotGreaterEqual)                          \
+    X(JumpIfNotEqual) X(JumpIfEqual)                                                            \
+    X(Call)              /* llama a functions[a] con sus argumentos en la pila */               \
+    X(Enter)             /* prólogo: empuja el marco registrado a (layout) con b parámetros */  \
+    X(Return)            /* retorna el tope de la pila */                                       \
+    X(ReturnVoid)                                                                               \
+    X(RecordStep)        /* registra el paso a con los b valores del tope y los saca */         \
+    X(RecordStepKeep)    /* igual que RecordStep, pero deja los valores en la pila */           \
+    X(Print)             /* escribe printFormats[a] con los b valores del tope y los saca */    \
+    X(Halt)
+
+enum class OpCode : unsigned char {
+#define BYTECODE_ENUM_ENTRY(name) name,
+    BYTECODE_OPCODES(BYTECODE_ENUM_ENTRY)
+#undef BYTECODE_ENUM_ENTRY
+};
+
+struct Instruction {
+    OpCode opcode;
+    int a;
+    int b;
+};
+
+struct BytecodeFunction {
+    std::string name;
+    std::string returnType;
+    int entry;          // Índice de su primera instrucción (Enter)
+    int line;           // Línea de su cabecera (paso final si un límite la detiene al entrar)
+    int parameterCount;
+    int frameSize;      // Slots locales (parámetros incluidos)
+    int maxStackDepth;  // Profundidad máxima de la pila de operandos dentro de la función
+    bool returnsValue;
+};
+
+// Programa compilado. Las tablas del runtime apuntan a cadenas guardadas aquí, así que el
+// programa no se copia (se maneja con unique_ptr) y debe vivir mientras se muestre la traza.
+struct BytecodeProgram {
+    std::vector<Instruction> code;
+    std::vector<long long> constants;
+    std::deque<std::string> strings; // Literales de cadena, plantillas y nombres (direcciones estables)
+    std::vector<BytecodeFunction> functions;
+    std::vector<std::vector<FormatSegment>> printFormats; // Segmentos de printf ya sin secuencias de escape
+
+    // Tablas que recibe el runtime, equivalentes a stepDescriptors[] y frameLayouts[] del código generado
+    std::vector<StepDescriptor> stepDescriptors;
+    std::vector<std::vector<FrameSlotInfo>> frameSlots;
+    std::vector<FrameLayout> frameLayouts;
+    // Paso final de cada SimStopReason (BytecodeCompiler::enableExecutionStops); -1 sin límites
+    int stopDescriptors[SIM_STOP_REASON_COUNT] = {-1, -1, -1};
+
+    BytecodeProgram() = default;
+    BytecodeProgram(const BytecodeProgram&) = delete;
+    BytecodeProgram& operator=(const BytecodeProgram&) = delete;
+};
+
+const char* opcodeName(OpCode opcode);
+
+// Listado legible del bytecode (opción --dump-bytecode)
+std::string printBytecode(const BytecodeProgram& program);
+
+#endif // BYTECODE_H
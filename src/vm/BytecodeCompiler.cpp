@@ -0,0 +1,671 @@
+// src/vm/BytecodeCompiler.cpp
+#include "BytecodeCompiler.h"
+#include "../runtime/SimulationLimits.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility> // Para std::move
+
+BytecodeCompiler::BytecodeCompiler(ErrorHandler& errorHandler)
+    : errorHandler(errorHandler), instrumentationPlan(nullptr), executionStops(false), currentFunction(-1), currentLayout(-1),
+      stepRecordingEnabled(true), sourceLine(0), stackDepth(0), labelPosition(0) {
+}
+
+void BytecodeCompiler::setInstrumentationPlan(const InstrumentationPlan* plan) {
+    instrumentationPlan = plan;
+}
+
+void BytecodeCompiler::enableExecutionStops() {
+    executionStops = true;
+}
+
+std::unique_ptr<BytecodeProgram> BytecodeCompiler::compile(ProgramNode* programNode) {
+    program = std::make_unique<BytecodeProgram>();
+    functionIndices.clear();
+    frameSlotNames.clear();
+    frameFunctionNames.clear();
+    if (!programNode) {
+        return std::move(program);
+    }
+
+    // Primero se registran todas las funciones: una llamada puede preceder a la definición
+    bool mainFound = false;
+    for (const auto& func : programNode->functionDeclarations) {
+        auto funcDecl = static_cast<FunctionDeclarationNode*>(func.get());
+        mainFound = mainFound || funcDecl->name == "main";
+        functionIndices[funcDecl->name] = static_cast<int>(program->functions.size());
+        program->functions.push_back({funcDecl->name, funcDecl->returnType, -1, funcDecl->line, static_cast<int>(funcDecl->parameters.size()),
+                                      0, 0, funcDecl->returnType != "void"});
+    }
+    if (!mainFound) {
+        errorHandler.reportWarning("No se encontró la función 'main()' en el código C. Ejecutando sentencias globales si las hay.", -1, -1);
+        program->functions.push_back({"global_scope", "void", -1, 0, 0, 0, 0, false});
+    }
+    const int entryFunction = mainFound ? functionIndices["main"] : static_cast<int>(program->functions.size() - 1);
+
+    // Código de arranque (equivalente a run_c_program_simulation)
+    emit(OpCode::RecordStep, addStepDescriptor(STEP_PROGRAM, "Program Started", STEP_COLOR_DEFAULT), 0);
+    if (executionStops) {
+        // Los registra la VM al detener el programa, con la línea del bucle o la función como argumento
+        program->stopDescriptors[SIM_STOP_STEPS] = addStepDescriptor(STEP_PROGRAM, "Execution stopped: step budget exceeded at line %d", STEP_COLOR_HIGHLIGHT);
+        program->stopDescriptors[SIM_STOP_TIME] = addStepDescriptor(STEP_PROGRAM, "Execution stopped: time budget exceeded at line %d", STEP_COLOR_HIGHLIGHT);
+        program->stopDescriptors[SIM_STOP_LOOP] = addStepDescriptor(STEP_PROGRAM, "Execution stopped: infinite loop detected at line %d", STEP_COLOR_HIGHLIGHT);
+    }
+    emit(OpCode::Call, entryFunction);
+    if (program->functions[entryFunction].returnsValue) {
+        emit(OpCode::Pop);
+    }
+    emit(OpCode::RecordStep, addStepDescriptor(STEP_PROGRAM, "Program Ended", STEP_COLOR_DEFAULT), 0);
+    emit(OpCode::Halt);
+
+    for (const auto& func : programNode->functionDeclarations) {
+        auto funcDecl = static_cast<FunctionDeclarationNode*>(func.get());
+        std::vector<ASTNode*> body;
+        if (funcDecl->body) {
+            body.push_back(funcDecl->body.get());
+        } else {
+            errorHandler.reportWarning("Cuerpo de función nulo para: " + funcDecl->name, -1, -1);
+        }
+        sourceLine = funcDecl->line; // El paso de entrada a la función lleva la línea de su cabecera
+        compileFunction(functionIndices[funcDecl->name], funcDecl->name, funcDecl->parameters, body, funcDecl);
+        sourceLine = 0;
+    }
+    if (!mainFound) {
+        std::vector<ASTNode*> statements;
+        for (const auto& stmt : programNode->statements) {
+            statements.push_back(stmt.get());
+        }
+        // Igual que en el CodeGenerator, las sentencias globales no tienen nombre de función en los pasos de return
+        compileFunction(entryFunction, "", {}, statements, nullptr);
+    }
+
+    finalizeTables();
+    return std::move(program);
+}
+
+// --- Sentencias ---
+
+void BytecodeCompiler::compileFunction(int functionIndex, const std::string& displayName,
+                                       const std::vector<std::pair<std::string, std::string>>& parameters,
+                                       const std::vector<ASTNode*>& statements, const ASTNode* declaration) {
+    BytecodeFunction& function = program->functions[functionIndex];
+    function.entry = markLabel();
+    currentFunction = functionIndex;
+    currentFunctionName = displayName;
+    stackDepth = 0;
+    stepRecordingEnabled = true;
+
+    // Los parámetros ocupan los primeros slots del marco; Call ya los copió a las variables locales
+    declareFrame(function.name);
+    for (const auto& param : parameters) {
+        declareLocal(param.second, param.first, declaration);
+    }
+    emit(OpCode::Enter, currentLayout, static_cast<int>(parameters.size()));
+    if (!instrumentationPlan || instrumentationPlan->recordsFunctionEntry(function.name, parameters)) {
+        emit(OpCode::RecordStep, addStepDescriptor(STEP_CALL, "Entering function: " + function.name, STEP_COLOR_FUNCTION_CALL), 0);
+    }
+
+    for (ASTNode* stmt : statements) {
+        compileStatement(stmt);
+    }
+
+    // Retorno implícito al final de la función
+    if (program->functions[functionIndex].returnsValue) {
+        emit(OpCode::PushConst, addConstant(0));
+        emit(OpCode::Return);
+    } else {
+        emit(OpCode::ReturnVoid);
+    }
+
+    program->functions[functionIndex].frameSize = static_cast<int>(frameSlotNames[currentLayout].size());
+    localScopes.clear();
+    currentFunction = -1;
+}
+
+void BytecodeCompiler::compileStatement(ASTNode* node) {
+    if (!node) {
+        return;
+    }
+    // Mismo criterio que CodeGenerator::visit: cada sentencia decide si registra paso
+    bool previousRecording = stepRecordingEnabled;
+    if (instrumentationPlan && node->type != ASTNodeType::BlockStatement) {
+        stepRecordingEnabled = instrumentationPlan->recordsStep(node);
+    }
+    const int previousLine = sourceLine;
+    if (node->type != ASTNodeType::BlockStatement && node->line > 0) {
+        sourceLine = node->line;
+    }
+    compileStatementNode(node);
+    stepRecordingEnabled = previousRecording;
+    sourceLine = previousLine;
+}
+
+void BytecodeCompiler::compileStatementNode(ASTNode* node) {
+    switch (node->type) {
+        case ASTNodeType::VariableDeclaration:
+            compileVariableDeclaration(static_cast<VariableDeclarationNode*>(node));
+            break;
+        case ASTNodeType::AssignmentStatement:
+            compileAssignment(static_cast<AssignmentStatementNode*>(node));
+            break;
+        case ASTNodeType::ReturnStatement:
+            compileReturn(static_cast<ReturnStatementNode*>(node));
+            break;
+        case ASTNodeType::IfStatement:
+            compileIf(static_cast<IfStatementNode*>(node));
+            break;
+        case ASTNodeType::ForStatement:
+            compileFor(static_cast<ForStatementNode*>(node));
+            break;
+        case ASTNodeType::PrintStatement:
+            compilePrint(static_cast<PrintStatementNode*>(node));
+            break;
+        case ASTNodeType::BlockStatement:
+            localScopes.emplace_back();
+            for (const auto& stmt : static_cast<BlockStatementNode*>(node)->statements) {
+                compileStatement(stmt.get());
+            }
+            localScopes.pop_back();
+            break;
+        case ASTNodeType::FreeStatement:
+        case ASTNodeType::PointerAssignmentStatement:
+            // La memoria de la VM son sus marcos: no hay heap ni escrituras a través de punteros
+            errorHandler.reportError("La VM no admite free ni asignaciones a través de punteros (use el modo compilado, sin --vm ni --precompute).",
+                                     node->line, node->column);
+            break;
+        case ASTNodeType::FunctionCall:
+        case ASTNodeType::BinaryExpression:
+        case ASTNodeType::UnaryExpression:
+        case ASTNodeType::Literal:
+        case ASTNodeType::Identifier: {
+            // Sentencia de expresión: el valor se descarta
+            std::string type = compileExpression(node);
+            if (type != "void") {
+                emit(OpCode::Pop);
+            }
+            break;
+        }
+        default:
+            errorHandler.reportError("Nodo AST inesperado como sentencia al compilar a bytecode: " + std::to_string(static_cast<int>(node->type)), -1, -1);
+            break;
+    }
+}
+
+void BytecodeCompiler::compileVariableDeclaration(VariableDeclarationNode* node) {
+    if (node->initializer) {
+        compileExpression(node->initializer.get());
+    } else {
+        emit(OpCode::PushConst, addConstant(0)); // El código generado usa T x{}
+    }
+
+    // El slot se asigna después de evaluar el inicializador (int x = x; ve la x exterior)
+    int slot = declareLocal(node->variableName, node->typeName, node);
+    if (stepRecordingEnabled) {
+        int descriptor = addStepDescriptor(STEP_DECLARATION, "Declaring: " + node->typeName + " " + node->variableName + " = " + valueFormat(node->typeName),
+                                           STEP_COLOR_VARIABLE_DECL);
+        emit(OpCode::StoreLocalRecord, slot, descriptor);
+    } else {
+        emit(OpCode::StoreLocal, slot);
+    }
+}
+
+void BytecodeCompiler::compileAssignment(AssignmentStatementNode* node) {
+    compileExpression(node->expression.get());
+
+    const LocalVariable* local = lookupLocal(node->identifierName);
+    if (!local) {
+        errorHandler.reportError("Variable '" + node->identifierName + "' no declarada al compilar a bytecode.", -1, -1);
+        emit(OpCode::Pop);
+        return;
+    }
+    if (stepRecordingEnabled) {
+        int descriptor = addStepDescriptor(STEP_ASSIGNMENT, "Assigning to " + node->identifierName + " = " + valueFormat(local->typeName),
+                                           STEP_COLOR_ASSIGNMENT);
+        emit(OpCode::StoreLocalRecord, local->slot, descriptor);
+    } else {
+        emit(OpCode::StoreLocal, local->slot);
+    }
+}
+
+void BytecodeCompiler::compileReturn(ReturnStatementNode* node) {
+    if (!node->expression) {
+        if (stepRecordingEnabled) {
+            emit(OpCode::RecordStep, addStepDescriptor(STEP_RETURN, "Returning from " + currentFunctionName, STEP_COLOR_RETURN), 0);
+        }
+        emit(OpCode::ReturnVoid);
+        return;
+    }
+
+    compileExpression(node->expression.get());
+    if (stepRecordingEnabled) {
+        emit(OpCode::RecordStepKeep, addStepDescriptor(STEP_RETURN, "Returning from " + currentFunctionName + " (Returns: %d)", STEP_COLOR_RETURN), 1);
+    }
+    emit(OpCode::Return);
+}
+
+void BytecodeCompiler::compileIf(IfStatementNode* node) {
+    // La condición se evalúa una sola vez: el paso la registra y el salto la consume
+    compileExpression(node->condition.get());
+    if (stepRecordingEnabled) {
+        emit(OpCode::RecordStepKeep, addStepDescriptor(STEP_CONDITION, "Evaluating if (%d)", STEP_COLOR_HIGHLIGHT), 1);
+    }
+    int elseJump = emitJump(OpCode::JumpIfFalse);
+    compileStatement(node->thenBlock.get());
+
+    if (node->elseBlock) {
+        int endJump = emitJump(OpCode::Jump);
+        patchJump(elseJump);
+        compileStatement(node->elseBlock.get());
+        patchJump(endJump);
+    } else {
+        patchJump(elseJump);
+    }
+}
+
+void BytecodeCompiler::compileFor(ForStatementNode* node) {
+    // La variable de inicialización pertenece al ámbito del for
+    localScopes.emplace_back();
+    compileStatement(node->initialization.get());
+    if (stepRecordingEnabled) {
+        emit(OpCode::RecordStep, addStepDescriptor(STEP_LOOP, "Entering for loop", STEP_COLOR_HIGHLIGHT), 0);
+    }
+
+    int conditionStart = markLabel();
+    std::vector<int> exitJumps;
+    if (node->condition) {
+        compileLoopCondition(node->condition.get(), exitJumps);
+    }
+    compileStatement(node->body.get());
+    compileStatement(node->increment.get());
+    emit(OpCode::LoopBack, conditionStart, sourceLine);
+
+    for (int jump : exitJumps) {
+        patchJump(jump);
+    }
+    localScopes.pop_back();
+}
+
+// La condición del for no registra paso: una comparación se fusiona con su salto
+void BytecodeCompiler::compileLoopCondition(ASTNode* condition, std::vector<int>& exitJumps) {
+    static const std::map<std::string, OpCode> fusedJumps = {
+        {"<", OpCode::JumpIfNotLess}, {">", OpCode::JumpIfNotGreater},
+        {"<=", OpCode::JumpIfNotLessEqual}, {">=", OpCode::JumpIfNotGreaterEqual},
+        {"==", OpCode::JumpIfNotEqual}, {"!=", OpCode::JumpIfEqual},
+    };
+
+    if (condition->type == ASTNodeType::BinaryExpression) {
+        auto binary = static_cast<BinaryExpressionNode*>(condition);
+        auto fused = fusedJumps.find(binary->op);
+        if (fused != fusedJumps.end()) {
+            compileExpression(binary->left.get());
+            compileExpression(binary->right.get());
+            exitJumps.push_back(emitJump(fused->second));
+            return;
+        }
+    }
+    compileExpression(condition);
+    exitJumps.push_back(emitJump(OpCode::JumpIfFalse));
+}
+
+void BytecodeCompiler::compilePrint(PrintStatementNode* node) {
+    if (stepRecordingEnabled && node->arguments.size() > static_cast<size_t>(SIM_MAX_STEP_ARGS)) {
+        errorHandler.reportError("printf registra " + std::to_string(node->arguments.size()) + " valores en su paso; el runtime admite como máximo " +
+                                 std::to_string(SIM_MAX_STEP_ARGS) + ".", node->line, node->column);
+    }
+    // Mismo paso que SFMLTranslator::generatePrintStatement; los segmentos se guardan ya sin escapes
+    std::string stepFormat = "Printing: ";
+    std::vector<FormatSegment> segments;
+    size_t argIndex = 0;
+    for (const auto& segment : node->segments) {
+        if (segment.kind == FormatSegmentKind::Literal) {
+            std::string text = unescape(segment.text);
+            for (char c : text) {
+                stepFormat += (c == '%') ? "%%" : std::string(1, c);
+            }
+            segments.emplace_back(FormatSegmentKind::Literal, text);
+            continue;
+        }
+        if (argIndex >= node->arguments.size()) {
+            break; // El SemanticAnalyzer ya reportó la falta de argumentos
+        }
+
+        compileExpression(node->arguments[argIndex++].get());
+        stepFormat += segment.kind == FormatSegmentKind::Int ? "%d" : segment.kind == FormatSegmentKind::String ? "%s" : "%p";
+        segments.push_back(segment);
+    }
+
+    int argCount = static_cast<int>(argIndex);
+    if (stepRecordingEnabled) {
+        emit(OpCode::RecordStepKeep, addStepDescriptor(STEP_PRINT, stepFormat, STEP_COLOR_PRINT), argCount);
+    }
+    program->printFormats.push_back(std::move(segments));
+    emit(OpCode::Print, static_cast<int>(program->printFormats.size() - 1), argCount);
+}
+
+// --- Expresiones ---
+
+std::string BytecodeCompiler::compileExpression(ASTNode* node) {
+    if (!node) {
+        emit(OpCode::PushConst, addConstant(0));
+        return "int";
+    }
+
+    switch (node->type) {
+        case ASTNodeType::Identifier: {
+            auto identifier = static_cast<IdentifierNode*>(node);
+            const LocalVariable* local = lookupLocal(identifier->name);
+            if (!local) {
+                errorHandler.reportError("Variable '" + identifier->name + "' no declarada al compilar a bytecode.", -1, -1);
+                emit(OpCode::PushConst, addConstant(0));
+                return "int";
+            }
+            emit(OpCode::LoadLocal, local->slot);
+            return local->typeName;
+        }
+        case ASTNodeType::Literal: {
+            auto literal = static_cast<LiteralNode*>(node);
+            if (literal->isString) {
+                emit(OpCode::PushString, addString(unescape(literal->value)));
+                return "char*";
+            }
+            long long value = 0;
+            try {
+                value = static_cast<int32_t>(std::stoll(literal->value));
+            } catch (const std::exception&) {
+                errorHandler.reportError("Literal entero fuera de rango: " + literal->value, -1, -1);
+            }
+            int constant = addConstant(value);
+            // Superinstrucción: 'variable op constante' es el patrón más común de las condiciones
+            if (!program->code.empty() && program->code.back().opcode == OpCode::LoadLocal &&
+                labelPosition != static_cast<int>(program->code.size())) {
+                Instruction& previous = program->code.back();
+                previous.opcode = OpCode::LoadLocalConst;
+                previous.b = constant;
+                adjustStack(1);
+            } else {
+                emit(OpCode::PushConst, constant);
+            }
+            return "int";
+        }
+        case ASTNodeType::BinaryExpression:
+            return compileBinary(static_cast<BinaryExpressionNode*>(node));
+        case ASTNodeType::UnaryExpression:
+            return compileUnary(static_cast<UnaryExpressionNode*>(node));
+        case ASTNodeType::FunctionCall:
+            return compileCall(static_cast<FunctionCallNode*>(node));
+        case ASTNodeType::MallocExpression:
+            errorHandler.reportError("La VM no admite malloc (use el modo compilado, sin --vm ni --precompute).", node->line, node->column);
+            emit(OpCode::PushConst, addConstant(0));
+            return "int*";
+        default:
+            errorHandler.reportError("Tipo de nodo desconocido o no esperado como expresión: " + std::to_string(static_cast<int>(node->type)), -1, -1);
+            emit(OpCode::PushConst, addConstant(0));
+            return "int";
+    }
+}
+
+std::string BytecodeCompiler::compileBinary(BinaryExpressionNode* node) {
+    std::string leftType = compileExpression(node->left.get());
+    std::string rightType = compileExpression(node->right.get());
+    const std::string& op = node->op;
+
+    // Aritmética de punteros: el entero se escala por el tamaño del elemento apuntado
+    if (op == "+" && isPointerType(leftType) && !isPointerType(rightType)) {
+        emit(OpCode::AddPointer, pointeeSize(leftType), 0);
+        return leftType;
+    }
+    if (op == "+" && isPointerType(rightType) && !isPointerType(leftType)) {
+        emit(OpCode::AddPointer, pointeeSize(rightType), 1);
+        return rightType;
+    }
+    if (op == "-" && isPointerType(leftType) && isPointerType(rightType)) {
+        emit(OpCode::PointerDifference, pointeeSize(leftType));
+        return "int";
+    }
+    if (op == "-" && isPointerType(leftType)) {
+        emit(OpCode::SubtractPointer, pointeeSize(leftType));
+        return leftType;
+    }
+
+    static const std::map<std::string, OpCode> binaryOpcodes = {
+        {"+", OpCode::Add}, {"-", OpCode::Subtract}, {"*", OpCode::Multiply}, {"/", OpCode::Divide},
+        {"<", OpCode::Less}, {">", OpCode::Greater}, {"<=", OpCode::LessEqual}, {">=", OpCode::GreaterEqual},
+        {"==", OpCode::Equal}, {"!=", OpCode::NotEqual},
+    };
+    auto found = binaryOpcodes.find(op);
+    if (found == binaryOpcodes.end()) {
+        errorHandler.reportError("Operador binario no soportado por la VM: " + op, -1, -1);
+        emit(OpCode::Pop);
+        return "int";
+    }
+    emit(found->second);
+    return "int";
+}
+
+std::string BytecodeCompiler::compileUnary(UnaryExpressionNode* node) {
+    if (node->op == "&") {
+        auto identifier = node->operand && node->operand->type == ASTNodeType::Identifier
+            ? static_cast<IdentifierNode*>(node->operand.get()) : nullptr;
+        const LocalVariable* local = identifier ? lookupLocal(identifier->name) : nullptr;
+        if (!local) {
+            errorHandler.reportError("La VM solo admite '&' sobre variables locales.", -1, -1);
+            emit(OpCode::PushConst, addConstant(0));
+            return "int*";
+        }
+        emit(OpCode::AddressOfLocal, local->slot);
+        return local->typeName + "*";
+    }
+
+    std::string operandType = compileExpression(node->operand.get());
+    if (node->op == "*") {
+        if (operandType == "char*") {
+            errorHandler.reportError("La VM no admite desreferenciar cadenas (char*).", -1, -1);
+        }
+        emit(OpCode::LoadIndirect);
+        return isPointerType(operandType) ? operandType.substr(0, operandType.size() - 1) : "int";
+    }
+    if (node->op == "-") {
+        emit(OpCode::Negate);
+        return "int";
+    }
+    errorHandler.reportError("Operador unario no soportado por la VM: " + node->op, -1, -1);
+    return "int";
+}
+
+std::string BytecodeCompiler::compileCall(FunctionCallNode* node) {
+    auto found = functionIndices.find(node->functionName);
+    if (found == functionIndices.end()) {
+        errorHandler.reportError("Función '" + node->functionName + "' no definida al compilar a bytecode.", -1, -1);
+        emit(OpCode::PushConst, addConstant(0));
+        return "int";
+    }
+    const BytecodeFunction& callee = program->functions[found->second];
+    if (static_cast<int>(node->arguments.size()) != callee.parameterCount) {
+        errorHandler.reportError("La función '" + node->functionName + "' espera " + std::to_string(callee.parameterCount) +
+                                 " argumentos y recibe " + std::to_string(node->arguments.size()) + ".", -1, -1);
+    }
+    for (const auto& arg : node->arguments) {
+        compileExpression(arg.get());
+    }
+    std::string returnType = callee.returnType;
+    emit(OpCode::Call, found->second);
+    return returnType;
+}
+
+// --- Emisión ---
+
+int BytecodeCompiler::emit(OpCode opcode, int a, int b) {
+    program->code.push_back({opcode, a, b});
+
+    // Efecto sobre la pila de operandos, para dimensionarla en cada llamada
+    int delta = 0;
+    switch (opcode) {
+        case OpCode::PushConst:
+        case OpCode::PushString:
+        case OpCode::LoadLocal:
+        case OpCode::AddressOfLocal:
+            delta = 1;
+            break;
+        case OpCode::LoadLocalConst:
+            delta = 2;
+            break;
+        case OpCode::Call: {
+            const BytecodeFunction& callee = program->functions[a];
+            delta = (callee.returnsValue ? 1 : 0) - callee.parameterCount;
+            break;
+        }
+        case OpCode::RecordStep:
+        case OpCode::Print:
+            delta = -b;
+            break;
+        case OpCode::JumpIfNotLess:
+        case OpCode::JumpIfNotGreater:
+        case OpCode::JumpIfNotLessEqual:
+        case OpCode::JumpIfNotGreaterEqual:
+        case OpCode::JumpIfNotEqual:
+        case OpCode::JumpIfEqual:
+            delta = -2;
+            break;
+        case OpCode::LoadIndirect:
+        case OpCode::Negate:
+        case OpCode::Jump:
+        case OpCode::LoopBack:
+        case OpCode::Enter:
+        case OpCode::ReturnVoid:
+        case OpCode::RecordStepKeep:
+        case OpCode::Halt:
+            delta = 0;
+            break;
+        default: // Operadores binarios, almacenamiento, Pop, JumpIfFalse y Return consumen un valor
+            delta = -1;
+            break;
+    }
+    adjustStack(delta);
+    return static_cast<int>(program->code.size() - 1);
+}
+
+void BytecodeCompiler::adjustStack(int delta) {
+    stackDepth += delta;
+    if (currentFunction >= 0) {
+        BytecodeFunction& function = program->functions[currentFunction];
+        function.maxStackDepth = std::max(function.maxStackDepth, stackDepth);
+    }
+}
+
+int BytecodeCompiler::emitJump(OpCode opcode) {
+    return emit(opcode, -1);
+}
+
+void BytecodeCompiler::patchJump(int instructionIndex) {
+    program->code[instructionIndex].a = markLabel();
+}
+
+int BytecodeCompiler::markLabel() {
+    labelPosition = static_cast<int>(program->code.size());
+    return labelPosition;
+}
+
+int BytecodeCompiler::addConstant(long long value) {
+    auto& constants = program->constants;
+    auto found = std::find(constants.begin(), constants.end(), value);
+    if (found != constants.end()) {
+        return static_cast<int>(found - constants.begin());
+    }
+    constants.push_back(value);
+    return static_cast<int>(constants.size() - 1);
+}
+
+int BytecodeCompiler::addString(const std::string& text) {
+    program->strings.push_back(text);
+    return static_cast<int>(program->strings.size() - 1);
+}
+
+int BytecodeCompiler::addStepDescriptor(StepKind kind, const std::string& format, StepColor color) {
+    const std::string& stored = program->strings[addString(format)];
+    program->stepDescriptors.push_back({kind, sourceLine, stored.c_str(), color});
+    return static_cast<int>(program->stepDescriptors.size() - 1);
+}
+
+// --- Slots de pila ---
+
+void BytecodeCompiler::declareFrame(const std::string& functionName) {
+    currentLayout = static_cast<int>(frameFunctionNames.size());
+    frameFunctionNames.push_back(functionName);
+    frameSlotNames.emplace_back();
+    localScopes.clear();
+    localScopes.emplace_back();
+}
+
+// Cada declaración recibe un slot propio en el marco de la función, incluso si oculta a otra. El runtime
+// tiene una capacidad fija por marco: el error se sitúa en la declaración que la supera
+int BytecodeCompiler::declareLocal(const std::string& name, const std::string& typeName, const ASTNode* declaration) {
+    auto& slots = frameSlotNames[currentLayout];
+    int slot = static_cast<int>(slots.size());
+    if (slot == SIM_MAX_FRAME_SLOTS) {
+        errorHandler.reportError("La variable '" + name + "' supera el máximo de " + std::to_string(SIM_MAX_FRAME_SLOTS) +
+                                 " variables locales por función que admite el runtime.", declaration->line, declaration->column);
+    }
+    slots.push_back({name, typeName});
+    localScopes.back()[name] = {typeName, slot};
+    return slot;
+}
+
+const BytecodeCompiler::LocalVariable* BytecodeCompiler::lookupLocal(const std::string& name) const {
+    for (auto it = localScopes.rbegin(); it != localScopes.rend(); ++it) {
+        auto found = it->find(name);
+        if (found != it->end()) {
+            return &found->second;
+        }
+    }
+    return nullptr;
+}
+
+// Construye las tablas de marcos del runtime una vez fijados todos los slots
+void BytecodeCompiler::finalizeTables() {
+    for (size_t layout = 0; layout < frameSlotNames.size(); ++layout) {
+        std::vector<FrameSlotInfo> slots;
+        for (const auto& slot : frameSlotNames[layout]) {
+            slots.push_back({program->strings[addString(slot.first)].c_str(), isPointerType(slot.second) ? SLOT_POINTER : SLOT_INT});
+        }
+        program->frameSlots.push_back(std::move(slots));
+    }
+    for (size_t layout = 0; layout < frameSlotNames.size(); ++layout) {
+        const std::string& functionName = program->strings[addString(frameFunctionNames[layout])];
+        program->frameLayouts.push_back({functionName.c_str(), program->frameSlots[layout].data(), static_cast<int>(program->frameSlots[layout].size())});
+    }
+}
+
+bool BytecodeCompiler::isPointerType(const std::string& typeName) {
+    return !typeName.empty() && typeName.back() == '*';
+}
+
+// Tamaño del elemento apuntado en la memoria de la VM: cada variable ocupa un long long
+int BytecodeCompiler::pointeeSize(const std::string& pointerType) {
+    return pointerType == "char*" ? 1 : static_cast<int>(sizeof(long long));
+}
+
+std::string BytecodeCompiler::valueFormat(const std::string& typeName) {
+    return isPointerType(typeName) ? "%p" : "%d";
+}
+
+// El lexer conserva las secuencias de escape; el código generado las deja al compilador de C++
+std::string BytecodeCompiler::unescape(const std::string& text) {
+    std::string result;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\' || i + 1 >= text.size()) {
+            result += text[i];
+            continue;
+        }
+        switch (text[++i]) {
+            case 'n':  result += '\n'; break;
+            case 't':  result += '\t'; break;
+            case 'r':  result += '\r'; break;
+            case '0':  result += '\0'; break;
+            case '\\': result += '\\'; break;
+            case '"':  result += '"'; break;
+            case '\'': result += '\''; break;
+            default:   result += '\\'; result += text[i]; break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,92 @@
+// src/vm/BytecodeCompiler.h
+#ifndef BYTECODECOMPILER_H
+#define BYTECODECOMPILER_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Bytecode.h"
+#include "../parser/AST.h"
+#include "../ir/InstrumentationPlan.h"
+#include "../utils/ErrorHandler.h"
+
+// Compila el AST verificado a bytecode para la VirtualMachine. Recorre el árbol igual que el
+// CodeGenerator (mismos slots de pila, mismos pasos y en el mismo orden), de modo que la traza
+// que registra la VM coincide con la del programa generado.
+class BytecodeCompiler {
+public:
+    explicit BytecodeCompiler(ErrorHandler& errorHandler);
+
+    void setInstrumentationPlan(const InstrumentationPlan* plan);
+    // Pasos finales de los límites de ejecución (--vm): sin ellos la VM se detiene sin registrar el motivo
+    void enableExecutionStops();
+    std::unique_ptr<BytecodeProgram> compile(ProgramNode* program);
+
+private:
+    struct LocalVariable {
+        std::string typeName;
+        int slot;
+    };
+
+    // Sentencias (mismo reparto que CodeGenerator::visit*)
+    void compileStatement(ASTNode* node);
+    void compileStatementNode(ASTNode* node);
+    void compileFunction(int functionIndex, const std::string& displayName,
+                         const std::vector<std::pair<std::string, std::string>>& parameters,
+                         const std::vector<ASTNode*>& statements, const ASTNode* declaration);
+    void compileVariableDeclaration(VariableDeclarationNode* node);
+    void compileAssignment(AssignmentStatementNode* node);
+    void compileReturn(ReturnStatementNode* node);
+    void compileIf(IfStatementNode* node);
+    void compileFor(ForStatementNode* node);
+    void compilePrint(PrintStatementNode* node);
+
+    // Expresiones: dejan un valor en la pila; devuelven su tipo C
+    std::string compileExpression(ASTNode* node);
+    std::string compileBinary(BinaryExpressionNode* node);
+    std::string compileUnary(UnaryExpressionNode* node);
+    std::string compileCall(FunctionCallNode* node);
+    void compileLoopCondition(ASTNode* condition, std::vector<int>& exitJumps);
+
+    // Emisión
+    int emit(OpCode opcode, int a = 0, int b = 0);
+    void adjustStack(int delta);
+    int emitJump(OpCode opcode);
+    void patchJump(int instructionIndex);
+    int markLabel();
+    int addConstant(long long value);
+    int addString(const std::string& text);
+    int addStepDescriptor(StepKind kind, const std::string& format, StepColor color);
+
+    // Slots de pila (misma asignación que el CodeGenerator)
+    void declareFrame(const std::string& functionName);
+    int declareLocal(const std::string& name, const std::string& typeName, const ASTNode* declaration);
+    const LocalVariable* lookupLocal(const std::string& name) const;
+    void finalizeTables();
+
+    static bool isPointerType(const std::string& typeName);
+    static int pointeeSize(const std::string& pointerType);
+    static std::string valueFormat(const std::string& typeName);
+    static std::string unescape(const std::string& text);
+
+    ErrorHandler& errorHandler;
+    const InstrumentationPlan* instrumentationPlan;
+    bool executionStops;
+    std::unique_ptr<BytecodeProgram> program;
+    std::map<std::string, int> functionIndices;
+    std::vector<std::vector<std::pair<std::string, std::string>>> frameSlotNames; // (nombre, tipo) por layout
+    std::vector<std::string> frameFunctionNames;
+
+    int currentFunction;
+    std::string currentFunctionName; // Nombre en los pasos de return ("" para las sentencias globales)
+    int currentLayout;
+    std::vector<std::map<std::string, LocalVariable>> localScopes;
+    bool stepRecordingEnabled;
+    int sourceLine; // Línea de la sentencia en compilación, para los descriptores de sus pasos
+    int stackDepth;
+    int labelPosition; // Posición del último destino de salto: no se fusionan instrucciones a través de él
+};
+
+#endif // BYTECODECOMPILER_H
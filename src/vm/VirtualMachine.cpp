@@ -0,0 +1,563 @@
+// src/vm/VirtualMachine.cpp
+#include "VirtualMachine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+
+namespace {
+
+VirtualMachine* activeMachine = nullptr;
+
+void runActiveMachine() {
+    activeMachine->run();
+}
+
+size_t loadActiveMachineWindow(size_t stepIndex) {
+    return activeMachine->loadWindow(stepIndex);
+}
+
+// Los 'int' del código generado son de 32 bits: la VM reproduce su desbordamiento
+inline long long wrapInt(long long value) {
+    return static_cast<int32_t>(static_cast<uint32_t>(value));
+}
+
+} // namespace
+
+// Con GCC/Clang el despacho usa goto calculado (un salto indirecto por instrucción);
+// en otros compiladores, un switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+VirtualMachine::VirtualMachine(const BytecodeProgram& program, ErrorHandler& errorHandler)
+    : program(program), errorHandler(errorHandler), operandStack(VM_OPERAND_STACK_SIZE), locals(VM_LOCALS_SIZE),
+      runtimeErrorOccurred(false), maxSteps(std::numeric_limits<size_t>::max()),
+      maxTraceBytes(std::numeric_limits<size_t>::max()), maxJumps(std::numeric_limits<size_t>::max()),
+      limitExceeded(false), stepLimit(NO_STOP), maxMillis(0), detectLoops(false), clockCountdown(VM_CLOCK_CHECK_INTERVAL),
+      limitChecks(0), stopStep(NO_STOP), stopChecks(0), stopReason(SIM_STOP_STEPS), stepCount(0), checkpointInterval(0),
+      resumeFrom(nullptr), replay{0, nullptr} {
+    callStack.reserve(64);
+}
+
+SimulationProgram VirtualMachine::getSimulationProgram() {
+    activeMachine = this;
+    return {
+        program.stepDescriptors.data(), static_cast<int>(program.stepDescriptors.size()),
+        program.frameLayouts.data(), static_cast<int>(program.frameLayouts.size()),
+        runActiveMachine
+    };
+}
+
+void VirtualMachine::runtimeError(const std::string& message) {
+    runtimeErrorOccurred = true;
+    if (resumeFrom) {
+        return; // La ejecución completa ya informó del error
+    }
+    errorHandler.reportError("Error en tiempo de ejecución (VM): " + message, -1, -1);
+}
+
+void VirtualMachine::setTraceLimits(size_t maxSteps, size_t maxTraceBytes, size_t maxJumps) {
+    this->maxSteps = maxSteps;
+    this->maxTraceBytes = maxTraceBytes;
+    this->maxJumps = maxJumps;
+}
+
+void VirtualMachine::setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops) {
+    stepLimit = maxSteps != 0 ? maxSteps : NO_STOP;
+    this->maxMillis = maxMillis;
+    this->detectLoops = detectLoops;
+}
+
+void VirtualMachine::setCheckpointInterval(size_t interval) {
+    checkpointInterval = interval;
+}
+
+const SimulationReplay* VirtualMachine::getSimulationReplay() {
+    activeMachine = this;
+    replay = {stepCount, loadActiveMachineWindow};
+    return &replay;
+}
+
+size_t VirtualMachine::loadWindow(size_t stepIndex) {
+    const Checkpoint& checkpoint = checkpoints[std::min(stepIndex / checkpointInterval, checkpoints.size() - 1)];
+    std::string discardedOutput; // La salida del programa ya se mostró en la ejecución completa
+    setOutputCapture(&discardedOutput);
+    resumeFrom = &checkpoint;
+    run();
+    resumeFrom = nullptr;
+    setOutputCapture(nullptr);
+    return checkpoint.step;
+}
+
+size_t VirtualMachine::getCheckpointBytes() const {
+    size_t bytes = checkpoints.capacity() * sizeof(Checkpoint);
+    for (const Checkpoint& checkpoint : checkpoints) {
+        bytes += (checkpoint.operands.size() + checkpoint.locals.size() + checkpoint.recording.stack.size()) * sizeof(long long) +
+                 checkpoint.callStack.size() * sizeof(CallFrame);
+        for (const auto& object : checkpoint.recording.heap) {
+            bytes += object.first.size() + sizeof(HeapObject) + object.second.value.size();
+        }
+    }
+    return bytes;
+}
+
+void VirtualMachine::saveCheckpoint(const Instruction* pc, long long* sp, long long* fp, int frameSize) {
+    Checkpoint& checkpoint = checkpoints.emplace_back();
+    checkpoint.step = stepCount;
+    checkpoint.pc = pc;
+    checkpoint.sp = sp;
+    checkpoint.fp = fp;
+    checkpoint.frameSize = frameSize;
+    checkpoint.operands.assign(operandStack.data(), sp);
+    checkpoint.locals.assign(locals.data(), fp + frameSize);
+    checkpoint.callStack = callStack;
+    saveRecordingState(checkpoint.recording);
+}
+
+// Se comprueba tras cada paso registrado; los deltas y los keyframes son lo que crece con el historial
+bool VirtualMachine::stepRecorded(const Instruction* pc, long long* sp, long long* fp, int frameSize) {
+    ++stepCount;
+    limitChecks = 0;
+    if (checkpointInterval != 0 && stepCount % checkpointInterval == 0) {
+        if (resumeFrom) {
+            return true; // Ventana completa
+        }
+        saveCheckpoint(pc, sp, fp, frameSize);
+        clearSimulationTrace(); // En la ejecución completa solo se conservan los checkpoints
+    }
+    if (simulationHistory.size() > maxSteps || getSimulationTraceBytes() > maxTraceBytes) {
+        limitExceeded = true;
+    }
+    return limitExceeded;
+}
+
+bool VirtualMachine::limitReached(const Instruction* loop, int line, const Instruction* pc, long long* sp, long long* fp, int frameSize) {
+    if (resumeFrom) {
+        // La ventana vuelve a ejecutar un tramo ya recorrido: solo se detiene donde lo hizo la ejecución completa
+        return stepCount == stopStep && limitChecks == stopChecks && stopExecution(stopReason, line, pc, sp, fp, frameSize);
+    }
+    if (stepCount >= stepLimit) {
+        return stopExecution(SIM_STOP_STEPS, line, pc, sp, fp, frameSize);
+    }
+    if (clockCountdown == 0) {
+        clockCountdown = VM_CLOCK_CHECK_INTERVAL;
+        if (maxMillis != 0 && std::chrono::steady_clock::now() - runStart >= std::chrono::milliseconds(maxMillis)) {
+            return stopExecution(SIM_STOP_TIME, line, pc, sp, fp, frameSize);
+        }
+    }
+    if (detectLoops && loop && loopGuard(loop, line).repeatsState()) {
+        return stopExecution(SIM_STOP_LOOP, line, pc, sp, fp, frameSize);
+    }
+    return false;
+}
+
+// Registra el paso final del motivo; pc, sp y fp son los del punto en que se detiene
+bool VirtualMachine::stopExecution(SimStopReason reason, int line, const Instruction* pc, long long* sp, long long* fp, int frameSize) {
+    if (!resumeFrom) {
+        stopStep = stepCount;
+        stopChecks = limitChecks;
+        stopReason = reason;
+        flushOutput();
+        std::fprintf(stderr, "execution stopped: %s at line %d after %zu steps\n", simulationStopReasonText(reason), line, stepCount);
+    }
+    const int descriptor = program.stopDescriptors[reason];
+    if (descriptor >= 0) {
+        const long long lineValue = line;
+        recordStepValues(descriptor, &lineValue, 1);
+        stepRecorded(pc, sp, fp, frameSize);
+    }
+    return true;
+}
+
+// Cada llamada en curso tiene sus propios bucles: Return descarta los de la función que termina
+SimulationLoopGuard& VirtualMachine::loopGuard(const Instruction* loop, int line) {
+    const size_t callDepth = callStack.size();
+    for (auto it = loopGuards.rbegin(); it != loopGuards.rend() && it->callDepth == callDepth; ++it) {
+        if (it->loop == loop) {
+            return it->guard;
+        }
+    }
+    loopGuards.push_back({callDepth, loop, SimulationLoopGuard(line)});
+    return loopGuards.back().guard;
+}
+
+void VirtualMachine::run() {
+    const Instruction* const code = program.code.data();
+    const long long* const constants = program.constants.data();
+    const BytecodeFunction* const functions = program.functions.data();
+    const long long* const stackLimit = operandStack.data() + operandStack.size();
+    const long long* const localsBegin = locals.data();
+    const long long* const localsLimit = locals.data() + locals.size();
+
+    const Instruction* pc = code;
+    long long* sp = operandStack.data(); // Siguiente posición libre de la pila de operandos
+    long long* fp = locals.data();       // Variables locales de la función en curso
+    int frameSize = 0;
+    size_t jumpBudget = maxJumps;
+    callStack.clear();
+    runtimeErrorOccurred = false;
+    limitExceeded = false;
+    loopGuards.clear();
+    limitChecks = 0;
+    clockCountdown = VM_CLOCK_CHECK_INTERVAL;
+    if (resumeFrom) {
+        pc = resumeFrom->pc;
+        sp = resumeFrom->sp;
+        fp = resumeFrom->fp;
+        frameSize = resumeFrom->frameSize;
+        std::copy(resumeFrom->operands.begin(), resumeFrom->operands.end(), operandStack.data());
+        std::copy(resumeFrom->locals.begin(), resumeFrom->locals.end(), locals.data());
+        callStack = resumeFrom->callStack;
+        stepCount = resumeFrom->step;
+        restoreRecordingState(resumeFrom->recording);
+    } else {
+        stepCount = 0;
+        stopStep = NO_STOP;
+        runStart = std::chrono::steady_clock::now();
+        checkpoints.clear();
+        if (checkpointInterval != 0) {
+            saveCheckpoint(pc, sp, fp, frameSize);
+        }
+    }
+
+#ifdef VM_COMPUTED_GOTO
+    static void* const dispatchTable[] = {
+#define VM_LABEL_ADDRESS(name) &&op_##name,
+        BYTECODE_OPCODES(VM_LABEL_ADDRESS)
+#undef VM_LABEL_ADDRESS
+    };
+#define VM_CASE(name) op_##name:
+#define VM_NEXT() goto *dispatchTable[static_cast<int>(pc->opcode)]
+    VM_NEXT();
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_NEXT() goto dispatch
+dispatch:
+    switch (pc->opcode) {
+#endif
+
+    VM_CASE(PushConst) {
+        *sp++ = constants[pc->a];
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(PushString) {
+        *sp++ = static_cast<long long>(reinterpret_cast<std::intptr_t>(program.strings[pc->a].c_str()));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LoadLocal) {
+        *sp++ = fp[pc->a];
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LoadLocalConst) {
+        sp[0] = fp[pc->a];
+        sp[1] = constants[pc->b];
+        sp += 2;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(StoreLocal) {
+        const long long value = *--sp;
+        fp[pc->a] = value;
+        updateStackFrame(pc->a, value);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(StoreLocalRecord) {
+        const long long value = *--sp;
+        fp[pc->a] = value;
+        updateStackFrame(pc->a, value);
+        recordStepValues(pc->b, &fp[pc->a], 1);
+        ++pc;
+        if (stepRecorded(pc, sp, fp, frameSize)) {
+            goto halt;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(AddressOfLocal) {
+        *sp++ = static_cast<long long>(reinterpret_cast<std::intptr_t>(&fp[pc->a]));
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LoadIndirect) {
+        // Solo hay punteros a variables locales de la VM
+        const long long* address = reinterpret_cast<const long long*>(static_cast<std::intptr_t>(sp[-1]));
+        if (address < localsBegin || address >= localsLimit) {
+            runtimeError("desreferencia de un puntero inválido (" + formatPointer(address) + ").");
+            goto halt;
+        }
+        sp[-1] = *address;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Pop) {
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Add) {
+        sp[-2] = wrapInt(sp[-2] + sp[-1]);
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Subtract) {
+        sp[-2] = wrapInt(sp[-2] - sp[-1]);
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Multiply) {
+        sp[-2] = wrapInt(sp[-2] * sp[-1]);
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Divide) {
+        if (sp[-1] == 0) {
+            runtimeError("división por cero.");
+            goto halt;
+        }
+        sp[-2] = wrapInt(sp[-2] / sp[-1]);
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Negate) {
+        sp[-1] = wrapInt(-sp[-1]);
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(AddPointer) {
+        if (pc->b == 0) {
+            sp[-2] += sp[-1] * pc->a;
+        } else {
+            sp[-2] = sp[-2] * pc->a + sp[-1];
+        }
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(SubtractPointer) {
+        sp[-2] -= sp[-1] * pc->a;
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(PointerDifference) {
+        sp[-2] = (sp[-2] - sp[-1]) / pc->a;
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Less) {
+        sp[-2] = sp[-2] < sp[-1];
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Greater) {
+        sp[-2] = sp[-2] > sp[-1];
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(LessEqual) {
+        sp[-2] = sp[-2] <= sp[-1];
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(GreaterEqual) {
+        sp[-2] = sp[-2] >= sp[-1];
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Equal) {
+        sp[-2] = sp[-2] == sp[-1];
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(NotEqual) {
+        sp[-2] = sp[-2] != sp[-1];
+        --sp;
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Jump) {
+        if (jumpBudget-- == 0) {
+            limitExceeded = true;
+            goto halt;
+        }
+        pc = code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(LoopBack) {
+        if (jumpBudget-- == 0) {
+            limitExceeded = true;
+            goto halt;
+        }
+        ++limitChecks;
+        if ((stepCount >= stepLimit || stepCount == stopStep || --clockCountdown == 0 || detectLoops) &&
+            limitReached(pc, pc->b, pc, sp, fp, frameSize)) {
+            goto halt;
+        }
+        pc = code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfFalse) {
+        pc = *--sp ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfNotLess) {
+        sp -= 2;
+        pc = sp[0] < sp[1] ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfNotGreater) {
+        sp -= 2;
+        pc = sp[0] > sp[1] ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfNotLessEqual) {
+        sp -= 2;
+        pc = sp[0] <= sp[1] ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfNotGreaterEqual) {
+        sp -= 2;
+        pc = sp[0] >= sp[1] ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfNotEqual) {
+        sp -= 2;
+        pc = sp[0] == sp[1] ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfEqual) {
+        sp -= 2;
+        pc = sp[0] != sp[1] ? pc + 1 : code + pc->a;
+        VM_NEXT();
+    }
+    VM_CASE(Call) {
+        const BytecodeFunction& callee = functions[pc->a];
+        ++limitChecks;
+        if ((stepCount >= stepLimit || stepCount == stopStep || --clockCountdown == 0) &&
+            limitReached(nullptr, callee.line, pc, sp, fp, frameSize)) {
+            goto halt;
+        }
+        long long* newFrame = fp + frameSize;
+        if (callStack.size() >= VM_MAX_CALL_DEPTH || newFrame + callee.frameSize > localsLimit ||
+            sp + callee.maxStackDepth > stackLimit) {
+            runtimeError("desbordamiento de pila al llamar a '" + callee.name + "'.");
+            goto halt;
+        }
+        sp -= callee.parameterCount;
+        std::copy(sp, sp + callee.parameterCount, newFrame);
+        callStack.push_back({pc + 1, fp, sp, frameSize});
+        fp = newFrame;
+        frameSize = callee.frameSize;
+        pc = code + callee.entry;
+        VM_NEXT();
+    }
+    VM_CASE(Enter) {
+        pushStackFrame(pc->a);
+        for (int param = 0; param < pc->b; ++param) {
+            updateStackFrame(param, fp[param]);
+        }
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Return) {
+        const long long value = sp[-1];
+        const CallFrame& frame = callStack.back();
+        popStackFrame();
+        pc = frame.returnAddress;
+        fp = frame.framePointer;
+        sp = frame.stackBase;
+        frameSize = frame.frameSize;
+        callStack.pop_back();
+        *sp++ = value;
+        while (!loopGuards.empty() && loopGuards.back().callDepth > callStack.size()) {
+            loopGuards.pop_back();
+        }
+        VM_NEXT();
+    }
+    VM_CASE(ReturnVoid) {
+        const CallFrame& frame = callStack.back();
+        popStackFrame();
+        pc = frame.returnAddress;
+        fp = frame.framePointer;
+        sp = frame.stackBase;
+        frameSize = frame.frameSize;
+        callStack.pop_back();
+        while (!loopGuards.empty() && loopGuards.back().callDepth > callStack.size()) {
+            loopGuards.pop_back();
+        }
+        VM_NEXT();
+    }
+    VM_CASE(RecordStep) {
+        sp -= pc->b;
+        recordStepValues(pc->a, sp, pc->b);
+        ++pc;
+        if (stepRecorded(pc, sp, fp, frameSize)) {
+            goto halt;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(RecordStepKeep) {
+        recordStepValues(pc->a, sp - pc->b, pc->b);
+        ++pc;
+        if (stepRecorded(pc, sp, fp, frameSize)) {
+            goto halt;
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Print) {
+        sp -= pc->b;
+        const long long* arg = sp;
+        for (const FormatSegment& segment : program.printFormats[pc->a]) {
+            switch (segment.kind) {
+                case FormatSegmentKind::Literal:
+                    writeOutput(segment.text.data(), segment.text.size());
+                    break;
+                case FormatSegmentKind::Int:
+                    writeOutputInt(*arg++);
+                    break;
+                case FormatSegmentKind::String:
+                    writeOutputString(reinterpret_cast<const char*>(static_cast<std::intptr_t>(*arg++)));
+                    break;
+                case FormatSegmentKind::Pointer:
+                    writeOutputPointer(reinterpret_cast<const void*>(static_cast<std::intptr_t>(*arg++)));
+                    break;
+            }
+        }
+        ++pc;
+        VM_NEXT();
+    }
+    VM_CASE(Halt) {
+        goto halt;
+    }
+
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
+#undef VM_CASE
+#undef VM_NEXT
+
+halt:
+    // Tras un error pueden quedar marcos abiertos: se cierran para que la traza termine limpia
+    for (size_t frame = 0; frame < callStack.size(); ++frame) {
+        popStackFrame();
+    }
+    callStack.clear();
+    if (checkpointInterval != 0 && !resumeFrom) {
+        clearSimulationTrace();
+    }
+}
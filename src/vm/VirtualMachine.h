@@ -0,0 +1,128 @@
+// src/vm/VirtualMachine.h
+#ifndef VIRTUALMACHINE_H
+#define VIRTUALMACHINE_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Bytecode.h"
+#include "../utils/ErrorHandler.h"
+
+// Capacidades fijas de la VM: las direcciones de las variables locales (&x) no cambian durante la ejecución
+const size_t VM_OPERAND_STACK_SIZE = 1 << 16;
+const size_t VM_LOCALS_SIZE = 1 << 20;
+// Cada keyframe guarda la pila completa: una recursión sin fin agotaría la memoria mucho antes que la pila nativa
+const size_t VM_MAX_CALL_DEPTH = 4096;
+// Pasos entre checkpoints (--checkpoint): el visor vuelve a ejecutar como mucho estos pasos al saltar
+const size_t VM_DEFAULT_CHECKPOINT_INTERVAL = 16384;
+// Pasos de --vm sin --max-steps, --checkpoint ni --trace-budget: un bucle sin fin agotaría la memoria con
+// su traza antes de mostrarla
+const size_t VM_DEFAULT_MAX_STEPS = 1000000;
+// Comprobaciones de límites entre lecturas del reloj (--max-seconds), como en el código generado
+const unsigned VM_CLOCK_CHECK_INTERVAL = 4096;
+
+// Intérprete del bytecode (opción --vm). Ejecuta el programa dentro del compilador y registra los
+// pasos con el mismo runtime (sim_runtime) que los programas generados, así que la traza se puede
+// mostrar directamente en el visor o exportar sin pasar por g++.
+class VirtualMachine {
+public:
+    VirtualMachine(const BytecodeProgram& program, ErrorHandler& errorHandler);
+
+    // Tablas del programa y punto de entrada para runSimulationProgram/runSimulationViewer
+    SimulationProgram getSimulationProgram();
+
+    // Ejecuta el programa desde el código de arranque (lo llama el runtime a través de getSimulationProgram)
+    void run();
+    bool hasRuntimeError() const { return runtimeErrorOccurred; }
+
+    // Límites de la ejecución (--precompute): al superar cualquiera la VM se detiene sin informar
+    // de un error y traceLimitExceeded() lo indica. Los saltos acotan los bucles que no registran pasos.
+    void setTraceLimits(size_t maxSteps, size_t maxTraceBytes, size_t maxJumps);
+    bool traceLimitExceeded() const { return limitExceeded; }
+
+    // Límites de --vm (--max-steps, --max-seconds, --detect-loops; 0: sin límite). Se comprueban en el
+    // salto de vuelta de cada for y en cada llamada, como en el código generado: al superar uno, la VM
+    // registra el paso final del motivo (BytecodeCompiler::enableExecutionStops) y se detiene. Las
+    // ventanas de loadWindow() se detienen en el mismo punto que la ejecución completa.
+    void setExecutionLimits(size_t maxSteps, unsigned maxMillis, bool detectLoops);
+    bool executionStopped() const { return stopStep != NO_STOP; }
+
+    // Modo checkpoint (--checkpoint): run() no conserva la traza, solo el estado completo de la VM y
+    // del runtime cada 'interval' pasos. Tras run(), getSimulationReplay() permite recorrer la
+    // ejecución completa: cada ventana de pasos se vuelve a ejecutar desde su checkpoint.
+    void setCheckpointInterval(size_t interval);
+    const SimulationReplay* getSimulationReplay();
+    size_t loadWindow(size_t stepIndex); // Deja en la traza los pasos del checkpoint de stepIndex
+    size_t getRecordedStepCount() const { return stepCount; }
+    size_t getCheckpointCount() const { return checkpoints.size(); }
+    size_t getCheckpointBytes() const;
+
+private:
+    struct CallFrame {
+        const Instruction* returnAddress;
+        long long* framePointer;
+        long long* stackBase; // Tope de la pila de operandos del llamador, ya sin los argumentos
+        int frameSize;
+    };
+
+    // Los punteros siguen siendo válidos al restaurar: la pila de operandos y las locales no se mueven
+    struct Checkpoint {
+        size_t step; // Paso que se registra a continuación
+        const Instruction* pc;
+        long long* sp;
+        long long* fp;
+        int frameSize;
+        std::vector<long long> operands; // Pila de operandos hasta sp
+        std::vector<long long> locals;   // Locales hasta el final del marco en curso
+        std::vector<CallFrame> callStack;
+        TraceKeyframe recording;         // Pila y heap del runtime
+    };
+
+    // Detección de bucles (--detect-loops): una por bucle y llamada en curso
+    struct LoopGuard {
+        size_t callDepth;
+        const Instruction* loop;
+        SimulationLoopGuard guard;
+    };
+
+    static const size_t NO_STOP = static_cast<size_t>(-1);
+
+    void runtimeError(const std::string& message);
+    // Parte lenta de la comprobación de límites; loop es nullptr en una llamada. Devuelve true para detenerse
+    bool limitReached(const Instruction* loop, int line, const Instruction* pc, long long* sp, long long* fp, int frameSize);
+    bool stopExecution(SimStopReason reason, int line, const Instruction* pc, long long* sp, long long* fp, int frameSize);
+    SimulationLoopGuard& loopGuard(const Instruction* loop, int line);
+    // Tras cada paso registrado, con pc ya en la instrucción siguiente; devuelve true para detenerse
+    bool stepRecorded(const Instruction* pc, long long* sp, long long* fp, int frameSize);
+    void saveCheckpoint(const Instruction* pc, long long* sp, long long* fp, int frameSize);
+
+    const BytecodeProgram& program;
+    ErrorHandler& errorHandler;
+    std::vector<long long> operandStack;
+    std::vector<long long> locals;
+    std::vector<CallFrame> callStack;
+    bool runtimeErrorOccurred;
+    size_t maxSteps;
+    size_t maxTraceBytes;
+    size_t maxJumps;
+    bool limitExceeded;
+    size_t stepLimit; // NO_STOP: sin límite
+    unsigned maxMillis;
+    bool detectLoops;
+    std::chrono::steady_clock::time_point runStart;
+    unsigned clockCountdown;
+    size_t limitChecks; // Comprobaciones desde el último paso registrado
+    std::vector<LoopGuard> loopGuards;
+    // Dónde se detuvo la ejecución completa (NO_STOP si no se detuvo), para repetirlo en las ventanas
+    size_t stopStep;
+    size_t stopChecks;
+    SimStopReason stopReason;
+    size_t stepCount; // Pasos registrados desde el inicio del programa
+    size_t checkpointInterval; // 0: sin checkpoints
+    std::vector<Checkpoint> checkpoints;
+    const Checkpoint* resumeFrom; // Ventana en curso de loadWindow()
+    SimulationReplay replay;
+};
+
+#endif // VIRTUALMACHINE_H
@@ -0,0 +1,49 @@
+# Prueba de extremo a extremo (ctest): traduce SOURCE con el compilador, compila el programa generado
+# sin ventana contra sim_runtime, lo ejecuta con --headless y busca en su traza NDJSON. Con --vm (y
+# --backend=html) no hay programa generado: se busca en el trace.json que escribe el compilador.
+#   EXPECT: expresión regular que debe cumplir alguna línea de la traza (un paso)
+#   REJECT: expresión regular que no debe cumplir ninguna línea (opcional)
+# Variables: COMPILER, COMPILER_ARGS (separados por espacios), SOURCE, CXX, RUNTIME_INCLUDE_DIR,
+# RUNTIME_LIBRARY_DIR y WORK_DIR.
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+separate_arguments(compilerArgs UNIX_COMMAND "${COMPILER_ARGS}")
+
+execute_process(COMMAND "${COMPILER}" ${compilerArgs} "${SOURCE}"
+                WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE errors TIMEOUT 60)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "The compiler failed on ${SOURCE}:\n${errors}")
+endif()
+
+if(" ${COMPILER_ARGS} " MATCHES " --vm ")
+    set(traceFile "${WORK_DIR}/trace.json") # Un paso por línea
+else()
+    execute_process(COMMAND "${CXX}" -std=c++17 output_sfml.cpp -o output_sfml -I${RUNTIME_INCLUDE_DIR} -L${RUNTIME_LIBRARY_DIR}
+                            -DSIMULATION_HEADLESS -lsim_runtime -pthread
+                    WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE result ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "The generated program did not compile:\n${errors}")
+    endif()
+
+    execute_process(COMMAND "${WORK_DIR}/output_sfml" --headless --output=trace.ndjson
+                    WORKING_DIRECTORY "${WORK_DIR}" RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE errors TIMEOUT 60)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "The generated program failed (${result}):\n${errors}")
+    endif()
+    set(traceFile "${WORK_DIR}/trace.ndjson")
+endif()
+
+file(STRINGS "${traceFile}" steps)
+set(expectFound FALSE)
+foreach(step IN LISTS steps)
+    if(step MATCHES "${EXPECT}")
+        set(expectFound TRUE)
+    endif()
+    if(DEFINED REJECT AND NOT REJECT STREQUAL "" AND step MATCHES "${REJECT}")
+        message(FATAL_ERROR "A step matches '${REJECT}':\n${step}\n${errors}")
+    endif()
+endforeach()
+if(NOT expectFound)
+    message(FATAL_ERROR "No step matches '${EXPECT}'\n${errors}")
+endif()
@@ -0,0 +1,7 @@
+int main() {
+    int x = 0;
+    for (int i = 0; i < 1; i = i) {
+        x = 1 - x;
+    }
+    return 0;
+}
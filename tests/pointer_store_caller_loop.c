@@ -0,0 +1,13 @@
+int fill(int* p) {
+    for (int k = 0; *p < 3; k = k) {
+        *p = *p + 1;
+    }
+    return 0;
+}
+
+int main() {
+    int x = 0;
+    fill(&x);
+    printf("x=%d\n", x);
+    return 0;
+}
@@ -0,0 +1,7 @@
+int main() {
+    int x = 0;
+    int* q = &x;
+    *q = 7;
+    printf("x=%d\n", x);
+    return 0;
+}
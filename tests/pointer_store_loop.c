@@ -0,0 +1,9 @@
+int main() {
+    int x = 0;
+    int* p = &x;
+    for (int k = 0; *p < 5; k = k) {
+        *p = *p + 1;
+    }
+    printf("x=%d\n", x);
+    return 0;
+}
@@ -0,0 +1,8 @@
+int main() {
+    int* p = malloc(sizeof(int) * 2);
+    *(p + 2) = 5;
+    printf("v=%d\n", *(p + 2));
+    free(p);
+    *p = 9;
+    return 0;
+}